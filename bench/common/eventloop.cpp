@@ -0,0 +1,128 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <eventloop.hpp>
+
+
+namespace {
+    void no_fds(fd_set &, fd_set &, fd_set &, int &,
+                std::chrono::nanoseconds &) {}
+
+    /**
+     * Runs an event loop in a background thread.
+     */
+    class background_loop_t {
+    public:
+        explicit background_loop_t(
+                const eventloop_t::select_handler_t &handler = nullptr) {
+            if (handler) {
+                loop.register_handler(handler, &no_fds);
+            }
+            thread = std::thread([this] {
+                loop.exec([this] { return stop.load(); });
+            });
+        }
+        ~background_loop_t() {
+            stop = true;
+            loop.notify();
+            thread.join();
+        }
+
+        eventloop_t loop;
+
+    private:
+        std::atomic<bool> stop{false};
+        std::thread thread;
+    };
+}
+
+
+/**
+ * Events queued by call() within the loop thread and run by one iteration.
+ */
+static void BM_EventloopCall(benchmark::State &state)
+{
+    eventloop_t loop;
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        std::size_t done = 0;
+        for (std::size_t i = 0; i < batch; ++i) {
+            loop.call([&done] { ++done; });
+        }
+        loop.exec([&done, batch] { return done == batch; });
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_EventloopCall)->Arg(1)->Arg(1024);
+
+/**
+ * Events posted by another thread while the loop is running.
+ */
+static void BM_EventloopCallCrossThread(benchmark::State &state)
+{
+    background_loop_t background;
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        std::atomic<std::size_t> done{0};
+        for (std::size_t i = 0; i < batch; ++i) {
+            background.loop.call([&done] { ++done; });
+        }
+        while (done.load() != batch) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_EventloopCallCrossThread)->Arg(1)->Arg(1024)->UseRealTime();
+
+/**
+ * Time from notify() until a sleeping loop has finished the next iteration.
+ */
+static void BM_EventloopNotifyWakeup(benchmark::State &state)
+{
+    std::atomic<std::uint64_t> iterations{0};
+    background_loop_t background([&iterations](const fd_set &, const fd_set &,
+                                               const fd_set &) {
+        ++iterations;
+    });
+    for (auto _ : state) {
+        const std::uint64_t before = iterations.load();
+        background.loop.notify();
+        while (iterations.load() == before) {
+            std::this_thread::yield();
+        }
+    }
+}
+BENCHMARK(BM_EventloopNotifyWakeup)->UseRealTime();
+
+/**
+ * Cost of a non-blocking iteration by the amount of registered handlers.
+ */
+static void BM_EventloopIteration(benchmark::State &state)
+{
+    eventloop_t loop;
+    std::vector<eventloop_t::select_handle_t> handles;
+    for (int i = 0; i < state.range(0); ++i) {
+        handles.push_back(loop.register_handler(
+                [](const fd_set &, const fd_set &, const fd_set &) {},
+                [](fd_set &, fd_set &, fd_set &, int &,
+                   std::chrono::nanoseconds &timeout) {
+                    timeout = std::chrono::nanoseconds::zero();
+                }));
+    }
+    constexpr int batch = 64;
+    for (auto _ : state) {
+        int remaining = batch;
+        loop.exec([&remaining] { return remaining-- == 0; });
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+    for (const auto &handle : handles) {
+        loop.unregister_handler(handle);
+    }
+}
+BENCHMARK(BM_EventloopIteration)->Arg(1)->Arg(16)->Arg(256);
@@ -0,0 +1,84 @@
+#include <ostream>
+
+#include <boost/core/null_deleter.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
+#include <boost/make_shared.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <logging.hpp>
+
+
+LOG_MODULE("bench")
+
+
+namespace {
+    using sink_t = boost::log::sinks::synchronous_sink<
+        boost::log::sinks::text_ostream_backend>;
+
+    /**
+     * Sink formatting records into a stream without buffer, so only the
+     * costs of the macros and of the core are measured.
+     */
+    class null_sink_t {
+    public:
+        null_sink_t() {
+            using backend_t = boost::log::sinks::text_ostream_backend;
+            auto backend = boost::make_shared<backend_t>();
+            backend->add_stream(boost::shared_ptr<std::ostream>(
+                    &stream, boost::null_deleter()));
+            sink = boost::make_shared<sink_t>(backend);
+            boost::log::core::get()->add_sink(sink);
+        }
+        ~null_sink_t() {
+            boost::log::core::get()->remove_sink(sink);
+        }
+
+    private:
+        std::ostream stream{nullptr};
+        boost::shared_ptr<sink_t> sink;
+    };
+}
+
+
+static void BM_LogInfo(benchmark::State &state)
+{
+    logging_init();
+    null_sink_t sink;
+    int i = 0;
+    for (auto _ : state) {
+        LOG_INFO() << "Iteration " << ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogInfo);
+
+static void BM_LogStartSuccess(benchmark::State &state)
+{
+    logging_init();
+    null_sink_t sink;
+    for (auto _ : state) {
+        LOG_START() << "Start";
+        LOG_SUCCESS() << "Done";
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_LogStartSuccess);
+
+/**
+ * Records dropped by the core, e.g. debug records in production.
+ */
+static void BM_LogDisabled(benchmark::State &state)
+{
+    logging_init();
+    null_sink_t sink;
+    boost::log::core::get()->set_logging_enabled(false);
+    for (auto _ : state) {
+        LOG_DEBUG() << "Dropped";
+    }
+    boost::log::core::get()->set_logging_enabled(true);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogDisabled);
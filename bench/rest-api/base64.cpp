@@ -0,0 +1,38 @@
+#include <random>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <base64.hpp>
+
+
+static std::string random_bytes(std::size_t size)
+{
+    std::mt19937 rng(42);
+    std::string bytes(size, '\0');
+    for (char &byte : bytes) {
+        byte = static_cast<char>(rng());
+    }
+    return bytes;
+}
+
+
+static void BM_Base64Encode(benchmark::State &state)
+{
+    const std::string bin = random_bytes(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(b64_encode(bin));
+    }
+    state.SetBytesProcessed(state.iterations() * bin.size());
+}
+BENCHMARK(BM_Base64Encode)->Arg(20)->Arg(4096);
+
+static void BM_Base64Decode(benchmark::State &state)
+{
+    const std::string str = b64_encode(random_bytes(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(b64_decode(str));
+    }
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+BENCHMARK(BM_Base64Decode)->Arg(20)->Arg(4096);
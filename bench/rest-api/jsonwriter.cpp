@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <jsonwriter.hpp>
+
+
+namespace {
+    // Shape of the status records returned by the torrent list.
+    struct status_record_t {
+        unsigned char infohash[20];
+        std::string   name;
+        const char   *state;
+        std::uint64_t total_size;
+        std::uint64_t total_done;
+        double        progress;
+        int           download_rate;
+        int           upload_rate;
+        int           peers;
+        int           seeds;
+        std::int64_t  added_time;
+        double        ratio;
+    };
+
+    std::vector<status_record_t> make_records(std::size_t count) {
+        std::mt19937_64 rng(42);
+        std::vector<status_record_t> records(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            status_record_t &r = records[i];
+            for (unsigned char &byte : r.infohash)
+                byte = static_cast<unsigned char>(rng());
+            r.name = "Game Image " + std::to_string(i) + " (Multi \"Lang\")";
+            r.state = i % 3 ? "seeding" : "downloading";
+            r.total_size = rng() % (64ull << 30);
+            r.total_done = r.total_size / 2;
+            r.progress = 0.5;
+            r.download_rate = static_cast<int>(rng() % 100000000);
+            r.upload_rate = static_cast<int>(rng() % 100000000);
+            r.peers = static_cast<int>(rng() % 200);
+            r.seeds = static_cast<int>(rng() % 200);
+            r.added_time = 1500000000 + static_cast<std::int64_t>(i);
+            r.ratio = static_cast<double>(rng() % 10000) / 1000;
+        }
+        return records;
+    }
+
+    void write_record(json_writer_t &json, const status_record_t &r) {
+        json.begin_object()
+            .key("infohash").binary(r.infohash, sizeof(r.infohash))
+            .key("name").value(r.name)
+            .key("state").value(r.state)
+            .key("total_size").value(r.total_size)
+            .key("total_done").value(r.total_done)
+            .key("progress").value(r.progress)
+            .key("download_rate").value(r.download_rate)
+            .key("upload_rate").value(r.upload_rate)
+            .key("peers").value(r.peers)
+            .key("seeds").value(r.seeds)
+            .key("added_time").value(r.added_time)
+            .key("ratio").value(r.ratio)
+            .end_object();
+    }
+}
+
+
+static void BM_JsonWriterTorrentList(benchmark::State &state)
+{
+    const auto records = make_records(state.range(0));
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        buffer_chain_t out;
+        json_writer_t json(out);
+        json.begin_array();
+        for (const status_record_t &record : records) {
+            write_record(json, record);
+        }
+        json.end_array();
+        bytes += out.size();
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(state.iterations() * records.size());
+}
+BENCHMARK(BM_JsonWriterTorrentList)->Arg(10000);
+
+static void BM_JsonWriterEscapeString(benchmark::State &state)
+{
+    std::string str(state.range(0), 'x');
+    for (std::size_t i = 0; i < str.size(); i += 97) {
+        str[i] = '"';
+    }
+    for (auto _ : state) {
+        buffer_chain_t out;
+        json_writer_t json(out);
+        json.value(str);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+BENCHMARK(BM_JsonWriterEscapeString)->Arg(64)->Arg(4096);
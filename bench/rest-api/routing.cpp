@@ -0,0 +1,62 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <eventloop.hpp>
+#include <httpd.hpp>
+
+
+namespace {
+    /**
+     * Exposes the route lookup of {@link httpserver_t::handle_access()}.
+     * The daemon listens on a random port as `httpd.port` is not configured.
+     */
+    class routing_server_t : public httpserver_t {
+    public:
+        using httpserver_t::httpserver_t;
+        using httpserver_t::find_route;
+    };
+}
+
+
+/**
+ * Routing a request to one of the registered routes.
+ */
+static void BM_HttpRouteRequest(benchmark::State &state)
+{
+    eventloop_t eventloop;
+    routing_server_t server(&eventloop);
+    std::vector<std::string> paths;
+    for (int i = 0; i < state.range(0); ++i) {
+        paths.push_back("route-" + std::to_string(i));
+        server.add_route(MHD_HTTP_METHOD_GET, paths.back(),
+                         [](MHD_Connection *) {
+                             return [](MHD_Connection *, const char *,
+                                       std::size_t *) {};
+                         });
+    }
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const std::string &path = paths[i++ % paths.size()];
+        benchmark::DoNotOptimize(server.find_route(MHD_HTTP_METHOD_GET,
+                                                   path.c_str()));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HttpRouteRequest)->Arg(8)->Arg(64);
+
+/**
+ * Requests without a route, which are answered with 404.
+ */
+static void BM_HttpRouteMissing(benchmark::State &state)
+{
+    eventloop_t eventloop;
+    routing_server_t server(&eventloop);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(server.find_route(MHD_HTTP_METHOD_GET,
+                                                   "missing"));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HttpRouteMissing);
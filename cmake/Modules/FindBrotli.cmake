@@ -0,0 +1,45 @@
+# - Try to find the brotli encoder library
+#
+# Once done this will define
+#  Brotli_FOUND - System has the brotli encoder
+#  Brotli_INCLUDE_DIRS - The brotli include directories
+#  Brotli_LIBRARIES - The libraries needed to use the brotli encoder
+
+
+find_package(PkgConfig QUIET)
+
+if(PKG_CONFIG_FOUND)
+    pkg_check_modules(PC_BROTLI QUIET libbrotlienc)
+endif()
+
+find_path(Brotli_INCLUDE_DIR brotli/encode.h
+    HINTS ${PC_BROTLI_INCLUDEDIR} ${PC_BROTLI_INCLUDE_DIRS})
+
+find_library(Brotli_LIBRARY NAMES brotlienc
+    HINTS ${PC_BROTLI_LIBDIR} ${PC_BROTLI_LIBRARY_DIRS})
+
+find_library(Brotli_COMMON_LIBRARY NAMES brotlicommon
+    HINTS ${PC_BROTLI_LIBDIR} ${PC_BROTLI_LIBRARY_DIRS})
+
+set(Brotli_LIBRARIES ${Brotli_LIBRARY} ${Brotli_COMMON_LIBRARY})
+set(Brotli_INCLUDE_DIRS ${Brotli_INCLUDE_DIR})
+
+
+include(FindPackageHandleStandardArgs)
+# handle the QUIETLY and REQUIRED arguments and set Brotli_FOUND to TRUE
+# if all listed variables are TRUE
+find_package_handle_standard_args(Brotli DEFAULT_MSG
+    Brotli_LIBRARY Brotli_COMMON_LIBRARY Brotli_INCLUDE_DIR)
+mark_as_advanced(Brotli_INCLUDE_DIR Brotli_LIBRARY Brotli_COMMON_LIBRARY)
+
+if (Brotli_FOUND AND NOT TARGET Brotli::Encoder)
+    add_library(Brotli::Encoder UNKNOWN IMPORTED)
+
+    set_target_properties(Brotli::Encoder PROPERTIES
+        IMPORTED_LINK_INTERFACE_LANGUAGES "C"
+        IMPORTED_LOCATION "${Brotli_LIBRARY}"
+        INTERFACE_INCLUDE_DIRECTORIES "${Brotli_INCLUDE_DIRS}"
+        INTERFACE_SYSTEM_INCLUDE_DIRECTORIES "${Brotli_INCLUDE_DIRS}"
+        INTERFACE_LINK_LIBRARIES "${Brotli_COMMON_LIBRARY}"
+    )
+endif()
@@ -1,28 +1,58 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <new>
+#include <string>
+#include <vector>
 
 #include <signal.h>
 #include <sysexits.h>
+#include <unistd.h>
 
 #ifdef XLTS_USE_SYSTEMD
 #   include <systemd/sd-daemon.h>
 #endif
 
+#include <admission.hpp>
+#include <bandwidth.hpp>
+#include <bandwidthapi.hpp>
 #include <configuration.hpp>
+#include <diskapi.hpp>
+#include <diskscheduler.hpp>
 #include <errorhandling.hpp>
 #include <eventloop.hpp>
+#include <filemover.hpp>
+#include <filesearch.hpp>
 #include <httpd.hpp>
 #include <logging.hpp>
+#include <moverapi.hpp>
+#include <requesttrace.hpp>
+#include <responsecache.hpp>
+#include <searchapi.hpp>
+#include <sockethandoff.hpp>
+#include <statsstream.hpp>
+#include <statusexport.hpp>
+#include <torrentindex.hpp>
+#include <torrentsapi.hpp>
+#include <torrentstatus.hpp>
+#include <torrentupload.hpp>
 
 
 static bool should_stop = false;
+static bool should_reload = false;
 
+//! Time requests may take to complete after the listening socket has been
+//! handed over to a new process.
+static constexpr std::chrono::seconds handoff_drain_timeout(5);
 
-static void sighandler(int)
+
+static void sighandler(int signum)
 {
-    should_stop = true;
+    if (signum == SIGHUP)
+        should_reload = true;
+    else
+        should_stop = true;
 }
 
 #ifdef XLTS_USE_SYSTEMD
@@ -38,6 +68,77 @@ static void sighandler(int)
     }
 #endif
 
+static admission_control_t::limits_t admission_limits(
+        const configuration_t &configuration)
+{
+    admission_control_t::limits_t limits;
+    limits.max_lag = std::chrono::milliseconds(
+            std::max(configuration.httpd.max_loop_lag, 0));
+    limits.max_suspended = static_cast<std::size_t>(
+            std::max(configuration.httpd.max_suspended, 0));
+    return limits;
+}
+
+static bandwidth_scheduler_t::limits_t bandwidth_limits(
+        const configuration_t &configuration)
+{
+    bandwidth_scheduler_t::limits_t limits;
+    limits.global = static_cast<std::uint64_t>(
+            std::max(configuration.httpd.rate_limit, 0)) << 10;
+    limits.client = static_cast<std::uint64_t>(
+            std::max(configuration.httpd.client_rate_limit, 0)) << 10;
+    limits.download = static_cast<std::uint64_t>(
+            std::max(configuration.httpd.download_rate_limit, 0)) << 10;
+    return limits;
+}
+
+/**
+ * Reloads the configuration and applies the settings which can change while
+ * running. Keeps the current configuration if the new one is invalid.
+ */
+static void reload(admission_control_t &admission,
+                   bandwidth_scheduler_t &bandwidth,
+                   response_cache_t &response_cache,
+                   torrent_upload_t &torrent_upload)
+{
+#   ifdef XLTS_USE_SYSTEMD
+        sd_notify(0, "RELOADING=1\n"
+                     "STATUS=Reloading configuration ...\n");
+#   endif
+
+    LOG_START() << "Reloading configuration ...";
+    try {
+        const configuration_t *previous = current_config();
+        std::vector<std::string> pending;
+        const configuration_t *next = reload_configuration(pending);
+        for (const std::string &name : pending) {
+            LOG_WARN() << "Changed setting " << name
+                       << " takes effect after restart";
+        }
+        admission.set_limits(admission_limits(*next));
+        // Keep limits set by the API unless the settings have changed.
+        if (next->httpd.rate_limit != previous->httpd.rate_limit
+                || next->httpd.client_rate_limit
+                   != previous->httpd.client_rate_limit
+                || next->httpd.download_rate_limit
+                   != previous->httpd.download_rate_limit) {
+            bandwidth.set_limits(bandwidth_limits(*next));
+        }
+        response_cache.set_budget(
+                static_cast<std::size_t>(next->httpd.cache_size) << 20);
+        torrent_upload.set_limit(
+                static_cast<std::size_t>(next->httpd.upload_limit) << 20);
+        LOG_SUCCESS() << "Configuration reloaded";
+    } catch (const configuration_error &e) {
+        LOG_FAILURE(e) << e.what();
+    }
+
+#   ifdef XLTS_USE_SYSTEMD
+        sd_notify(0, "READY=1\n"
+                     "STATUS=Application is running ...\n");
+#   endif
+}
+
 static void main0(int argc, char *argv[])
 {
     using std::chrono::microseconds;
@@ -68,7 +169,8 @@ static void main0(int argc, char *argv[])
                                                       // mask them.
     OSCHECK(pthread_sigmask,(SIG_SETMASK, &signal_mask, nullptr), == 0);
 
-    // Register signal handlers to quit the application properly.
+    // Register signal handlers to quit the application properly and to reload
+    // the configuration.
     struct sigaction act;
     act.sa_handler = &sighandler;
     act.sa_flags   = 0;
@@ -80,13 +182,99 @@ static void main0(int argc, char *argv[])
     if (sigaction(SIGTERM, &act, nullptr) < 0) {
         OSERROR(sigaction, "Could not set signal handler for SIGTERM");
     }
+    if (sigaction(SIGHUP, &act, nullptr) < 0) {
+        OSERROR(sigaction, "Could not set signal handler for SIGHUP");
+    }
 
     // Start up application (initialize components)
     LOG_START() << "Initialize components ...";
     eventloop_t eventloop;
-    httpserver_t httpserver(&eventloop);
+    torrent_status_store_t torrent_status;
+    torrent_index_t torrent_index(&torrent_status);
+    file_search_index_t file_search;
+    disk_scheduler_t disk_scheduler(2, config.torrent.lowdiskprio);
+    // Moves completed downloads once a session submits them.
+    file_mover_t file_mover(&eventloop, config.torrent.read_os_cache,
+                            config.torrent.write_os_cache);
+    std::unique_ptr<trace_writer_t> request_trace;
+    if (!config.httpd.trace_file.empty()) {
+        request_trace.reset(new trace_writer_t(config.httpd.trace_file,
+                                               &eventloop));
+    }
+    // Take over the listening socket of a running process, so no connection
+    // is refused during a restart. Otherwise, use the socket passed by systemd.
+    int listen_fd = -1;
+    if (!config.httpd.handoff_socket.empty()) {
+        listen_fd = socket_handoff_t::receive_listen_socket(
+                config.httpd.handoff_socket);
+        if (listen_fd >= 0) {
+            LOG_INFO() << "Took over listening socket of running process";
+        }
+    }
+#   ifdef XLTS_USE_SYSTEMD
+        if (listen_fd < 0 && sd_listen_fds(true) > 0) {
+            listen_fd = SD_LISTEN_FDS_START;
+        }
+#   endif
+    // Outlives the server, which destroys the paced downloads.
+    bandwidth_scheduler_t bandwidth(&eventloop, bandwidth_limits(config));
+    httpserver_t httpserver(&eventloop, listen_fd);
+    httpserver.set_request_trace(request_trace.get());
+    admission_control_t admission(&eventloop, admission_limits(config));
+    httpserver.set_admission_control(&admission);
+    response_cache_t response_cache(
+            &httpserver, static_cast<std::size_t>(config.httpd.cache_size) << 20);
+    torrents_api_t torrents_api(&eventloop, &httpserver, &response_cache,
+                                &torrent_status, &torrent_index);
+    search_api_t search_api(&httpserver, &file_search);
+    bandwidth_api_t bandwidth_api(&httpserver, &bandwidth);
+    disk_api_t disk_api(&httpserver, &disk_scheduler);
+    mover_api_t mover_api(&httpserver, &file_mover);
+    stats_stream_t stats_stream(&eventloop, &httpserver, &torrent_status);
+    std::unique_ptr<status_export_t> status_export;
+    if (!config.httpd.status_shm.empty()) {
+        status_export.reset(new status_export_t(
+                &eventloop, &torrent_status, config.httpd.status_shm));
+    }
+    torrent_upload_t torrent_upload(
+            &eventloop, &httpserver, &disk_scheduler, config.storage.torrents,
+            static_cast<std::size_t>(config.httpd.upload_limit) << 20);
+    bool handed_over = false, drain_expired = false;
+    std::unique_ptr<socket_handoff_t> handoff;
+    if (!config.httpd.handoff_socket.empty()) {
+        handoff.reset(new socket_handoff_t(
+                &eventloop, config.httpd.handoff_socket,
+                [&] { return httpserver.listen_socket(); },
+                [&] {
+            // The new process publishes the status from now on.
+            if (status_export) {
+                status_export->hand_over();
+            }
+            // The new process has its own copy of the socket.
+            const int fd = httpserver.quiesce();
+            if (fd >= 0) {
+                close(fd);
+            }
+            handed_over = true;
+            eventloop.call([&] { drain_expired = true; },
+                           handoff_drain_timeout);
+        }));
+    }
     LOG_SUCCESS() << "Ready";
 
+    // Reload configuration on SIGHUP. The signal interrupts select(), so the
+    // handler runs right after it has been received.
+    eventloop.register_handler(
+            [&](const fd_set &, const fd_set &, const fd_set &) {
+                if (should_reload) {
+                    should_reload = false;
+                    reload(admission, bandwidth, response_cache,
+                           torrent_upload);
+                }
+            },
+            [](fd_set &, fd_set &, fd_set &, int &,
+               std::chrono::nanoseconds &) {});
+
     // Send status updates when using Systemd
 #   ifdef XLTS_USE_SYSTEMD
         std::uint64_t watchdog_usec;
@@ -102,7 +290,11 @@ static void main0(int argc, char *argv[])
 
     // Run eventloop
     OSCHECK(sigemptyset,(&signal_mask), == 0);
-    eventloop.exec([&] { return should_stop; }, &signal_mask);
+    // After a handoff, quit when all requests have completed.
+    eventloop.exec([&] {
+        return should_stop || (handed_over && (drain_expired
+                || httpserver.active_requests() == 0));
+    }, &signal_mask);
 
     // Notify Systemd about shutdown
 #   ifdef XLTS_USE_SYSTEMD
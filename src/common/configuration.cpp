@@ -1,7 +1,15 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <sysexits.h>
 #include <syslog.h>
@@ -13,6 +21,7 @@
 
 #include <buildconf.h>
 #include <configuration.hpp>
+#include <errorhandling.hpp>
 
 using boost::program_options::bool_switch;
 using boost::program_options::command_line_parser;
@@ -30,6 +39,14 @@ using std::string;
 static configuration_t cfg;
 const configuration_t &config = cfg;
 
+//! Every configuration published so far. Snapshots are never freed, so
+//! readers need no reference counting. Only changed by publish().
+static std::deque<std::unique_ptr<const configuration_t>> snapshots;
+//! Configuration in effect, replaced by reload_configuration().
+static std::atomic<const configuration_t*> snapshot{nullptr};
+//! Command line arguments, parsed again by reload_configuration().
+static std::vector<std::string> arguments;
+
 
 static void validate(boost::any &v, const std::vector<std::string> &values,
                      storage_format_e* target_type, int)
@@ -56,58 +73,62 @@ static void validate(boost::any &v, const std::vector<std::string> &values,
 }
 
 
-void load_configuration(int argc, const char *const argv[])
+static options_description command_line_options(configuration_t &c)
 {
-    // Define configuration options
-    options_description clidesc("Command line only");
-    clidesc.add_options()
+    options_description desc("Command line only");
+    desc.add_options()
             ("help,h",    "Show help message.")
             ("verbose,v", "Print log to stderr.")
             ("version",   "Print version string.")
-            ("inifile",   value<string>(&cfg.inifile)
+            ("inifile",   value<string>(&c.inifile)
                           ->value_name("file")
                           ->default_value(XLTS_DEFAULT_INIFILE),
                           "Path to configuration file.")
             ;
-    options_description genericdesc("Configuration");
-    genericdesc.add_options()
+    return desc;
+}
+
+static options_description generic_options(configuration_t &c)
+{
+    options_description desc("Configuration");
+    desc.add_options()
             ("storage.downloads",
-                 value<string>(&cfg.storage.downloads)
+                 value<string>(&c.storage.downloads)
                  ->value_name("directory")
                  ->default_value(XLTS_DEFAULT_DOWNLOADDIR),
                  "Directory to store downloaded files.")
             ("storage.resumedata",
-                 value<string>(&cfg.storage.resumedata)
+                 value<string>(&c.storage.resumedata)
                  ->value_name("directory")
                  ->default_value(XLTS_DEFAULT_RESUMEDATADIR),
                  "Directory to store resume data.")
             ("storage.tmpdir",
-                 value<string>(&cfg.storage.tmpdir)
+                 value<string>(&c.storage.tmpdir)
                  ->value_name("directory")
                  ->default_value(""),
                  "Directory to store files before fully downloaded.")
             ("storage.torrents",
-                 value<string>(&cfg.storage.torrents)
+                 value<string>(&c.storage.torrents)
                  ->value_name("directory")
                  ->default_value(XLTS_DEFAULT_TORRENTDIR),
                  "Directory to store torrent files.")
             ("storage.format",
-                 value<storage_format_e>(&cfg.storage.format)
+                 value<storage_format_e>(&c.storage.format)
                  ->value_name("format")
                  ->default_value(storage_format_e::PLAIN, "plain"),
                  "Used format to store downloaded files.")
             ("storage.use-sparse-files",
-                 bool_switch(&cfg.storage.use_sparse_files)
+                 bool_switch(&c.storage.use_sparse_files)
                  ->default_value(false),
                  "Use sparse files to store yet incomplete data.")
 
             ("torrent.cachesize",
-                 value<int>(&cfg.torrent.cachesize)
+                 value<int>(&c.torrent.cachesize)
                  ->value_name("num_blocks")
                  ->default_value(1024),
                  "Size of read/write cache as amount of 16 KiB blocks.")
             ("torrent.cachefile",
-                 value<string>(&cfg.torrent.cachefile)
+                 value<string>(&c.torrent.cachefile)
                  ->value_name("file")
                  ->default_value(""),
                  "Specifies a file to be used as read/write cache. The file "
@@ -116,49 +137,346 @@ void load_configuration(int argc, const char *const argv[])
                  "RAM. This will disable contiguous_recv_buffer and can impact "
                  "seeding performance.")
             ("torrent.read-cache-line-size",
-                 value<int>(&cfg.torrent.read_cacheline_size)
+                 value<int>(&c.torrent.read_cacheline_size)
                  ->value_name("num_blocks")
                  ->default_value(32),
                  "Number of blocks to read on cache miss.")
             ("torrent.write-cache-line-size",
-                 value<int>(&cfg.torrent.write_cacheline_size)
+                 value<int>(&c.torrent.write_cacheline_size)
                  ->value_name("num_blocks")
                  ->default_value(16),
                  "Number of blocks to cache before they are flushed.")
             ("torrent.read-os-cache",
-                 value<bool>(&cfg.torrent.read_os_cache)
+                 value<bool>(&c.torrent.read_os_cache)
                  ->default_value(true),
                  "Enable or disable os cache while reading files.")
             ("torrent.write-os-cache",
-                 value<bool>(&cfg.torrent.write_os_cache)
+                 value<bool>(&c.torrent.write_os_cache)
                  ->default_value(true),
                  "Enable or disable os cache while writing files.")
             ("torrent.low-disk-priority",
-                 value<bool>(&cfg.torrent.lowdiskprio)
+                 value<bool>(&c.torrent.lowdiskprio)
                  ->implicit_value(true)->zero_tokens()
                  ->default_value(false),
                  "Use low priority for disk I/O.")
             ("torrent.file-pool-size",
-                 value<int>(&cfg.torrent.file_pool_size)
+                 value<int>(&c.torrent.file_pool_size)
                  ->default_value(40),
                  "Upper limit on the total number of files the torrent session "
                  " will keep open.")
             ("torrent.make-suggestions",
-                 bool_switch(&cfg.torrent.suggestions)
+                 bool_switch(&c.torrent.suggestions)
                  ->default_value(false),
                  "Make suggestions about pieces that are in cache already.")
 
             ("httpd.port",
-                 value<std::uint16_t>(&cfg.httpd.port)
+                 value<std::uint16_t>(&c.httpd.port)
                  ->value_name("port")
                  ->default_value(8080),
                  "Port to listen on for HTTP requests")
             ("httpd.prefix",
-                 value<string>(&cfg.httpd.prefix)
+                 value<string>(&c.httpd.prefix)
                  ->value_name("prefix")
                  ->default_value("/"),
                  "Prefix for paths used by the HTTP server")
+            ("httpd.readahead-budget",
+                 value<int>(&c.httpd.readahead_budget)
+                 ->value_name("MiB")
+                 ->default_value(256),
+                 "Amount of memory which may be used to prefetch files that "
+                 "are downloaded sequentially.")
+            ("httpd.longpoll-timeout",
+                 value<int>(&c.httpd.longpoll_timeout)
+                 ->value_name("seconds")
+                 ->default_value(30),
+                 "Maximal time a request for status changes is kept open "
+                 "while nothing changes.")
+            ("httpd.stats-interval",
+                 value<int>(&c.httpd.stats_interval)
+                 ->value_name("ms")
+                 ->default_value(1000),
+                 "Interval of the live statistics pushed to clients. At least "
+                 "10 ms.")
+            ("httpd.cache-size",
+                 value<int>(&c.httpd.cache_size)
+                 ->value_name("MiB")
+                 ->default_value(64),
+                 "Amount of memory used to cache responses.")
+            ("httpd.worker-threads",
+                 value<int>(&c.httpd.worker_threads)
+                 ->default_value(4),
+                 "Amount of threads running blocking request handlers.")
+            ("httpd.worker-queue",
+                 value<int>(&c.httpd.worker_queue)
+                 ->default_value(64),
+                 "Amount of blocking requests which may wait for a worker. "
+                 "Further requests are rejected with status 503.")
+            ("httpd.upload-limit",
+                 value<int>(&c.httpd.upload_limit)
+                 ->value_name("MiB")
+                 ->default_value(16),
+                 "Maximal size of all torrent files uploaded by one request.")
+            ("httpd.max-loop-lag",
+                 value<int>(&c.httpd.max_loop_lag)
+                 ->value_name("ms")
+                 ->default_value(250),
+                 "Lag of the event loop above which new requests for status "
+                 "and statistics are rejected with status 503. Zero disables "
+                 "the limit.")
+            ("httpd.max-suspended",
+                 value<int>(&c.httpd.max_suspended)
+                 ->default_value(1024),
+                 "Amount of connections waiting for work in progress "
+                 "(blocking requests and uploads) above which new requests "
+                 "for status and statistics are rejected with status 503. "
+                 "Long polling and streams are not counted. Zero disables "
+                 "the limit.")
+            ("httpd.rate-limit",
+                 value<int>(&c.httpd.rate_limit)
+                 ->value_name("KiB/s")
+                 ->default_value(0),
+                 "Rate all file downloads may send in total. Zero disables "
+                 "the limit.")
+            ("httpd.client-rate-limit",
+                 value<int>(&c.httpd.client_rate_limit)
+                 ->value_name("KiB/s")
+                 ->default_value(0),
+                 "Rate the file downloads of a single client address may send "
+                 "in total. Zero disables the limit.")
+            ("httpd.download-rate-limit",
+                 value<int>(&c.httpd.download_rate_limit)
+                 ->value_name("KiB/s")
+                 ->default_value(0),
+                 "Rate a single file download may send. Zero disables the "
+                 "limit.")
+            ("httpd.status-shm",
+                 value<string>(&c.httpd.status_shm)
+                 ->value_name("name")
+                 ->default_value(""),
+                 "POSIX shared memory object the status of the torrents is "
+                 "published to every httpd.stats-interval for local "
+                 "monitoring tools, e.g. lan-torrent-server-status.")
+            ("httpd.trace-file",
+                 value<string>(&c.httpd.trace_file)
+                 ->value_name("file")
+                 ->default_value(""),
+                 "Record all requests to this file for replay by "
+                 "lan-torrent-server-load.")
+            ("httpd.handoff-socket",
+                 value<string>(&c.httpd.handoff_socket)
+                 ->value_name("file")
+                 ->default_value(""),
+                 "Unix socket used to pass the listening socket to a new "
+                 "process of the application, which is started while this "
+                 "one is still running.")
+            ("httpd.unix-socket",
+                 value<string>(&c.httpd.unix_socket)
+                 ->value_name("file")
+                 ->default_value(""),
+                 "Unix socket the HTTP server listens on in addition to "
+                 "httpd.port. Local clients may be identified by their "
+                 "credentials instead of their address.")
+            ("httpd.unix-socket-mode",
+                 value<string>(&c.httpd.unix_socket_mode)
+                 ->value_name("mode")
+                 ->default_value("0660"),
+                 "Permissions of httpd.unix-socket as octal number.")
             ;
+    return desc;
+}
+
+/**
+ * Parses the configuration file into @p c. Values already stored in @p vm
+ * take precedence.
+ */
+static void parse_inifile(configuration_t &c, variables_map &vm)
+{
+    if (!c.inifile.empty()) {
+        store(parse_config_file<char>(c.inifile.c_str(), generic_options(c)),
+              vm);
+        notify(vm);
+    }
+}
+
+static struct stat stat_directory(const string &path)
+{
+    struct stat result;
+    if (stat(path.c_str(), &result)) {
+        THROW(os_file_error("Cannot access storage directory"))
+                << errinfo::function("stat") << errinfo::errnum(errno)
+                << errinfo::filename(path);
+    }
+    return result;
+}
+
+/**
+ * Ensures that the setting @p name is at least @p min and at most @p max.
+ */
+static void check_range(int value, int min, int max, const char *name)
+{
+    if (value < min || value > max) {
+        throw configuration_error(string(name) + " has to be between "
+                                  + std::to_string(min) + " and "
+                                  + std::to_string(max) + ".");
+    }
+}
+
+/**
+ * Ensures that the numeric settings of the HTTP server are in the range their
+ * users expect. Sizes in MiB have to fit into `size_t` as bytes.
+ */
+static void check_httpd_ranges(const configuration_t::httpd_t &httpd)
+{
+    const int max_mib = static_cast<int>(std::min<std::size_t>(
+            std::numeric_limits<int>::max(),
+            std::numeric_limits<std::size_t>::max() >> 20));
+    const int max_kib = static_cast<int>(std::min<std::size_t>(
+            std::numeric_limits<int>::max(),
+            std::numeric_limits<std::size_t>::max() >> 10));
+    check_range(httpd.readahead_budget, 0, max_mib, "httpd.readahead-budget");
+    check_range(httpd.longpoll_timeout, 0, 86400, "httpd.longpoll-timeout");
+    check_range(httpd.stats_interval, 10, 3600000, "httpd.stats-interval");
+    check_range(httpd.cache_size, 0, max_mib, "httpd.cache-size");
+    check_range(httpd.worker_threads, 1, 1024, "httpd.worker-threads");
+    check_range(httpd.worker_queue, 0, 1 << 20, "httpd.worker-queue");
+    check_range(httpd.upload_limit, 1, max_mib, "httpd.upload-limit");
+    check_range(httpd.max_loop_lag, 0, 3600000, "httpd.max-loop-lag");
+    check_range(httpd.max_suspended, 0, std::numeric_limits<int>::max(),
+                "httpd.max-suspended");
+    check_range(httpd.rate_limit, 0, max_kib, "httpd.rate-limit");
+    check_range(httpd.client_rate_limit, 0, max_kib,
+                "httpd.client-rate-limit");
+    check_range(httpd.download_rate_limit, 0, max_kib,
+                "httpd.download-rate-limit");
+}
+
+/**
+ * Derives and checks values which depend on each other.
+ *
+ * @throws configuration_error if the values are inconsistent.
+ * @throws os_file_error if a directory cannot be inspected.
+ */
+static void finish_configuration(configuration_t &c)
+{
+    // Set `c.storage.tmpdir` to `c.storage.downloads` if not set.
+    // Otherwise, ensure that both pathes are on the same filesystem.
+    if (c.storage.tmpdir.empty()) {
+        c.storage.tmpdir = c.storage.downloads;
+    } else {
+        const struct stat tmpdirStat = stat_directory(c.storage.tmpdir);
+        const struct stat downloadsStat = stat_directory(c.storage.downloads);
+        if (tmpdirStat.st_dev != downloadsStat.st_dev) {
+            throw configuration_error("storage.tmpdir and storage.downloads "
+                                      "have to be on the same filesystem.");
+        }
+    }
+
+    // Ensure that `c.httpd.prefix` starts and ends with '/'.
+    if (c.httpd.prefix.back() != '/')
+        c.httpd.prefix = c.httpd.prefix + "/";
+    if (c.httpd.prefix.front() != '/')
+        c.httpd.prefix = "/" + c.httpd.prefix;
+
+    // Ensure that `c.httpd.unix_socket_mode` is an octal file mode.
+    const string &mode = c.httpd.unix_socket_mode;
+    if (mode.empty() || mode.size() > 4
+            || mode.find_first_not_of("01234567") != string::npos) {
+        throw configuration_error("httpd.unix-socket-mode has to be an octal "
+                                  "file mode, e.g. 0660.");
+    }
+
+    check_httpd_ranges(c.httpd);
+}
+
+/**
+ * Resets @p next to @p current for a setting which cannot change while
+ * running, and appends its name to @p changed if it differs.
+ */
+template<typename T>
+static void keep(T &next, const T &current, const char *name,
+                 std::vector<string> &changed)
+{
+    if (!(next == current)) {
+        changed.emplace_back(name);
+        next = current;
+    }
+}
+
+static void keep_static_settings(configuration_t &next,
+                                 const configuration_t &current,
+                                 std::vector<string> &changed)
+{
+    configuration_t::storage_t &storage = next.storage;
+    const configuration_t::storage_t &storage0 = current.storage;
+    keep(storage.downloads,  storage0.downloads,  "storage.downloads",
+         changed);
+    keep(storage.resumedata, storage0.resumedata, "storage.resumedata",
+         changed);
+    keep(storage.tmpdir,     storage0.tmpdir,     "storage.tmpdir", changed);
+    keep(storage.torrents,   storage0.torrents,   "storage.torrents", changed);
+    keep(storage.format,     storage0.format,     "storage.format", changed);
+    keep(storage.use_sparse_files, storage0.use_sparse_files,
+         "storage.use-sparse-files", changed);
+
+    configuration_t::torrent_t &torrent = next.torrent;
+    const configuration_t::torrent_t &torrent0 = current.torrent;
+    keep(torrent.cachesize,  torrent0.cachesize,  "torrent.cachesize",
+         changed);
+    keep(torrent.cachefile,  torrent0.cachefile,  "torrent.cachefile",
+         changed);
+    keep(torrent.read_cacheline_size, torrent0.read_cacheline_size,
+         "torrent.read-cache-line-size", changed);
+    keep(torrent.write_cacheline_size, torrent0.write_cacheline_size,
+         "torrent.write-cache-line-size", changed);
+    keep(torrent.read_os_cache,  torrent0.read_os_cache,
+         "torrent.read-os-cache", changed);
+    keep(torrent.write_os_cache, torrent0.write_os_cache,
+         "torrent.write-os-cache", changed);
+    keep(torrent.lowdiskprio,    torrent0.lowdiskprio,
+         "torrent.low-disk-priority", changed);
+    keep(torrent.file_pool_size, torrent0.file_pool_size,
+         "torrent.file-pool-size", changed);
+    keep(torrent.suggestions,    torrent0.suggestions,
+         "torrent.make-suggestions", changed);
+
+    configuration_t::httpd_t &httpd = next.httpd;
+    const configuration_t::httpd_t &httpd0 = current.httpd;
+    keep(httpd.port,   httpd0.port,   "httpd.port", changed);
+    keep(httpd.prefix, httpd0.prefix, "httpd.prefix", changed);
+    keep(httpd.readahead_budget, httpd0.readahead_budget,
+         "httpd.readahead-budget", changed);
+    keep(httpd.worker_threads, httpd0.worker_threads,
+         "httpd.worker-threads", changed);
+    keep(httpd.worker_queue, httpd0.worker_queue, "httpd.worker-queue",
+         changed);
+    keep(httpd.status_shm,   httpd0.status_shm,   "httpd.status-shm", changed);
+    keep(httpd.trace_file,   httpd0.trace_file,   "httpd.trace-file", changed);
+    keep(httpd.handoff_socket, httpd0.handoff_socket,
+         "httpd.handoff-socket", changed);
+    keep(httpd.unix_socket, httpd0.unix_socket, "httpd.unix-socket",
+         changed);
+    keep(httpd.unix_socket_mode, httpd0.unix_socket_mode,
+         "httpd.unix-socket-mode", changed);
+}
+
+/**
+ * Makes @p next the configuration returned by current_config(). Reloads are
+ * rare, so keeping every snapshot costs little.
+ */
+static const configuration_t *publish(configuration_t next)
+{
+    snapshots.emplace_back(new configuration_t(std::move(next)));
+    const configuration_t *result = snapshots.back().get();
+    snapshot.store(result, std::memory_order_release);
+    return result;
+}
+
+
+void load_configuration(int argc, const char *const argv[])
+{
+    configuration_t next;
+    options_description clidesc = command_line_options(next);
+    options_description genericdesc = generic_options(next);
 
     variables_map vm;
     // Parse command line options
@@ -197,44 +515,89 @@ void load_configuration(int argc, const char *const argv[])
 
     // Parse configuration file
     try {
-        if (!cfg.inifile.empty()) {
-            options_description desc;
-            desc.add(genericdesc);
-            store(parse_config_file<char>(cfg.inifile.c_str(), desc), vm);
-            notify(vm);
-        }
+        parse_inifile(next, vm);
     } catch (boost::program_options::reading_file &e) {
-        cerr << "Could not read configuration file: " << cfg.inifile << "\n"
+        cerr << "Could not read configuration file: " << next.inifile << "\n"
              << "    " << e.what() << std::endl;
         std::exit(EX_CONFIG);
     } catch (boost::program_options::error_with_option_name &e) {
-        cerr << "Invalid configuration file: " << cfg.inifile << "\n"
+        cerr << "Invalid configuration file: " << next.inifile << "\n"
              << "    " << e.what() << std::endl;
         std::exit(EX_CONFIG);
     }
 
-    // Set `cfg.storage.tmpdir` to `cfg.storage.downloads` if not set.
-    // Otherwise, ensure that both pathes are on the same filesystem.
-    if (cfg.storage.tmpdir.empty()) {
-        cfg.storage.tmpdir = cfg.storage.downloads;
-    } else {
-        struct stat tmpdirStat, downloadsStat;
-        if (stat(cfg.storage.tmpdir.c_str(), &tmpdirStat)) {
-            std::perror("stat() on storage.tmpdir failed");
-            std::exit(EX_OSERR);
-        } else if (stat(cfg.storage.downloads.c_str(), &downloadsStat)) {
-            std::perror("stat() on storage.downloads failed");
-            std::exit(EX_OSERR);
-        } else if (tmpdirStat.st_dev != downloadsStat.st_dev) {
-            std::cerr << "storage.tmpdir and storage.downloads have to be on "
-                      << "the same filesystem." << std::endl;
-            std::exit(EX_CONFIG);
+    try {
+        finish_configuration(next);
+    } catch (const os_error &e) {
+        const int *errnum = boost::get_error_info<errinfo::errnum>(e);
+        const string *path = boost::get_error_info<errinfo::filename>(e);
+        cerr << "stat() on " << (path ? *path : string()) << " failed: "
+             << std::strerror(errnum ? *errnum : 0) << std::endl;
+        std::exit(EX_OSERR);
+    } catch (const configuration_error &e) {
+        cerr << e.what() << std::endl;
+        std::exit(EX_CONFIG);
+    }
+
+    arguments.assign(argv, argv + argc);
+    cfg = next;
+    publish(std::move(next));
+}
+
+/**
+ * Parses the command line of load_configuration() and the configuration file
+ * again and publishes the result for current_config().
+ *
+ * Settings which cannot change while running keep their current value. Must
+ * not be called concurrently.
+ *
+ * @param[out] pending Receives the names of changed settings which take
+ *                     effect after restart.
+ * @return The new configuration.
+ * @throws configuration_error if the configuration is invalid. The current
+ *         configuration stays in effect.
+ */
+const configuration_t *reload_configuration(std::vector<string> &pending)
+{
+    const configuration_t *current = current_config();
+    ASSERT(current);
+
+    configuration_t next;
+    try {
+        std::vector<const char*> argv;
+        for (const string &arg : arguments) {
+            argv.push_back(arg.c_str());
         }
+        options_description desc;
+        desc.add(command_line_options(next)).add(generic_options(next));
+        variables_map vm;
+        store(command_line_parser(static_cast<int>(argv.size()), argv.data())
+                .options(desc)
+                .positional({}).run(),
+              vm);
+        notify(vm);
+        parse_inifile(next, vm);
+        finish_configuration(next);
+    } catch (const boost::program_options::error &e) {
+        throw configuration_error(
+                "Invalid configuration file: " + next.inifile + ": "
+                + e.what());
+    } catch (const os_error &e) {
+        throw configuration_error(
+                string("Invalid storage directories: ") + e.what());
     }
 
-    // Ensure that `cfg.httpd.prefix` starts and ends with '/'.
-    if (cfg.httpd.prefix.back() != '/')
-        cfg.httpd.prefix = cfg.httpd.prefix + "/";
-    if (cfg.httpd.prefix.front() != '/')
-        cfg.httpd.prefix = "/" + cfg.httpd.prefix;
+    keep_static_settings(next, *current, pending);
+    return publish(std::move(next));
+}
+
+/**
+ * Returns the configuration in effect.
+ *
+ * The returned snapshot never changes and is never freed. Thread-safe and
+ * lock-free, so it may be called for every request.
+ */
+const configuration_t *current_config() noexcept
+{
+    return snapshot.load(std::memory_order_acquire);
 }
@@ -11,7 +11,9 @@ const char *basic_error::what() const noexcept
 basic_error::basic_error(const char *what) : mWhat(what) {}
 assertion_error::assertion_error(const char *what) : basic_error(what) {}
 os_error::os_error(const char *what) : basic_error(what) {}
-os_file_error::os_file_error(const char *what) : os_error(what) {}
+// The virtual base is initialized by the most derived class.
+os_file_error::os_file_error(const char *what)
+    : basic_error(what), os_error(what) {}
 
 const char *crop_ampersand_and_stdnamespace(const char *str) noexcept
 {
@@ -9,10 +9,16 @@
  * {@link configuration_t}. Other components can access the configuration
  * through this variable. It is initialized by {@link load_configuration()}
  * which is executed when starting the application.
+ *
+ * Settings which can change while running are read from current_config()
+ * instead. The application reloads the configuration on `SIGHUP` by
+ * reload_configuration().
  */
 
 #include <cstdint>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 
 /**
@@ -48,8 +54,8 @@ struct configuration_t {
         std::string cachefile; //!< A cachefile to use.
         int         read_cacheline_size;
         int         write_cacheline_size;
-        bool        read_os_cache;
-        bool        write_os_cache;
+        bool        read_os_cache;  //!< Use page cache when reading files.
+        bool        write_os_cache; //!< Use page cache when writing files.
         bool        lowdiskprio; //!< Use low priority for disk I/O.
         int         file_pool_size;
         bool        suggestions;
@@ -60,14 +66,61 @@ struct configuration_t {
         std::string   prefix;
         //! Port used by HTTP server.
         std::uint16_t port;
+        //! Memory in MiB which may be prefetched for all file downloads.
+        int           readahead_budget;
+        //! Seconds a request for status changes waits for changes at most.
+        int           longpoll_timeout;
+        //! Milliseconds between two events of the statistics stream.
+        int           stats_interval;
+        //! Memory in MiB used to cache responses.
+        int           cache_size;
+        //! Amount of threads running blocking request handlers.
+        int           worker_threads;
+        //! Amount of blocking requests which may wait for a thread.
+        int           worker_queue;
+        //! Maximal size in MiB of the torrent files uploaded by one request.
+        int           upload_limit;
+        //! Milliseconds the event loop may lag before requests are rejected.
+        int           max_loop_lag;
+        //! Amount of suspended connections before requests are rejected.
+        int           max_suspended;
+        //! KiB/s all downloads may send in total. Zero is unlimited.
+        int           rate_limit;
+        //! KiB/s the downloads of one client may send. Zero is unlimited.
+        int           client_rate_limit;
+        //! KiB/s a single download may send. Zero is unlimited.
+        int           download_rate_limit;
+        //! Shared memory object the status is published to. Empty if
+        //! disabled.
+        std::string   status_shm;
+        //! File to record all requests to. Empty if disabled.
+        std::string   trace_file;
+        //! Unix socket to pass the listening socket on restart. Empty if
+        //! disabled.
+        std::string   handoff_socket;
+        //! Unix socket the HTTP server listens on in addition to `port`.
+        //! Empty if disabled.
+        std::string   unix_socket;
+        //! Permissions of `unix_socket` as octal number, e.g. "0660".
+        std::string   unix_socket_mode;
     } httpd;
 };
 
+/**
+ * Thrown by reload_configuration() for invalid configurations.
+ */
+class configuration_error : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
 /**
  * Global variable that holds global configuration.
  *
- * It is initialized by load_configuration(). You can find more information
- * about available options at {@link configuration_t}.
+ * It is initialized by load_configuration() and keeps the values from the
+ * start of the application. You can find more information about available
+ * options at {@link configuration_t}.
  */
 extern const configuration_t &config;
 
@@ -82,4 +135,9 @@ extern const configuration_t &config;
  */
 void load_configuration(int argc, const char *const argv[]);
 
+const configuration_t *
+reload_configuration(std::vector<std::string> &pending);
+
+const configuration_t *current_config() noexcept;
+
 #endif // CONFIGURATION_HPP
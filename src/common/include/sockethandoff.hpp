@@ -0,0 +1,89 @@
+#ifndef SOCKETHANDOFF_HPP
+#define SOCKETHANDOFF_HPP
+
+/**
+ * @file sockethandoff.hpp
+ * File contains class {@link socket_handoff_t} which passes the listening
+ * socket of the HTTP server to a new process of the application.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <eventloop.hpp>
+
+
+/**
+ * Offers the listening socket to a new process at a Unix domain socket.
+ *
+ * When the application is restarted, the new process calls
+ * receive_listen_socket() with the same path before it starts its HTTP server.
+ * The old process then sends the listening socket by `SCM_RIGHTS` and waits
+ * for the new process to confirm the receipt. Only then, it releases the
+ * socket, i.e. stops accepting connections, finishes its requests and quits.
+ * Pending connections stay in the backlog of the socket, so no connection is
+ * refused while both processes are switching. If the handoff fails, the old
+ * process keeps serving and waits for the next attempt.
+ *
+ * The confirmation is awaited within the event loop, so requests are served
+ * while the new process starts up. Only one handoff is attempted at a time.
+ */
+class socket_handoff_t : private boost::noncopyable
+{
+public:
+    /**
+     * Returns the listening socket to pass on, or -1 if there is none. The
+     * socket still belongs to the caller.
+     */
+    using listen_socket_t = std::function<int()>;
+    /**
+     * Called after the new process has received the listening socket. The
+     * caller must not accept connections from the socket anymore.
+     */
+    using release_t = std::function<void()>;
+
+    socket_handoff_t(eventloop_t *eventloop, const std::string &path,
+                     const listen_socket_t &listen_socket,
+                     const release_t &release);
+    ~socket_handoff_t() noexcept;
+
+    //! Whether the listening socket has been passed on.
+    bool done() const noexcept { return m_done; }
+
+    static int receive_listen_socket(const std::string &path,
+                                     std::chrono::milliseconds timeout
+                                     = std::chrono::seconds(5));
+
+    //! Time the old process waits for the new one to confirm the receipt.
+    static constexpr std::chrono::seconds ack_timeout{2};
+
+private:
+    void fdset_getter(fd_set &rs, fd_set &ws, fd_set &es, int &max,
+                      std::chrono::nanoseconds &timeout);
+    void io_handler(const fd_set &rs, const fd_set &ws, const fd_set &es);
+    void hand_off(int fd);
+    void receive_ack();
+    void abort_handoff(const char *reason);
+    void stop_listening() noexcept;
+
+    eventloop_t *m_eventloop;
+    eventloop_t::select_handle_t m_select_handle;
+    const std::string m_path;
+    listen_socket_t m_listen_socket;
+    release_t m_release;
+    int m_listen_fd = -1;
+    //! Connection to the new process while waiting for its confirmation.
+    int m_peer_fd = -1;
+    //! Identifies the current attempt, so outdated timeouts are ignored.
+    std::uint64_t m_attempt = 0;
+    bool m_done = false;
+    //! Lets the timeout of an attempt detect if the object has been destroyed.
+    std::shared_ptr<socket_handoff_t*> m_self;
+};
+
+#endif // SOCKETHANDOFF_HPP
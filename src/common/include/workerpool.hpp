@@ -0,0 +1,63 @@
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+/**
+ * @file workerpool.hpp
+ * File contains class {@link worker_pool_t} which runs jobs on a fixed amount
+ * of threads.
+ */
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+
+/**
+ * Runs jobs on worker threads with a bounded queue.
+ *
+ * Jobs are rejected instead of queued when the queue is full, so callers can
+ * shed load early. Results should be reported by the job itself, e.g. through
+ * eventloop_t::call().
+ */
+class worker_pool_t : private boost::noncopyable
+{
+public:
+    using job_t = std::function<void()>;
+
+    /**
+     * Statistics of the pool.
+     */
+    struct stats_t {
+        std::size_t   queue_length = 0; //!< Amount of jobs waiting.
+        std::size_t   running = 0;      //!< Amount of jobs being executed.
+        std::uint64_t completed = 0;    //!< Amount of finished jobs.
+        std::uint64_t rejected = 0;     //!< Amount of jobs rejected.
+    };
+
+    worker_pool_t(std::size_t threads, std::size_t max_queue);
+    ~worker_pool_t() noexcept;
+
+    bool try_submit(job_t job);
+    stats_t stats() const;
+
+private:
+    void worker() noexcept;
+
+    const std::size_t m_max_queue;
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cond;
+    std::deque<job_t> m_queue;
+    stats_t m_stats;
+    bool m_stop = false;
+
+    std::vector<std::thread> m_threads;
+};
+
+#endif // WORKERPOOL_HPP
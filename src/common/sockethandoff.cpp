@@ -0,0 +1,279 @@
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <errorhandling.hpp>
+#include <logging.hpp>
+#include <sockethandoff.hpp>
+
+LOG_MODULE("SocketHandoff")
+
+
+constexpr std::chrono::seconds socket_handoff_t::ack_timeout;
+
+
+static sockaddr_un make_address(const std::string &path)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        THROW(os_file_error("Invalid path of handoff socket"))
+                << errinfo::filename(path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+
+/**
+ * Starts listening at @p path. An existing socket at @p path, e.g. of the
+ * process which has passed its socket to this one, is replaced.
+ *
+ * @param listen_socket Called when a new process asks for the listening
+ *                      socket.
+ * @param release Called when the new process has received the socket.
+ * @throws os_file_error if the path cannot be used.
+ */
+socket_handoff_t::socket_handoff_t(eventloop_t *eventloop,
+                                   const std::string &path,
+                                   const listen_socket_t &listen_socket,
+                                   const release_t &release)
+    : m_eventloop(eventloop)
+    , m_path(path)
+    , m_listen_socket(listen_socket)
+    , m_release(release)
+    , m_self(std::make_shared<socket_handoff_t*>(this))
+{
+    const sockaddr_un address = make_address(path);
+
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        OSCHECK(unlink,(path.c_str()), == 0);
+    }
+
+    m_listen_fd = OSCHECK(socket,(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK
+                                  | SOCK_CLOEXEC, 0), >= 0);
+    if (bind(m_listen_fd, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) < 0 || listen(m_listen_fd, 1) < 0) {
+        const int errnum = errno;
+        close(m_listen_fd);
+        THROW(os_file_error("Cannot listen on handoff socket"))
+                << errinfo::function("bind") << errinfo::errnum(errnum)
+                << errinfo::filename(path);
+    }
+
+    m_select_handle = m_eventloop->register_handler(
+            [this](auto&... args) {this->io_handler(args...);},
+            [this](auto&... args) {this->fdset_getter(args...);}
+    );
+}
+
+socket_handoff_t::~socket_handoff_t() noexcept
+{
+    m_eventloop->unregister_handler(m_select_handle);
+    if (m_peer_fd >= 0) {
+        close(m_peer_fd);
+    }
+    if (m_listen_fd >= 0) {
+        // Without handoff, the path still belongs to this process.
+        stop_listening();
+        unlink(m_path.c_str());
+    }
+}
+
+/**
+ * Asks a running process for its listening socket. Called before starting
+ * the HTTP server.
+ *
+ * @return The listening socket, or -1 if no process listens at @p path.
+ * @throws os_error if the process does not send a socket within @p timeout.
+ */
+int socket_handoff_t::receive_listen_socket(const std::string &path,
+                                            std::chrono::milliseconds timeout)
+{
+    const sockaddr_un address = make_address(path);
+    const int fd = OSCHECK(socket,(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0),
+                           >= 0);
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) < 0) {
+        const int errnum = errno;
+        close(fd);
+        if (errnum == ENOENT || errnum == ECONNREFUSED) {
+            return -1;
+        }
+        THROW(os_error("Cannot connect to handoff socket"))
+                << errinfo::function("connect") << errinfo::errnum(errnum)
+                << errinfo::filename(path);
+    }
+
+    timeval tv;
+    tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000);
+    OSCHECK(setsockopt,(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)), == 0);
+
+    char byte;
+    iovec iov = {&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t ret;
+    do {
+        ret = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (ret < 0 && errno == EINTR);
+    const int errnum = errno;
+
+    const cmsghdr *cmsg = ret > 0 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET
+            || cmsg->cmsg_type != SCM_RIGHTS) {
+        close(fd);
+        THROW(os_error("No listening socket received"))
+                << errinfo::function("recvmsg")
+                << errinfo::errnum(ret < 0 ? errnum : 0)
+                << errinfo::filename(path);
+    }
+    int listen_fd;
+    std::memcpy(&listen_fd, CMSG_DATA(cmsg), sizeof(listen_fd));
+
+    // Let the running process release the socket.
+    byte = 'A';
+    do {
+        ret = send(fd, &byte, 1, MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+    close(fd);
+    return listen_fd;
+}
+
+void socket_handoff_t::fdset_getter(fd_set &rs, fd_set &ws, fd_set &es,
+                                    int &max,
+                                    std::chrono::nanoseconds &timeout)
+{
+    // Wait for the confirmation before accepting the next process.
+    const int fd = m_peer_fd >= 0 ? m_peer_fd : m_listen_fd;
+    if (fd >= 0) {
+        FD_SET(fd, &rs);
+        max = fd + 1;
+    }
+}
+
+void socket_handoff_t::io_handler(const fd_set &rs, const fd_set &ws,
+                                  const fd_set &es)
+{
+    if (m_peer_fd >= 0) {
+        if (FD_ISSET(m_peer_fd, &rs)) {
+            receive_ack();
+        }
+        return;
+    }
+    if (m_listen_fd < 0 || !FD_ISSET(m_listen_fd, &rs)) {
+        return;
+    }
+    const int fd = accept4(m_listen_fd, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR
+                && errno != ECONNABORTED) {
+            OSERROR(accept4, "Cannot accept on handoff socket");
+        }
+        return;
+    }
+    hand_off(fd);
+}
+
+/**
+ * Sends the listening socket over @p fd, which is taken over. The receipt is
+ * awaited by receive_ack() for at most #ack_timeout.
+ */
+void socket_handoff_t::hand_off(int fd)
+{
+    const int listen_fd = m_listen_socket();
+    if (listen_fd < 0) {
+        LOG_WARN() << "Listening socket is not available";
+        close(fd);
+        return;
+    }
+
+    char byte = 'L';
+    iovec iov = {&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &listen_fd, sizeof(listen_fd));
+
+    ssize_t ret;
+    do {
+        ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0) {
+        LOG_WARN() << "Cannot hand over listening socket: "
+                   << (ret < 0 ? strerror(errno) : "nothing sent");
+        close(fd);
+        return;
+    }
+
+    // Keep serving until the new process owns the socket.
+    m_peer_fd = fd;
+    const std::uint64_t attempt = ++m_attempt;
+    std::weak_ptr<socket_handoff_t*> self = m_self;
+    m_eventloop->call([self, attempt] {
+        auto handoff = self.lock();
+        if (handoff && (*handoff)->m_peer_fd >= 0
+                && (*handoff)->m_attempt == attempt) {
+            (*handoff)->abort_handoff("no confirmation received");
+        }
+    }, ack_timeout);
+}
+
+/**
+ * Releases the listening socket if the new process has confirmed the receipt.
+ */
+void socket_handoff_t::receive_ack()
+{
+    char byte;
+    ssize_t ret;
+    do {
+        ret = recv(m_peer_fd, &byte, 1, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+    }
+    if (ret <= 0) {
+        abort_handoff(ret < 0 ? strerror(errno) : "new process has quit");
+        return;
+    }
+    close(m_peer_fd);
+    m_peer_fd = -1;
+
+    // Only one process may take over.
+    stop_listening();
+    m_done = true;
+    m_release();
+    LOG_INFO() << "Listening socket handed over";
+}
+
+void socket_handoff_t::abort_handoff(const char *reason)
+{
+    LOG_WARN() << "Cannot hand over listening socket: " << reason;
+    close(m_peer_fd);
+    m_peer_fd = -1;
+}
+
+void socket_handoff_t::stop_listening() noexcept
+{
+    close(m_listen_fd);
+    m_listen_fd = -1;
+}
@@ -0,0 +1,98 @@
+#include <exception>
+
+#include <logging.hpp>
+#include <workerpool.hpp>
+
+LOG_MODULE("WorkerPool")
+
+
+/**
+ * Starts the worker threads.
+ *
+ * @param threads   Amount of worker threads.
+ * @param max_queue Maximal amount of jobs waiting for a thread.
+ */
+worker_pool_t::worker_pool_t(std::size_t threads, std::size_t max_queue)
+    : m_max_queue(max_queue)
+{
+    for (std::size_t i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this] { worker(); });
+    }
+}
+
+/**
+ * Stops the worker threads. Running jobs are finished, waiting jobs are
+ * discarded.
+ */
+worker_pool_t::~worker_pool_t() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+/**
+ * Adds a job to the queue. This function is thread-safe.
+ *
+ * Exceptions thrown by @p job are logged and discarded.
+ *
+ * @return `false` if the queue is full. The job is not run in that case.
+ */
+bool worker_pool_t::try_submit(job_t job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (m_queue.size() >= m_max_queue) {
+            ++m_stats.rejected;
+            return false;
+        }
+        m_queue.push_back(std::move(job));
+    }
+    m_cond.notify_one();
+    return true;
+}
+
+/**
+ * Returns statistics of the pool. This function is thread-safe.
+ */
+worker_pool_t::stats_t worker_pool_t::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    stats_t stats = m_stats;
+    stats.queue_length = m_queue.size();
+    return stats;
+}
+
+void worker_pool_t::worker() noexcept
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cond.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+        if (m_stop) {
+            return;
+        }
+
+        job_t job = std::move(m_queue.front());
+        m_queue.pop_front();
+        ++m_stats.running;
+        lock.unlock();
+
+        try {
+            job();
+        } catch (const std::exception &e) {
+            LOG_WARN() << "Job failed: " << e.what();
+        } catch (...) {
+            LOG_WARN() << "Job failed with an unknown exception";
+        }
+        job = nullptr;
+
+        lock.lock();
+        --m_stats.running;
+        ++m_stats.completed;
+    }
+}
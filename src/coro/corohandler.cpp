@@ -0,0 +1,143 @@
+#include <stdexcept>
+
+#include <errorhandling.hpp>
+#include <corohandler.hpp>
+
+
+/**
+ * Creates a route which starts @p handler for every request. The coroutine
+ * keeps the request alive, it is notified through next_chunk() when the
+ * connection is closed.
+ */
+httpserver_t::route_t coro_route(httpserver_t *server,
+                                 const coro_handler_t &handler)
+{
+    return [server, handler](MHD_Connection *connection) {
+        // Closes the request when libmicrohttpd drops the access handler.
+        struct closer_t {
+            std::shared_ptr<coro_request_t> request;
+            ~closer_t() noexcept { request->close(); }
+        };
+
+        auto request = std::make_shared<coro_request_t>(server, connection);
+        // No temporary closer, its destruction would close the request.
+        std::shared_ptr<closer_t> closer(new closer_t{request});
+        auto start = [handler, request] {
+            // The coroutine's reference reports when the coroutine is done.
+            handler(std::shared_ptr<coro_request_t>(request.get(),
+                    [request](coro_request_t *r) { r->finish(); }));
+        };
+        return [request, closer, start](MHD_Connection *,
+                                        const char *upload_data,
+                                        size_t *upload_data_size) {
+            request->handle(start, upload_data, upload_data_size);
+        };
+    };
+}
+
+
+coro_request_t::~coro_request_t() noexcept
+{
+    if (m_response != nullptr) {
+        MHD_destroy_response(m_response);
+    }
+}
+
+/**
+ * Sets the response of the request. It is queued on the next call of the
+ * access handler. Takes ownership of @p response.
+ */
+void coro_request_t::respond(unsigned int status, MHD_Response *response)
+{
+    if (m_closed || m_responded) {
+        MHD_destroy_response(response);
+        return;
+    }
+    m_status = status;
+    m_response = response;
+    m_responded = true;
+    wake();
+}
+
+void coro_request_t::handle(const std::function<void()> &start,
+                            const char *upload_data,
+                            std::size_t *upload_data_size)
+{
+    struct scope_t {
+        bool &flag;
+        explicit scope_t(bool &flag) : flag(flag) { flag = true; }
+        ~scope_t() { flag = false; }
+    } in_handler(m_in_handler);
+    m_suspended = false;
+
+    if (m_first_call) {
+        m_first_call = false;
+        start();
+    } else if (m_chunk_waiter) {
+        // An empty chunk marks the end of the upload.
+        m_chunk = std::string_view(upload_data, *upload_data_size);
+        m_upload_done = m_chunk.empty();
+        std::exchange(m_chunk_waiter, nullptr).resume();
+        *upload_data_size = 0;
+    }
+
+    if (m_responded) {
+        if (m_response != nullptr) {
+            MHD_Response *response = std::exchange(m_response, nullptr);
+            int ret = MHD_queue_response(m_connection, m_status, response);
+            MHD_destroy_response(response);
+            if (ret != MHD_YES) {
+                OSERROR(MHD_queue_response,
+                        "`MHD_queue_response()' has surprisingly failed");
+            }
+        }
+    } else if (m_finished) {
+        throw std::runtime_error("Coroutine finished without response");
+    } else if (!m_chunk_waiter) {
+        // Wait for respond() or next_chunk().
+        m_server->suspend(m_connection);
+        m_suspended = true;
+    }
+}
+
+void coro_request_t::finish() noexcept
+{
+    m_finished = true;
+    if (!m_responded) {
+        wake();
+    }
+}
+
+void coro_request_t::close() noexcept
+{
+    m_closed = true;
+    m_suspended = false;
+    if (m_chunk_waiter) {
+        m_chunk = std::string_view();
+        std::exchange(m_chunk_waiter, nullptr).resume();
+    }
+}
+
+void coro_request_t::wake()
+{
+    if (m_suspended && !m_in_handler && !m_closed) {
+        m_suspended = false;
+        m_server->resume(m_connection);
+    }
+}
+
+
+void coro_request_t::chunk_awaitable_t::await_suspend(
+        std::coroutine_handle<> handle)
+{
+    m_request->m_chunk_waiter = handle;
+    m_request->wake();
+}
+
+std::string_view coro_request_t::chunk_awaitable_t::await_resume() noexcept
+{
+    if (m_request->m_closed) {
+        return {};
+    }
+    return std::exchange(m_request->m_chunk, std::string_view());
+}
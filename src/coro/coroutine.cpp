@@ -0,0 +1,107 @@
+#include <array>
+#include <new>
+
+#include <logging.hpp>
+#include <coroutine.hpp>
+
+LOG_MODULE("Coroutine")
+
+
+namespace {
+
+constexpr std::size_t frame_granularity = 64;
+constexpr std::size_t frame_classes = 64;
+//! Maximal amount of frames kept per size class.
+constexpr std::size_t frame_pool_depth = 64;
+
+/**
+ * Per-thread free lists of coroutine frames.
+ */
+class frame_pool_t
+{
+public:
+    ~frame_pool_t() noexcept {
+        for (free_list_t &list : m_lists) {
+            while (list.head != nullptr) {
+                node_t *node = list.head;
+                list.head = node->next;
+                ::operator delete(node);
+            }
+        }
+    }
+
+    void *allocate(std::size_t cls) {
+        free_list_t &list = m_lists[cls];
+        if (list.head == nullptr) {
+            return ::operator new((cls + 1) * frame_granularity);
+        }
+        node_t *node = list.head;
+        list.head = node->next;
+        --list.length;
+        return node;
+    }
+
+    void release(void *ptr, std::size_t cls) noexcept {
+        free_list_t &list = m_lists[cls];
+        if (list.length >= frame_pool_depth) {
+            ::operator delete(ptr);
+            return;
+        }
+        list.head = new (ptr) node_t{list.head};
+        ++list.length;
+    }
+
+private:
+    struct node_t {
+        node_t *next;
+    };
+    struct free_list_t {
+        node_t *head = nullptr;
+        std::size_t length = 0;
+    };
+
+    std::array<free_list_t, frame_classes> m_lists;
+};
+
+thread_local frame_pool_t frame_pool;
+
+std::size_t size_class(std::size_t size) noexcept
+{
+    return (size + frame_granularity - 1) / frame_granularity - 1;
+}
+
+} // namespace
+
+
+void *allocate_frame(std::size_t size)
+{
+    std::size_t cls = size_class(size);
+    if (size == 0 || cls >= frame_classes) {
+        return ::operator new(size);
+    }
+    return frame_pool.allocate(cls);
+}
+
+void deallocate_frame(void *ptr, std::size_t size) noexcept
+{
+    std::size_t cls = size_class(size);
+    if (size == 0 || cls >= frame_classes) {
+        ::operator delete(ptr);
+        return;
+    }
+    frame_pool.release(ptr, cls);
+}
+
+/**
+ * Logs exceptions leaving a coroutine. There is nobody to pass them to.
+ */
+void coro_task_t::promise_type::unhandled_exception() noexcept
+{
+    try {
+        throw;
+    } catch (const std::exception &e) {
+        LOG_WARN() << "Coroutine failed: " << e.what();
+    } catch (...) {
+        LOG_WARN() << "Coroutine failed";
+    }
+}
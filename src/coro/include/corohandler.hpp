@@ -0,0 +1,137 @@
+#ifndef COROHANDLER_HPP
+#define COROHANDLER_HPP
+
+/**
+ * @file corohandler.hpp
+ * File contains {@link coro_request_t} and coro_route() which implement HTTP
+ * request handlers as coroutines.
+ *
+ * This component requires C++20.
+ */
+
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <coroutine.hpp>
+#include <httpd.hpp>
+
+
+class coro_request_t;
+
+/**
+ * Coroutine handling a request.
+ */
+using coro_handler_t = std::function<
+    coro_task_t(std::shared_ptr<coro_request_t> request)
+>;
+
+httpserver_t::route_t coro_route(httpserver_t *server,
+                                 const coro_handler_t &handler);
+
+
+/**
+ * Request handled by a coroutine.
+ *
+ * ```{.cpp}
+ * server.add_route("POST", "upload", coro_route(&server,
+ *         [](std::shared_ptr<coro_request_t> request) -> coro_task_t {
+ *     std::size_t size = 0;
+ *     while (true) {
+ *         std::string_view chunk = co_await request->next_chunk();
+ *         if (chunk.empty())
+ *             break;
+ *         size += chunk.size();
+ *     }
+ *     co_await sleep_for(eventloop, 1s);
+ *     request->respond(MHD_HTTP_OK, make_response(size));
+ * }));
+ * ```
+ *
+ * Libmicrohttpd requires responses to be queued within the access handler.
+ * Whenever the coroutine waits for anything except the next chunk, the
+ * connection is suspended. respond() and next_chunk() resume it, and the
+ * handler completes the operation on the next call. Since no data is read
+ * while the connection is suspended, slow handlers apply back-pressure to
+ * uploads.
+ */
+class coro_request_t : private boost::noncopyable
+{
+public:
+    /**
+     * Awaitable returned by next_chunk().
+     */
+    class chunk_awaitable_t
+    {
+    public:
+        explicit chunk_awaitable_t(coro_request_t *request)
+            : m_request(request) {}
+
+        bool await_ready() const noexcept {
+            return m_request->m_closed || m_request->m_upload_done;
+        }
+        void await_suspend(std::coroutine_handle<> handle);
+        std::string_view await_resume() noexcept;
+
+    private:
+        coro_request_t *m_request;
+    };
+
+    coro_request_t(httpserver_t *server, MHD_Connection *connection)
+        : m_server(server), m_connection(connection) {}
+    ~coro_request_t() noexcept;
+
+    MHD_Connection *connection() const noexcept { return m_connection; }
+
+    /**
+     * Waits for the next part of the uploaded data. The data is valid until
+     * the coroutine suspends again.
+     *
+     * @return The data or an empty view if everything has been received.
+     */
+    chunk_awaitable_t next_chunk() { return chunk_awaitable_t(this); }
+
+    void respond(unsigned int status, MHD_Response *response);
+
+private:
+    friend httpserver_t::route_t coro_route(httpserver_t *server,
+                                            const coro_handler_t &handler);
+
+    void handle(const std::function<void()> &start, const char *upload_data,
+                std::size_t *upload_data_size);
+    void finish() noexcept;
+    void close() noexcept;
+    void wake();
+
+    httpserver_t *m_server;
+    MHD_Connection *m_connection;
+
+    //! Whether the access handler is being executed.
+    bool m_in_handler = false;
+    //! Whether the connection has been suspended.
+    bool m_suspended = false;
+    //! Whether the access handler has not been called yet.
+    bool m_first_call = true;
+    //! Set when the connection is gone.
+    bool m_closed = false;
+    //! Set when the coroutine has finished.
+    bool m_finished = false;
+    //! Set when the end of the upload has been passed to the coroutine.
+    bool m_upload_done = false;
+
+    //! Coroutine waiting for the next chunk.
+    std::coroutine_handle<> m_chunk_waiter;
+    std::string_view m_chunk;
+
+    unsigned int m_status = 0;
+    MHD_Response *m_response = nullptr;
+    bool m_responded = false;
+};
+
+#endif // COROHANDLER_HPP
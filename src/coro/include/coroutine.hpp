@@ -0,0 +1,214 @@
+#ifndef COROUTINE_HPP
+#define COROUTINE_HPP
+
+/**
+ * @file coroutine.hpp
+ * File contains the coroutine type {@link coro_task_t} and awaitables which
+ * resume coroutines on an {@link eventloop_t}.
+ *
+ * This component requires C++20. Other components stay on C++14 and must not
+ * include this file.
+ */
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <eventloop.hpp>
+#include <torrentstatus.hpp>
+#include <workerpool.hpp>
+
+
+/**
+ * Allocates memory for a coroutine frame.
+ *
+ * Frames are taken from per-thread free lists with size classes of 64 bytes up
+ * to 4 KiB. Larger frames are allocated by `operator new`.
+ */
+void *allocate_frame(std::size_t size);
+
+/**
+ * Releases memory allocated by allocate_frame() with the same @p size.
+ */
+void deallocate_frame(void *ptr, std::size_t size) noexcept;
+
+
+/**
+ * Return type of detached coroutines.
+ *
+ * The coroutine starts immediately and runs until it suspends for the first
+ * time. Its frame is destroyed when it finishes. Exceptions leaving the
+ * coroutine are logged and discarded, so they should be handled within.
+ */
+class coro_task_t
+{
+public:
+    struct promise_type {
+        static void *operator new(std::size_t size) {
+            return allocate_frame(size);
+        }
+        static void operator delete(void *ptr, std::size_t size) noexcept {
+            deallocate_frame(ptr, size);
+        }
+
+        coro_task_t get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept;
+    };
+};
+
+
+/**
+ * Awaitable returned by sleep_for().
+ */
+class timer_awaitable_t
+{
+public:
+    timer_awaitable_t(eventloop_t *eventloop, std::chrono::nanoseconds delay)
+        : m_eventloop(eventloop), m_delay(delay) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        m_eventloop->call([handle] { handle.resume(); }, m_delay);
+    }
+    void await_resume() const noexcept {}
+
+private:
+    eventloop_t *m_eventloop;
+    std::chrono::nanoseconds m_delay;
+};
+
+/**
+ * Suspends the coroutine for @p delay. It is resumed by @p eventloop.
+ */
+inline timer_awaitable_t sleep_for(eventloop_t *eventloop,
+                                   std::chrono::nanoseconds delay)
+{
+    return {eventloop, delay};
+}
+
+
+/**
+ * Awaitable returned by next_change().
+ */
+class change_awaitable_t
+{
+public:
+    explicit change_awaitable_t(torrent_status_store_t *store)
+        : m_store(store) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        m_handle = handle;
+        m_listener = m_store->add_listener([this](std::uint64_t version) {
+            m_store->remove_listener(m_listener);
+            m_version = version;
+            m_handle.resume();
+        });
+    }
+    std::uint64_t await_resume() const noexcept { return m_version; }
+
+private:
+    torrent_status_store_t *m_store;
+    std::coroutine_handle<> m_handle;
+    torrent_status_store_t::listener_handle_t m_listener = 0;
+    std::uint64_t m_version = 0;
+};
+
+/**
+ * Suspends the coroutine until @p store changes, i.e. until the next
+ * `state_update_alert` which changes anything has been processed.
+ *
+ * @return The new version of the store.
+ */
+inline change_awaitable_t next_change(torrent_status_store_t *store)
+{
+    return change_awaitable_t(store);
+}
+
+
+/**
+ * Thrown by awaiting run_on() if the worker pool is full.
+ */
+class pool_full_error : public std::runtime_error
+{
+public:
+    pool_full_error() : std::runtime_error("Worker pool is full") {}
+};
+
+/**
+ * Awaitable returned by run_on().
+ */
+template<typename func_t>
+class worker_awaitable_t
+{
+    using result_t = std::invoke_result_t<func_t>;
+    using storage_t = std::conditional_t<std::is_void_v<result_t>,
+                                         bool, result_t>;
+
+public:
+    worker_awaitable_t(worker_pool_t *pool, eventloop_t *eventloop,
+                       func_t func)
+        : m_pool(pool), m_eventloop(eventloop), m_func(std::move(func)) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        bool queued = m_pool->try_submit([this, handle] {
+            try {
+                if constexpr (std::is_void_v<result_t>) {
+                    m_func();
+                    m_result.emplace(true);
+                } else {
+                    m_result.emplace(m_func());
+                }
+            } catch (...) {
+                m_error = std::current_exception();
+            }
+            m_eventloop->call([handle] { handle.resume(); });
+        });
+        if (!queued) {
+            m_error = std::make_exception_ptr(pool_full_error());
+        }
+        // Continue immediately if the job has been rejected.
+        return queued;
+    }
+    result_t await_resume() {
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+        if constexpr (!std::is_void_v<result_t>) {
+            return std::move(*m_result);
+        }
+    }
+
+private:
+    worker_pool_t *m_pool;
+    eventloop_t *m_eventloop;
+    func_t m_func;
+    std::optional<storage_t> m_result;
+    std::exception_ptr m_error;
+};
+
+/**
+ * Runs @p func on @p pool and resumes the coroutine with its result on
+ * @p eventloop. Exceptions thrown by @p func are rethrown within the
+ * coroutine. Throws pool_full_error if the queue of the pool is full.
+ */
+template<typename func_t>
+worker_awaitable_t<std::decay_t<func_t>> run_on(worker_pool_t *pool,
+                                                eventloop_t *eventloop,
+                                                func_t &&func)
+{
+    return {pool, eventloop, std::forward<func_t>(func)};
+}
+
+#endif // COROUTINE_HPP
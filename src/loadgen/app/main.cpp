@@ -0,0 +1,215 @@
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <sysexits.h>
+
+#include <boost/program_options.hpp>
+
+#include <loadgenerator.hpp>
+
+namespace po = boost::program_options;
+
+
+/**
+ * Parses weights like `list=60,page=25`.
+ */
+static std::map<std::string, unsigned int> parse_mix(const std::string &spec)
+{
+    std::map<std::string, unsigned int> weights;
+    std::size_t begin = 0;
+    while (begin < spec.size()) {
+        std::size_t end = spec.find(',', begin);
+        if (end == std::string::npos)
+            end = spec.size();
+        const std::string entry = spec.substr(begin, end - begin);
+        const std::size_t eq = entry.find('=');
+        if (eq == std::string::npos) {
+            throw po::error("invalid mix entry '" + entry + "'");
+        }
+        try {
+            weights[entry.substr(0, eq)] = static_cast<unsigned int>(
+                    std::stoul(entry.substr(eq + 1)));
+        } catch (const std::logic_error &) {
+            throw po::error("invalid weight in '" + entry + "'");
+        }
+        begin = end + 1;
+    }
+    return weights;
+}
+
+/**
+ * Returns @p str percent-encoded for use as value of a query argument.
+ */
+static std::string encode_query(const std::string &str)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    std::string result;
+    for (const char ch : str) {
+        const unsigned char c = static_cast<unsigned char>(ch);
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_'
+                || c == '~') {
+            result += ch;
+        } else {
+            result += '%';
+            result += hex[c >> 4];
+            result += hex[c & 0xf];
+        }
+    }
+    return result;
+}
+
+static load_request_t make_request(const std::string &target,
+                                   const std::string &range = "")
+{
+    load_request_t request;
+    request.target = target;
+    request.range = range;
+    return request;
+}
+
+static void print_latencies(const char *title,
+                            const latency_histogram_t &histogram)
+{
+    std::printf("%s\n", title);
+    for (double percent : {50.0, 90.0, 99.0, 99.9, 99.99, 100.0}) {
+        const double ms = std::chrono::duration<double, std::milli>(
+                histogram.percentile(percent)).count();
+        std::printf("  %7g%%  %10.3f ms\n", percent, ms);
+    }
+}
+
+static void print_report(const load_report_t &report)
+{
+    const double seconds =
+            std::chrono::duration<double>(report.elapsed).count();
+    std::printf("Requests:  %llu completed, %llu errors in %.1f s "
+                "(%.1f req/s, %.1f MiB)\n",
+                static_cast<unsigned long long>(report.completed),
+                static_cast<unsigned long long>(report.errors), seconds,
+                seconds > 0 ? report.completed / seconds : 0.0,
+                static_cast<double>(report.bytes) / (1 << 20));
+    std::printf("Statuses: ");
+    for (const auto &entry : report.statuses) {
+        std::printf(" %d: %llu", entry.first,
+                    static_cast<unsigned long long>(entry.second));
+    }
+    std::printf("\n");
+    print_latencies("Latency from intended start "
+                    "(corrected for coordinated omission):", report.latency);
+    print_latencies("Service time from sending:", report.service_time);
+}
+
+static int main0(int argc, char *argv[])
+{
+    load_generator_t::options_t options;
+    std::string prefix, mix_spec, range_path, search, trace;
+    double rate, speed, duration;
+
+    po::options_description desc(
+            "Sends requests to a running lan-torrent-server and reports "
+            "latency percentiles.\n\nOptions");
+    desc.add_options()
+        ("help,h", "Print this help.")
+        ("host", po::value<std::string>(&options.host)
+                 ->default_value(options.host), "Host of the server.")
+        ("port", po::value<std::string>(&options.port)
+                 ->default_value(options.port), "Port of the server.")
+        ("prefix", po::value<std::string>(&prefix)->default_value("/"),
+                 "Prefix of all paths (httpd.prefix).")
+        ("connections,c", po::value<unsigned int>(&options.connections)
+                 ->default_value(options.connections),
+                 "Amount of keep-alive connections.")
+        ("rate,r", po::value<double>(&rate)->default_value(100),
+                 "Synthetic requests per second.")
+        ("duration,d", po::value<double>(&duration)->default_value(30),
+                 "Seconds to send requests. Zero replays the whole trace, "
+                 "it is only allowed with --trace.")
+        ("mix", po::value<std::string>(&mix_spec)
+                 ->default_value("list=60,page=25,search=10,range=5"),
+                 "Weights of the synthetic requests: `list` (all torrents), "
+                 "`page` (sorted page), `search` and `range` (download).")
+        ("search", po::value<std::string>(&search)->default_value("iso"),
+                 "Query of the synthetic searches.")
+        ("range-path", po::value<std::string>(&range_path),
+                 "Path of a file for synthetic range requests. Range "
+                 "requests are skipped without it.")
+        ("trace,t", po::value<std::string>(&trace),
+                 "Replay a trace recorded by httpd.trace-file instead.")
+        ("speed", po::value<double>(&speed)->default_value(1),
+                 "Speed factor of the replay.")
+        ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return EX_OK;
+    }
+    if (rate <= 0 || speed <= 0 || duration < 0 || options.connections == 0) {
+        throw po::error("rate, speed and connections must be positive");
+    }
+    if (duration == 0 && trace.empty()) {
+        throw po::error("duration must be positive without --trace");
+    }
+    if (prefix.empty() || prefix.back() != '/') {
+        prefix += '/';
+    }
+
+    const auto length = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(duration));
+    request_source_t source;
+    if (!trace.empty()) {
+        source = trace_source(std::make_shared<trace_reader_t>(trace), speed,
+                              length);
+    } else {
+        request_mix_t mix;
+        for (const auto &entry : parse_mix(mix_spec)) {
+            if (entry.first == "list") {
+                mix.add(entry.second, make_request(prefix + "torrents"));
+            } else if (entry.first == "page") {
+                mix.add(entry.second, make_request(
+                        prefix + "torrents?sort=-progress&limit=50"));
+            } else if (entry.first == "search") {
+                mix.add(entry.second, make_request(
+                        prefix + "search?q=" + encode_query(search)));
+            } else if (entry.first == "range") {
+                if (!range_path.empty())
+                    mix.add(entry.second, make_request(
+                            range_path, "bytes=0-1048575"));
+            } else {
+                throw po::error("unknown request '" + entry.first + "'");
+            }
+        }
+        if (mix.empty()) {
+            throw po::error("the mix contains no requests");
+        }
+        source = synthetic_source(mix, rate, length);
+    }
+
+    load_generator_t generator(options);
+    print_report(generator.run(source));
+    return EX_OK;
+}
+
+int main(int argc, char *argv[])
+{
+    try {
+        return main0(argc, argv);
+    } catch (const po::error &e) {
+        std::cerr << e.what() << std::endl;
+        return EX_USAGE;
+    } catch (const trace_error &e) {
+        std::cerr << e.what() << std::endl;
+        return EX_DATAERR;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EX_SOFTWARE;
+    }
+}
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <strings.h>
+
+#include <httpresponse.hpp>
+
+
+static std::string trim(const std::string &str)
+{
+    const std::size_t begin = str.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return {};
+    }
+    const std::size_t end = str.find_last_not_of(" \t");
+    return str.substr(begin, end - begin + 1);
+}
+
+static std::uint64_t parse_number(const std::string &str, int base)
+{
+    if (str.empty() || !std::isxdigit(static_cast<unsigned char>(str[0]))) {
+        throw http_parse_error("Invalid number");
+    }
+    char *end;
+    errno = 0;
+    const unsigned long long value = std::strtoull(str.c_str(), &end, base);
+    if (errno != 0 || (*end != '\0' && *end != ';' && *end != ' ')) {
+        throw http_parse_error("Invalid number");
+    }
+    return value;
+}
+
+
+/**
+ * Prepares the parser for the next response.
+ *
+ * @param head Whether the request has been a `HEAD` request, whose response
+ *             has no body.
+ */
+void http_response_parser_t::reset(bool head)
+{
+    m_state = state_e::STATUS_LINE;
+    m_head = head;
+    m_line.clear();
+    m_line_complete = false;
+    m_status = 0;
+    m_keep_alive = true;
+    m_chunked = false;
+    m_has_length = false;
+    m_remaining = 0;
+    m_body_size = 0;
+}
+
+/**
+ * Parses the next bytes of the response.
+ *
+ * @return The amount of consumed bytes. It is less than @p size if the
+ *         response is complete and the remaining bytes belong to the next
+ *         response.
+ * @throws http_parse_error if the response is malformed.
+ */
+std::size_t http_response_parser_t::feed(const char *data, std::size_t size)
+{
+    const char *const begin = data;
+    const char *const end = data + size;
+    while (data != end && m_state != state_e::DONE) {
+        switch (m_state) {
+        case state_e::STATUS_LINE:
+            if (read_line(data, end))
+                parse_status_line();
+            break;
+        case state_e::HEADERS:
+            if (!read_line(data, end))
+                break;
+            if (m_line.empty())
+                end_of_headers();
+            else
+                parse_header();
+            break;
+        case state_e::BODY:
+        case state_e::CHUNK_DATA: {
+            const std::uint64_t n = std::min<std::uint64_t>(
+                    m_remaining, static_cast<std::uint64_t>(end - data));
+            data += n;
+            m_remaining -= n;
+            m_body_size += n;
+            if (m_remaining == 0) {
+                m_state = m_state == state_e::BODY
+                        ? state_e::DONE : state_e::CHUNK_END;
+            }
+            break;
+        }
+        case state_e::BODY_UNTIL_CLOSE:
+            m_body_size += static_cast<std::uint64_t>(end - data);
+            data = end;
+            break;
+        case state_e::CHUNK_SIZE:
+            if (!read_line(data, end))
+                break;
+            m_remaining = parse_number(trim(m_line), 16);
+            m_state = m_remaining > 0 ? state_e::CHUNK_DATA : state_e::TRAILERS;
+            break;
+        case state_e::CHUNK_END:
+            if (!read_line(data, end))
+                break;
+            if (!m_line.empty())
+                throw http_parse_error("Missing end of chunk");
+            m_state = state_e::CHUNK_SIZE;
+            break;
+        case state_e::TRAILERS:
+            if (read_line(data, end) && m_line.empty())
+                m_state = state_e::DONE;
+            break;
+        case state_e::DONE:
+            break;
+        }
+    }
+    return static_cast<std::size_t>(data - begin);
+}
+
+/**
+ * Notifies the parser that the server has closed the connection.
+ *
+ * @throws http_parse_error if the response is incomplete.
+ */
+void http_response_parser_t::close()
+{
+    if (m_state == state_e::BODY_UNTIL_CLOSE) {
+        m_state = state_e::DONE;
+        m_keep_alive = false;
+    } else if (m_state != state_e::DONE) {
+        throw http_parse_error("Connection closed before end of response");
+    }
+}
+
+/**
+ * Collects the next line into #m_line without the line break.
+ *
+ * @return Whether the line is complete.
+ */
+bool http_response_parser_t::read_line(const char *&data, const char *end)
+{
+    if (m_line_complete) {
+        m_line.clear();
+        m_line_complete = false;
+    }
+    const char *newline = std::find(data, end, '\n');
+    m_line.append(data, newline);
+    if (m_line.size() > max_line_length) {
+        throw http_parse_error("Line too long");
+    }
+    if (newline == end) {
+        data = end;
+        return false;
+    }
+    data = newline + 1;
+    if (!m_line.empty() && m_line.back() == '\r') {
+        m_line.pop_back();
+    }
+    m_line_complete = true;
+    return true;
+}
+
+void http_response_parser_t::parse_status_line()
+{
+    // HTTP/1.1 200 OK
+    if (m_line.compare(0, 5, "HTTP/") != 0 || m_line.size() < 12
+            || m_line[8] != ' ') {
+        throw http_parse_error("Invalid status line");
+    }
+    m_status = static_cast<int>(parse_number(m_line.substr(9, 3), 10));
+    m_keep_alive = m_line.compare(0, 8, "HTTP/1.0") != 0;
+    m_state = state_e::HEADERS;
+}
+
+void http_response_parser_t::parse_header()
+{
+    const std::size_t colon = m_line.find(':');
+    if (colon == std::string::npos) {
+        throw http_parse_error("Invalid header");
+    }
+    const std::string name = m_line.substr(0, colon);
+    const std::string value = trim(m_line.substr(colon + 1));
+    if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+        m_remaining = parse_number(value, 10);
+        m_has_length = true;
+    } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) {
+        m_chunked = strcasecmp(value.c_str(), "chunked") == 0;
+    } else if (strcasecmp(name.c_str(), "Connection") == 0) {
+        if (strcasecmp(value.c_str(), "close") == 0)
+            m_keep_alive = false;
+        else if (strcasecmp(value.c_str(), "keep-alive") == 0)
+            m_keep_alive = true;
+    }
+}
+
+void http_response_parser_t::end_of_headers()
+{
+    if (m_status >= 100 && m_status < 200) {
+        // Interim responses are followed by the actual response.
+        reset(m_head);
+    } else if (m_head || m_status == 204 || m_status == 304) {
+        m_state = state_e::DONE;
+    } else if (m_chunked) {
+        m_state = state_e::CHUNK_SIZE;
+    } else if (m_has_length) {
+        m_state = m_remaining > 0 ? state_e::BODY : state_e::DONE;
+    } else {
+        m_state = state_e::BODY_UNTIL_CLOSE;
+        m_keep_alive = false;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef HTTPRESPONSE_HPP
+#define HTTPRESPONSE_HPP
+
+/**
+ * @file httpresponse.hpp
+ * File contains class {@link http_response_parser_t} which finds the end of
+ * HTTP/1.1 responses on keep-alive connections.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+
+/**
+ * Thrown if a response is malformed.
+ */
+class http_parse_error : public std::runtime_error
+{
+public:
+    explicit http_parse_error(const char *what) : std::runtime_error(what) {}
+};
+
+/**
+ * Incremental parser of a single HTTP/1.1 response.
+ *
+ * The parser only extracts what is needed to find the end of the response:
+ * the status, `Content-Length`, `Transfer-Encoding: chunked` and
+ * `Connection: close`. The body is skipped without copying.
+ */
+class http_response_parser_t
+{
+public:
+    //! Maximal length of the status line and of every header line.
+    static constexpr std::size_t max_line_length = 8192;
+
+    explicit http_response_parser_t(bool head = false) { reset(head); }
+
+    void reset(bool head);
+    std::size_t feed(const char *data, std::size_t size);
+    void close();
+
+    //! Whether the response is complete.
+    bool done() const noexcept { return m_state == state_e::DONE; }
+    //! Status code, zero until the status line has been parsed.
+    int status() const noexcept { return m_status; }
+    //! Whether the connection can be used for the next request.
+    bool keep_alive() const noexcept { return m_keep_alive; }
+    //! Size of the body received so far.
+    std::uint64_t body_size() const noexcept { return m_body_size; }
+
+private:
+    enum class state_e {
+        STATUS_LINE, HEADERS, BODY, BODY_UNTIL_CLOSE,
+        CHUNK_SIZE, CHUNK_DATA, CHUNK_END, TRAILERS, DONE
+    };
+
+    bool read_line(const char *&data, const char *end);
+    void parse_status_line();
+    void parse_header();
+    void end_of_headers();
+
+    state_e       m_state;
+    bool          m_head;
+    std::string   m_line;
+    //! Whether #m_line holds a complete line, which has been processed.
+    bool          m_line_complete;
+    int           m_status;
+    bool          m_keep_alive;
+    bool          m_chunked;
+    bool          m_has_length;
+    //! Bytes of the body or of the current chunk which are still expected.
+    std::uint64_t m_remaining;
+    std::uint64_t m_body_size;
+};
+
+#endif // HTTPRESPONSE_HPP
@@ -0,0 +1,52 @@
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+/**
+ * @file latencyhistogram.hpp
+ * File contains class {@link latency_histogram_t} which counts latencies with
+ * bounded relative error.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * Histogram of latencies in nanoseconds.
+ *
+ * Values below 2^precision_bits are counted exactly. Larger values are
+ * counted in buckets of 2^(precision_bits - 1) per power of two, so the
+ * relative error of every reported value is below 2^(1 - precision_bits),
+ * i.e. 1.6 %. All values up to 2^63 ns fit into a few thousand buckets, so
+ * recording is a constant-time increment.
+ */
+class latency_histogram_t
+{
+public:
+    static constexpr int precision_bits = 7;
+
+    latency_histogram_t();
+
+    void record(std::chrono::nanoseconds latency);
+    void merge(const latency_histogram_t &other);
+
+    std::chrono::nanoseconds percentile(double percent) const;
+
+    //! Amount of recorded values.
+    std::uint64_t count() const noexcept { return m_count; }
+    //! Largest recorded value.
+    std::chrono::nanoseconds max() const noexcept {
+        return std::chrono::nanoseconds(m_max);
+    }
+
+private:
+    static std::size_t bucket(std::uint64_t value) noexcept;
+    static std::uint64_t highest_value(std::size_t bucket) noexcept;
+
+    std::vector<std::uint64_t> m_buckets;
+    std::uint64_t m_count = 0;
+    std::uint64_t m_max = 0;
+};
+
+#endif // LATENCYHISTOGRAM_HPP
@@ -0,0 +1,135 @@
+#ifndef LOADGENERATOR_HPP
+#define LOADGENERATOR_HPP
+
+/**
+ * @file loadgenerator.hpp
+ * File contains class {@link load_generator_t} which sends requests to the
+ * REST API at a given schedule and measures their latencies.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <latencyhistogram.hpp>
+#include <requesttrace.hpp>
+
+
+/**
+ * A request to send.
+ */
+struct load_request_t {
+    //! Time the request is intended to be sent, relative to the start.
+    std::chrono::nanoseconds time{0};
+    std::string method = "GET";
+    std::string target; //!< Path including the query.
+    std::string range;  //!< Value of the `Range` header, if any.
+};
+
+/**
+ * Returns the requests to send ordered by time. Returns `false` if there are
+ * no more requests.
+ */
+using request_source_t = std::function<bool(load_request_t &request)>;
+
+/**
+ * Weighted mix of requests.
+ */
+class request_mix_t
+{
+public:
+    void add(unsigned int weight, const load_request_t &request);
+    bool empty() const noexcept { return m_total == 0; }
+    const load_request_t &pick(std::mt19937_64 &rng) const;
+
+private:
+    std::vector<std::pair<unsigned int, load_request_t>> m_requests;
+    unsigned int m_total = 0;
+};
+
+request_source_t synthetic_source(const request_mix_t &mix, double rate,
+                                  std::chrono::nanoseconds duration);
+request_source_t trace_source(const std::shared_ptr<trace_reader_t> &reader,
+                              double speed,
+                              std::chrono::nanoseconds duration);
+
+/**
+ * Results of {@link load_generator_t::run()}.
+ */
+struct load_report_t {
+    //! Time from the intended start until the end of the response.
+    latency_histogram_t latency;
+    //! Time from actually sending the request until the end of the response.
+    latency_histogram_t service_time;
+    std::uint64_t completed = 0; //!< Amount of complete responses.
+    std::uint64_t errors = 0;    //!< Amount of failed or abandoned requests.
+    std::uint64_t bytes = 0;     //!< Bytes of all response bodies.
+    std::map<int, std::uint64_t> statuses; //!< Amount of responses by status.
+    std::chrono::nanoseconds elapsed{0};   //!< Duration of the run.
+};
+
+/**
+ * Sends requests over a fixed amount of keep-alive connections.
+ *
+ * The generator follows an open model: every request has an intended start
+ * time given by its source, independent of the responses. If no connection is
+ * idle at that time, the request waits, and its latency is still measured
+ * from the intended time. So a server which stalls is charged for all
+ * requests it has delayed, instead of only for the few which have been sent
+ * (coordinated omission).
+ *
+ * All connections are handled by one thread with epoll. Requests are not
+ * pipelined.
+ */
+class load_generator_t : private boost::noncopyable
+{
+public:
+    /**
+     * Options of the generator.
+     */
+    struct options_t {
+        std::string host = "127.0.0.1";
+        std::string port = "8080";
+        unsigned int connections = 16;
+        //! Time waited for outstanding responses after the last request.
+        std::chrono::nanoseconds drain_timeout = std::chrono::seconds(10);
+    };
+
+    explicit load_generator_t(const options_t &options);
+    ~load_generator_t() noexcept;
+
+    load_report_t run(const request_source_t &source);
+
+private:
+    struct connection_t;
+    struct pending_t;
+
+    void connect(connection_t &connection);
+    void watch(connection_t &connection, std::uint32_t events, int op);
+    void disconnect(connection_t &connection);
+    void send(connection_t &connection, pending_t &&request);
+    void handle_event(connection_t &connection, std::uint32_t events,
+                      load_report_t &report);
+    void complete(connection_t &connection, load_report_t &report);
+    void fail(connection_t &connection, load_report_t &report);
+
+    const options_t m_options;
+    sockaddr_storage m_address;
+    socklen_t m_address_size;
+    int m_epoll_fd = -1;
+    int m_timer_fd = -1;
+    std::vector<std::unique_ptr<connection_t>> m_connections;
+    std::vector<connection_t*> m_idle;
+    std::vector<char> m_buffer;
+};
+
+#endif // LOADGENERATOR_HPP
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cmath>
+
+#include <latencyhistogram.hpp>
+
+
+static constexpr std::uint64_t exact_limit =
+        std::uint64_t(1) << latency_histogram_t::precision_bits;
+static constexpr std::uint64_t sub_buckets = exact_limit / 2;
+
+static int highest_bit(std::uint64_t value) noexcept
+{
+    return 63 - __builtin_clzll(value);
+}
+
+
+latency_histogram_t::latency_histogram_t()
+    : m_buckets(bucket(~std::uint64_t(0) >> 1) + 1)
+{
+}
+
+/**
+ * Counts @p latency. Negative values are counted as zero.
+ */
+void latency_histogram_t::record(std::chrono::nanoseconds latency)
+{
+    const std::uint64_t value = latency.count() > 0
+            ? static_cast<std::uint64_t>(latency.count()) : 0;
+    ++m_buckets[bucket(value)];
+    ++m_count;
+    m_max = std::max(m_max, value);
+}
+
+/**
+ * Adds all values of @p other.
+ */
+void latency_histogram_t::merge(const latency_histogram_t &other)
+{
+    for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_max = std::max(m_max, other.m_max);
+}
+
+/**
+ * Returns the smallest value which is greater than or equal to @p percent
+ * percent of all values, rounded up to the end of its bucket. Returns zero if
+ * nothing has been recorded.
+ */
+std::chrono::nanoseconds latency_histogram_t::percentile(double percent) const
+{
+    if (m_count == 0) {
+        return std::chrono::nanoseconds::zero();
+    }
+    // Tolerate rounding errors, e.g. 99.9 % of 1000 values is 999 values.
+    const double rank = std::ceil(
+            percent / 100 * static_cast<double>(m_count) - 1e-9);
+    const std::uint64_t target = std::max<std::uint64_t>(
+            1, std::min<std::uint64_t>(static_cast<std::uint64_t>(rank),
+                                       m_count));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+        seen += m_buckets[i];
+        if (seen >= target) {
+            return std::chrono::nanoseconds(std::min(highest_value(i), m_max));
+        }
+    }
+    return max();
+}
+
+std::size_t latency_histogram_t::bucket(std::uint64_t value) noexcept
+{
+    if (value < exact_limit) {
+        return static_cast<std::size_t>(value);
+    }
+    const int shift = highest_bit(value) - (precision_bits - 1);
+    const std::uint64_t sub = value >> shift; // In [sub_buckets, exact_limit)
+    return static_cast<std::size_t>(
+            exact_limit + (shift - 1) * sub_buckets + (sub - sub_buckets));
+}
+
+std::uint64_t latency_histogram_t::highest_value(std::size_t bucket) noexcept
+{
+    if (bucket < exact_limit) {
+        return bucket;
+    }
+    const std::uint64_t shift = (bucket - exact_limit) / sub_buckets + 1;
+    const std::uint64_t sub = (bucket - exact_limit) % sub_buckets
+                              + sub_buckets;
+    return ((sub + 1) << shift) - 1;
+}
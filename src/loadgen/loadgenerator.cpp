@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <errorhandling.hpp>
+#include <httpresponse.hpp>
+#include <loadgenerator.hpp>
+
+using clock_type = std::chrono::steady_clock;
+
+
+//! Delay before reconnecting after a connection has failed.
+static constexpr std::chrono::milliseconds retry_delay(100);
+
+
+struct load_generator_t::pending_t {
+    clock_type::time_point intended;
+    load_request_t         request;
+};
+
+struct load_generator_t::connection_t {
+    int  fd = -1;
+    bool connected = false;
+    bool busy = false;
+    //! Time of the next connection attempt if #fd is closed.
+    clock_type::time_point retry_at;
+
+    std::string out;         //!< Request being sent.
+    std::size_t written = 0; //!< Bytes of #out already sent.
+    http_response_parser_t parser;
+    clock_type::time_point intended;
+    clock_type::time_point sent;
+};
+
+
+/**
+ * Adds @p request, which is picked with a probability proportional to
+ * @p weight.
+ */
+void request_mix_t::add(unsigned int weight, const load_request_t &request)
+{
+    if (weight > 0) {
+        m_requests.emplace_back(weight, request);
+        m_total += weight;
+    }
+}
+
+const load_request_t &request_mix_t::pick(std::mt19937_64 &rng) const
+{
+    ASSERT(!empty());
+    unsigned int value = std::uniform_int_distribution<unsigned int>(
+            0, m_total - 1)(rng);
+    for (const auto &entry : m_requests) {
+        if (value < entry.first) {
+            return entry.second;
+        }
+        value -= entry.first;
+    }
+    return m_requests.back().second;
+}
+
+/**
+ * Returns requests picked from @p mix at a constant @p rate per second for
+ * @p duration. The sequence is the same for every run.
+ */
+request_source_t synthetic_source(const request_mix_t &mix, double rate,
+                                  std::chrono::nanoseconds duration)
+{
+    ASSERT(rate > 0 && !mix.empty());
+    auto rng = std::make_shared<std::mt19937_64>(42);
+    auto sent = std::make_shared<std::uint64_t>(0);
+    return [mix, rate, duration, rng, sent](load_request_t &request) {
+        const std::chrono::nanoseconds time(static_cast<std::int64_t>(
+                static_cast<double>(*sent) * 1e9 / rate));
+        if (time >= duration) {
+            return false;
+        }
+        request = mix.pick(*rng);
+        request.time = time;
+        ++*sent;
+        return true;
+    };
+}
+
+/**
+ * Returns the requests of a trace at their recorded times divided by
+ * @p speed. Stops after @p duration unless it is zero.
+ */
+request_source_t trace_source(const std::shared_ptr<trace_reader_t> &reader,
+                              double speed, std::chrono::nanoseconds duration)
+{
+    ASSERT(speed > 0);
+    return [reader, speed, duration](load_request_t &request) {
+        trace_record_t record;
+        if (!reader->next(record)) {
+            return false;
+        }
+        const std::chrono::nanoseconds time(static_cast<std::int64_t>(
+                std::chrono::duration<double, std::nano>(record.time).count()
+                / speed));
+        if (duration.count() > 0 && time >= duration) {
+            return false;
+        }
+        request.time = time;
+        request.method = std::move(record.method);
+        request.target = std::move(record.target);
+        request.range = std::move(record.range);
+        return true;
+    };
+}
+
+
+/**
+ * Resolves the address of the server.
+ *
+ * @throws os_error if the address cannot be resolved.
+ */
+load_generator_t::load_generator_t(const options_t &options)
+    : m_options(options)
+    , m_buffer(1 << 16)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result;
+    const int ret = getaddrinfo(m_options.host.c_str(),
+                                m_options.port.c_str(), &hints, &result);
+    if (ret != 0) {
+        THROW(os_error(gai_strerror(ret)))
+                << errinfo::function("getaddrinfo");
+    }
+    std::memcpy(&m_address, result->ai_addr, result->ai_addrlen);
+    m_address_size = result->ai_addrlen;
+    freeaddrinfo(result);
+
+    m_epoll_fd = OSCHECK(epoll_create1,(EPOLL_CLOEXEC), >= 0);
+    m_timer_fd = OSCHECK(timerfd_create,(CLOCK_MONOTONIC,
+                                         TFD_NONBLOCK | TFD_CLOEXEC), >= 0);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    OSCHECK(epoll_ctl,(m_epoll_fd, EPOLL_CTL_ADD, m_timer_fd, &event), == 0);
+}
+
+load_generator_t::~load_generator_t() noexcept
+{
+    for (auto &connection : m_connections) {
+        if (connection->fd >= 0)
+            close(connection->fd);
+    }
+    close(m_timer_fd);
+    close(m_epoll_fd);
+}
+
+/**
+ * Opens the connections, sends all requests of @p source and waits for their
+ * responses.
+ *
+ * @throws os_error if a connection cannot be established at the start.
+ */
+load_report_t load_generator_t::run(const request_source_t &source)
+{
+    load_report_t report;
+    std::vector<epoll_event> events(m_options.connections + 1);
+
+    // Establish all connections before the clock starts.
+    m_connections.clear();
+    m_idle.clear();
+    for (unsigned int i = 0; i < m_options.connections; ++i) {
+        m_connections.emplace_back(new connection_t);
+        connect(*m_connections.back());
+        if (m_connections.back()->fd < 0) {
+            OSERROR(connect, "Cannot connect to server");
+        }
+    }
+    while (m_idle.size() < m_connections.size()) {
+        const int n = OSCHECK(epoll_wait,(m_epoll_fd, events.data(),
+                                          static_cast<int>(events.size()),
+                                          -1), >= 0 || errno == EINTR);
+        for (int i = 0; i < n; ++i) {
+            auto *connection = static_cast<connection_t*>(events[i].data.ptr);
+            if (connection == nullptr)
+                continue;
+            handle_event(*connection, events[i].events, report);
+            if (connection->fd < 0) {
+                errno = ECONNREFUSED;
+                OSERROR(connect, "Cannot connect to server");
+            }
+        }
+    }
+
+    const clock_type::time_point start = clock_type::now();
+    clock_type::time_point now = start;
+    clock_type::time_point last_intended = start;
+    std::deque<pending_t> pending;
+    load_request_t next;
+    bool have_next = source(next);
+
+    while (true) {
+        now = clock_type::now();
+        while (have_next && start + next.time <= now) {
+            last_intended = start + next.time;
+            pending.push_back({last_intended, std::move(next)});
+            next = load_request_t();
+            have_next = source(next);
+        }
+        clock_type::time_point wakeup = have_next
+                ? start + next.time : last_intended + m_options.drain_timeout;
+        std::size_t busy = 0;
+        for (auto &connection : m_connections) {
+            if (connection->fd < 0) {
+                if (connection->retry_at <= now)
+                    connect(*connection);
+                else
+                    wakeup = std::min(wakeup, connection->retry_at);
+            }
+            busy += connection->busy ? 1 : 0;
+        }
+        while (!pending.empty() && !m_idle.empty()) {
+            connection_t *connection = m_idle.back();
+            m_idle.pop_back();
+            send(*connection, std::move(pending.front()));
+            pending.pop_front();
+            ++busy;
+        }
+
+        if (!have_next && pending.empty() && busy == 0) {
+            break;
+        }
+        if (!have_next && now >= last_intended + m_options.drain_timeout) {
+            // Abandon requests the server has not answered in time.
+            report.errors += pending.size() + busy;
+            break;
+        }
+
+        itimerspec timer = {};
+        const auto wakeup_ns = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(wakeup.time_since_epoch()).count();
+        timer.it_value.tv_sec = wakeup_ns / 1000000000;
+        timer.it_value.tv_nsec = wakeup_ns % 1000000000;
+        if (timer.it_value.tv_sec == 0 && timer.it_value.tv_nsec == 0) {
+            timer.it_value.tv_nsec = 1; // Zero would disarm the timer.
+        }
+        OSCHECK(timerfd_settime,(m_timer_fd, TFD_TIMER_ABSTIME, &timer,
+                                 nullptr), == 0);
+
+        const int n = OSCHECK(epoll_wait,(m_epoll_fd, events.data(),
+                                          static_cast<int>(events.size()),
+                                          -1), >= 0 || errno == EINTR);
+        for (int i = 0; i < n; ++i) {
+            auto *connection = static_cast<connection_t*>(events[i].data.ptr);
+            if (connection == nullptr) {
+                std::uint64_t expirations;
+                while (read(m_timer_fd, &expirations, sizeof(expirations)) > 0)
+                    ;
+                continue;
+            }
+            handle_event(*connection, events[i].events, report);
+        }
+    }
+
+    report.elapsed = now - start;
+    for (auto &connection : m_connections) {
+        disconnect(*connection);
+    }
+    return report;
+}
+
+void load_generator_t::connect(connection_t &connection)
+{
+    connection.connected = false;
+    connection.busy = false;
+    connection.fd = OSCHECK(socket,(m_address.ss_family,
+                                    SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                    0), >= 0);
+    const int one = 1;
+    setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(connection.fd, reinterpret_cast<sockaddr*>(&m_address),
+                  m_address_size) < 0 && errno != EINPROGRESS) {
+        close(connection.fd);
+        connection.fd = -1;
+        connection.retry_at = clock_type::now() + retry_delay;
+        return;
+    }
+    watch(connection, EPOLLOUT, EPOLL_CTL_ADD);
+}
+
+void load_generator_t::watch(connection_t &connection, std::uint32_t events,
+                             int op)
+{
+    epoll_event event = {};
+    event.events = events;
+    event.data.ptr = &connection;
+    OSCHECK(epoll_ctl,(m_epoll_fd, op, connection.fd, &event), == 0);
+}
+
+void load_generator_t::disconnect(connection_t &connection)
+{
+    if (connection.fd >= 0) {
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        close(connection.fd);
+        connection.fd = -1;
+    }
+    connection.connected = false;
+    connection.busy = false;
+    m_idle.erase(std::remove(m_idle.begin(), m_idle.end(), &connection),
+                 m_idle.end());
+}
+
+void load_generator_t::send(connection_t &connection, pending_t &&request)
+{
+    const load_request_t &r = request.request;
+    connection.out = r.method + " " + r.target + " HTTP/1.1\r\n"
+                     "Host: " + m_options.host + ":" + m_options.port + "\r\n"
+                     "Accept-Encoding: identity\r\n";
+    if (!r.range.empty()) {
+        connection.out += "Range: " + r.range + "\r\n";
+    }
+    connection.out += "\r\n";
+    connection.written = 0;
+    connection.parser.reset(r.method == "HEAD");
+    connection.intended = request.intended;
+    connection.sent = clock_type::now();
+    connection.busy = true;
+    // Sent by handle_event() as soon as the socket is writable.
+    watch(connection, EPOLLIN | EPOLLOUT, EPOLL_CTL_MOD);
+}
+
+void load_generator_t::handle_event(connection_t &connection,
+                                    std::uint32_t events,
+                                    load_report_t &report)
+{
+    if (connection.fd < 0) {
+        // Closed while handling an earlier event of the same batch.
+        return;
+    }
+    if (!connection.connected) {
+        int error = 0;
+        socklen_t size = sizeof(error);
+        getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &size);
+        if (error != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+            fail(connection, report);
+            return;
+        }
+        connection.connected = true;
+        watch(connection, EPOLLIN, EPOLL_CTL_MOD);
+        m_idle.push_back(&connection);
+        return;
+    }
+
+    if ((events & EPOLLOUT) && connection.written < connection.out.size()) {
+        const ssize_t n = write(connection.fd,
+                                connection.out.data() + connection.written,
+                                connection.out.size() - connection.written);
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            fail(connection, report);
+            return;
+        }
+        connection.written += n > 0 ? static_cast<std::size_t>(n) : 0;
+        if (connection.written == connection.out.size()) {
+            watch(connection, EPOLLIN, EPOLL_CTL_MOD);
+        }
+    }
+
+    if (!(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+        return;
+    }
+    while (connection.fd >= 0) {
+        const ssize_t n = read(connection.fd, m_buffer.data(), m_buffer.size());
+        try {
+            if (n > 0 && connection.busy) {
+                const auto size = static_cast<std::size_t>(n);
+                if (connection.parser.feed(m_buffer.data(), size) < size) {
+                    // Requests are not pipelined.
+                    throw http_parse_error("Unexpected data");
+                }
+                if (connection.parser.done())
+                    complete(connection, report);
+            } else if (n > 0) {
+                throw http_parse_error("Unexpected data");
+            } else if (n == 0) {
+                if (connection.busy) {
+                    connection.parser.close();
+                    complete(connection, report);
+                }
+                // The server closes idle connections, open a new one.
+                disconnect(connection);
+                connection.retry_at = clock_type::now();
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            } else if (errno != EINTR) {
+                fail(connection, report);
+            }
+        } catch (const http_parse_error &) {
+            fail(connection, report);
+        }
+    }
+}
+
+void load_generator_t::complete(connection_t &connection,
+                                load_report_t &report)
+{
+    const clock_type::time_point now = clock_type::now();
+    report.latency.record(now - connection.intended);
+    report.service_time.record(now - connection.sent);
+    ++report.completed;
+    ++report.statuses[connection.parser.status()];
+    report.bytes += connection.parser.body_size();
+    connection.busy = false;
+    if (connection.parser.keep_alive()) {
+        m_idle.push_back(&connection);
+    } else {
+        disconnect(connection);
+        connection.retry_at = now;
+    }
+}
+
+void load_generator_t::fail(connection_t &connection, load_report_t &report)
+{
+    if (connection.busy) {
+        ++report.errors;
+    }
+    disconnect(connection);
+    connection.retry_at = clock_type::now() + retry_delay;
+}
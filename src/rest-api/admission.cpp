@@ -0,0 +1,80 @@
+#include <algorithm>
+
+#include <admission.hpp>
+#include <logging.hpp>
+
+LOG_MODULE("AdmissionControl")
+
+
+constexpr std::chrono::milliseconds admission_control_t::probe_interval;
+
+
+/**
+ * Starts measuring the lag of @p eventloop.
+ */
+admission_control_t::admission_control_t(eventloop_t *eventloop,
+                                         const limits_t &limits)
+    : m_eventloop(eventloop)
+    , m_limits(limits)
+    , m_self(std::make_shared<admission_control_t*>(this))
+{
+    schedule_probe();
+}
+
+/**
+ * Decides whether a new request is served.
+ *
+ * @param priority  Priority of the route of the request.
+ * @param suspended Amount of currently suspended connections.
+ * @return `false` if the request should be rejected with 503.
+ */
+bool admission_control_t::admit(route_priority_e priority,
+                                std::size_t suspended)
+{
+    const bool overloaded =
+            (m_limits.max_lag.count() > 0 && m_lag > m_limits.max_lag)
+            || (m_limits.max_suspended > 0
+                && suspended > m_limits.max_suspended);
+    if (overloaded != m_overloaded) {
+        m_overloaded = overloaded;
+        if (overloaded) {
+            ++m_stats.overloads;
+            LOG_WARN() << "Server is overloaded (lag: "
+                       << std::chrono::duration_cast<
+                              std::chrono::milliseconds>(m_lag).count()
+                       << " ms, suspended connections: " << suspended
+                       << "), rejecting requests";
+        } else {
+            LOG_INFO() << "Server has recovered from overload, "
+                       << m_stats.rejected << " requests rejected so far";
+        }
+    }
+    if (!overloaded || priority == route_priority_e::HIGH) {
+        return true;
+    }
+    ++m_stats.rejected;
+    return false;
+}
+
+void admission_control_t::schedule_probe()
+{
+    std::weak_ptr<admission_control_t*> self = m_self;
+    m_due = std::chrono::steady_clock::now() + probe_interval;
+    m_eventloop->call([self] {
+        if (auto control = self.lock())
+            (*control)->probe();
+    }, probe_interval);
+}
+
+void admission_control_t::probe()
+{
+    const std::chrono::nanoseconds sample = std::max(
+            std::chrono::nanoseconds::zero(),
+            std::chrono::steady_clock::now() - m_due);
+    if (sample >= m_lag) {
+        m_lag = sample;
+    } else {
+        m_lag -= (m_lag - sample) / 4;
+    }
+    schedule_probe();
+}
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <bandwidth.hpp>
+
+
+constexpr std::uint64_t token_bucket_t::min_burst;
+constexpr std::size_t bandwidth_scheduler_t::min_grant;
+
+
+/**
+ * Creates a full bucket.
+ */
+token_bucket_t::token_bucket_t(std::uint64_t rate, time_point now)
+    : m_rate(rate)
+    , m_burst(std::max<double>(static_cast<double>(rate) / 4, min_burst))
+    , m_tokens(m_burst)
+    , m_time(now)
+{
+}
+
+/**
+ * Changes the rate. Tokens exceeding the new burst size are dropped.
+ */
+void token_bucket_t::set_rate(std::uint64_t rate, time_point now) noexcept
+{
+    available(now);
+    m_rate = rate;
+    m_burst = std::max<double>(static_cast<double>(rate) / 4, min_burst);
+    m_tokens = std::min(m_tokens, m_burst);
+}
+
+/**
+ * Refills the bucket.
+ *
+ * @return The amount of tokens which may be consumed.
+ */
+std::uint64_t token_bucket_t::available(time_point now) noexcept
+{
+    if (now > m_time) {
+        const double seconds =
+                std::chrono::duration<double>(now - m_time).count();
+        m_tokens = std::min(m_burst, m_tokens + seconds * m_rate);
+        m_time = now;
+    }
+    if (m_rate == 0) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+    return m_tokens > 0 ? static_cast<std::uint64_t>(m_tokens) : 0;
+}
+
+/**
+ * Takes @p bytes tokens. The bucket may go into debt, which is paid back by
+ * the following refills.
+ */
+void token_bucket_t::consume(std::uint64_t bytes) noexcept
+{
+    if (m_rate != 0) {
+        m_tokens -= static_cast<double>(bytes);
+    }
+}
+
+/**
+ * Returns the time until @p bytes tokens are available, as of the last
+ * refill.
+ */
+std::chrono::nanoseconds token_bucket_t::time_until(
+        std::uint64_t bytes) const noexcept
+{
+    if (m_rate == 0 || m_tokens >= static_cast<double>(bytes)) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(
+                (static_cast<double>(bytes) - m_tokens) / m_rate));
+}
+
+
+/**
+ * State shared by all flows of one client address.
+ */
+struct bandwidth_flow_t::client_t {
+    std::string address;
+    token_bucket_t bucket;
+};
+
+bandwidth_flow_t::bandwidth_flow_t(bandwidth_scheduler_t *scheduler,
+                                   std::uint64_t id,
+                                   const std::shared_ptr<client_t> &client,
+                                   const pause_t &pause)
+    : m_scheduler(scheduler)
+    , m_id(id)
+    , m_client(client)
+    , m_pause(pause)
+    , m_bucket(scheduler->m_limits.download)
+{
+    m_scheduler->m_flows[m_id] = this;
+}
+
+bandwidth_flow_t::~bandwidth_flow_t() noexcept
+{
+    m_scheduler->m_flows.erase(m_id);
+    if (m_client.use_count() == 1) {
+        m_scheduler->m_clients.erase(m_client->address);
+    }
+}
+
+/**
+ * Asks for permission to send up to @p max bytes.
+ *
+ * @return The amount of bytes which may be sent now. If it is zero, the flow
+ *         has been paused and will be continued by a timer.
+ */
+std::size_t bandwidth_flow_t::grant(std::size_t max)
+{
+    if (max == 0) {
+        return 0;
+    }
+    const token_bucket_t::time_point now = std::chrono::steady_clock::now();
+    token_bucket_t *const buckets[] = {
+        &m_scheduler->m_bucket, &m_client->bucket, &m_bucket
+    };
+    std::uint64_t granted = max;
+    for (token_bucket_t *bucket : buckets) {
+        granted = std::min(granted, bucket->available(now));
+    }
+
+    // Do not send tiny chunks, wait until a reasonable amount is available.
+    const std::uint64_t needed = std::min<std::uint64_t>(
+            max, bandwidth_scheduler_t::min_grant);
+    if (granted < needed) {
+        std::chrono::nanoseconds delay = std::chrono::milliseconds(1);
+        for (token_bucket_t *bucket : buckets) {
+            delay = std::max(delay, bucket->time_until(needed));
+        }
+        m_paused = true;
+        ++m_scheduler->m_stats.paused;
+        m_pause(true);
+        m_scheduler->schedule_wake(m_id, delay);
+        return 0;
+    }
+
+    for (token_bucket_t *bucket : buckets) {
+        bucket->consume(granted);
+    }
+    m_scheduler->m_stats.sent += granted;
+    return static_cast<std::size_t>(granted);
+}
+
+void bandwidth_flow_t::wake()
+{
+    if (m_paused) {
+        m_paused = false;
+        m_pause(false);
+    }
+}
+
+
+bandwidth_scheduler_t::bandwidth_scheduler_t(eventloop_t *eventloop,
+                                             const limits_t &limits)
+    : m_eventloop(eventloop)
+    , m_limits(limits)
+    , m_bucket(limits.global)
+    , m_self(std::make_shared<bandwidth_scheduler_t*>(this))
+{
+}
+
+/**
+ * Changes the limits of all current and future downloads. Paused downloads
+ * are continued, so they are paced by the new limits at once.
+ */
+void bandwidth_scheduler_t::set_limits(const limits_t &limits)
+{
+    const token_bucket_t::time_point now = std::chrono::steady_clock::now();
+    m_limits = limits;
+    m_bucket.set_rate(limits.global, now);
+    for (auto &entry : m_clients) {
+        if (auto client = entry.second.lock())
+            client->bucket.set_rate(limits.client, now);
+    }
+    // Waking a flow may destroy other flows.
+    std::vector<std::uint64_t> ids;
+    for (auto &entry : m_flows) {
+        entry.second->m_bucket.set_rate(limits.download, now);
+        ids.push_back(entry.first);
+    }
+    for (std::uint64_t id : ids) {
+        auto it = m_flows.find(id);
+        if (it != m_flows.end())
+            it->second->wake();
+    }
+}
+
+bandwidth_scheduler_t::stats_t bandwidth_scheduler_t::stats() const noexcept
+{
+    stats_t stats = m_stats;
+    stats.clients = m_clients.size();
+    stats.downloads = m_flows.size();
+    return stats;
+}
+
+/**
+ * Starts pacing a download.
+ *
+ * @param client Address of the client, which shares its bucket with all its
+ *               downloads.
+ * @param pause  Called to pause and continue sending.
+ */
+std::unique_ptr<bandwidth_flow_t> bandwidth_scheduler_t::open(
+        const std::string &client, const bandwidth_flow_t::pause_t &pause)
+{
+    std::shared_ptr<bandwidth_flow_t::client_t> state =
+            m_clients[client].lock();
+    if (!state) {
+        state = std::make_shared<bandwidth_flow_t::client_t>();
+        state->address = client;
+        state->bucket = token_bucket_t(m_limits.client);
+        m_clients[client] = state;
+    }
+    return std::unique_ptr<bandwidth_flow_t>(
+            new bandwidth_flow_t(this, m_next_id++, state, pause));
+}
+
+/**
+ * Charges @p bytes sent outside of HTTP downloads to the global limit.
+ */
+void bandwidth_scheduler_t::charge(std::uint64_t bytes) noexcept
+{
+    m_bucket.consume(bytes);
+}
+
+void bandwidth_scheduler_t::schedule_wake(std::uint64_t id,
+                                          std::chrono::nanoseconds delay)
+{
+    std::weak_ptr<bandwidth_scheduler_t*> self = m_self;
+    m_eventloop->call([self, id] {
+        if (auto scheduler = self.lock()) {
+            auto it = (*scheduler)->m_flows.find(id);
+            if (it != (*scheduler)->m_flows.end())
+                it->second->wake();
+        }
+    }, delay);
+}
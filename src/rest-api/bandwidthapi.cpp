@@ -0,0 +1,193 @@
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <bandwidthapi.hpp>
+#include <bufferchain.hpp>
+#include <responseformat.hpp>
+
+
+/**
+ * State of a single request to `PUT /bandwidth`.
+ */
+struct bandwidth_request_t {
+    std::string body;
+    bool started = false;
+    bool responded = false;
+};
+
+
+static void parse_limit(const boost::property_tree::ptree &tree,
+                        const char *name, std::uint64_t &limit)
+{
+    if (!tree.get_child_optional(name)) {
+        return;
+    }
+    const long long value = tree.get<long long>(name);
+    if (value < 0) {
+        throw std::runtime_error(std::string("negative limit: ") + name);
+    }
+    limit = static_cast<std::uint64_t>(value);
+}
+
+/**
+ * Returns the address of the client of @p connection without port, so all
+ * connections of a host share its bucket.
+ */
+static std::string client_address(MHD_Connection *connection)
+{
+    const MHD_ConnectionInfo *info = MHD_get_connection_info(
+            connection, MHD_CONNECTION_INFO_CLIENT_ADDRESS);
+    if (info == nullptr || info->client_addr == nullptr) {
+        return std::string();
+    }
+    const sockaddr *address = info->client_addr;
+    char buf[INET6_ADDRSTRLEN] = "";
+    if (address->sa_family == AF_INET) {
+        inet_ntop(AF_INET,
+                  &reinterpret_cast<const sockaddr_in*>(address)->sin_addr,
+                  buf, sizeof(buf));
+    } else if (address->sa_family == AF_INET6) {
+        inet_ntop(AF_INET6,
+                  &reinterpret_cast<const sockaddr_in6*>(address)->sin6_addr,
+                  buf, sizeof(buf));
+    }
+    return buf;
+}
+
+
+bandwidth_scheduler_t::limits_t parse_bandwidth_limits(
+        const std::string &body,
+        const bandwidth_scheduler_t::limits_t &current)
+{
+    boost::property_tree::ptree tree;
+    std::istringstream in(body);
+    boost::property_tree::read_json(in, tree);
+
+    bandwidth_scheduler_t::limits_t limits = current;
+    parse_limit(tree, "global", limits.global);
+    parse_limit(tree, "client", limits.client);
+    parse_limit(tree, "download", limits.download);
+    return limits;
+}
+
+
+bandwidth_api_t::bandwidth_api_t(httpserver_t *server,
+                                 bandwidth_scheduler_t *scheduler)
+    : m_server(server), m_scheduler(scheduler)
+{
+    m_server->add_route(MHD_HTTP_METHOD_GET, "bandwidth",
+                        [this](MHD_Connection *connection) {
+                            return route_get(connection);
+                        });
+    // Limiting the bandwidth is a remedy for overload.
+    m_server->add_route(MHD_HTTP_METHOD_PUT, "bandwidth",
+                        [this](MHD_Connection *connection) {
+                            return route_put(connection);
+                        }, route_priority_e::HIGH);
+}
+
+/**
+ * Starts pacing a download of @p connection. The connection is suspended
+ * while the download waits for bandwidth.
+ */
+std::unique_ptr<bandwidth_flow_t> bandwidth_api_t::open(
+        MHD_Connection *connection)
+{
+    httpserver_t *server = m_server;
+    return m_scheduler->open(client_address(connection),
+                             [server, connection](bool pause) {
+        if (pause)
+            server->suspend(connection, suspension_e::THROTTLED);
+        else
+            server->resume(connection);
+    });
+}
+
+httpserver_t::access_handler_t bandwidth_api_t::route_get(MHD_Connection *)
+{
+    return [this](MHD_Connection *connection, const char *,
+                  std::size_t *upload_data_size) {
+        if (*upload_data_size != 0) {
+            *upload_data_size = 0;
+            return;
+        }
+        respond(connection);
+    };
+}
+
+httpserver_t::access_handler_t bandwidth_api_t::route_put(MHD_Connection *)
+{
+    auto request = std::make_shared<bandwidth_request_t>();
+    return [this, request](MHD_Connection *connection,
+                           const char *upload_data,
+                           std::size_t *upload_data_size) {
+        if (request->responded) {
+            *upload_data_size = 0;
+            return;
+        }
+        if (!request->started && *upload_data_size == 0) {
+            request->started = true;
+            return;
+        }
+        if (*upload_data_size != 0) {
+            if (request->body.size() + *upload_data_size > max_body_size) {
+                request->responded = true;
+                queue_error_response(connection,
+                                     MHD_HTTP_REQUEST_ENTITY_TOO_LARGE,
+                                     "body is too large");
+                return;
+            }
+            request->body.append(upload_data, *upload_data_size);
+            *upload_data_size = 0;
+            return;
+        }
+        request->responded = true;
+        bandwidth_scheduler_t::limits_t limits;
+        try {
+            limits = parse_bandwidth_limits(request->body,
+                                            m_scheduler->limits());
+        } catch (const std::runtime_error &) {
+            queue_error_response(connection, MHD_HTTP_BAD_REQUEST,
+                                 "invalid limits");
+            return;
+        }
+        m_scheduler->set_limits(limits);
+        respond(connection);
+    };
+}
+
+void bandwidth_api_t::respond(MHD_Connection *connection)
+{
+    const bandwidth_scheduler_t::limits_t &limits = m_scheduler->limits();
+    const bandwidth_scheduler_t::stats_t stats = m_scheduler->stats();
+
+    const response_format_e format = request_format(connection);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &out) {
+        out.begin_object()
+            .key("global").value(static_cast<unsigned long long>(limits.global))
+            .key("client").value(static_cast<unsigned long long>(limits.client))
+            .key("download")
+                .value(static_cast<unsigned long long>(limits.download))
+            .key("sent").value(static_cast<unsigned long long>(stats.sent))
+            .key("paused").value(static_cast<unsigned long long>(stats.paused))
+            .key("clients")
+                .value(static_cast<unsigned long long>(stats.clients))
+            .key("downloads")
+                .value(static_cast<unsigned long long>(stats.downloads))
+            .end_object();
+    });
+    queue_buffer_response(connection, MHD_HTTP_OK, std::move(chain),
+                          to_media_type(format));
+}
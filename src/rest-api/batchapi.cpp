@@ -0,0 +1,169 @@
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <batchapi.hpp>
+#include <bufferchain.hpp>
+#include <errorhandling.hpp>
+#include <responseformat.hpp>
+
+
+/**
+ * State of a single request to `POST /batch`.
+ */
+struct batch_request_t {
+    std::string body;
+    bool started = false;
+    bool responded = false;
+};
+
+
+static int hex_value(char c) noexcept
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool parse_infohash(const std::string &hex, infohash_t &infohash)
+{
+    if (hex.size() != 2 * infohash.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < infohash.size(); ++i) {
+        int high = hex_value(hex[2 * i]);
+        int low = hex_value(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        infohash[i] = static_cast<std::uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+static boost::optional<batch_op_t> parse_op(
+        const boost::property_tree::ptree &item)
+{
+    batch_op_t op;
+    const std::string action = item.get<std::string>("op", "");
+    if (action == "pause") {
+        op.action = batch_action_e::PAUSE;
+    } else if (action == "resume") {
+        op.action = batch_action_e::RESUME;
+    } else if (action == "remove") {
+        op.action = item.get<bool>("data", false)
+                ? batch_action_e::REMOVE_DATA : batch_action_e::REMOVE;
+    } else if (action == "file-priority") {
+        op.action = batch_action_e::FILE_PRIORITY;
+        op.file = item.get<int>("file");
+        op.priority = item.get<int>("priority");
+        if (op.file < 0 || op.priority < 0 || op.priority > 7) {
+            return boost::none;
+        }
+    } else {
+        return boost::none;
+    }
+    if (!parse_infohash(item.get<std::string>("torrent", ""), op.infohash)) {
+        return boost::none;
+    }
+    return op;
+}
+
+
+std::vector<boost::optional<batch_op_t>> parse_batch(const std::string &body)
+{
+    boost::property_tree::ptree tree;
+    std::istringstream in(body);
+    boost::property_tree::read_json(in, tree);
+
+    std::vector<boost::optional<batch_op_t>> ops;
+    for (const auto &item : tree.get_child("operations")) {
+        try {
+            ops.push_back(parse_op(item.second));
+        } catch (const boost::property_tree::ptree_error &) {
+            // Missing or malformed numbers
+            ops.push_back(boost::none);
+        }
+    }
+    return ops;
+}
+
+
+batch_api_t::batch_api_t(httpserver_t *server, const executor_t &executor)
+    : m_server(server), m_executor(executor)
+{
+    m_server->add_route(MHD_HTTP_METHOD_POST, "batch",
+                        [this](MHD_Connection *connection) {
+                            return route_batch(connection);
+                        }, route_priority_e::HIGH);
+}
+
+httpserver_t::access_handler_t batch_api_t::route_batch(MHD_Connection *)
+{
+    auto request = std::make_shared<batch_request_t>();
+    return [this, request](MHD_Connection *connection,
+                           const char *upload_data,
+                           std::size_t *upload_data_size) {
+        if (request->responded) {
+            *upload_data_size = 0;
+            return;
+        }
+        if (!request->started && *upload_data_size == 0) {
+            request->started = true;
+            return;
+        }
+        if (*upload_data_size != 0) {
+            if (request->body.size() + *upload_data_size > max_body_size) {
+                request->responded = true;
+                queue_error_response(connection,
+                                     MHD_HTTP_REQUEST_ENTITY_TOO_LARGE,
+                                     "batch is too large");
+                return;
+            }
+            request->body.append(upload_data, *upload_data_size);
+            *upload_data_size = 0;
+            return;
+        }
+        request->responded = true;
+        std::vector<boost::optional<batch_op_t>> parsed;
+        try {
+            parsed = parse_batch(request->body);
+        } catch (const std::runtime_error &) {
+            queue_error_response(connection, MHD_HTTP_BAD_REQUEST,
+                                 "invalid batch");
+            return;
+        }
+        std::string().swap(request->body);
+
+        std::vector<batch_op_t> ops;
+        ops.reserve(parsed.size());
+        for (const auto &op : parsed) {
+            if (op)
+                ops.push_back(*op);
+        }
+        const std::vector<batch_result_e> results = m_executor(ops);
+        ASSERT(results.size() == ops.size());
+
+        const response_format_e format = request_format(connection);
+        buffer_chain_t chain;
+        write_formatted(format, chain, [&](auto &out) {
+            out.begin_object().key("results").begin_array();
+            std::size_t next = 0;
+            for (const auto &op : parsed) {
+                out.value(op ? to_string(results[next++])
+                             : "invalid_operation");
+            }
+            out.end_array().end_object();
+        });
+        queue_buffer_response(connection, MHD_HTTP_OK, std::move(chain),
+                              to_media_type(format));
+    };
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include <microhttpd.h>
+
+#include <bufferchain.hpp>
+#include <errorhandling.hpp>
+
+
+//! Amount of unused chunks kept per thread.
+static constexpr std::size_t max_free_chunks = 256;
+
+constexpr std::size_t buffer_chain_t::chunk_size;
+
+
+struct buffer_chain_t::chunk_t {
+    chunk_t *next;
+    std::size_t used;
+    char data[chunk_size];
+};
+
+/**
+ * Unused chunks of the current thread.
+ */
+static thread_local struct free_list_t {
+    void *head = nullptr;
+    std::size_t size = 0;
+
+    ~free_list_t() {
+        while (head != nullptr) {
+            void *next = *static_cast<void**>(head);
+            ::operator delete(head);
+            head = next;
+        }
+    }
+} free_chunks;
+
+
+buffer_chain_t::buffer_chain_t(buffer_chain_t &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+buffer_chain_t &buffer_chain_t::operator =(buffer_chain_t &&other) noexcept
+{
+    std::swap(m_head, other.m_head);
+    std::swap(m_tail, other.m_tail);
+    std::swap(m_tail_data, other.m_tail_data);
+    std::swap(m_tail_used, other.m_tail_used);
+    std::swap(m_size, other.m_size);
+    std::swap(m_read_chunk, other.m_read_chunk);
+    std::swap(m_read_offset, other.m_read_offset);
+    return *this;
+}
+
+buffer_chain_t::~buffer_chain_t() noexcept
+{
+    while (m_head != nullptr) {
+        chunk_t *chunk = m_head;
+        m_head = chunk->next;
+        if (free_chunks.size < max_free_chunks) {
+            // The first member of the chunk is reused as link.
+            *reinterpret_cast<void**>(chunk) = free_chunks.head;
+            free_chunks.head = chunk;
+            ++free_chunks.size;
+        } else {
+            ::operator delete(chunk);
+        }
+    }
+}
+
+void buffer_chain_t::append(const char *data, std::size_t size)
+{
+    while (size > 0) {
+        std::size_t n = std::min(size, chunk_size);
+        if (m_tail != nullptr && m_tail_used < chunk_size) {
+            n = std::min(n, chunk_size - m_tail_used);
+        }
+        std::memcpy(reserve(n), data, n);
+        commit(n);
+        data += n;
+        size -= n;
+    }
+}
+
+/**
+ * Copies up to @p max bytes which have not been read yet into @p buf.
+ *
+ * @return The amount of bytes copied. Zero if everything has been read.
+ */
+std::size_t buffer_chain_t::read(char *buf, std::size_t max) noexcept
+{
+    seal_tail();
+    if (m_read_chunk == nullptr) {
+        m_read_chunk = m_head;
+    }
+
+    std::size_t done = 0;
+    while (m_read_chunk != nullptr && done < max) {
+        std::size_t n = std::min(max - done,
+                                 m_read_chunk->used - m_read_offset);
+        std::memcpy(buf + done, m_read_chunk->data + m_read_offset, n);
+        done += n;
+        m_read_offset += n;
+        if (m_read_offset == m_read_chunk->used) {
+            if (m_read_chunk->next == nullptr) {
+                break;
+            }
+            m_read_chunk = m_read_chunk->next;
+            m_read_offset = 0;
+        }
+    }
+    return done;
+}
+
+/**
+ * Returns a copy of the whole content.
+ */
+std::string buffer_chain_t::str() const
+{
+    std::string result;
+    result.reserve(m_size);
+    for (const chunk_t *chunk = m_head; chunk != nullptr; chunk = chunk->next) {
+        std::size_t used = chunk == m_tail ? m_tail_used : chunk->used;
+        result.append(chunk->data, used);
+    }
+    return result;
+}
+
+void buffer_chain_t::add_chunk()
+{
+    chunk_t *chunk;
+    if (free_chunks.head != nullptr) {
+        chunk = static_cast<chunk_t*>(free_chunks.head);
+        free_chunks.head = *static_cast<void**>(free_chunks.head);
+        --free_chunks.size;
+    } else {
+        chunk = static_cast<chunk_t*>(::operator new(sizeof(chunk_t)));
+    }
+    chunk->next = nullptr;
+    chunk->used = 0;
+
+    seal_tail();
+    if (m_tail == nullptr) {
+        m_head = chunk;
+    } else {
+        m_tail->next = chunk;
+    }
+    m_tail = chunk;
+    m_tail_data = chunk->data;
+    m_tail_used = 0;
+}
+
+void buffer_chain_t::seal_tail() noexcept
+{
+    if (m_tail != nullptr) {
+        m_tail->used = m_tail_used;
+    }
+}
+
+
+static ssize_t read_buffer_chain(void *cls, std::uint64_t pos, char *buf,
+                                 std::size_t max) noexcept
+{
+    buffer_chain_t *chain = static_cast<buffer_chain_t*>(cls);
+    std::size_t ret = chain->read(buf, max);
+    return ret > 0 ? static_cast<ssize_t>(ret)
+                   : MHD_CONTENT_READER_END_OF_STREAM;
+}
+
+static void free_buffer_chain(void *cls) noexcept
+{
+    delete static_cast<buffer_chain_t*>(cls);
+}
+
+MHD_Response *create_buffer_response(buffer_chain_t &&chain,
+                                     const char *content_type)
+{
+    std::size_t size = chain.size();
+    buffer_chain_t *content = new buffer_chain_t(std::move(chain));
+    MHD_Response *r = MHD_create_response_from_callback(
+            size, buffer_chain_t::chunk_size, &read_buffer_chain, content,
+            &free_buffer_chain);
+    if (r == nullptr) {
+        delete content;
+        OSERROR(MHD_create_response_from_callback,
+                "`MHD_create_response_from_callback()' has surprisingly failed");
+    }
+    OSCHECK(MHD_add_response_header,(r, "Content-type", content_type),
+            != MHD_NO);
+    return r;
+}
+
+void queue_buffer_response(MHD_Connection *connection, unsigned int status,
+                           buffer_chain_t &&chain, const char *content_type)
+{
+    MHD_Response *response = create_buffer_response(std::move(chain),
+                                                    content_type);
+    int ret = MHD_queue_response(connection, status, response);
+    MHD_destroy_response(response);
+    if (ret != MHD_YES) {
+        OSERROR(MHD_queue_response,
+                "`MHD_queue_response()' has surprisingly failed");
+    }
+}
@@ -0,0 +1,181 @@
+#include <cmath>
+
+#include <cborwriter.hpp>
+
+
+// Major types of CBOR.
+static constexpr unsigned major_unsigned = 0;
+static constexpr unsigned major_negative = 1;
+static constexpr unsigned major_bytes    = 2;
+static constexpr unsigned major_text     = 3;
+static constexpr unsigned major_array    = 4;
+static constexpr unsigned major_map      = 5;
+
+// Initial bytes of simple values and floats.
+static constexpr char cbor_false      = '\xf4';
+static constexpr char cbor_true       = '\xf5';
+static constexpr char cbor_null       = '\xf6';
+static constexpr char cbor_float32    = '\xfa';
+static constexpr char cbor_float64    = '\xfb';
+static constexpr char cbor_break      = '\xff';
+//! Argument which marks an array or a map of indefinite length.
+static constexpr unsigned indefinite  = 31;
+
+
+const char *const cbor_key_names[] = {
+    // GET /torrents
+    "infohash", "name", "state", "progress", "download_rate", "upload_rate",
+    "peers", "seeds", "total_done", "total_wanted", "added", "ratio",
+    "version", "full", "torrents", "removed", "total", "offset",
+    // Errors
+    "msg"
+};
+
+const std::size_t cbor_key_count =
+        sizeof(cbor_key_names) / sizeof(cbor_key_names[0]);
+
+
+/**
+ * Writes the @p size lowest bytes of @p value to @p buf in network byte order.
+ */
+static void write_be(std::uint64_t value, std::size_t size, char *buf)
+{
+    for (std::size_t i = size; i > 0; --i) {
+        buf[i - 1] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+
+cbor_writer_t &cbor_writer_t::begin_object()
+{
+    m_out.append(static_cast<char>(major_map << 5 | indefinite));
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::end_object()
+{
+    m_out.append(cbor_break);
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::begin_array()
+{
+    m_out.append(static_cast<char>(major_array << 5 | indefinite));
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::end_array()
+{
+    m_out.append(cbor_break);
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::key(const char *str, std::size_t len)
+{
+    for (std::size_t i = 0; i < cbor_key_count; ++i) {
+        const char *name = cbor_key_names[i];
+        if (std::strncmp(name, str, len) == 0 && name[len] == '\0') {
+            write_head(major_unsigned, i);
+            return *this;
+        }
+    }
+    return value(str, len);
+}
+
+cbor_writer_t &cbor_writer_t::value(const char *str, std::size_t len)
+{
+    write_head(major_text, len);
+    m_out.append(str, len);
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::value(bool b)
+{
+    m_out.append(b ? cbor_true : cbor_false);
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::value(double d)
+{
+    if (!std::isfinite(d)) {
+        return null();
+    }
+    const float f = static_cast<float>(d);
+    if (static_cast<double>(f) == d) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        char *buf = m_out.reserve(5);
+        buf[0] = cbor_float32;
+        write_be(bits, 4, buf + 1);
+        m_out.commit(5);
+    } else {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        char *buf = m_out.reserve(9);
+        buf[0] = cbor_float64;
+        write_be(bits, 8, buf + 1);
+        m_out.commit(9);
+    }
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::null()
+{
+    m_out.append(cbor_null);
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::binary(const void *data, std::size_t len)
+{
+    write_head(major_bytes, len);
+    m_out.append(static_cast<const char*>(data), len);
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::write_int(std::int64_t i)
+{
+    if (i < 0) {
+        // -1 - i, which cannot overflow.
+        write_head(major_negative, ~static_cast<std::uint64_t>(i));
+    } else {
+        write_head(major_unsigned, static_cast<std::uint64_t>(i));
+    }
+    return *this;
+}
+
+cbor_writer_t &cbor_writer_t::write_uint(std::uint64_t i)
+{
+    write_head(major_unsigned, i);
+    return *this;
+}
+
+/**
+ * Writes the initial byte of a data item and its argument in the shortest
+ * form.
+ */
+void cbor_writer_t::write_head(unsigned major, std::uint64_t argument)
+{
+    char *buf = m_out.reserve(9);
+    std::size_t size;
+    unsigned info;
+    if (argument < 24) {
+        size = 0;
+        info = static_cast<unsigned>(argument);
+    } else if (argument <= 0xFF) {
+        size = 1;
+        info = 24;
+    } else if (argument <= 0xFFFF) {
+        size = 2;
+        info = 25;
+    } else if (argument <= 0xFFFFFFFF) {
+        size = 4;
+        info = 26;
+    } else {
+        size = 8;
+        info = 27;
+    }
+    buf[0] = static_cast<char>(major << 5 | info);
+    write_be(argument, size, buf + 1);
+    m_out.commit(1 + size);
+}
@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <strings.h>
+#include <zlib.h>
+
+#ifdef XLTS_USE_BROTLI
+#   include <brotli/encode.h>
+#endif
+
+#include <compression.hpp>
+
+
+//! Compression level of gzip. Responses are compressed once and sent often.
+static constexpr int gzip_level = 6;
+//! Quality of brotli. Higher values are too slow for frequently changing data.
+static constexpr int brotli_quality = 5;
+
+
+static std::string compress_gzip(const char *data, std::size_t size)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // 16 added to the window bits selects the gzip wrapper.
+    if (deflateInit2(&stream, gzip_level, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return {};
+    }
+
+    std::string result(deflateBound(&stream, size), '\0');
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in  = size;
+    stream.next_out  = reinterpret_cast<Bytef*>(&result[0]);
+    stream.avail_out = result.size();
+    int ret = deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+        return {};
+    }
+    return result;
+}
+
+#ifdef XLTS_USE_BROTLI
+static std::string compress_brotli(const char *data, std::size_t size)
+{
+    std::size_t result_size = BrotliEncoderMaxCompressedSize(size);
+    if (result_size == 0) {
+        return {};
+    }
+    std::string result(result_size, '\0');
+    if (!BrotliEncoderCompress(
+            brotli_quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+            size, reinterpret_cast<const std::uint8_t*>(data),
+            &result_size, reinterpret_cast<std::uint8_t*>(&result[0]))) {
+        return {};
+    }
+    result.resize(result_size);
+    return result;
+}
+#endif
+
+
+const char *to_token(content_coding_e coding) noexcept
+{
+    switch (coding) {
+    case content_coding_e::IDENTITY: return nullptr;
+    case content_coding_e::GZIP:     return "gzip";
+    case content_coding_e::BROTLI:   return "br";
+    }
+    return nullptr;
+}
+
+bool accepts_coding(const char *accept_encoding,
+                    content_coding_e coding) noexcept
+{
+    const char *token = to_token(coding);
+    if (token == nullptr) {
+        return true;
+    }
+    if (accept_encoding == nullptr) {
+        return false;
+    }
+
+    // Explicitly listed codings take precedence over `*`.
+    double token_q = -1, any_q = -1;
+    const std::size_t token_len = std::strlen(token);
+    const char *p = accept_encoding;
+    while (*p != '\0') {
+        // Parse `coding [; q=value]` up to the next comma.
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            ++p;
+        }
+        const char *begin = p;
+        while (*p != '\0' && *p != ',' && *p != ';' && *p != ' ') {
+            ++p;
+        }
+        const std::size_t len = p - begin;
+
+        double q = 1;
+        while (*p != '\0' && *p != ',') {
+            if (*p == 'q' && p[1] == '=') {
+                q = std::strtod(p + 2, nullptr);
+            }
+            ++p;
+        }
+        if (len == token_len && strncasecmp(begin, token, len) == 0) {
+            token_q = q;
+        } else if (len == 1 && *begin == '*') {
+            any_q = q;
+        }
+    }
+    return token_q >= 0 ? token_q > 0 : any_q > 0;
+}
+
+std::string compress(const char *data, std::size_t size,
+                     content_coding_e coding)
+{
+    switch (coding) {
+    case content_coding_e::IDENTITY:
+        return std::string(data, size);
+    case content_coding_e::GZIP:
+        return compress_gzip(data, size);
+    case content_coding_e::BROTLI:
+#       ifdef XLTS_USE_BROTLI
+            return compress_brotli(data, size);
+#       else
+            return {};
+#       endif
+    }
+    return {};
+}
@@ -0,0 +1,50 @@
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <bufferchain.hpp>
+#include <diskapi.hpp>
+#include <responseformat.hpp>
+
+
+static const char *const class_names[] = {
+    "interactive", "normal", "background"
+};
+
+
+disk_api_t::disk_api_t(httpserver_t *server, disk_scheduler_t *scheduler)
+    : m_scheduler(scheduler)
+{
+    server->add_route(MHD_HTTP_METHOD_GET, "disk",
+                      [this](MHD_Connection *) {
+                          return [this](MHD_Connection *connection,
+                                        const char *, std::size_t *) {
+                              respond(connection);
+                          };
+                      });
+}
+
+void disk_api_t::respond(MHD_Connection *connection)
+{
+    const response_format_e format = request_format(connection);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &out) {
+        out.begin_object();
+        for (std::size_t i = 0; i < disk_scheduler_t::class_count; ++i) {
+            const disk_scheduler_t::stats_t stats =
+                    m_scheduler->stats(static_cast<io_class_e>(i));
+            out.key(class_names[i]).begin_object()
+                .key("queue_depth").value(stats.queue_depth)
+                .key("started")
+                    .value(static_cast<unsigned long long>(stats.started))
+                .key("wait_histogram").begin_array();
+            for (std::uint64_t count : stats.wait_histogram) {
+                out.value(static_cast<unsigned long long>(count));
+            }
+            out.end_array().end_object();
+        }
+        out.end_object();
+    });
+    queue_buffer_response(connection, MHD_HTTP_OK, std::move(chain),
+                          to_media_type(format));
+}
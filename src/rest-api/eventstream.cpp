@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include <microhttpd.h>
+
+#include <errorhandling.hpp>
+#include <eventstream.hpp>
+
+
+//! Size of the chunks requested by libmicrohttpd.
+static constexpr std::size_t block_size = 4 << 10;
+
+
+struct event_stream_t::hub_t {
+    httpserver_t *server;
+    //! Latest encoded event.
+    std::shared_ptr<const std::string> latest;
+    //! Sequence number of #latest.
+    std::uint64_t sequence = 0;
+    std::set<subscriber_t*> subscribers;
+    //! Set when the stream has been destroyed.
+    bool closed = false;
+};
+
+struct event_stream_t::subscriber_t {
+    std::shared_ptr<hub_t> hub;
+    MHD_Connection *connection;
+    //! Event which is being sent.
+    std::shared_ptr<const std::string> frame;
+    std::size_t offset = 0;
+    //! Sequence number of #frame.
+    std::uint64_t sequence = 0;
+    bool suspended = false;
+};
+
+
+/**
+ * Returns @p data encoded as event with id @p sequence.
+ */
+static std::string encode_event(std::uint64_t sequence,
+                                const std::string &data)
+{
+    std::string frame;
+    frame.reserve(data.size() + 32);
+    frame.append("id: ").append(std::to_string(sequence))
+         .append("\ndata: ").append(data).append("\n\n");
+    return frame;
+}
+
+
+event_stream_t::event_stream_t(httpserver_t *server)
+    : m_hub(std::make_shared<hub_t>())
+{
+    m_hub->server = server;
+}
+
+/**
+ * Ends the responses of all subscribers.
+ */
+event_stream_t::~event_stream_t() noexcept
+{
+    m_hub->closed = true;
+    for (subscriber_t *subscriber : m_hub->subscribers) {
+        if (subscriber->suspended) {
+            subscriber->suspended = false;
+            m_hub->server->resume(subscriber->connection);
+        }
+    }
+}
+
+/**
+ * Route for clients subscribing to the stream. Clients immediately receive
+ * @p initial as first event if it is set, else the latest event if there is
+ * one. @p initial is meant to replace all published events, so it gets the id
+ * of the latest event.
+ */
+httpserver_t::access_handler_t event_stream_t::subscribe(
+        MHD_Connection *connection, const std::string &initial)
+{
+    std::shared_ptr<hub_t> hub = m_hub;
+    std::shared_ptr<const std::string> frame;
+    if (!initial.empty()) {
+        frame = std::make_shared<const std::string>(
+                encode_event(hub->sequence, initial));
+    }
+    return [hub, frame](MHD_Connection *connection, const char *,
+                        std::size_t *) {
+        subscriber_t *subscriber = new subscriber_t{hub, connection};
+        if (frame) {
+            subscriber->frame = frame;
+            subscriber->sequence = hub->sequence;
+        }
+        MHD_Response *r = MHD_create_response_from_callback(
+                MHD_SIZE_UNKNOWN, block_size, &event_stream_t::read,
+                subscriber, &event_stream_t::free);
+        if (r == nullptr) {
+            delete subscriber;
+            OSERROR(MHD_create_response_from_callback,
+                    "`MHD_create_response_from_callback()' has surprisingly failed");
+        }
+        hub->subscribers.insert(subscriber);
+
+        std::unique_ptr<MHD_Response, void(*)(MHD_Response*)> guard(
+                r, &MHD_destroy_response);
+        OSCHECK(MHD_add_response_header,(r, "Content-type",
+                                         "text/event-stream"), != MHD_NO);
+        OSCHECK(MHD_add_response_header,(r, "Cache-Control", "no-cache"),
+                != MHD_NO);
+        OSCHECK(MHD_queue_response,(connection, MHD_HTTP_OK, r), == MHD_YES);
+    };
+}
+
+/**
+ * Encodes @p data as event and wakes up all waiting subscribers. @p data must
+ * not contain line breaks, which is true for any JSON written by
+ * {@link json_writer_t}.
+ */
+void event_stream_t::publish(const std::string &data)
+{
+    const std::uint64_t sequence = m_hub->sequence + 1;
+    m_hub->latest = std::make_shared<const std::string>(
+            encode_event(sequence, data));
+    m_hub->sequence = sequence;
+    for (subscriber_t *subscriber : m_hub->subscribers) {
+        if (subscriber->suspended) {
+            subscriber->suspended = false;
+            m_hub->server->resume(subscriber->connection);
+        }
+    }
+}
+
+//! Amount of connected clients.
+std::size_t event_stream_t::subscribers() const noexcept
+{
+    return m_hub->subscribers.size();
+}
+
+ssize_t event_stream_t::read(void *cls, std::uint64_t pos, char *buf,
+                             std::size_t max) noexcept
+{
+    subscriber_t *subscriber = static_cast<subscriber_t*>(cls);
+    hub_t *hub = subscriber->hub.get();
+    if (hub->closed) {
+        return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+
+    if (!subscriber->frame
+            || subscriber->offset == subscriber->frame->size()) {
+        if (subscriber->sequence == hub->sequence) {
+            // Nothing new. Events published in the meantime are skipped, only
+            // the latest one is sent when being woken up.
+            subscriber->suspended = true;
+            hub->server->suspend(subscriber->connection,
+                                 suspension_e::PARKED);
+            return 0;
+        }
+        subscriber->frame = hub->latest;
+        subscriber->sequence = hub->sequence;
+        subscriber->offset = 0;
+    }
+
+    std::size_t n = std::min(max,
+                             subscriber->frame->size() - subscriber->offset);
+    std::memcpy(buf, subscriber->frame->data() + subscriber->offset, n);
+    subscriber->offset += n;
+    return static_cast<ssize_t>(n);
+}
+
+void event_stream_t::free(void *cls) noexcept
+{
+    subscriber_t *subscriber = static_cast<subscriber_t*>(cls);
+    subscriber->hub->subscribers.erase(subscriber);
+    delete subscriber;
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <unistd.h>
+
+#include <microhttpd.h>
+
+#include <configuration.hpp>
+#include <errorhandling.hpp>
+#include <fileresponse.hpp>
+#include <logging.hpp>
+#include <readahead.hpp>
+
+LOG_MODULE("HttpServer")
+
+
+//! Size of the chunks requested by libmicrohttpd.
+static constexpr std::size_t block_size = 64 << 10;
+
+static std::unique_ptr<readahead_budget_t> budget;
+
+struct file_stream_t {
+    file_stream_t(int fd, std::uint64_t offset, std::uint64_t size,
+                  std::unique_ptr<bandwidth_flow_t> flow)
+        : fd(fd), offset(offset), size(size), readahead(fd, *budget)
+        , flow(std::move(flow)) {}
+    ~file_stream_t() {
+        close(fd);
+    }
+
+    int fd;
+    std::uint64_t offset;
+    std::uint64_t size;
+    readahead_stream_t readahead;
+    std::unique_ptr<bandwidth_flow_t> flow;
+};
+
+
+static void init_budget()
+{
+    budget.reset(new readahead_budget_t(
+            static_cast<std::uint64_t>(config.httpd.readahead_budget) << 20));
+}
+
+static ssize_t read_file_stream(void *cls, std::uint64_t pos, char *buf,
+                                std::size_t max) noexcept
+{
+    file_stream_t *stream = static_cast<file_stream_t*>(cls);
+    if (pos >= stream->size) {
+        return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+
+    std::size_t size = std::min<std::uint64_t>(max, stream->size - pos);
+    if (stream->flow) {
+        // Nothing is sent while the flow is paused, its connection is
+        // suspended until the buckets have been refilled.
+        try {
+            size = stream->flow->grant(size);
+        } catch (const std::exception &e) {
+            LOG_FAILURE(e) << e.what();
+            return MHD_CONTENT_READER_END_WITH_ERROR;
+        }
+        if (size == 0) {
+            return 0;
+        }
+    }
+    stream->readahead.on_read(stream->offset + pos, size);
+
+    ssize_t ret;
+    do {
+        ret = pread(stream->fd, buf, size, stream->offset + pos);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0) {
+        LOG_WARN() << "Cannot read file for response: "
+                   << (ret < 0 ? strerror(errno) : "unexpected end of file");
+        return MHD_CONTENT_READER_END_WITH_ERROR;
+    }
+    return ret;
+}
+
+static void free_file_stream(void *cls) noexcept
+{
+    delete static_cast<file_stream_t*>(cls);
+}
+
+
+MHD_Response *create_file_response(int fd, std::uint64_t offset,
+                                   std::uint64_t size,
+                                   std::unique_ptr<bandwidth_flow_t> flow)
+{
+    // Initialize readahead budget if not done already.
+    static std::once_flag flag;
+    std::call_once(flag, &init_budget);
+
+    std::unique_ptr<file_stream_t> stream;
+    try {
+        stream.reset(new file_stream_t(fd, offset, size, std::move(flow)));
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    MHD_Response *r = OSCHECK(MHD_create_response_from_callback,(
+                                      size, block_size, &read_file_stream,
+                                      stream.get(), &free_file_stream),
+                              != nullptr);
+    // The response owns the stream from now on.
+    stream.release();
+    return r;
+}
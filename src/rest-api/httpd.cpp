@@ -1,12 +1,27 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 #include <microhttpd.h>
 
 #include <configuration.hpp>
 #include <errorhandling.hpp>
+#include <bufferchain.hpp>
 #include <eventloop.hpp>
 #include <httpd.hpp>
 #include <logging.hpp>
+#include <requesttrace.hpp>
+#include <responsecache.hpp>
+#include <responseformat.hpp>
 
 LOG_MODULE("HttpServer")
 
@@ -15,50 +30,175 @@ struct connection_data_t {
     httpserver_t::access_handler_t access_handler;
 };
 
-static MHD_Response *response_404 = nullptr;
-static MHD_Response *response_500 = nullptr;
+//! Static error responses, indexed by response_format_e.
+static MHD_Response *response_404[2] = {};
+static MHD_Response *response_500[2] = {};
+static MHD_Response *response_503[2] = {};
+
+
+/**
+ * State of a request handled by offload().
+ */
+struct offload_t {
+    ~offload_t() {
+        if (response != nullptr)
+            MHD_destroy_response(response);
+    }
+
+    bool submitted = false;
+    bool done = false;
+    unsigned int status = 0;
+    MHD_Response *response = nullptr;
+    std::exception_ptr error;
+};
 
 
-static MHD_Response *create_static_response(const char *json)
+static MHD_Response *create_static_response(const char *message,
+                                            response_format_e format)
 {
-    MHD_Response *r = MHD_create_response_from_buffer(strlen(json),
-                                                      const_cast<char*>(json),
-                                                      MHD_RESPMEM_PERSISTENT);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &out) {
+        out.begin_object().key("msg").value(message).end_object();
+    });
+    const std::string body = chain.str();
+    MHD_Response *r = MHD_create_response_from_buffer(
+            body.size(), const_cast<char*>(body.data()),
+            MHD_RESPMEM_MUST_COPY);
 
-    OSCHECK(MHD_add_response_header,(r, "Content-type", "application/json"),
-            != MHD_NO);
+    OSCHECK(MHD_add_response_header,(r, "Content-type",
+                                     to_media_type(format)), != MHD_NO);
     return r;
 }
 
 static void init_static_responses()
 {
-    response_404 = create_static_response("{\"msg\":\"not found\"}");
-    response_500 = create_static_response("{\"msg\":\"internal server error\"}");
+    for (response_format_e format : {response_format_e::JSON,
+                                     response_format_e::CBOR}) {
+        const int i = static_cast<int>(format);
+        response_404[i] = create_static_response("not found", format);
+        response_500[i] = create_static_response("internal server error",
+                                                 format);
+        response_503[i] = create_static_response("service unavailable",
+                                                 format);
+        OSCHECK(MHD_add_response_header,(response_503[i], "Retry-After", "1"),
+                != MHD_NO);
+    }
 }
 
+/**
+ * Queues the static response out of @p responses in the format requested on
+ * @p connection.
+ */
+static int queue_static_response(MHD_Connection *connection,
+                                 unsigned int status,
+                                 MHD_Response *const (&responses)[2])
+{
+    return MHD_queue_response(
+            connection, status,
+            responses[static_cast<int>(request_format(connection))]);
+}
 
-httpserver_t::httpserver_t(eventloop_t *eventloop)
+/**
+ * Creates a listening Unix socket at @p path. A socket left by a previous
+ * process is replaced.
+ *
+ * @throws os_file_error if the socket cannot be created.
+ */
+static int listen_unix(const std::string &path, mode_t mode)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        THROW(os_file_error("Path of Unix socket is too long"))
+                << errinfo::errnum(ENAMETOOLONG) << errinfo::filename(path);
+    }
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        THROW(os_file_error("Cannot create Unix socket"))
+                << errinfo::function("socket") << errinfo::errnum(errno)
+                << errinfo::filename(path);
+    }
+    // Do not remove anything but a stale socket.
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path.c_str());
+    }
+    const char *function = nullptr;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        function = "bind";
+    } else if (chmod(path.c_str(), mode) < 0) {
+        function = "chmod";
+    } else if (listen(fd, SOMAXCONN) < 0) {
+        function = "listen";
+    }
+    if (function != nullptr) {
+        const int errnum = errno;
+        close(fd);
+        THROW(os_file_error("Cannot listen on Unix socket"))
+                << errinfo::function(function) << errinfo::errnum(errnum)
+                << errinfo::filename(path);
+    }
+    return fd;
+}
+
+
+/**
+ * Starts the HTTP server. If `httpd.unix-socket` is set, the server also
+ * listens there with the same routes.
+ *
+ * @param listen_fd Listening socket to use instead of binding `httpd.port`,
+ *                  e.g. received from the previous process of the
+ *                  application. The server takes ownership. -1 to bind.
+ */
+httpserver_t::httpserver_t(eventloop_t *eventloop, int listen_fd)
 	: m_eventloop(eventloop)
+    , m_workers(config.httpd.worker_threads, config.httpd.worker_queue)
+    , m_self(std::make_shared<httpserver_t*>(this))
 {
     // Initialize static responses if not done already.
     static std::once_flag flag;
     std::call_once(flag, &init_static_responses);
 
 	// Start httpd
-    unsigned int flags = MHD_USE_DUAL_STACK | MHD_USE_EPOLL_LINUX_ONLY
-            | MHD_USE_SUSPEND_RESUME | MHD_USE_TCP_FASTOPEN;
+    unsigned int flags = MHD_USE_EPOLL_LINUX_ONLY | MHD_USE_SUSPEND_RESUME;
 #   ifndef NDEBUG
     flags |= MHD_USE_DEBUG;
 #   endif
-    m_deamon = OSCHECK(MHD_start_daemon,(flags,
-                                         config.httpd.port, nullptr, nullptr,
-                                         &handle_access, this,
-                                         MHD_OPTION_NOTIFY_COMPLETED,
-                                         &access_completed, this,
-                                         MHD_OPTION_NONCE_NC_SIZE, 0u,
-                                         MHD_OPTION_LISTENING_ADDRESS_REUSE, 1u,
-                                         MHD_OPTION_END),
-                       != nullptr);
+    m_deamon = start_daemon(flags | MHD_USE_DUAL_STACK | MHD_USE_TCP_FASTOPEN,
+                            config.httpd.port, listen_fd);
+
+    if (!config.httpd.unix_socket.empty()) {
+        const mode_t mode = static_cast<mode_t>(std::strtoul(
+                config.httpd.unix_socket_mode.c_str(), nullptr, 8));
+        int unix_fd = -1;
+        try {
+            unix_fd = listen_unix(config.httpd.unix_socket, mode);
+            m_unix_deamon = start_daemon(flags, 0, unix_fd);
+        } catch (...) {
+            if (unix_fd >= 0) {
+                close(unix_fd);
+                unlink(config.httpd.unix_socket.c_str());
+            }
+            MHD_stop_daemon(m_deamon);
+            throw;
+        }
+        m_unix_path = config.httpd.unix_socket;
+    }
+
+    // Overload is diagnosed best while it lasts.
+    add_route(MHD_HTTP_METHOD_GET, "admission", [this](MHD_Connection *) {
+        access_handler_t handler;
+        if (m_admission != nullptr) {
+            handler = [this](MHD_Connection *connection, const char *,
+                             std::size_t *) {
+                write_admission_stats(connection);
+            };
+        }
+        return handler;
+    }, route_priority_e::HIGH);
 
     // Register at event loop
     m_select_handle = m_eventloop->register_handler(
@@ -73,19 +213,299 @@ httpserver_t::~httpserver_t() noexcept
     for (MHD_Connection *connection : suspended_connections) {
         MHD_resume_connection(connection);
     }
+    for (MHD_Connection *connection : throttled_connections) {
+        MHD_resume_connection(connection);
+    }
+    for (MHD_Connection *connection : parked_connections) {
+        MHD_resume_connection(connection);
+    }
 
-    // Stop HTTP daemon.
+    // Stop HTTP daemons.
     MHD_stop_daemon(m_deamon);
+    if (m_unix_deamon != nullptr) {
+        MHD_stop_daemon(m_unix_deamon);
+    }
+    if (!m_unix_path.empty()) {
+        unlink(m_unix_path.c_str());
+    }
 
     // Unregister from eventloop.
     m_eventloop->unregister_handler(m_select_handle);
 }
 
-httpserver_t::access_handler_t httpserver_t::route_request(
-        MHD_Connection *connection, const char *url, const char *method,
-        const char *version)
+/**
+ * Starts a daemon which serves the routes of this server.
+ *
+ * @param listen_fd Listening socket to use instead of binding @p port. -1 to
+ *                  bind.
+ */
+MHD_Daemon *httpserver_t::start_daemon(unsigned int flags, std::uint16_t port,
+                                       int listen_fd)
+{
+    return OSCHECK(MHD_start_daemon,(flags, port, nullptr, nullptr,
+                                     &handle_access, this,
+                                     MHD_OPTION_NOTIFY_COMPLETED,
+                                     &access_completed, this,
+                                     MHD_OPTION_NONCE_NC_SIZE, 0u,
+                                     MHD_OPTION_LISTENING_ADDRESS_REUSE, 1u,
+                                     // Ends the list without socket.
+                                     listen_fd >= 0
+                                         ? MHD_OPTION_LISTEN_SOCKET
+                                         : MHD_OPTION_END,
+                                     listen_fd,
+                                     MHD_OPTION_END),
+                   != nullptr);
+}
+
+/**
+ * Registers a route. Requests using @p method for @p path (relative to
+ * `httpd.prefix`) are handled by the handler returned by @p route. Query
+ * arguments are not part of the path.
+ *
+ * @param priority Whether new requests of the route may be rejected while the
+ *                 server is overloaded (see {@link admission_control_t}).
+ */
+void httpserver_t::add_route(const std::string &method, const std::string &path,
+                             const route_t &route, route_priority_e priority)
+{
+    m_routes[std::make_pair(method, path)] = route_entry_t{route, priority};
+}
+
+/**
+ * Sets the cache which is consulted before routing GET requests. Pass
+ * `nullptr` to disable it.
+ */
+void httpserver_t::set_response_cache(response_cache_t *cache) noexcept
+{
+    m_cache = cache;
+}
+
+/**
+ * Sets the admission control which is consulted before routing new requests.
+ * Pass `nullptr` to serve all requests.
+ */
+void httpserver_t::set_admission_control(
+        admission_control_t *admission) noexcept
+{
+    m_admission = admission;
+}
+
+/**
+ * Answers `GET /admission` with the state of the admission control, e.g.
+ *
+ * ```{.json}
+ * {
+ *   "overloaded": false, "lag_ms": 1.5, "max_lag_ms": 500,
+ *   "suspended": 3, "max_suspended": 1000, "parked": 250, "throttled": 4,
+ *   "rejected": 42, "overloads": 2
+ * }
+ * ```
+ *
+ * `suspended` counts connections waiting for work, `parked` and `throttled`
+ * those waiting for events or bandwidth, which are not limited. `rejected`
+ * counts requests answered with 503, `overloads` the periods of overload.
+ * Without admission control, the route answers 404.
+ */
+void httpserver_t::write_admission_stats(MHD_Connection *connection)
+{
+    const admission_control_t::limits_t &limits = m_admission->limits();
+    const admission_control_t::stats_t &stats = m_admission->stats();
+    const response_format_e format = request_format(connection);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &out) {
+        out.begin_object()
+            .key("overloaded").value(m_admission->overloaded())
+            .key("lag_ms").value(std::chrono::duration<double, std::milli>(
+                    m_admission->lag()).count())
+            .key("max_lag_ms").value(
+                    static_cast<long long>(limits.max_lag.count()))
+            .key("suspended").value(suspended_connections.size())
+            .key("max_suspended").value(limits.max_suspended)
+            .key("parked").value(parked_connections.size())
+            .key("throttled").value(throttled_connections.size())
+            .key("rejected").value(
+                    static_cast<unsigned long long>(stats.rejected))
+            .key("overloads").value(
+                    static_cast<unsigned long long>(stats.overloads))
+            .end_object();
+    });
+    queue_buffer_response(connection, MHD_HTTP_OK, std::move(chain),
+                          to_media_type(format));
+}
+
+/**
+ * Sets the trace which records every request before it is routed. Pass
+ * `nullptr` to stop recording.
+ */
+void httpserver_t::set_request_trace(trace_writer_t *trace) noexcept
+{
+    m_trace = trace;
+}
+
+/**
+ * Returns the listening TCP socket, which still belongs to the server. -1 if
+ * the server has been stopped already.
+ */
+int httpserver_t::listen_socket() const noexcept
+{
+    const union MHD_DaemonInfo *info = MHD_get_daemon_info(
+            m_deamon, MHD_DAEMON_INFO_LISTEN_FD);
+    return info != nullptr ? info->listen_fd : -1;
+}
+
+/**
+ * Stops accepting connections. Requests of established connections are still
+ * served.
+ *
+ * The Unix socket of `httpd.unix-socket` is closed but not removed, so a new
+ * process of the application may already bind it.
+ *
+ * @return The listening TCP socket, which is not closed by the server
+ *         anymore. -1 if the server has been stopped already.
+ */
+int httpserver_t::quiesce() noexcept
+{
+    if (m_unix_deamon != nullptr) {
+        const int unix_fd = MHD_quiesce_daemon(m_unix_deamon);
+        if (unix_fd >= 0) {
+            close(unix_fd);
+        }
+        m_unix_path.clear();
+    }
+    return MHD_quiesce_daemon(m_deamon);
+}
+
+/**
+ * Gets the credentials of the process which has connected via
+ * `httpd.unix-socket`. Handlers may use them to authorize local clients.
+ *
+ * @return `false` if @p connection does not use the Unix socket.
+ */
+bool httpserver_t::peer_credentials(MHD_Connection *connection,
+                                    ucred &credentials) noexcept
+{
+    const union MHD_ConnectionInfo *address = MHD_get_connection_info(
+            connection, MHD_CONNECTION_INFO_CLIENT_ADDRESS);
+    if (address == nullptr || address->client_addr == nullptr
+            || address->client_addr->sa_family != AF_UNIX) {
+        return false;
+    }
+    const union MHD_ConnectionInfo *info = MHD_get_connection_info(
+            connection, MHD_CONNECTION_INFO_CONNECTION_FD);
+    if (info == nullptr) {
+        return false;
+    }
+    socklen_t size = sizeof(credentials);
+    return getsockopt(info->connect_fd, SOL_SOCKET, SO_PEERCRED, &credentials,
+                      &size) == 0;
+}
+
+/**
+ * Returns a handler which runs @p work on the worker pool.
+ *
+ * Uploaded data is discarded. When the request is complete, the connection is
+ * suspended and @p work is queued. Its result is passed back through
+ * eventloop_t::call(), which resumes the connection. If the queue of the pool
+ * is full (`httpd.worker-queue`), the request is answered with 503 at once.
+ * Exceptions thrown by @p work result in 500.
+ */
+httpserver_t::access_handler_t httpserver_t::offload(
+        const blocking_work_t &work)
 {
-    return {};
+    auto state = std::make_shared<offload_t>();
+    return [this, state, work](MHD_Connection *connection, const char *,
+                               size_t *upload_data_size) {
+        if (*upload_data_size != 0) {
+            *upload_data_size = 0;
+            return;
+        }
+        if (!state->submitted) {
+            state->submitted = true;
+            std::weak_ptr<httpserver_t*> self = m_self;
+            eventloop_t *eventloop = m_eventloop;
+            bool queued = m_workers.try_submit(
+                    [state, work, self, eventloop, connection] {
+                try {
+                    std::tie(state->status, state->response) = work();
+                } catch (...) {
+                    state->error = std::current_exception();
+                }
+                eventloop->call([state, self, connection] {
+                    state->done = true;
+                    if (auto server = self.lock())
+                        (*server)->resume(connection);
+                });
+            });
+            if (!queued) {
+                LOG_WARN() << "Worker queue is full, request is rejected";
+                OSCHECK(queue_static_response,(connection,
+                                               MHD_HTTP_SERVICE_UNAVAILABLE,
+                                               response_503), == MHD_YES);
+                return;
+            }
+            suspend(connection);
+            return;
+        }
+        if (!state->done) {
+            return;
+        }
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+        OSCHECK(MHD_queue_response,(connection, state->status,
+                                    state->response), == MHD_YES);
+    };
+}
+
+/**
+ * Suspends @p connection until resume() is called. Handlers use it to wait for
+ * events without blocking the event loop. Must be called within the event
+ * loop.
+ *
+ * @param reason What the connection waits for. Only connections waiting for
+ *               work count towards `httpd.max-suspended`.
+ */
+void httpserver_t::suspend(MHD_Connection *connection, suspension_e reason)
+{
+    MHD_suspend_connection(connection);
+    switch (reason) {
+    case suspension_e::WORK:
+        suspended_connections.insert(connection);
+        break;
+    case suspension_e::THROTTLED:
+        throttled_connections.insert(connection);
+        break;
+    case suspension_e::PARKED:
+        parked_connections.insert(connection);
+        break;
+    }
+}
+
+/**
+ * Resumes a connection suspended by suspend(). The access handler is called
+ * again on the next iteration of the event loop. Must be called within the
+ * event loop.
+ */
+void httpserver_t::resume(MHD_Connection *connection)
+{
+    if (suspended_connections.erase(connection) > 0
+            || throttled_connections.erase(connection) > 0
+            || parked_connections.erase(connection) > 0) {
+        MHD_resume_connection(connection);
+        m_resumed = true;
+    }
+}
+
+/**
+ * Returns the route for @p method and @p url (relative to `httpd.prefix`) or
+ * `nullptr` if there is none.
+ */
+const httpserver_t::route_entry_t *httpserver_t::find_route(
+        const char *method, const char *url) const
+{
+    auto it = m_routes.find(std::make_pair(std::string(method),
+                                           std::string(url)));
+    return it != m_routes.end() ? &it->second : nullptr;
 }
 
 void httpserver_t::fdset_getter(fd_set &rs, fd_set &ws, fd_set &es,
@@ -95,18 +515,39 @@ void httpserver_t::fdset_getter(fd_set &rs, fd_set &ws, fd_set &es,
                 m_deamon, MHD_DAEMON_INFO_EPOLL_FD_LINUX_ONLY), != nullptr);
     FD_SET(info->epoll_fd, &rs);
     max = info->epoll_fd + 1;
+    if (m_unix_deamon != nullptr) {
+        info = OSCHECK(MHD_get_daemon_info,(
+                m_unix_deamon, MHD_DAEMON_INFO_EPOLL_FD_LINUX_ONLY),
+                != nullptr);
+        FD_SET(info->epoll_fd, &rs);
+        max = std::max(max, info->epoll_fd + 1);
+    }
 
     MHD_UNSIGNED_LONG_LONG mhd_timeout;
+    if (m_resumed) {
+        // Let MHD process resumed connections immediately.
+        timeout = std::chrono::nanoseconds::zero();
+        return;
+    }
     if (MHD_get_timeout(m_deamon, &mhd_timeout) == MHD_YES) {
         timeout = std::chrono::milliseconds(mhd_timeout);
     }
+    if (m_unix_deamon != nullptr
+            && MHD_get_timeout(m_unix_deamon, &mhd_timeout) == MHD_YES) {
+        timeout = std::min<std::chrono::nanoseconds>(
+                timeout, std::chrono::milliseconds(mhd_timeout));
+    }
 }
 
 void httpserver_t::io_handler(const fd_set &rs, const fd_set &ws,
                               const fd_set &es)
 {
     //int ret = MHD_run_from_select(deamon, &rs, &ws, &es);
+    m_resumed = false;
     OSCHECK(MHD_run,(m_deamon), == MHD_YES);
+    if (m_unix_deamon != nullptr) {
+        OSCHECK(MHD_run,(m_unix_deamon), == MHD_YES);
+    }
 }
 
 int httpserver_t::handle_access(
@@ -120,28 +561,59 @@ int httpserver_t::handle_access(
     // TODO handle logging properly (start new procedure for every request)
 
     if (data == nullptr) {
+        // Record the full URL, so the trace can be replayed as is.
+        if (server->m_trace != nullptr) {
+            try {
+                server->m_trace->record(connection, url, method);
+            } catch (const std::exception &e) {
+                LOG_WARN() << "Stop recording requests: " << e.what();
+                server->m_trace = nullptr;
+            }
+        }
         // Cut prefix. Return 404 if it is not used by the request.
         if (strncmp(url, config.httpd.prefix.data(), config.httpd.prefix.size())) {
-            return MHD_queue_response(connection, 404, response_404);
+            return queue_static_response(connection, 404, response_404);
         }
         url = url + config.httpd.prefix.size();
         // Route request and get handler.
         access_handler_t handler;
         try {
-            handler = server->route_request(connection, url, method, version);
+            // Serve cached responses without routing.
+            if (server->m_cache != nullptr
+                    && !strcmp(method, MHD_HTTP_METHOD_GET)
+                    && server->m_cache->lookup(connection,
+                            response_cache_t::request_key(connection, url))) {
+                return MHD_YES;
+            }
+            const route_entry_t *entry = server->find_route(method, url);
+            if (entry == nullptr) {
+                return queue_static_response(connection, 404, response_404);
+            }
+            // Reject at once while overloaded, before doing any work.
+            if (server->m_admission != nullptr
+                    && !server->m_admission->admit(
+                            entry->priority,
+                            server->suspended_connections.size())) {
+                return queue_static_response(connection,
+                                             MHD_HTTP_SERVICE_UNAVAILABLE,
+                                             response_503);
+            }
+            handler = entry->route(connection);
         } catch (const std::exception &e) {
             LOG_FAILURE(e) << e.what();
-            return MHD_queue_response(connection, 500, response_500);
+            return queue_static_response(connection, 500, response_500);
+        } catch (...) {
+            LOG_WARN() << "Routing failed with an unknown exception";
+            return queue_static_response(connection, 500, response_500);
         }
         // Respond with 404 if no handler has been set.
         if (!handler) {
-            return MHD_queue_response(connection, 404, response_404);
+            return queue_static_response(connection, 404, response_404);
         }
         // Save handler
-        data = new connection_data_t{
-                server->route_request(connection, url, method, version)
-        };
+        data = new connection_data_t{std::move(handler)};
         *con_cls = data;
+        ++server->m_active_requests;
     }
 
     // Delegate to request handler.
@@ -149,7 +621,10 @@ int httpserver_t::handle_access(
         data->access_handler(connection, upload_data, upload_data_size);
     } catch (const std::exception &e) {
        LOG_FAILURE(e) << e.what();
-       return MHD_queue_response(connection, 500, response_500);
+       return queue_static_response(connection, 500, response_500);
+    } catch (...) {
+       LOG_WARN() << "Request handler failed with an unknown exception";
+       return queue_static_response(connection, 500, response_500);
     }
 
     return MHD_YES;
@@ -163,5 +638,6 @@ void httpserver_t::access_completed(
     connection_data_t *data = static_cast<connection_data_t*>(*con_cls);
     if (data != nullptr) {
         delete data;
+        --server->m_active_requests;
     }
 }
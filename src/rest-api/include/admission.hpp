@@ -0,0 +1,94 @@
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+/**
+ * @file admission.hpp
+ * File contains class {@link admission_control_t} which detects when the
+ * server is overloaded.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <eventloop.hpp>
+
+
+/**
+ * Priority of a route of the {@link httpserver_t}.
+ */
+enum class route_priority_e {
+    NORMAL, //!< Rejected with 503 while the server is overloaded.
+    HIGH    //!< Always served, e.g. downloads which are already running.
+};
+
+/**
+ * Decides whether new requests of routes with normal priority are admitted.
+ *
+ * The lag of the event loop is measured by a timer which should fire every
+ * {@link probe_interval}. The delay of each tick is one sample. The lag
+ * follows rising samples at once and decays slowly, so a single quiet tick
+ * does not end the overload.
+ *
+ * The server is overloaded while the lag exceeds `httpd.max-loop-lag` or more
+ * connections than `httpd.max-suspended` wait for work in progress. Parked
+ * long-polls and stream subscribers are not counted. Then the
+ * {@link httpserver_t} answers new requests of routes with normal priority by
+ * `503 Service Unavailable` at once, instead of adding them to the backlog.
+ * Cached responses are still served, as they are cheaper than the rejection.
+ *
+ * The lag and the counters are shown at `GET /admission`, which is served
+ * during overload, too.
+ */
+class admission_control_t : private boost::noncopyable
+{
+public:
+    /**
+     * Thresholds of the overload. Zero disables the threshold.
+     */
+    struct limits_t {
+        std::chrono::milliseconds max_lag{0};
+        std::size_t max_suspended = 0;
+    };
+
+    /**
+     * Counters of the admission control.
+     */
+    struct stats_t {
+        std::uint64_t rejected = 0;  //!< Requests answered with 503.
+        std::uint64_t overloads = 0; //!< Amount of overload periods.
+    };
+
+    static constexpr std::chrono::milliseconds probe_interval{50};
+
+    admission_control_t(eventloop_t *eventloop, const limits_t &limits);
+
+    void set_limits(const limits_t &limits) noexcept { m_limits = limits; }
+    const limits_t &limits() const noexcept { return m_limits; }
+
+    bool admit(route_priority_e priority, std::size_t suspended);
+
+    //! Current lag of the event loop.
+    std::chrono::nanoseconds lag() const noexcept { return m_lag; }
+    bool overloaded() const noexcept { return m_overloaded; }
+    const stats_t &stats() const noexcept { return m_stats; }
+
+private:
+    void schedule_probe();
+    void probe();
+
+    eventloop_t *m_eventloop;
+    limits_t m_limits;
+    std::chrono::nanoseconds m_lag{0};
+    //! Time the next probe is due.
+    std::chrono::steady_clock::time_point m_due;
+    bool m_overloaded = false;
+    stats_t m_stats;
+    //! Used to ignore scheduled calls after destruction.
+    std::shared_ptr<admission_control_t*> m_self;
+};
+
+#endif // ADMISSION_HPP
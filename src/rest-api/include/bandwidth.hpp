@@ -0,0 +1,161 @@
+#ifndef BANDWIDTH_HPP
+#define BANDWIDTH_HPP
+
+/**
+ * @file bandwidth.hpp
+ * File contains class {@link bandwidth_scheduler_t} which limits the rate of
+ * HTTP downloads.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <eventloop.hpp>
+
+
+/**
+ * Token bucket limiting a rate of bytes.
+ *
+ * The bucket is filled with @p rate tokens per second up to its burst size of
+ * a quarter second of the rate, but at least {@link min_burst}. A rate of
+ * zero means unlimited.
+ */
+class token_bucket_t
+{
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    static constexpr std::uint64_t min_burst = 64 << 10;
+
+    explicit token_bucket_t(
+            std::uint64_t rate = 0,
+            time_point now = std::chrono::steady_clock::now());
+
+    void set_rate(std::uint64_t rate, time_point now) noexcept;
+    std::uint64_t rate() const noexcept { return m_rate; }
+
+    std::uint64_t available(time_point now) noexcept;
+    void consume(std::uint64_t bytes) noexcept;
+    std::chrono::nanoseconds time_until(std::uint64_t bytes) const noexcept;
+
+private:
+    std::uint64_t m_rate;
+    double m_burst;
+    //! Tokens at #m_time. Negative if more has been consumed than available.
+    double m_tokens;
+    time_point m_time;
+};
+
+class bandwidth_scheduler_t;
+
+/**
+ * A download paced by a {@link bandwidth_scheduler_t}.
+ *
+ * The flow holds the bucket of the download and shares the buckets of its
+ * client and of the scheduler. It is closed when destroyed.
+ */
+class bandwidth_flow_t : private boost::noncopyable
+{
+    friend class bandwidth_scheduler_t;
+public:
+    /**
+     * Pauses (`true`) or continues (`false`) sending the download.
+     */
+    using pause_t = std::function<void(bool pause)>;
+
+    ~bandwidth_flow_t() noexcept;
+
+    std::size_t grant(std::size_t max);
+
+private:
+    struct client_t;
+
+    bandwidth_flow_t(bandwidth_scheduler_t *scheduler, std::uint64_t id,
+                     const std::shared_ptr<client_t> &client,
+                     const pause_t &pause);
+    void wake();
+
+    bandwidth_scheduler_t *m_scheduler;
+    const std::uint64_t m_id;
+    std::shared_ptr<client_t> m_client;
+    pause_t m_pause;
+    token_bucket_t m_bucket;
+    bool m_paused = false;
+};
+
+/**
+ * Hierarchical token buckets limiting HTTP downloads: in total, per client
+ * address and per download.
+ *
+ * A download asks for permission by bandwidth_flow_t::grant() before sending a
+ * chunk. It gets at most what all three buckets allow. If that is less than
+ * {@link min_grant}, the download is paused and continued by a timer of the
+ * event loop when its buckets have been refilled. So a client with a fast
+ * link gets its share but cannot starve the others, and the total stays below
+ * the global limit.
+ *
+ * Data sent by other means, e.g. uploads of the torrent session, can be
+ * charged to the global bucket by charge() to share one budget. Flows must be
+ * destroyed before the scheduler. All functions have to be called within the
+ * event loop.
+ */
+class bandwidth_scheduler_t : private boost::noncopyable
+{
+    friend class bandwidth_flow_t;
+public:
+    /**
+     * Limits in bytes per second. Zero means unlimited.
+     */
+    struct limits_t {
+        std::uint64_t global = 0;
+        std::uint64_t client = 0;
+        std::uint64_t download = 0;
+    };
+
+    /**
+     * Counters of the scheduler.
+     */
+    struct stats_t {
+        std::uint64_t sent = 0;   //!< Bytes granted to downloads.
+        std::uint64_t paused = 0; //!< Amount of times a download was paused.
+        std::size_t clients = 0;  //!< Clients with active downloads.
+        std::size_t downloads = 0; //!< Active downloads.
+    };
+
+    //! Smallest chunk granted to a download, unless it asks for less.
+    static constexpr std::size_t min_grant = 16 << 10;
+
+    bandwidth_scheduler_t(eventloop_t *eventloop, const limits_t &limits);
+
+    void set_limits(const limits_t &limits);
+    const limits_t &limits() const noexcept { return m_limits; }
+    stats_t stats() const noexcept;
+
+    std::unique_ptr<bandwidth_flow_t> open(
+            const std::string &client, const bandwidth_flow_t::pause_t &pause);
+    void charge(std::uint64_t bytes) noexcept;
+
+private:
+    void schedule_wake(std::uint64_t id, std::chrono::nanoseconds delay);
+
+    eventloop_t *m_eventloop;
+    limits_t m_limits;
+    token_bucket_t m_bucket;
+    std::map<std::string, std::weak_ptr<bandwidth_flow_t::client_t>>
+    m_clients;
+    //! Flows by id, used by timers to find flows which still exist.
+    std::map<std::uint64_t, bandwidth_flow_t*> m_flows;
+    std::uint64_t m_next_id = 0;
+    stats_t m_stats;
+    //! Used to ignore scheduled calls after destruction.
+    std::shared_ptr<bandwidth_scheduler_t*> m_self;
+};
+
+#endif // BANDWIDTH_HPP
@@ -0,0 +1,74 @@
+#ifndef BANDWIDTHAPI_HPP
+#define BANDWIDTHAPI_HPP
+
+/**
+ * @file bandwidthapi.hpp
+ * File contains class {@link bandwidth_api_t} which shows and changes the
+ * bandwidth limits of HTTP downloads.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <bandwidth.hpp>
+#include <httpd.hpp>
+
+
+/**
+ * Parses the body of `PUT /bandwidth`. Limits missing in the body are taken
+ * from @p current.
+ *
+ * @throws std::runtime_error if the body is no valid JSON or a limit is no
+ *         non-negative number.
+ */
+bandwidth_scheduler_t::limits_t parse_bandwidth_limits(
+        const std::string &body,
+        const bandwidth_scheduler_t::limits_t &current);
+
+
+/**
+ * Provides `GET /bandwidth` and `PUT /bandwidth`.
+ *
+ * `GET` returns the limits in bytes per second, zero meaning unlimited, and
+ * the counters of the scheduler:
+ *
+ * ```{.json}
+ * {
+ *   "global": 10485760, "client": 2097152, "download": 0,
+ *   "sent": 123456789, "paused": 42, "clients": 3, "downloads": 5
+ * }
+ * ```
+ *
+ * `PUT` takes an object with any of `global`, `client` and `download` and
+ * applies the new limits to all running downloads at once. It answers like
+ * `GET`. The limits are reset to the configuration when a changed
+ * `httpd.*rate-limit` setting is reloaded.
+ *
+ * open() starts pacing a download of a connection, see
+ * create_file_response().
+ */
+class bandwidth_api_t : private boost::noncopyable
+{
+public:
+    //! Maximal size of the body of a request.
+    static constexpr std::size_t max_body_size = 4 << 10;
+
+    bandwidth_api_t(httpserver_t *server, bandwidth_scheduler_t *scheduler);
+
+    std::unique_ptr<bandwidth_flow_t> open(MHD_Connection *connection);
+
+private:
+    httpserver_t::access_handler_t route_get(MHD_Connection *connection);
+    httpserver_t::access_handler_t route_put(MHD_Connection *connection);
+    void respond(MHD_Connection *connection);
+
+    httpserver_t *m_server;
+    bandwidth_scheduler_t *m_scheduler;
+};
+
+#endif // BANDWIDTHAPI_HPP
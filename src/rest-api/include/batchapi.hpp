@@ -0,0 +1,84 @@
+#ifndef BATCHAPI_HPP
+#define BATCHAPI_HPP
+
+/**
+ * @file batchapi.hpp
+ * File contains class {@link batch_api_t} which applies many operations on
+ * torrents by a single request.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <microhttpd.h>
+
+#include <httpd.hpp>
+#include <torrentbatch.hpp>
+
+
+/**
+ * Parses the body of `POST /batch`.
+ *
+ * @return One entry per operation, which is empty if the operation is
+ *         invalid.
+ * @throws std::runtime_error if the body is no valid JSON or has no
+ *         `operations` array.
+ */
+std::vector<boost::optional<batch_op_t>> parse_batch(const std::string &body);
+
+
+/**
+ * Provides `POST /batch` which applies an array of operations at once:
+ *
+ * ```{.json}
+ * {
+ *   "operations": [
+ *     {"op": "pause", "torrent": "..."},
+ *     {"op": "resume", "torrent": "..."},
+ *     {"op": "remove", "torrent": "...", "data": true},
+ *     {"op": "file-priority", "torrent": "...", "file": 3, "priority": 0}
+ *   ]
+ * }
+ * ```
+ *
+ * All valid operations are passed to the executor at once, within the same
+ * iteration of the event loop. The response contains one result per
+ * operation in the same order. It is serialized into a buffer chain and sent
+ * chunk by chunk:
+ *
+ * ```{.json}
+ * {"results": ["ok", "unknown_torrent", "invalid_operation", ...]}
+ * ```
+ *
+ * Operations on a torrent which the same batch removes are not applied and
+ * result in `superseded`.
+ */
+class batch_api_t : private boost::noncopyable
+{
+public:
+    //! Maximal size of the body of a request.
+    static constexpr std::size_t max_body_size = 1 << 20;
+
+    /**
+     * Applies the operations, usually by apply_batch(). Returns one result per
+     * operation.
+     */
+    using executor_t = std::function<
+        std::vector<batch_result_e>(const std::vector<batch_op_t> &ops)
+    >;
+
+    batch_api_t(httpserver_t *server, const executor_t &executor);
+
+private:
+    httpserver_t::access_handler_t route_batch(MHD_Connection *connection);
+
+    httpserver_t *m_server;
+    const executor_t m_executor;
+};
+
+#endif // BATCHAPI_HPP
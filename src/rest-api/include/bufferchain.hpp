@@ -0,0 +1,90 @@
+#ifndef BUFFERCHAIN_HPP
+#define BUFFERCHAIN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+
+/**
+ * Growable buffer consisting of a chain of fixed-size chunks.
+ *
+ * Chunks are taken from a free list of the current thread and returned to the
+ * free list of the thread destroying the chain. Building responses therefore
+ * does not allocate memory once the free list is warm, and the content is
+ * never moved when the chain grows.
+ */
+class buffer_chain_t : private boost::noncopyable
+{
+    struct chunk_t;
+public:
+    //! Size of every chunk. Larger pieces of data are split.
+    static constexpr std::size_t chunk_size = 16 << 10;
+
+    buffer_chain_t() = default;
+    buffer_chain_t(buffer_chain_t &&other) noexcept;
+    buffer_chain_t &operator =(buffer_chain_t &&other) noexcept;
+    ~buffer_chain_t() noexcept;
+
+    /**
+     * Returns a pointer to at least @p size contiguous bytes at the end of the
+     * buffer. @p size must not exceed #chunk_size. The bytes become part of
+     * the content by commit().
+     */
+    char *reserve(std::size_t size) {
+        if (m_tail == nullptr || chunk_size - m_tail_used < size)
+            add_chunk();
+        return m_tail_data + m_tail_used;
+    }
+    //! Appends @p size bytes which have been written after reserve().
+    void commit(std::size_t size) {
+        m_tail_used += size;
+        m_size += size;
+    }
+    void append(const char *data, std::size_t size);
+    void append(char c) {
+        *reserve(1) = c;
+        commit(1);
+    }
+
+    //! Total amount of bytes in the buffer.
+    std::size_t size() const noexcept { return m_size; }
+
+    std::size_t read(char *buf, std::size_t max) noexcept;
+    std::string str() const;
+
+private:
+    void add_chunk();
+    void seal_tail() noexcept;
+
+    chunk_t *m_head = nullptr;
+    chunk_t *m_tail = nullptr;
+    char *m_tail_data = nullptr;
+    std::size_t m_tail_used = 0;
+    std::size_t m_size = 0;
+
+    // Read position used by read().
+    chunk_t *m_read_chunk = nullptr;
+    std::size_t m_read_offset = 0;
+};
+
+/**
+ * Creates a response which sends the content of @p chain.
+ *
+ * The content is passed to libmicrohttpd chunk by chunk. It is never copied
+ * into a single contiguous buffer.
+ */
+MHD_Response *create_buffer_response(buffer_chain_t &&chain,
+                                     const char *content_type);
+
+/**
+ * Queues a response created by create_buffer_response() for @p connection.
+ */
+void queue_buffer_response(MHD_Connection *connection, unsigned int status,
+                           buffer_chain_t &&chain, const char *content_type);
+
+#endif // BUFFERCHAIN_HPP
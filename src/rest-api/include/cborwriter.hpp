@@ -0,0 +1,83 @@
+#ifndef CBORWRITER_HPP
+#define CBORWRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <bufferchain.hpp>
+
+
+/**
+ * Keys which CBOR responses encode as their index, e.g. `infohash` as 0.
+ * New keys have to be appended.
+ */
+extern const char *const cbor_key_names[];
+//! Amount of entries of {@link cbor_key_names}.
+extern const std::size_t cbor_key_count;
+
+/**
+ * Writes CBOR (RFC 8949) directly into a {@link buffer_chain_t}.
+ *
+ * Provides the same member functions as {@link json_writer_t}, so the same
+ * templates serialize both formats. Objects and arrays are written with
+ * indefinite length, as their size is not known in advance. Integers take one
+ * to nine bytes depending on their value, binary data like infohashes is
+ * written as byte string instead of hexadecimal text.
+ *
+ * Keys listed in {@link cbor_key_names} are written as their index, which
+ * takes a single byte, other keys as text. The list is only ever appended to,
+ * so an index keeps its meaning across releases.
+ *
+ * Doubles which are exact as single precision take five bytes, others nine.
+ * Non-finite doubles are written as `null` like in JSON.
+ */
+class cbor_writer_t
+{
+public:
+    explicit cbor_writer_t(buffer_chain_t &out) : m_out(out) {}
+
+    cbor_writer_t &begin_object();
+    cbor_writer_t &end_object();
+    cbor_writer_t &begin_array();
+    cbor_writer_t &end_array();
+
+    cbor_writer_t &key(const char *str, std::size_t len);
+    cbor_writer_t &key(const char *str) { return key(str, std::strlen(str)); }
+    cbor_writer_t &key(const std::string &str) {
+        return key(str.data(), str.size());
+    }
+
+    cbor_writer_t &value(const char *str, std::size_t len);
+    cbor_writer_t &value(const char *str) {
+        return value(str, std::strlen(str));
+    }
+    cbor_writer_t &value(const std::string &str) {
+        return value(str.data(), str.size());
+    }
+    cbor_writer_t &value(bool b);
+    cbor_writer_t &value(int i) { return write_int(i); }
+    cbor_writer_t &value(long i) { return write_int(i); }
+    cbor_writer_t &value(long long i) { return write_int(i); }
+    cbor_writer_t &value(unsigned i) { return write_uint(i); }
+    cbor_writer_t &value(unsigned long i) { return write_uint(i); }
+    cbor_writer_t &value(unsigned long long i) { return write_uint(i); }
+    cbor_writer_t &value(double d);
+    cbor_writer_t &null();
+
+    /**
+     * Writes binary data like an infohash as byte string.
+     */
+    cbor_writer_t &binary(const void *data, std::size_t len);
+
+private:
+    cbor_writer_t &write_int(std::int64_t i);
+    cbor_writer_t &write_uint(std::uint64_t i);
+
+    void write_head(unsigned major, std::uint64_t argument);
+
+    buffer_chain_t &m_out;
+};
+
+#endif // CBORWRITER_HPP
@@ -0,0 +1,54 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+/**
+ * @file compression.hpp
+ * File contains functions to compress HTTP responses and to negotiate the
+ * content coding.
+ */
+
+#include <cstddef>
+#include <string>
+
+
+/**
+ * Content codings supported for responses.
+ */
+enum class content_coding_e {
+    IDENTITY, //!< Uncompressed.
+    GZIP,     //!< `gzip`
+    BROTLI    //!< `br`, only available if built with XLTS_USE_BROTLI.
+};
+
+//! Amount of values of {@link content_coding_e}.
+static constexpr std::size_t content_coding_count = 3;
+
+/**
+ * Returns the token of @p coding as used in `Content-Encoding`. Returns
+ * `nullptr` for IDENTITY.
+ */
+const char *to_token(content_coding_e coding) noexcept;
+
+/**
+ * Returns whether a coding is acceptable according to the value of the header
+ * `Accept-Encoding`. Codings with `q=0` are not acceptable. `*` matches any
+ * coding. IDENTITY is always acceptable.
+ */
+bool accepts_coding(const char *accept_encoding,
+                    content_coding_e coding) noexcept;
+
+/**
+ * Compresses @p size bytes at @p data with @p coding.
+ *
+ * @return The compressed data. Empty if @p coding is not supported or the
+ *         compression has failed.
+ */
+std::string compress(const char *data, std::size_t size,
+                     content_coding_e coding);
+
+inline std::string compress(const std::string &data, content_coding_e coding)
+{
+    return compress(data.data(), data.size(), coding);
+}
+
+#endif // COMPRESSION_HPP
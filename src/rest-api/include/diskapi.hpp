@@ -0,0 +1,48 @@
+#ifndef DISKAPI_HPP
+#define DISKAPI_HPP
+
+/**
+ * @file diskapi.hpp
+ * File contains class {@link disk_api_t} which shows the queues of the
+ * {@link disk_scheduler_t} over HTTP.
+ */
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <diskscheduler.hpp>
+#include <httpd.hpp>
+
+
+/**
+ * Provides `GET /disk` which returns the statistics of every I/O class of a
+ * {@link disk_scheduler_t}:
+ *
+ * ```{.json}
+ * {
+ *   "interactive": {"queue_depth": 0, "started": 42,
+ *                   "wait_histogram": [3, 0, 12, ...]},
+ *   "normal": {...},
+ *   "background": {...}
+ * }
+ * ```
+ *
+ * `wait_histogram` has {@link disk_scheduler_t::histogram_size} buckets,
+ * bucket `i` counts jobs which have waited less than `2^i` microseconds, see
+ * {@link disk_scheduler_t::stats_t}.
+ *
+ * The scheduler must outlive the API.
+ */
+class disk_api_t : private boost::noncopyable
+{
+public:
+    disk_api_t(httpserver_t *server, disk_scheduler_t *scheduler);
+
+private:
+    void respond(MHD_Connection *connection);
+
+    disk_scheduler_t *m_scheduler;
+};
+
+#endif // DISKAPI_HPP
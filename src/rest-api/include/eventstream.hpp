@@ -0,0 +1,56 @@
+#ifndef EVENTSTREAM_HPP
+#define EVENTSTREAM_HPP
+
+/**
+ * @file eventstream.hpp
+ * File contains class {@link event_stream_t} which pushes Server-Sent Events
+ * to any amount of clients.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <httpd.hpp>
+
+
+/**
+ * Channel of Server-Sent Events.
+ *
+ * Every event is encoded once by publish() and shared by all subscribers.
+ * Subscribers only ever send the latest event. When a client reads slower than
+ * events are published, intermediate events are dropped. Connections without
+ * pending data are suspended until the next event is published.
+ *
+ * All functions have to be called within the event loop.
+ */
+class event_stream_t : private boost::noncopyable
+{
+public:
+    explicit event_stream_t(httpserver_t *server);
+    ~event_stream_t() noexcept;
+
+    httpserver_t::access_handler_t subscribe(
+            MHD_Connection *connection,
+            const std::string &initial = std::string());
+    void publish(const std::string &data);
+
+    std::size_t subscribers() const noexcept;
+
+private:
+    struct hub_t;
+    struct subscriber_t;
+
+    static ssize_t read(void *cls, std::uint64_t pos, char *buf,
+                        std::size_t max) noexcept;
+    static void free(void *cls) noexcept;
+
+    //! Shared with subscribers, which may outlive the stream.
+    std::shared_ptr<hub_t> m_hub;
+};
+
+#endif // EVENTSTREAM_HPP
@@ -0,0 +1,28 @@
+#ifndef FILERESPONSE_HPP
+#define FILERESPONSE_HPP
+
+#include <cstdint>
+#include <memory>
+
+#include <microhttpd.h>
+
+#include <bandwidth.hpp>
+
+
+/**
+ * Creates a response streaming @p size bytes of a file starting at @p offset.
+ *
+ * The response takes ownership of @p fd and closes it when destroyed. The file
+ * is read in chunks within the event loop. Sequential access is detected by
+ * {@link readahead_stream_t}, so the data is usually in the page cache already
+ * when the chunk is requested. All responses share a readahead budget of
+ * `httpd.readahead-budget` MiB.
+ *
+ * If @p flow is set, every chunk is granted by it first, so the download is
+ * paced by the limits of its {@link bandwidth_scheduler_t}.
+ */
+MHD_Response *create_file_response(
+        int fd, std::uint64_t offset, std::uint64_t size,
+        std::unique_ptr<bandwidth_flow_t> flow = nullptr);
+
+#endif // FILERESPONSE_HPP
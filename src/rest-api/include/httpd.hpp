@@ -1,15 +1,36 @@
 #ifndef HTTPD_HPP
 #define HTTPD_HPP
 
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <memory>
+#include <string>
 #include <unordered_set>
+#include <utility>
 
 #include <boost/core/noncopyable.hpp>
 
+#include <sys/socket.h>
+
 #include <microhttpd.h>
 
+#include <admission.hpp>
 #include <eventloop.hpp>
+#include <workerpool.hpp>
+
+class response_cache_t;
+class trace_writer_t;
 
+/**
+ * What a suspended connection waits for. Only connections waiting for work
+ * count towards the overload limit of the {@link admission_control_t}.
+ */
+enum class suspension_e {
+    WORK,      //!< Work in progress, e.g. an offloaded job or a disk write.
+    THROTTLED, //!< Bandwidth, e.g. a paced download.
+    PARKED     //!< An event, e.g. a long-poll or a stream subscriber.
+};
 
 class httpserver_t : private boost::noncopyable
 {
@@ -19,15 +40,60 @@ public:
         const char *upload_data, size_t *upload_data_size
     )>;
 
-    httpserver_t(eventloop_t *eventloop);
+    /**
+     * Creates the handler of a request. It is called once per request.
+     */
+    using route_t = std::function<access_handler_t(
+        struct MHD_Connection *connection
+    )>;
+
+    /**
+     * Work of a blocking handler. It runs on a worker thread and returns the
+     * status code and the response. The server releases the response.
+     */
+    using blocking_work_t = std::function<
+        std::pair<unsigned int, struct MHD_Response*>()
+    >;
+
+    explicit httpserver_t(eventloop_t *eventloop, int listen_fd = -1);
     ~httpserver_t() noexcept;
 
+    void add_route(const std::string &method, const std::string &path,
+                   const route_t &route,
+                   route_priority_e priority = route_priority_e::NORMAL);
+
+    void set_response_cache(response_cache_t *cache) noexcept;
+    void set_admission_control(admission_control_t *admission) noexcept;
+    void set_request_trace(trace_writer_t *trace) noexcept;
+
+    access_handler_t offload(const blocking_work_t &work);
+    worker_pool_t::stats_t worker_stats() const { return m_workers.stats(); }
+
+    void suspend(struct MHD_Connection *connection,
+                 suspension_e reason = suspension_e::WORK);
+    void resume(struct MHD_Connection *connection);
+
+    int listen_socket() const noexcept;
+    int quiesce() noexcept;
+    static bool peer_credentials(struct MHD_Connection *connection,
+                                 struct ucred &credentials) noexcept;
+    //! Amount of routed requests which have not completed yet.
+    std::size_t active_requests() const noexcept { return m_active_requests; }
+
 protected:
-    access_handler_t route_request(struct MHD_Connection *connection,
-                                   const char *url, const char *method,
-                                   const char *version);
+    //! A route and its priority.
+    struct route_entry_t {
+        route_t route;
+        route_priority_e priority;
+    };
+
+    const route_entry_t *find_route(const char *method,
+                                    const char *url) const;
 
 private:
+    MHD_Daemon *start_daemon(unsigned int flags, std::uint16_t port,
+                             int listen_fd);
+    void write_admission_stats(struct MHD_Connection *connection);
     void fdset_getter(fd_set &rs, fd_set &ws, fd_set &es, int &max,
                       std::chrono::nanoseconds &timeout);
     void io_handler(const fd_set &rs, const fd_set &ws, const fd_set &es);
@@ -44,7 +110,29 @@ private:
     eventloop_t *m_eventloop;
     eventloop_t::select_handle_t m_select_handle;
     MHD_Daemon *m_deamon = nullptr;
+    //! Daemon listening on `httpd.unix-socket`, if set.
+    MHD_Daemon *m_unix_deamon = nullptr;
+    //! Path of the Unix socket to remove on destruction. Empty after the
+    //! socket has been handed over.
+    std::string m_unix_path;
+    //! Connections waiting for work in progress.
     std::unordered_set<MHD_Connection*> suspended_connections;
+    //! Connections suspended by the bandwidth limits. They are no sign of
+    //! overload, so the admission control does not count them.
+    std::unordered_set<MHD_Connection*> throttled_connections;
+    //! Connections waiting for events. Idle clients are no sign of overload
+    //! either.
+    std::unordered_set<MHD_Connection*> parked_connections;
+    //! Whether connections have been resumed since the last run of MHD.
+    bool m_resumed = false;
+    std::map<std::pair<std::string, std::string>, route_entry_t> m_routes;
+    response_cache_t *m_cache = nullptr;
+    admission_control_t *m_admission = nullptr;
+    trace_writer_t *m_trace = nullptr;
+    std::size_t m_active_requests = 0;
+    worker_pool_t m_workers;
+    //! Used by workers to ignore results after destruction.
+    std::shared_ptr<httpserver_t*> m_self;
 };
 
 
@@ -0,0 +1,104 @@
+#ifndef JSONWRITER_HPP
+#define JSONWRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <bufferchain.hpp>
+
+
+/**
+ * Writes JSON directly into a {@link buffer_chain_t}.
+ *
+ * Commas and colons are inserted automatically. Inside objects, every value
+ * has to be preceded by key(). The writer does not validate the structure
+ * beyond that.
+ *
+ * ```{.cpp}
+ * buffer_chain_t out;
+ * json_writer_t json(out);
+ * json.begin_object()
+ *     .key("name").value("debian.iso")
+ *     .key("size").value(std::uint64_t(1) << 30)
+ *     .end_object();
+ * ```
+ *
+ * Encoders of other formats provide the same member functions, so data can be
+ * serialized by templates working with any of them.
+ */
+class json_writer_t
+{
+public:
+    explicit json_writer_t(buffer_chain_t &out) : m_out(out) {}
+
+    json_writer_t &begin_object();
+    json_writer_t &end_object();
+    json_writer_t &begin_array();
+    json_writer_t &end_array();
+
+    json_writer_t &key(const char *str, std::size_t len);
+    json_writer_t &key(const char *str) { return key(str, std::strlen(str)); }
+    json_writer_t &key(const std::string &str) {
+        return key(str.data(), str.size());
+    }
+
+    json_writer_t &value(const char *str, std::size_t len);
+    json_writer_t &value(const char *str) {
+        return value(str, std::strlen(str));
+    }
+    json_writer_t &value(const std::string &str) {
+        return value(str.data(), str.size());
+    }
+    json_writer_t &value(bool b);
+    json_writer_t &value(int i) { return write_int(i); }
+    json_writer_t &value(long i) { return write_int(i); }
+    json_writer_t &value(long long i) { return write_int(i); }
+    json_writer_t &value(unsigned i) { return write_uint(i); }
+    json_writer_t &value(unsigned long i) { return write_uint(i); }
+    json_writer_t &value(unsigned long long i) { return write_uint(i); }
+    json_writer_t &value(double d);
+    json_writer_t &null();
+
+    /**
+     * Writes binary data like an infohash. JSON represents it as lowercase
+     * hexadecimal string.
+     */
+    json_writer_t &binary(const void *data, std::size_t len);
+
+private:
+    json_writer_t &write_int(std::int64_t i);
+    json_writer_t &write_uint(std::uint64_t i);
+
+    void separate() {
+        if (m_need_comma)
+            m_out.append(',');
+        m_need_comma = true;
+    }
+    void begin(char c);
+    void end(char c);
+    void write_string(const char *str, std::size_t len);
+
+    buffer_chain_t &m_out;
+    bool m_need_comma = false;
+};
+
+/**
+ * Writes the decimal representation of @p value to @p buf.
+ *
+ * @return Pointer behind the last written character. At most 20 characters
+ *         are written.
+ */
+char *format_uint(std::uint64_t value, char *buf) noexcept;
+
+/**
+ * Writes @p value with at most @p decimals fractional digits to @p buf.
+ * Trailing zeros are omitted. Non-finite values are written as `null`.
+ *
+ * @return Pointer behind the last written character. At most 32 characters
+ *         are written.
+ */
+char *format_double(double value, int decimals, char *buf) noexcept;
+
+#endif // JSONWRITER_HPP
@@ -0,0 +1,45 @@
+#ifndef MOVERAPI_HPP
+#define MOVERAPI_HPP
+
+/**
+ * @file moverapi.hpp
+ * File contains class {@link mover_api_t} which shows the progress of the
+ * {@link file_mover_t} over HTTP.
+ */
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <filemover.hpp>
+#include <httpd.hpp>
+
+
+/**
+ * Provides `GET /moves` which returns the progress of every batch of a
+ * {@link file_mover_t} which has not been completed yet:
+ *
+ * ```{.json}
+ * {
+ *   "batches": [{"id": 7, "files_total": 12, "files_done": 3,
+ *                "bytes_total": 1048576, "bytes_done": 524288}]
+ * }
+ * ```
+ *
+ * The amount of bytes only counts files which have to be copied, see
+ * {@link file_mover_t::progress()}.
+ *
+ * The mover must outlive the API.
+ */
+class mover_api_t : private boost::noncopyable
+{
+public:
+    mover_api_t(httpserver_t *server, const file_mover_t *mover);
+
+private:
+    void respond(MHD_Connection *connection);
+
+    const file_mover_t *m_mover;
+};
+
+#endif // MOVERAPI_HPP
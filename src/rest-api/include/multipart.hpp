@@ -0,0 +1,95 @@
+#ifndef MULTIPART_HPP
+#define MULTIPART_HPP
+
+/**
+ * @file multipart.hpp
+ * File contains class {@link multipart_parser_t} which parses request bodies
+ * of type `multipart/form-data` while they are received.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+
+/**
+ * Thrown by {@link multipart_parser_t} on malformed bodies.
+ */
+class multipart_error : public std::runtime_error
+{
+public:
+    explicit multipart_error(const char *what) : std::runtime_error(what) {}
+};
+
+/**
+ * Returns the boundary given in the `Content-Type` header of a request or an
+ * empty string if it is not a valid `multipart/form-data` type.
+ */
+std::string multipart_boundary(const char *content_type);
+
+/**
+ * Incremental parser for `multipart/form-data` (RFC 7578).
+ *
+ * The body can be passed in chunks of any size. The content of every part is
+ * passed to the data handler without being copied. Only the headers of the
+ * current part and a partially matched boundary are kept in memory.
+ */
+class multipart_parser_t : private boost::noncopyable
+{
+public:
+    //! Maximal size of the headers of a part.
+    static constexpr std::size_t max_header_size = 8192;
+
+    /**
+     * Headers of a part.
+     */
+    struct part_t {
+        std::string name;         //!< Name of the form field.
+        std::string filename;     //!< File name if the part is a file.
+        std::string content_type; //!< Content type, may be empty.
+    };
+
+    /**
+     * Handlers called while parsing. Each of them may be empty.
+     */
+    struct handlers_t {
+        //! Called when the headers of a part have been received.
+        std::function<void(const part_t &part)> begin;
+        //! Called with the content of the current part, possibly many times.
+        std::function<void(const char *data, std::size_t len)> data;
+        //! Called when the current part is complete.
+        std::function<void()> end;
+    };
+
+    multipart_parser_t(const std::string &boundary, handlers_t handlers);
+
+    void feed(const char *data, std::size_t len);
+    void finish() const;
+
+private:
+    enum class state_e {
+        PREAMBLE,  //!< Before the first boundary.
+        DELIMITER, //!< After a boundary, expecting `--` or CRLF.
+        HEADERS,   //!< Within the headers of a part.
+        BODY,      //!< Within the content of a part.
+        EPILOGUE   //!< After the final boundary.
+    };
+
+    std::size_t scan(const char *data, std::size_t len);
+    void parse_headers();
+
+    const std::string m_delimiter;
+    const handlers_t m_handlers;
+
+    state_e m_state = state_e::PREAMBLE;
+    //! Amount of bytes of the delimiter matched so far.
+    std::size_t m_match;
+    //! Characters received after the last delimiter.
+    std::string m_tail;
+    std::string m_headers;
+};
+
+#endif // MULTIPART_HPP
@@ -0,0 +1,105 @@
+#ifndef REQUESTTRACE_HPP
+#define REQUESTTRACE_HPP
+
+/**
+ * @file requesttrace.hpp
+ * File contains classes {@link trace_writer_t} and {@link trace_reader_t}
+ * which record requests to a compact binary file and read them for replay.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <eventloop.hpp>
+
+
+/**
+ * Thrown if a trace file is malformed.
+ */
+class trace_error : public std::runtime_error
+{
+public:
+    explicit trace_error(const char *what) : std::runtime_error(what) {}
+};
+
+/**
+ * A recorded request.
+ */
+struct trace_record_t {
+    //! Time of the request since the start of the recording.
+    std::chrono::microseconds time{0};
+    std::string method; //!< Method of the request, e.g. `GET`.
+    std::string target; //!< Encoded path including the query arguments.
+    std::string range;  //!< Value of the `Range` header, if any.
+};
+
+/**
+ * Appends requests to a trace file.
+ *
+ * The file starts with the magic `XLTSTRC1`. Every record consists of the
+ * delta to the time of the previous record in microseconds, the method, the
+ * target and the range. Numbers and lengths are stored as LEB128 varints,
+ * common methods as a single byte. A typical record takes less than 40 bytes.
+ *
+ * Records are buffered and written when the buffer is full, by flush() or on
+ * destruction. If an event loop is given, new records are also flushed every
+ * #flush_interval, so the trace is usable while the server is running. The
+ * writer is used within the event loop.
+ */
+class trace_writer_t : private boost::noncopyable
+{
+public:
+    //! Maximal time records stay buffered if an event loop is given.
+    static constexpr std::chrono::seconds flush_interval{1};
+
+    explicit trace_writer_t(const std::string &path,
+                            eventloop_t *eventloop = nullptr);
+    ~trace_writer_t() noexcept;
+
+    void record(MHD_Connection *connection, const char *url,
+                const char *method);
+    void write(const trace_record_t &record);
+    void flush();
+
+private:
+    void schedule_flush();
+
+    std::FILE *m_file;
+    eventloop_t *m_eventloop;
+    std::chrono::steady_clock::time_point m_start;
+    //! Time of the previous record.
+    std::chrono::microseconds m_last{0};
+    //! Whether records have been written since the last flush.
+    bool m_dirty = false;
+    //! Used to ignore scheduled calls after destruction.
+    std::shared_ptr<trace_writer_t*> m_self;
+};
+
+/**
+ * Reads the records of a trace file in order.
+ */
+class trace_reader_t : private boost::noncopyable
+{
+public:
+    explicit trace_reader_t(const std::string &path);
+    ~trace_reader_t() noexcept;
+
+    bool next(trace_record_t &record);
+
+private:
+    bool read_varint(std::uint64_t &value);
+    std::string read_string();
+
+    std::FILE *m_file;
+    std::chrono::microseconds m_time{0};
+};
+
+#endif // REQUESTTRACE_HPP
@@ -0,0 +1,102 @@
+#ifndef RESPONSECACHE_HPP
+#define RESPONSECACHE_HPP
+
+/**
+ * @file responsecache.hpp
+ * File contains class {@link response_cache_t} which keeps prebuilt responses
+ * of idempotent GET routes.
+ */
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <bufferchain.hpp>
+#include <compression.hpp>
+#include <httpd.hpp>
+
+
+/**
+ * Cache of complete responses of GET routes.
+ *
+ * Entries are keyed by the path and the sorted query arguments (see
+ * request_key()). Every entry holds prebuilt responses for all content codings
+ * which make the body smaller, each with a strong ETag. Requests with a
+ * matching `If-None-Match` get `304 Not Modified`.
+ *
+ * The cache is consulted by {@link httpserver_t} before routing a GET request.
+ * HEAD requests are not served from it, as no route answers them. Routes fill
+ * the cache by respond(). Entries are tagged and dropped by invalidate() when
+ * the data they depend on changes. If the size of all entries
+ * exceeds the budget, the least recently used entries are evicted.
+ *
+ * Statistics are available at `GET /cache`. All functions have to be called
+ * within the event loop.
+ */
+class response_cache_t : private boost::noncopyable
+{
+public:
+    /**
+     * Counters of the cache.
+     */
+    struct stats_t {
+        std::uint64_t hits = 0;          //!< Requests served from the cache.
+        std::uint64_t not_modified = 0;  //!< Hits answered with 304.
+        std::uint64_t misses = 0;        //!< Responses built by routes.
+        std::uint64_t evictions = 0;     //!< Entries evicted due to the budget.
+        std::uint64_t invalidations = 0; //!< Entries dropped by invalidate().
+        std::size_t   entries = 0;       //!< Amount of entries.
+        std::size_t   memory = 0;        //!< Size of all entries in bytes.
+    };
+
+    response_cache_t(httpserver_t *server, std::size_t budget);
+    ~response_cache_t() noexcept;
+
+    static std::string request_key(MHD_Connection *connection,
+                                   const char *path);
+
+    bool lookup(MHD_Connection *connection, const std::string &key);
+    void respond(MHD_Connection *connection, const std::string &key,
+                 buffer_chain_t &&body, const char *content_type,
+                 const std::vector<std::string> &tags, bool cacheable = true);
+
+    void invalidate(const std::string &tag);
+    void set_budget(std::size_t budget) noexcept;
+    void clear() noexcept;
+
+    const stats_t &stats() const noexcept { return m_stats; }
+
+private:
+    struct entry_t;
+    using lru_t = std::list<std::unique_ptr<entry_t>>;
+
+    std::unique_ptr<entry_t> build(const std::string &key,
+                                   buffer_chain_t &&body,
+                                   const char *content_type,
+                                   const std::vector<std::string> &tags);
+    void queue(MHD_Connection *connection, const entry_t &entry);
+    void erase(const std::string &key) noexcept;
+    void evict() noexcept;
+    void write_stats(MHD_Connection *connection);
+
+    httpserver_t *m_server;
+    std::size_t m_budget;
+
+    //! Entries ordered by last use, most recent first.
+    lru_t m_lru;
+    std::unordered_map<std::string, lru_t::iterator> m_entries;
+    //! Keys of the entries by tag.
+    std::map<std::string, std::set<std::string>> m_tags;
+    stats_t m_stats;
+};
+
+#endif // RESPONSECACHE_HPP
@@ -0,0 +1,79 @@
+#ifndef RESPONSEFORMAT_HPP
+#define RESPONSEFORMAT_HPP
+
+/**
+ * @file responseformat.hpp
+ * File contains functions to negotiate the format of structured responses
+ * and to write them with the matching encoder.
+ */
+
+#include <microhttpd.h>
+
+#include <bufferchain.hpp>
+#include <cborwriter.hpp>
+#include <jsonwriter.hpp>
+
+
+/**
+ * Formats of structured responses. Both carry the same data with the same
+ * keys. Every route with a structured body follows the format, including
+ * error bodies. Only the event streams (`GET /events`) stay JSON, as
+ * server-sent events are text.
+ */
+enum class response_format_e {
+    JSON, //!< `application/json`, written by {@link json_writer_t}.
+    CBOR  //!< `application/cbor`, written by {@link cbor_writer_t}.
+};
+
+/**
+ * Returns the media type of @p format as used in `Content-Type`.
+ */
+const char *to_media_type(response_format_e format) noexcept;
+
+/**
+ * Chooses the format according to the value of the header `Accept`. CBOR is
+ * chosen if `application/cbor` is listed with a quality above zero which is
+ * not lower than the one of `application/json`. Wildcards and missing headers
+ * result in JSON, so browsers and existing clients are not affected.
+ */
+response_format_e negotiate_format(const char *accept) noexcept;
+
+/**
+ * Chooses the format for the request on @p connection.
+ */
+inline response_format_e request_format(MHD_Connection *connection) noexcept
+{
+    return negotiate_format(MHD_lookup_connection_value(
+            connection, MHD_HEADER_KIND, "Accept"));
+}
+
+/**
+ * Queues a response with @p status and the body `{"msg": message}` in the
+ * format requested on @p connection.
+ */
+void queue_error_response(MHD_Connection *connection, unsigned int status,
+                          const char *message);
+
+/**
+ * Calls @p write with the writer of @p format, which writes into @p out.
+ *
+ * ```{.cpp}
+ * write_formatted(format, chain, [&](auto &out) {
+ *     out.begin_object().key("version").value(version).end_object();
+ * });
+ * ```
+ */
+template<typename function_t>
+void write_formatted(response_format_e format, buffer_chain_t &out,
+                     function_t &&write)
+{
+    if (format == response_format_e::CBOR) {
+        cbor_writer_t cbor(out);
+        write(cbor);
+    } else {
+        json_writer_t json(out);
+        write(json);
+    }
+}
+
+#endif // RESPONSEFORMAT_HPP
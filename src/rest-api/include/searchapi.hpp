@@ -0,0 +1,54 @@
+#ifndef SEARCHAPI_HPP
+#define SEARCHAPI_HPP
+
+/**
+ * @file searchapi.hpp
+ * File contains class {@link search_api_t} which finds files of all torrents
+ * over HTTP.
+ */
+
+#include <cstddef>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <filesearch.hpp>
+#include <httpd.hpp>
+
+
+/**
+ * Provides `GET /search?q=...` which returns the files whose paths contain
+ * all terms of `q`:
+ *
+ * ```{.json}
+ * {
+ *   "total": 1234,
+ *   "files": [{"infohash": "...", "file": 3, "path": "Album/03 Song.mp3"}]
+ * }
+ * ```
+ *
+ * `limit` restricts the amount of listed files. It defaults to 50 and is
+ * capped at 500, `total` counts all matching files. Queries without any term
+ * of {@link file_search_index_t::min_term_length} characters are rejected
+ * with 400, as they could not be answered by the index.
+ *
+ * Must be destroyed before the {@link httpserver_t}, the index must outlive
+ * it.
+ */
+class search_api_t : private boost::noncopyable
+{
+public:
+    //! Maximal amount of files of a response.
+    static constexpr std::size_t max_limit = 500;
+
+    search_api_t(httpserver_t *server, const file_search_index_t *index);
+
+private:
+    httpserver_t::access_handler_t route_search(MHD_Connection *connection);
+
+    httpserver_t *m_server;
+    const file_search_index_t *m_index;
+};
+
+#endif // SEARCHAPI_HPP
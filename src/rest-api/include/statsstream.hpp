@@ -0,0 +1,78 @@
+#ifndef STATSSTREAM_HPP
+#define STATSSTREAM_HPP
+
+/**
+ * @file statsstream.hpp
+ * File contains class {@link stats_stream_t} which pushes transfer statistics
+ * to clients.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <eventloop.hpp>
+#include <eventstream.hpp>
+#include <httpd.hpp>
+#include <torrentstatus.hpp>
+
+
+/**
+ * Provides `GET /events`, a stream of Server-Sent Events with live transfer
+ * statistics.
+ *
+ * Every `httpd.stats-interval` milliseconds, all changes of the torrent status
+ * store are coalesced into one event if anybody is subscribed:
+ *
+ * ```{.json}
+ * {
+ *   "version": 42,
+ *   "download_rate": 1234, "upload_rate": 567, "peers": 8, "full": false,
+ *   "torrents": [{"infohash": "...", "progress": 0.5, "download_rate": 1234,
+ *                 "upload_rate": 567, "peers": 8}],
+ *   "removed": ["..."]
+ * }
+ * ```
+ *
+ * The rates and peers at top level are the sums over all torrents. `torrents`
+ * only lists torrents which have changed since the previous event, `removed`
+ * the infohashes of torrents removed since then. The event is serialized once
+ * per tick, independent of the amount of subscribers.
+ *
+ * Events with `full` set list all torrents and have no `removed`. Clients
+ * replace their list by them. New subscribers first receive such an event, so
+ * they do not have to wait for changes to learn about them. It is also
+ * published if removals have been pruned from the store before they could be
+ * published (see torrent_status_store_t::horizon()).
+ */
+class stats_stream_t : private boost::noncopyable
+{
+public:
+    stats_stream_t(eventloop_t *eventloop, httpserver_t *server,
+                   torrent_status_store_t *store);
+
+private:
+    void schedule_tick();
+    void tick();
+    const std::string &snapshot();
+    std::string serialize(
+            const std::vector<const torrent_status_store_t::entry_t*>
+                    &torrents, bool full);
+
+    eventloop_t *m_eventloop;
+    torrent_status_store_t *m_store;
+    event_stream_t m_stream;
+    //! Version of the store when the last event has been published.
+    std::uint64_t m_version;
+    //! Event listing all torrents, see snapshot().
+    std::string m_snapshot;
+    //! Version of the store when #m_snapshot has been serialized.
+    std::uint64_t m_snapshot_version = 0;
+    //! Used to ignore scheduled calls after destruction.
+    std::shared_ptr<stats_stream_t*> m_self;
+};
+
+#endif // STATSSTREAM_HPP
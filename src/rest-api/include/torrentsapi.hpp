@@ -0,0 +1,97 @@
+#ifndef TORRENTSAPI_HPP
+#define TORRENTSAPI_HPP
+
+/**
+ * @file torrentsapi.hpp
+ * File contains class {@link torrents_api_t} which provides the status of all
+ * torrents over HTTP.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <bufferchain.hpp>
+#include <eventloop.hpp>
+#include <httpd.hpp>
+#include <responsecache.hpp>
+#include <responseformat.hpp>
+#include <torrentindex.hpp>
+#include <torrentstatus.hpp>
+
+
+/**
+ * Provides `GET /torrents` which returns the status of all torrents.
+ *
+ * Clients can pass the version of the last response as `since` to get only the
+ * torrents which have changed since then. If nothing has changed, the
+ * connection is suspended until something changes or `httpd.longpoll-timeout`
+ * expires. The response has the following format:
+ *
+ * ```{.json}
+ * {
+ *   "version": 42,
+ *   "full": false,
+ *   "torrents": [{"infohash": "...", "name": "...", "state": "seeding", ...}],
+ *   "removed": ["..."]
+ * }
+ * ```
+ *
+ * If `full` is true, the response contains all torrents, and clients have to
+ * drop all torrents not listed. This happens if `since` is missing, unknown or
+ * too old.
+ *
+ * Clients showing a list can ask for a single page instead by passing any of
+ * `state`, `sort`, `offset` and `limit`. `state` filters by a state name,
+ * `sort` is one of `name`, `size`, `progress`, `added` and `ratio`, prefixed
+ * by `-` for descending order. `limit` defaults to 50 and is capped at 500.
+ * Pages are taken from a {@link torrent_index_t} and never long-polled:
+ *
+ * ```{.json}
+ * {"version": 42, "total": 10000, "offset": 100, "torrents": [...]}
+ * ```
+ *
+ * Clients sending `Accept: application/cbor` get the same data encoded as CBOR
+ * (see {@link cbor_writer_t}). Keys are written as their index in
+ * {@link cbor_key_names} there, and infohashes as byte strings instead of
+ * hexadecimal text. New keys may be added, but existing keys keep their
+ * meaning in both formats.
+ *
+ * Responses are stored in the {@link response_cache_t} with tag `torrents`
+ * until the store changes, and shared by all clients asking for the same
+ * delta. Clients woken by a change usually ask for the same delta, so every
+ * change is serialized only once.
+ *
+ * Must be destroyed before the {@link httpserver_t}, the cache and the index,
+ * the store must outlive all of them.
+ */
+class torrents_api_t : private boost::noncopyable
+{
+public:
+    torrents_api_t(eventloop_t *eventloop, httpserver_t *server,
+                   response_cache_t *cache, torrent_status_store_t *store,
+                   torrent_index_t *index);
+    ~torrents_api_t() noexcept;
+
+private:
+    struct poll_t;
+
+    httpserver_t::access_handler_t route_torrents(MHD_Connection *connection);
+    void park(const std::shared_ptr<poll_t> &poll);
+    buffer_chain_t serialize(std::uint64_t since, response_format_e format);
+    buffer_chain_t serialize(const torrent_query_t &query,
+                             response_format_e format);
+
+    eventloop_t *m_eventloop;
+    httpserver_t *m_server;
+    response_cache_t *m_cache;
+    torrent_status_store_t *m_store;
+    torrent_index_t *m_index;
+    torrent_status_store_t::listener_handle_t m_listener;
+};
+
+#endif // TORRENTSAPI_HPP
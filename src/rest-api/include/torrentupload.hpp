@@ -0,0 +1,78 @@
+#ifndef TORRENTUPLOAD_HPP
+#define TORRENTUPLOAD_HPP
+
+/**
+ * @file torrentupload.hpp
+ * File contains class {@link torrent_upload_t} which accepts uploaded torrent
+ * files.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <microhttpd.h>
+
+#include <diskscheduler.hpp>
+#include <eventloop.hpp>
+#include <httpd.hpp>
+
+
+/**
+ * Provides `POST /torrents` which adds torrent files sent as
+ * `multipart/form-data`, as done by HTML forms.
+ *
+ * Every part with a file name is a torrent file. The body is never buffered
+ * as a whole. Each chunk received by libmicrohttpd is passed through the
+ * multipart parser into a bencode scanner, which validates the file and hashes
+ * the info dictionary on the fly. The content is written to a temporary file
+ * in the torrent directory by a job of the {@link disk_scheduler_t}. While the
+ * job is running, the connection is suspended, so no more data is read from
+ * the client. Hence, a request never holds more than one chunk of data.
+ *
+ * When a file is complete, it is renamed to `<infohash>.torrent`, where the
+ * torrent watcher picks it up. The response lists the infohashes of all
+ * files of the request:
+ *
+ * ```{.json}
+ * {"torrents": ["..."]}
+ * ```
+ *
+ * Requests with invalid files get 400, requests whose files exceed
+ * `httpd.upload-limit` in total get 413. Temporary files of failed requests
+ * are removed, files completed before the failure are kept.
+ *
+ * Must be destroyed before the {@link httpserver_t}.
+ */
+class torrent_upload_t : private boost::noncopyable
+{
+public:
+    torrent_upload_t(eventloop_t *eventloop, httpserver_t *server,
+                     disk_scheduler_t *scheduler, const std::string &directory,
+                     std::size_t limit);
+
+    /**
+     * Changes the maximal amount of bytes of all files of a request.
+     */
+    void set_limit(std::size_t limit) noexcept { m_limit = limit; }
+
+private:
+    struct upload_t;
+
+    httpserver_t::access_handler_t route_upload(MHD_Connection *connection);
+    void fail(const std::shared_ptr<upload_t> &upload, unsigned int status,
+              const char *message);
+    void flush(const std::shared_ptr<upload_t> &upload);
+
+    eventloop_t *m_eventloop;
+    httpserver_t *m_server;
+    disk_scheduler_t *m_scheduler;
+    const std::string m_directory;
+    std::size_t m_limit;
+    //! Used to ignore finished jobs after destruction.
+    std::shared_ptr<torrent_upload_t*> m_self;
+};
+
+#endif // TORRENTUPLOAD_HPP
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+
+#include <jsonwriter.hpp>
+
+
+static const char digit_pairs[] =
+    "00010203040506070809" "10111213141516171819"
+    "20212223242526272829" "30313233343536373839"
+    "40414243444546474849" "50515253545556575859"
+    "60616263646566676869" "70717273747576777879"
+    "80818283848586878889" "90919293949596979899";
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static const std::uint64_t powers_of_ten[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+    10000000ull, 100000000ull, 1000000000ull};
+
+
+static bool needs_escape(char c)
+{
+    return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+/**
+ * Returns the length of the prefix of @p str which can be copied unescaped.
+ */
+static std::size_t safe_prefix(const char *str, std::size_t len)
+{
+    std::size_t i = 0;
+#ifdef __SSE2__
+    // Check 16 characters at once for quotes, backslashes and control
+    // characters (unsigned values below 0x20).
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control   = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+        __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                             _mm_cmpeq_epi8(v, backslash)),
+                _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        int mask = _mm_movemask_epi8(m);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < len; ++i) {
+        if (needs_escape(str[i])) {
+            return i;
+        }
+    }
+    return len;
+}
+
+
+char *format_uint(std::uint64_t value, char *buf) noexcept
+{
+    // Write digits backwards into a temporary buffer, two at a time.
+    char tmp[20];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    while (value >= 100) {
+        std::size_t i = (value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    }
+    if (value >= 10) {
+        std::size_t i = value * 2;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    } else {
+        *--p = static_cast<char>('0' + value);
+    }
+    std::memcpy(buf, p, end - p);
+    return buf + (end - p);
+}
+
+char *format_double(double value, int decimals, char *buf) noexcept
+{
+    if (!std::isfinite(value)) {
+        std::memcpy(buf, "null", 4);
+        return buf + 4;
+    }
+    if (decimals < 0 || decimals > 9
+            || std::fabs(value) >= 1e18 / powers_of_ten[decimals]) {
+        // Too large for the fixed-point path below.
+        return buf + std::snprintf(buf, 32, "%.17g", value);
+    }
+
+    // Round to a fixed-point integer and print both parts.
+    const std::uint64_t scale = powers_of_ten[decimals];
+    const bool negative = value < 0;
+    std::uint64_t scaled = static_cast<std::uint64_t>(
+            std::fabs(value) * scale + 0.5);
+    if (negative && scaled != 0) {
+        *buf++ = '-';
+    }
+    buf = format_uint(scaled / scale, buf);
+
+    std::uint64_t fraction = scaled % scale;
+    if (fraction != 0) {
+        int digits = decimals;
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            --digits;
+        }
+        *buf++ = '.';
+        for (int i = digits - 1; i >= 0; --i) {
+            buf[i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        buf += digits;
+    }
+    return buf;
+}
+
+
+json_writer_t &json_writer_t::begin_object()
+{
+    begin('{');
+    return *this;
+}
+
+json_writer_t &json_writer_t::end_object()
+{
+    end('}');
+    return *this;
+}
+
+json_writer_t &json_writer_t::begin_array()
+{
+    begin('[');
+    return *this;
+}
+
+json_writer_t &json_writer_t::end_array()
+{
+    end(']');
+    return *this;
+}
+
+json_writer_t &json_writer_t::key(const char *str, std::size_t len)
+{
+    separate();
+    write_string(str, len);
+    m_out.append(':');
+    m_need_comma = false;
+    return *this;
+}
+
+json_writer_t &json_writer_t::value(const char *str, std::size_t len)
+{
+    separate();
+    write_string(str, len);
+    return *this;
+}
+
+json_writer_t &json_writer_t::value(bool b)
+{
+    separate();
+    if (b) {
+        m_out.append("true", 4);
+    } else {
+        m_out.append("false", 5);
+    }
+    return *this;
+}
+
+json_writer_t &json_writer_t::value(double d)
+{
+    separate();
+    char *buf = m_out.reserve(32);
+    m_out.commit(format_double(d, 6, buf) - buf);
+    return *this;
+}
+
+json_writer_t &json_writer_t::null()
+{
+    separate();
+    m_out.append("null", 4);
+    return *this;
+}
+
+json_writer_t &json_writer_t::binary(const void *data, std::size_t len)
+{
+    separate();
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    m_out.append('"');
+    while (len > 0) {
+        std::size_t n = std::min(len, buffer_chain_t::chunk_size / 2);
+        char *buf = m_out.reserve(2 * n);
+        for (std::size_t i = 0; i < n; ++i) {
+            buf[2 * i]     = hex_digits[bytes[i] >> 4];
+            buf[2 * i + 1] = hex_digits[bytes[i] & 0x0F];
+        }
+        m_out.commit(2 * n);
+        bytes += n;
+        len -= n;
+    }
+    m_out.append('"');
+    return *this;
+}
+
+json_writer_t &json_writer_t::write_int(std::int64_t i)
+{
+    separate();
+    char *buf = m_out.reserve(21);
+    char *p = buf;
+    std::uint64_t magnitude = static_cast<std::uint64_t>(i);
+    if (i < 0) {
+        *p++ = '-';
+        magnitude = 0 - magnitude;
+    }
+    m_out.commit(format_uint(magnitude, p) - buf);
+    return *this;
+}
+
+json_writer_t &json_writer_t::write_uint(std::uint64_t i)
+{
+    separate();
+    char *buf = m_out.reserve(20);
+    m_out.commit(format_uint(i, buf) - buf);
+    return *this;
+}
+
+void json_writer_t::begin(char c)
+{
+    separate();
+    m_out.append(c);
+    m_need_comma = false;
+}
+
+void json_writer_t::end(char c)
+{
+    m_out.append(c);
+    m_need_comma = true;
+}
+
+void json_writer_t::write_string(const char *str, std::size_t len)
+{
+    m_out.append('"');
+    while (len > 0) {
+        std::size_t n = safe_prefix(str, len);
+        m_out.append(str, n);
+        str += n;
+        len -= n;
+        if (len == 0) {
+            break;
+        }
+
+        char *buf = m_out.reserve(6);
+        buf[0] = '\\';
+        switch (*str) {
+        case '"':  buf[1] = '"';  m_out.commit(2); break;
+        case '\\': buf[1] = '\\'; m_out.commit(2); break;
+        case '\b': buf[1] = 'b';  m_out.commit(2); break;
+        case '\f': buf[1] = 'f';  m_out.commit(2); break;
+        case '\n': buf[1] = 'n';  m_out.commit(2); break;
+        case '\r': buf[1] = 'r';  m_out.commit(2); break;
+        case '\t': buf[1] = 't';  m_out.commit(2); break;
+        default:
+            buf[1] = 'u';
+            buf[2] = '0';
+            buf[3] = '0';
+            buf[4] = hex_digits[(*str >> 4) & 0x0F];
+            buf[5] = hex_digits[*str & 0x0F];
+            m_out.commit(6);
+        }
+        ++str;
+        --len;
+    }
+    m_out.append('"');
+}
@@ -0,0 +1,47 @@
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+#include <bufferchain.hpp>
+#include <moverapi.hpp>
+#include <responseformat.hpp>
+
+
+mover_api_t::mover_api_t(httpserver_t *server, const file_mover_t *mover)
+    : m_mover(mover)
+{
+    server->add_route(MHD_HTTP_METHOD_GET, "moves",
+                      [this](MHD_Connection *) {
+                          return [this](MHD_Connection *connection,
+                                        const char *, std::size_t *) {
+                              respond(connection);
+                          };
+                      });
+}
+
+void mover_api_t::respond(MHD_Connection *connection)
+{
+    const std::map<std::uint64_t, file_mover_t::progress_t> batches =
+            m_mover->progress();
+    const response_format_e format = request_format(connection);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &out) {
+        out.begin_object().key("batches").begin_array();
+        for (const auto &batch : batches) {
+            const file_mover_t::progress_t &progress = batch.second;
+            out.begin_object()
+                .key("id").value(static_cast<unsigned long long>(batch.first))
+                .key("files_total").value(progress.files_total)
+                .key("files_done").value(progress.files_done)
+                .key("bytes_total").value(
+                        static_cast<unsigned long long>(progress.bytes_total))
+                .key("bytes_done").value(
+                        static_cast<unsigned long long>(progress.bytes_done))
+                .end_object();
+        }
+        out.end_array().end_object();
+    });
+    queue_buffer_response(connection, MHD_HTTP_OK, std::move(chain),
+                          to_media_type(format));
+}
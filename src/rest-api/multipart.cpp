@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <strings.h>
+
+#include <multipart.hpp>
+
+
+static bool is_space(char c) noexcept
+{
+    return c == ' ' || c == '\t';
+}
+
+/**
+ * Returns the parameter @p name of a header value like
+ * `form-data; name="field"` or an empty string if it is missing.
+ */
+static std::string parameter(const std::string &value, const char *name)
+{
+    std::size_t pos = value.find(';');
+    while (pos < value.size()) {
+        ++pos;
+        while (pos < value.size() && is_space(value[pos]))
+            ++pos;
+        std::size_t eq = std::min(value.find_first_of("=;", pos),
+                                  value.size());
+        const bool match = eq < value.size() && value[eq] == '='
+                && strncasecmp(value.c_str() + pos, name, eq - pos) == 0
+                && std::strlen(name) == eq - pos;
+        pos = eq < value.size() && value[eq] == '=' ? eq + 1 : eq;
+
+        // Read token or quoted string.
+        std::string result;
+        if (pos < value.size() && value[pos] == '"') {
+            for (++pos; pos < value.size() && value[pos] != '"'; ++pos) {
+                if (value[pos] == '\\' && pos + 1 < value.size())
+                    ++pos;
+                result += value[pos];
+            }
+        } else {
+            while (pos < value.size() && value[pos] != ';'
+                    && !is_space(value[pos]))
+                result += value[pos++];
+        }
+        if (match) {
+            return result;
+        }
+        pos = value.find(';', pos);
+    }
+    return {};
+}
+
+
+std::string multipart_boundary(const char *content_type)
+{
+    static const char type[] = "multipart/form-data";
+    if (content_type == nullptr
+            || strncasecmp(content_type, type, sizeof(type) - 1) != 0) {
+        return {};
+    }
+    std::string boundary = parameter(content_type, "boundary");
+    if (boundary.size() > 70
+            || boundary.find_first_of("\r\n") != std::string::npos) {
+        return {};
+    }
+    return boundary;
+}
+
+
+/**
+ * Creates a parser for a body using @p boundary, which must not be empty.
+ */
+multipart_parser_t::multipart_parser_t(const std::string &boundary,
+                                       handlers_t handlers)
+    : m_delimiter("\r\n--" + boundary)
+    , m_handlers(std::move(handlers))
+    // The first boundary is not preceded by CRLF.
+    , m_match(2)
+{
+}
+
+/**
+ * Parses the next part of the body.
+ *
+ * @throws multipart_error if the body is malformed.
+ */
+void multipart_parser_t::feed(const char *data, std::size_t len)
+{
+    std::size_t i = 0;
+    while (i < len) {
+        switch (m_state) {
+        case state_e::PREAMBLE:
+        case state_e::BODY:
+            i += scan(data + i, len - i);
+            break;
+
+        case state_e::DELIMITER: {
+            const char c = data[i++];
+            if (m_tail.empty() && is_space(c)) {
+                break; // Transport padding
+            }
+            m_tail += c;
+            if (m_tail == "--") {
+                m_state = state_e::EPILOGUE;
+            } else if (m_tail == "\r\n") {
+                m_state = state_e::HEADERS;
+                // Lets the empty line be found when there are no headers.
+                m_headers = "\r\n";
+            } else if (m_tail != "-" && m_tail != "\r") {
+                throw multipart_error("Invalid multipart boundary");
+            }
+            break;
+        }
+
+        case state_e::HEADERS: {
+            const std::size_t old = m_headers.size();
+            const std::size_t take = std::min(len - i,
+                                              max_header_size + 2 - old);
+            m_headers.append(data + i, take);
+            std::size_t end = m_headers.find("\r\n\r\n",
+                                             old >= 3 ? old - 3 : 0);
+            if (end == std::string::npos) {
+                if (m_headers.size() >= max_header_size + 2) {
+                    throw multipart_error("Headers of part are too large");
+                }
+                i += take;
+                break;
+            }
+            i += end + 4 - old;
+            m_headers.resize(end + 2);
+            parse_headers();
+            m_state = state_e::BODY;
+            break;
+        }
+
+        case state_e::EPILOGUE:
+            i = len;
+            break;
+        }
+    }
+}
+
+/**
+ * Checks that the whole body has been received.
+ *
+ * @throws multipart_error if the final boundary is missing.
+ */
+void multipart_parser_t::finish() const
+{
+    if (m_state != state_e::EPILOGUE) {
+        throw multipart_error("Multipart body is incomplete");
+    }
+}
+
+/**
+ * Looks for the delimiter. Content of parts is passed to the data handler.
+ *
+ * @return Amount of bytes consumed. The state is changed when the delimiter
+ *         has been found.
+ */
+std::size_t multipart_parser_t::scan(const char *data, std::size_t len)
+{
+    const bool body = m_state == state_e::BODY;
+    std::size_t i = 0;
+    while (i < len) {
+        if (m_match == 0) {
+            // Skip everything which cannot start the delimiter.
+            const void *cr = std::memchr(data + i, '\r', len - i);
+            std::size_t stop = cr != nullptr
+                    ? static_cast<const char*>(cr) - data : len;
+            if (body && stop > i && m_handlers.data) {
+                m_handlers.data(data + i, stop - i);
+            }
+            i = stop;
+            if (cr == nullptr) {
+                break;
+            }
+        }
+        if (data[i] == m_delimiter[m_match]) {
+            ++i;
+            if (++m_match == m_delimiter.size()) {
+                m_match = 0;
+                if (body && m_handlers.end) {
+                    m_handlers.end();
+                }
+                m_state = state_e::DELIMITER;
+                m_tail.clear();
+                return i;
+            }
+        } else {
+            // Boundaries do not contain CR, so the delimiter cannot start
+            // within the bytes matched so far.
+            if (body && m_handlers.data) {
+                m_handlers.data(m_delimiter.data(), m_match);
+            }
+            m_match = 0;
+        }
+    }
+    return i;
+}
+
+void multipart_parser_t::parse_headers()
+{
+    part_t part;
+    std::size_t pos = 2;
+    while (pos < m_headers.size()) {
+        std::size_t eol = m_headers.find("\r\n", pos);
+        std::string line = m_headers.substr(pos, eol - pos);
+        pos = eol + 2;
+
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            throw multipart_error("Invalid header in multipart body");
+        }
+        std::size_t begin = colon + 1;
+        while (begin < line.size() && is_space(line[begin]))
+            ++begin;
+        std::string value = line.substr(begin);
+        line.resize(colon);
+
+        if (strcasecmp(line.c_str(), "Content-Disposition") == 0) {
+            part.name = parameter(value, "name");
+            part.filename = parameter(value, "filename");
+        } else if (strcasecmp(line.c_str(), "Content-Type") == 0) {
+            part.content_type = std::move(value);
+        }
+    }
+    if (m_handlers.begin) {
+        m_handlers.begin(part);
+    }
+}
@@ -0,0 +1,303 @@
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <memory>
+
+#include <errorhandling.hpp>
+#include <logging.hpp>
+#include <requesttrace.hpp>
+
+
+LOG_MODULE("RequestTrace")
+
+
+constexpr std::chrono::seconds trace_writer_t::flush_interval;
+
+static const char magic[] = "XLTSTRC1";
+static constexpr std::size_t magic_size = sizeof(magic) - 1;
+
+//! Methods stored as a single byte. Other methods follow the byte `0xff`.
+static const char *const methods[] = {
+    MHD_HTTP_METHOD_GET, MHD_HTTP_METHOD_HEAD, MHD_HTTP_METHOD_POST,
+    MHD_HTTP_METHOD_PUT, MHD_HTTP_METHOD_DELETE, MHD_HTTP_METHOD_OPTIONS
+};
+static constexpr std::size_t method_count =
+        sizeof(methods) / sizeof(methods[0]);
+static constexpr unsigned char other_method = 0xff;
+
+
+static std::FILE *open_file(const std::string &path, const char *mode)
+{
+    std::FILE *file = std::fopen(path.c_str(), mode);
+    if (file == nullptr) {
+        THROW(os_file_error("Cannot open trace file"))
+                << errinfo::function("fopen") << errinfo::errnum(errno)
+                << errinfo::filename(path);
+    }
+    return file;
+}
+
+static void put_varint(std::string &out, std::uint64_t value)
+{
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static void put_string(std::string &out, const std::string &str)
+{
+    put_varint(out, str.size());
+    out += str;
+}
+
+/**
+ * Appends @p str percent-encoded to @p out. Unreserved characters and those
+ * in @p keep are copied as they are.
+ */
+static void put_encoded(std::string &out, const char *str, const char *keep)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    for (; *str != '\0'; ++str) {
+        const unsigned char c = static_cast<unsigned char>(*str);
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                || (c >= '0' && c <= '9') || std::strchr("-._~", c)
+                || std::strchr(keep, c)) {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 0xf];
+        }
+    }
+}
+
+/**
+ * Appends @p str percent-encoded to @p out, so it can be used in a query.
+ */
+static void put_query_component(std::string &out, const char *str)
+{
+    put_encoded(out, str, "");
+}
+
+static int append_argument(void *cls, MHD_ValueKind, const char *key,
+                           const char *value)
+{
+    std::string &target = *static_cast<std::string*>(cls);
+    target += target.find('?') == std::string::npos ? '?' : '&';
+    put_query_component(target, key);
+    if (value != nullptr) {
+        target += '=';
+        put_query_component(target, value);
+    }
+    return MHD_YES;
+}
+
+
+/**
+ * Creates or truncates the trace file at @p path. Times are recorded
+ * relative to the construction.
+ *
+ * @throws os_file_error if the file cannot be opened.
+ */
+trace_writer_t::trace_writer_t(const std::string &path,
+                               eventloop_t *eventloop)
+    : m_file(open_file(path, "wb"))
+    , m_eventloop(eventloop)
+    , m_start(std::chrono::steady_clock::now())
+    , m_self(std::make_shared<trace_writer_t*>(this))
+{
+    // Records are small, so write them in large blocks.
+    std::setvbuf(m_file, nullptr, _IOFBF, 1 << 16);
+    if (std::fwrite(magic, 1, magic_size, m_file) != magic_size) {
+        std::fclose(m_file);
+        OSERROR(fwrite, "Cannot write trace file") << errinfo::filename(path);
+    }
+    if (m_eventloop != nullptr) {
+        schedule_flush();
+    }
+}
+
+trace_writer_t::~trace_writer_t() noexcept
+{
+    if (std::fclose(m_file) != 0) {
+        LOG_WARN() << "Error occurred while closing trace file: "
+                   << strerror(errno);
+    }
+}
+
+/**
+ * Records a new request. Called by the {@link httpserver_t} before routing
+ * the request.
+ *
+ * @param url The decoded path of the request without query arguments.
+ *            It is encoded again, so the target can be replayed as is.
+ */
+void trace_writer_t::record(MHD_Connection *connection, const char *url,
+                            const char *method)
+{
+    trace_record_t record;
+    record.time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_start);
+    record.method = method;
+    put_encoded(record.target, url, "/");
+    MHD_get_connection_values(connection, MHD_GET_ARGUMENT_KIND,
+                              &append_argument, &record.target);
+    const char *range = MHD_lookup_connection_value(
+            connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_RANGE);
+    if (range != nullptr) {
+        record.range = range;
+    }
+    write(record);
+}
+
+/**
+ * Appends @p record to the trace. Records must be appended in the order of
+ * their time.
+ */
+void trace_writer_t::write(const trace_record_t &record)
+{
+    ASSERT(record.time >= m_last);
+    std::string out;
+    put_varint(out, static_cast<std::uint64_t>((record.time - m_last).count()));
+    m_last = record.time;
+
+    std::size_t code = 0;
+    while (code < method_count && record.method != methods[code]) {
+        ++code;
+    }
+    if (code < method_count) {
+        out += static_cast<char>(code);
+    } else {
+        out += static_cast<char>(other_method);
+        put_string(out, record.method);
+    }
+    put_string(out, record.target);
+    put_string(out, record.range);
+
+    if (std::fwrite(out.data(), 1, out.size(), m_file) != out.size()) {
+        OSERROR(fwrite, "Cannot write trace file");
+    }
+    m_dirty = true;
+}
+
+/**
+ * Writes all buffered records to the file.
+ */
+void trace_writer_t::flush()
+{
+    m_dirty = false;
+    if (std::fflush(m_file) != 0) {
+        OSERROR(fflush, "Cannot write trace file");
+    }
+}
+
+void trace_writer_t::schedule_flush()
+{
+    std::weak_ptr<trace_writer_t*> self = m_self;
+    m_eventloop->call([self] {
+        auto writer = self.lock();
+        if (!writer) {
+            return;
+        }
+        if ((*writer)->m_dirty) {
+            try {
+                (*writer)->flush();
+            } catch (const std::exception &e) {
+                LOG_WARN() << "Cannot flush trace file: " << e.what();
+            }
+        }
+        (*writer)->schedule_flush();
+    }, flush_interval);
+}
+
+
+/**
+ * Opens the trace file at @p path.
+ *
+ * @throws os_file_error if the file cannot be opened.
+ * @throws trace_error if the file is no trace file.
+ */
+trace_reader_t::trace_reader_t(const std::string &path)
+    : m_file(open_file(path, "rb"))
+{
+    char header[magic_size];
+    if (std::fread(header, 1, magic_size, m_file) != magic_size
+            || std::memcmp(header, magic, magic_size) != 0) {
+        std::fclose(m_file);
+        throw trace_error("Not a trace file");
+    }
+}
+
+trace_reader_t::~trace_reader_t() noexcept
+{
+    std::fclose(m_file);
+}
+
+/**
+ * Reads the next record.
+ *
+ * @return `false` at the end of the file.
+ * @throws trace_error if the file is truncated or malformed.
+ */
+bool trace_reader_t::next(trace_record_t &record)
+{
+    std::uint64_t delta;
+    if (!read_varint(delta)) {
+        return false;
+    }
+    m_time += std::chrono::microseconds(delta);
+    record.time = m_time;
+
+    const int code = std::fgetc(m_file);
+    if (code == EOF) {
+        throw trace_error("Truncated trace file");
+    } else if (static_cast<std::size_t>(code) < method_count) {
+        record.method = methods[code];
+    } else if (code == other_method) {
+        record.method = read_string();
+    } else {
+        throw trace_error("Unknown method in trace file");
+    }
+    record.target = read_string();
+    record.range = read_string();
+    return true;
+}
+
+/**
+ * Reads a varint.
+ *
+ * @return `false` if the file ends before the first byte.
+ */
+bool trace_reader_t::read_varint(std::uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int byte = std::fgetc(m_file);
+        if (byte == EOF) {
+            if (shift == 0) {
+                return false;
+            }
+            throw trace_error("Truncated trace file");
+        }
+        value |= std::uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    throw trace_error("Malformed number in trace file");
+}
+
+std::string trace_reader_t::read_string()
+{
+    std::uint64_t size;
+    if (!read_varint(size) || size > (1 << 20)) {
+        throw trace_error("Malformed string in trace file");
+    }
+    std::string str(static_cast<std::size_t>(size), '\0');
+    if (std::fread(&str[0], 1, str.size(), m_file) != str.size()) {
+        throw trace_error("Truncated trace file");
+    }
+    return str;
+}
@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <microhttpd.h>
+
+#include <bufferchain.hpp>
+#include <errorhandling.hpp>
+#include <responsecache.hpp>
+#include <responseformat.hpp>
+
+
+//! Bodies smaller than this are not compressed.
+static constexpr std::size_t min_compress_size = 256;
+//! Estimated overhead of an entry in bytes, added to the size of the bodies.
+static constexpr std::size_t entry_overhead = 512;
+
+
+struct response_cache_t::entry_t {
+    ~entry_t() {
+        for (std::size_t i = 0; i < content_coding_count; ++i) {
+            if (ok[i] != nullptr)
+                MHD_destroy_response(ok[i]);
+            if (not_modified[i] != nullptr)
+                MHD_destroy_response(not_modified[i]);
+        }
+    }
+
+    std::string key;
+    std::vector<std::string> tags;
+    //! Hash of the uncompressed body, base of all ETags.
+    std::string hash;
+    //! Responses by content coding. `nullptr` if not worth it.
+    std::array<MHD_Response*, content_coding_count> ok = {};
+    //! Responses for `304 Not Modified` by content coding.
+    std::array<MHD_Response*, content_coding_count> not_modified = {};
+    std::size_t memory = entry_overhead;
+};
+
+
+/**
+ * Returns the FNV-1a hash of @p size bytes at @p data as hexadecimal string.
+ */
+static std::string hash_body(const char *data, std::size_t size)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx",
+                  static_cast<unsigned long long>(hash));
+    return buf;
+}
+
+static std::string make_etag(const std::string &hash, content_coding_e coding)
+{
+    // Strong ETags have to differ between content codings.
+    const char *token = to_token(coding);
+    return token == nullptr ? '"' + hash + '"'
+                            : '"' + hash + '-' + token + '"';
+}
+
+/**
+ * Returns whether the value of `If-None-Match` matches any representation of a
+ * body with the given hash. The value is a comma separated list of ETags, e.g.
+ * `"0123-gzip", W/"4567"`, or a single `*`.
+ */
+static bool etag_matches(const char *if_none_match, const std::string &hash)
+{
+    if (if_none_match == nullptr) {
+        return false;
+    }
+    const char *p = if_none_match;
+    while (*p != '\0') {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            ++p;
+        }
+        const char *end = std::strchr(p, ',');
+        if (end == nullptr) {
+            end = p + std::strlen(p);
+        }
+        const char *last = end;
+        while (last > p && (last[-1] == ' ' || last[-1] == '\t')) {
+            --last;
+        }
+        const std::size_t size = static_cast<std::size_t>(last - p);
+
+        if (size == 1 && *p == '*') {
+            return true;
+        }
+        // Weak comparison is used for If-None-Match.
+        const char *tag = size >= 2 && std::strncmp(p, "W/", 2) == 0 ? p + 2
+                                                                     : p;
+        const std::size_t tag_size = static_cast<std::size_t>(last - tag);
+        if (tag_size >= hash.size() + 2 && tag[0] == '"'
+                && last[-1] == '"'
+                && std::strncmp(tag + 1, hash.data(), hash.size()) == 0
+                && (tag_size == hash.size() + 2
+                    || tag[hash.size() + 1] == '-')) {
+            return true;
+        }
+        p = end;
+    }
+    return false;
+}
+
+static int collect_argument(void *cls, MHD_ValueKind kind, const char *key,
+                            const char *value) noexcept
+{
+    auto *args = static_cast<std::vector<std::pair<std::string,
+                                                   std::string>>*>(cls);
+    args->emplace_back(key, value != nullptr ? value : "");
+    return MHD_YES;
+}
+
+
+/**
+ * Registers the cache at @p server.
+ *
+ * @param budget Maximal size of all entries in bytes.
+ */
+response_cache_t::response_cache_t(httpserver_t *server, std::size_t budget)
+    : m_server(server), m_budget(budget)
+{
+    m_server->set_response_cache(this);
+    m_server->add_route(MHD_HTTP_METHOD_GET, "cache",
+                        [this](MHD_Connection *) {
+                            return [this](MHD_Connection *connection,
+                                          const char *, std::size_t *) {
+                                write_stats(connection);
+                            };
+                        });
+}
+
+response_cache_t::~response_cache_t() noexcept
+{
+    m_server->set_response_cache(nullptr);
+}
+
+/**
+ * Returns the key of a request: @p path followed by the query arguments sorted
+ * by name, e.g. `torrents?since=3`. Requests negotiating CBOR (see
+ * request_format()) get the suffix `#cbor`, e.g. `torrents?since=3#cbor`.
+ */
+std::string response_cache_t::request_key(MHD_Connection *connection,
+                                          const char *path)
+{
+    std::vector<std::pair<std::string, std::string>> args;
+    MHD_get_connection_values(connection, MHD_GET_ARGUMENT_KIND,
+                              &collect_argument, &args);
+    std::sort(args.begin(), args.end());
+
+    std::string key = path;
+    char separator = '?';
+    for (const auto &arg : args) {
+        key.append(1, separator).append(arg.first)
+           .append(1, '=').append(arg.second);
+        separator = '&';
+    }
+    if (request_format(connection) == response_format_e::CBOR) {
+        key.append("#cbor");
+    }
+    return key;
+}
+
+/**
+ * Queues the cached response for @p key.
+ *
+ * @return Whether the key has been found.
+ */
+bool response_cache_t::lookup(MHD_Connection *connection,
+                              const std::string &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    // Move to the front of the LRU list.
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    ++m_stats.hits;
+    queue(connection, **it->second);
+    return true;
+}
+
+/**
+ * Builds all representations of @p body, queues the best one for @p connection
+ * and stores them if @p cacheable is set. The body is copied once into the
+ * buffer which libmicrohttpd sends uncompressed responses from.
+ *
+ * @param tags Tags of the entry. Used by invalidate().
+ */
+void response_cache_t::respond(MHD_Connection *connection,
+                               const std::string &key,
+                               buffer_chain_t &&body,
+                               const char *content_type,
+                               const std::vector<std::string> &tags,
+                               bool cacheable)
+{
+    ++m_stats.misses;
+    std::unique_ptr<entry_t> entry = build(key, std::move(body),
+                                           content_type, tags);
+    queue(connection, *entry);
+    if (!cacheable || entry->memory > m_budget) {
+        return;
+    }
+
+    erase(key);
+    for (const std::string &tag : entry->tags) {
+        m_tags[tag].insert(key);
+    }
+    m_stats.memory += entry->memory;
+    ++m_stats.entries;
+    m_lru.push_front(std::move(entry));
+    m_entries[key] = m_lru.begin();
+    evict();
+}
+
+/**
+ * Drops all entries with tag @p tag.
+ */
+void response_cache_t::invalidate(const std::string &tag)
+{
+    auto it = m_tags.find(tag);
+    if (it == m_tags.end()) {
+        return;
+    }
+    const std::set<std::string> keys = std::move(it->second);
+    m_tags.erase(it);
+    for (const std::string &key : keys) {
+        erase(key);
+        ++m_stats.invalidations;
+    }
+}
+
+/**
+ * Changes the maximal size of all entries to @p budget bytes. Evicts the least
+ * recently used entries if they exceed the new budget.
+ */
+void response_cache_t::set_budget(std::size_t budget) noexcept
+{
+    m_budget = budget;
+    evict();
+}
+
+void response_cache_t::clear() noexcept
+{
+    m_entries.clear();
+    m_tags.clear();
+    m_lru.clear();
+    m_stats.entries = 0;
+    m_stats.memory = 0;
+}
+
+void response_cache_t::evict() noexcept
+{
+    while (m_stats.memory > m_budget) {
+        erase(m_lru.back()->key);
+        ++m_stats.evictions;
+    }
+}
+
+std::unique_ptr<response_cache_t::entry_t> response_cache_t::build(
+        const std::string &key, buffer_chain_t &&body,
+        const char *content_type, const std::vector<std::string> &tags)
+{
+    // Owned by the uncompressed response once it has been created, which
+    // frees it by free().
+    const std::size_t size = body.size();
+    std::unique_ptr<char, void(*)(void*)> data(
+            static_cast<char*>(std::malloc(std::max<std::size_t>(size, 1))),
+            &std::free);
+    if (!data) {
+        throw std::bad_alloc();
+    }
+    body.read(data.get(), size);
+    const char *bytes = data.get();
+
+    std::unique_ptr<entry_t> entry(new entry_t);
+    entry->key = key;
+    entry->tags = tags;
+    entry->hash = hash_body(bytes, size);
+    entry->memory += key.size() + size;
+
+    for (std::size_t i = 0; i < content_coding_count; ++i) {
+        const content_coding_e coding = static_cast<content_coding_e>(i);
+        MHD_Response *r;
+        if (coding == content_coding_e::IDENTITY) {
+            r = OSCHECK(MHD_create_response_from_buffer,(
+                    size, data.get(), MHD_RESPMEM_MUST_FREE), != nullptr);
+            data.release();
+        } else {
+            if (size < min_compress_size) {
+                continue;
+            }
+            const std::string compressed = compress(bytes, size, coding);
+            // Keep compressed bodies only if they save at least 10%.
+            if (compressed.empty() || compressed.size() > size / 10 * 9) {
+                continue;
+            }
+            entry->memory += compressed.size();
+            r = OSCHECK(MHD_create_response_from_buffer,(
+                    compressed.size(), const_cast<char*>(compressed.data()),
+                    MHD_RESPMEM_MUST_COPY), != nullptr);
+        }
+        entry->ok[i] = r;
+        const std::string etag = make_etag(entry->hash, coding);
+        OSCHECK(MHD_add_response_header,(r, "Content-type", content_type),
+                != MHD_NO);
+        OSCHECK(MHD_add_response_header,(r, "ETag", etag.c_str()), != MHD_NO);
+        OSCHECK(MHD_add_response_header,(r, "Vary",
+                                         "Accept, Accept-Encoding"),
+                != MHD_NO);
+        if (to_token(coding) != nullptr) {
+            OSCHECK(MHD_add_response_header,(r, "Content-Encoding",
+                                             to_token(coding)), != MHD_NO);
+        }
+
+        r = OSCHECK(MHD_create_response_from_buffer,(
+                0, nullptr, MHD_RESPMEM_PERSISTENT), != nullptr);
+        entry->not_modified[i] = r;
+        OSCHECK(MHD_add_response_header,(r, "ETag", etag.c_str()), != MHD_NO);
+        OSCHECK(MHD_add_response_header,(r, "Vary",
+                                         "Accept, Accept-Encoding"),
+                != MHD_NO);
+    }
+    return entry;
+}
+
+/**
+ * Queues the best representation of @p entry which the client accepts.
+ */
+void response_cache_t::queue(MHD_Connection *connection, const entry_t &entry)
+{
+    const char *accept_encoding = MHD_lookup_connection_value(
+            connection, MHD_HEADER_KIND, "Accept-Encoding");
+    std::size_t best = static_cast<std::size_t>(content_coding_e::IDENTITY);
+    for (content_coding_e coding : {content_coding_e::BROTLI,
+                                    content_coding_e::GZIP}) {
+        const std::size_t i = static_cast<std::size_t>(coding);
+        if (entry.ok[i] != nullptr && accepts_coding(accept_encoding, coding)) {
+            best = i;
+            break;
+        }
+    }
+
+    const char *if_none_match = MHD_lookup_connection_value(
+            connection, MHD_HEADER_KIND, "If-None-Match");
+    if (etag_matches(if_none_match, entry.hash)) {
+        ++m_stats.not_modified;
+        OSCHECK(MHD_queue_response,(connection, MHD_HTTP_NOT_MODIFIED,
+                                    entry.not_modified[best]), == MHD_YES);
+    } else {
+        OSCHECK(MHD_queue_response,(connection, MHD_HTTP_OK, entry.ok[best]),
+                == MHD_YES);
+    }
+}
+
+void response_cache_t::erase(const std::string &key) noexcept
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+    const lru_t::iterator entry = it->second;
+    for (const std::string &tag : (*entry)->tags) {
+        auto tag_it = m_tags.find(tag);
+        if (tag_it != m_tags.end()) {
+            tag_it->second.erase(key);
+            if (tag_it->second.empty())
+                m_tags.erase(tag_it);
+        }
+    }
+    m_stats.memory -= (*entry)->memory;
+    --m_stats.entries;
+    m_entries.erase(it);
+    m_lru.erase(entry);
+}
+
+void response_cache_t::write_stats(MHD_Connection *connection)
+{
+    const std::uint64_t requests = m_stats.hits + m_stats.misses;
+    const response_format_e format = request_format(connection);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &out) {
+        out.begin_object()
+            .key("entries").value(m_stats.entries)
+            .key("memory").value(m_stats.memory)
+            .key("budget").value(m_budget)
+            .key("hits").value(static_cast<unsigned long long>(m_stats.hits))
+            .key("not_modified").value(
+                    static_cast<unsigned long long>(m_stats.not_modified))
+            .key("misses").value(
+                    static_cast<unsigned long long>(m_stats.misses))
+            .key("evictions").value(
+                    static_cast<unsigned long long>(m_stats.evictions))
+            .key("invalidations").value(
+                    static_cast<unsigned long long>(m_stats.invalidations))
+            .key("hit_ratio").value(requests == 0 ? 0.0
+                    : static_cast<double>(m_stats.hits) / requests)
+            .end_object();
+    });
+
+    MHD_Response *r = create_buffer_response(std::move(chain),
+                                             to_media_type(format));
+    std::unique_ptr<MHD_Response, void(*)(MHD_Response*)> guard(
+            r, &MHD_destroy_response);
+    OSCHECK(MHD_queue_response,(connection, MHD_HTTP_OK, r), == MHD_YES);
+}
@@ -0,0 +1,68 @@
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include <strings.h>
+
+#include <responseformat.hpp>
+
+
+const char *to_media_type(response_format_e format) noexcept
+{
+    switch (format) {
+    case response_format_e::JSON:
+        return "application/json";
+    case response_format_e::CBOR:
+        return "application/cbor";
+    }
+    return "application/json";
+}
+
+response_format_e negotiate_format(const char *accept) noexcept
+{
+    if (accept == nullptr) {
+        return response_format_e::JSON;
+    }
+
+    double cbor_q = -1, json_q = -1;
+    const char *p = accept;
+    while (*p != '\0') {
+        // Parse `type/subtype [; q=value]` up to the next comma.
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            ++p;
+        }
+        const char *begin = p;
+        while (*p != '\0' && *p != ',' && *p != ';' && *p != ' ') {
+            ++p;
+        }
+        const std::size_t len = p - begin;
+
+        double q = 1;
+        while (*p != '\0' && *p != ',') {
+            if (*p == 'q' && p[1] == '=') {
+                q = std::strtod(p + 2, nullptr);
+            }
+            ++p;
+        }
+        if (len == 16 && strncasecmp(begin, "application/cbor", len) == 0) {
+            cbor_q = q;
+        } else if (len == 16
+                   && strncasecmp(begin, "application/json", len) == 0) {
+            json_q = q;
+        }
+    }
+    return cbor_q > 0 && cbor_q >= json_q ? response_format_e::CBOR
+                                          : response_format_e::JSON;
+}
+
+void queue_error_response(MHD_Connection *connection, unsigned int status,
+                          const char *message)
+{
+    const response_format_e format = request_format(connection);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &out) {
+        out.begin_object().key("msg").value(message).end_object();
+    });
+    queue_buffer_response(connection, status, std::move(chain),
+                          to_media_type(format));
+}
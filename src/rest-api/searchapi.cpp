@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include <bufferchain.hpp>
+#include <responseformat.hpp>
+#include <searchapi.hpp>
+
+
+static std::size_t parse_limit(MHD_Connection *connection)
+{
+    const char *arg = MHD_lookup_connection_value(
+            connection, MHD_GET_ARGUMENT_KIND, "limit");
+    if (arg == nullptr || *arg < '0' || *arg > '9') {
+        return 50;
+    }
+    char *end;
+    errno = 0;
+    unsigned long long limit = std::strtoull(arg, &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return 50;
+    }
+    return static_cast<std::size_t>(
+            std::min<unsigned long long>(limit, search_api_t::max_limit));
+}
+
+
+search_api_t::search_api_t(httpserver_t *server,
+                           const file_search_index_t *index)
+    : m_server(server), m_index(index)
+{
+    m_server->add_route(MHD_HTTP_METHOD_GET, "search",
+                        [this](MHD_Connection *connection) {
+                            return route_search(connection);
+                        });
+}
+
+httpserver_t::access_handler_t search_api_t::route_search(MHD_Connection *)
+{
+    return [this](MHD_Connection *connection, const char *, std::size_t *) {
+        const char *arg = MHD_lookup_connection_value(
+                connection, MHD_GET_ARGUMENT_KIND, "q");
+        const std::string query = arg != nullptr ? arg : "";
+
+        if (!file_search_index_t::searchable(query)) {
+            queue_error_response(connection, MHD_HTTP_BAD_REQUEST,
+                                 "query is too short");
+            return;
+        }
+
+        const file_search_result_t result =
+                m_index->search(query, parse_limit(connection));
+        const response_format_e format = request_format(connection);
+        buffer_chain_t chain;
+        write_formatted(format, chain, [&](auto &out) {
+            out.begin_object()
+                .key("total")
+                    .value(static_cast<unsigned long long>(result.total))
+                .key("files").begin_array();
+            for (const file_match_t &file : result.files) {
+                out.begin_object()
+                    .key("infohash").binary(file.infohash.data(),
+                                            file.infohash.size())
+                    .key("file").value(file.file)
+                    .key("path").value(file.path)
+                    .end_object();
+            }
+            out.end_array().end_object();
+        });
+        queue_buffer_response(connection, MHD_HTTP_OK, std::move(chain),
+                              to_media_type(format));
+    };
+}
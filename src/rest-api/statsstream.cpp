@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <microhttpd.h>
+
+#include <bufferchain.hpp>
+#include <configuration.hpp>
+#include <jsonwriter.hpp>
+#include <statsstream.hpp>
+
+
+stats_stream_t::stats_stream_t(eventloop_t *eventloop, httpserver_t *server,
+                               torrent_status_store_t *store)
+    : m_eventloop(eventloop)
+    , m_store(store)
+    , m_stream(server)
+    , m_version(store->version())
+    , m_self(std::make_shared<stats_stream_t*>(this))
+{
+    server->add_route(MHD_HTTP_METHOD_GET, "events",
+                      [this](MHD_Connection *connection) {
+                          return m_stream.subscribe(connection, snapshot());
+                      });
+    schedule_tick();
+}
+
+void stats_stream_t::schedule_tick()
+{
+    std::weak_ptr<stats_stream_t*> self = m_self;
+    m_eventloop->call([self] {
+        if (auto stream = self.lock())
+            (*stream)->tick();
+    }, std::chrono::milliseconds(current_config()->httpd.stats_interval));
+}
+
+void stats_stream_t::tick()
+{
+    schedule_tick();
+
+    const std::uint64_t version = m_store->version();
+    if (m_stream.subscribers() == 0 || version == m_version) {
+        // Nobody is listening or nothing has changed.
+        m_version = version;
+        return;
+    }
+
+    if (m_version < m_store->horizon()) {
+        // Removals have been pruned before they have been published.
+        m_stream.publish(snapshot());
+    } else {
+        m_stream.publish(serialize(m_store->changes(m_version), false));
+    }
+    m_version = version;
+}
+
+/**
+ * Returns an event listing all torrents, sent to new subscribers before the
+ * changes. It is only serialized again after the store has changed.
+ */
+const std::string &stats_stream_t::snapshot()
+{
+    const std::uint64_t version = m_store->version();
+    if (m_snapshot.empty() || m_snapshot_version != version) {
+        m_snapshot = serialize(m_store->entries(), true);
+        m_snapshot_version = version;
+    }
+    return m_snapshot;
+}
+
+/**
+ * Serializes an event with the sums over all torrents and the status of the
+ * given @p torrents.
+ *
+ * @param full Whether @p torrents are all torrents. Otherwise, removed
+ *             torrents among them are listed as `removed`.
+ */
+std::string stats_stream_t::serialize(
+        const std::vector<const torrent_status_store_t::entry_t*> &torrents,
+        bool full)
+{
+    // Sum up all torrents. This is done once per event, not per client.
+    long long download_rate = 0, upload_rate = 0, peers = 0;
+    for (const auto *entry : m_store->entries()) {
+        download_rate += entry->status.download_rate;
+        upload_rate   += entry->status.upload_rate;
+        peers         += entry->status.num_peers;
+    }
+
+    buffer_chain_t chain;
+    json_writer_t json(chain);
+    json.begin_object()
+        .key("version").value(
+                static_cast<unsigned long long>(m_store->version()))
+        .key("download_rate").value(download_rate)
+        .key("upload_rate").value(upload_rate)
+        .key("peers").value(peers)
+        .key("full").value(full)
+        .key("torrents").begin_array();
+    for (const auto *entry : torrents) {
+        if (entry->removed) {
+            continue;
+        }
+        const torrent_status_t &status = entry->status;
+        json.begin_object()
+            .key("infohash").binary(status.infohash.data(),
+                                    status.infohash.size())
+            .key("progress").value(static_cast<double>(status.progress))
+            .key("download_rate").value(status.download_rate)
+            .key("upload_rate").value(status.upload_rate)
+            .key("peers").value(status.num_peers)
+            .end_object();
+    }
+    json.end_array();
+    if (!full) {
+        json.key("removed").begin_array();
+        for (const auto *entry : torrents) {
+            if (entry->removed) {
+                json.binary(entry->status.infohash.data(),
+                            entry->status.infohash.size());
+            }
+        }
+        json.end_array();
+    }
+    json.end_object();
+    return chain.str();
+}
@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include <microhttpd.h>
+
+#include <bufferchain.hpp>
+#include <configuration.hpp>
+#include <errorhandling.hpp>
+#include <responseformat.hpp>
+#include <torrentsapi.hpp>
+
+
+/**
+ * State of a single request to `GET /torrents`.
+ */
+struct torrents_api_t::poll_t {
+    ~poll_t() {
+        if (listening) {
+            store->remove_listener(listener);
+        }
+    }
+
+    // Stop waiting and let the access handler respond.
+    void wake() {
+        if (listening) {
+            store->remove_listener(listener);
+            listening = false;
+        }
+        server->resume(connection);
+    }
+
+    httpserver_t *server;
+    torrent_status_store_t *store;
+    MHD_Connection *connection;
+    //! Version passed by the client. Zero if a full list is requested.
+    std::uint64_t since;
+    bool parked = false;
+    bool listening = false;
+    torrent_status_store_t::listener_handle_t listener = 0;
+};
+
+
+//! Maximal amount of torrents of a page.
+static constexpr std::size_t max_page_size = 500;
+
+
+template<typename writer_t>
+static void write_torrent(writer_t &out, const torrent_status_t &status)
+{
+    out.begin_object()
+        .key("infohash").binary(status.infohash.data(), status.infohash.size())
+        .key("name").value(status.name)
+        .key("state").value(to_string(status.state))
+        .key("progress").value(static_cast<double>(status.progress))
+        .key("download_rate").value(status.download_rate)
+        .key("upload_rate").value(status.upload_rate)
+        .key("peers").value(status.num_peers)
+        .key("seeds").value(status.num_seeds)
+        .key("total_done").value(static_cast<long long>(status.total_done))
+        .key("total_wanted").value(static_cast<long long>(status.total_wanted))
+        .key("added").value(static_cast<long long>(status.added_time))
+        .key("ratio").value(static_cast<double>(status.ratio))
+        .end_object();
+}
+
+static bool parse_number(const char *arg, std::uint64_t &number)
+{
+    if (arg == nullptr || *arg < '0' || *arg > '9') {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    unsigned long long result = std::strtoull(arg, &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return false;
+    }
+    number = result;
+    return true;
+}
+
+/**
+ * Parses the argument `since`.
+ *
+ * @return The version or zero if the argument is missing or invalid.
+ */
+static std::uint64_t parse_since(MHD_Connection *connection)
+{
+    std::uint64_t since = 0;
+    parse_number(MHD_lookup_connection_value(
+            connection, MHD_GET_ARGUMENT_KIND, "since"), since);
+    return since;
+}
+
+/**
+ * Parses the arguments `state`, `sort`, `offset` and `limit`.
+ *
+ * @param paged Set if any of the arguments is present.
+ * @return Whether all present arguments are valid.
+ */
+static bool parse_query(MHD_Connection *connection, torrent_query_t &query,
+                        bool &paged)
+{
+    static const struct {
+        const char *name;
+        torrent_sort_e sort;
+    } sort_keys[] = {
+        {"name",     torrent_sort_e::NAME},
+        {"size",     torrent_sort_e::SIZE},
+        {"progress", torrent_sort_e::PROGRESS},
+        {"added",    torrent_sort_e::ADDED},
+        {"ratio",    torrent_sort_e::RATIO}
+    };
+    auto lookup = [connection](const char *key) {
+        return MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND,
+                                           key);
+    };
+
+    const char *state = lookup("state");
+    const char *sort = lookup("sort");
+    const char *offset = lookup("offset");
+    const char *limit = lookup("limit");
+    paged = state != nullptr || sort != nullptr || offset != nullptr
+            || limit != nullptr;
+
+    if (state != nullptr) {
+        query.filter_state = false;
+        for (int i = static_cast<int>(torrent_state_e::CHECKING_FILES);
+             i <= static_cast<int>(torrent_state_e::CHECKING_RESUME_DATA);
+             ++i) {
+            if (std::strcmp(state, to_string(torrent_state_e(i))) == 0) {
+                query.filter_state = true;
+                query.state = torrent_state_e(i);
+            }
+        }
+        if (!query.filter_state) {
+            return false;
+        }
+    }
+    if (sort != nullptr) {
+        query.descending = *sort == '-';
+        sort += query.descending ? 1 : 0;
+        auto it = std::find_if(std::begin(sort_keys), std::end(sort_keys),
+                               [sort](const auto &key) {
+                                   return std::strcmp(key.name, sort) == 0;
+                               });
+        if (it == std::end(sort_keys)) {
+            return false;
+        }
+        query.sort = it->sort;
+    }
+    std::uint64_t number;
+    if (offset != nullptr) {
+        if (!parse_number(offset, number)) {
+            return false;
+        }
+        query.offset = static_cast<std::size_t>(number);
+    }
+    if (limit != nullptr) {
+        if (!parse_number(limit, number)) {
+            return false;
+        }
+        query.limit = static_cast<std::size_t>(
+                std::min<std::uint64_t>(number, max_page_size));
+    }
+    return true;
+}
+
+
+torrents_api_t::torrents_api_t(eventloop_t *eventloop, httpserver_t *server,
+                               response_cache_t *cache,
+                               torrent_status_store_t *store,
+                               torrent_index_t *index)
+    : m_eventloop(eventloop), m_server(server), m_cache(cache), m_store(store)
+    , m_index(index)
+{
+    m_server->add_route(MHD_HTTP_METHOD_GET, "torrents",
+                        [this](MHD_Connection *connection) {
+                            return route_torrents(connection);
+                        });
+    m_listener = m_store->add_listener([this](std::uint64_t) {
+        m_cache->invalidate("torrents");
+    });
+}
+
+torrents_api_t::~torrents_api_t() noexcept
+{
+    m_store->remove_listener(m_listener);
+}
+
+httpserver_t::access_handler_t torrents_api_t::route_torrents(
+        MHD_Connection *connection)
+{
+    torrent_query_t query;
+    bool paged = false;
+    if (!parse_query(connection, query, paged)) {
+        return [](MHD_Connection *connection, const char *, std::size_t *) {
+            queue_error_response(connection, MHD_HTTP_BAD_REQUEST,
+                                 "invalid query");
+        };
+    }
+    if (paged) {
+        return [this, query](MHD_Connection *connection, const char *,
+                             std::size_t *) {
+            const std::string key =
+                    response_cache_t::request_key(connection, "torrents");
+            const response_format_e format = request_format(connection);
+            m_cache->respond(connection, key, serialize(query, format),
+                             to_media_type(format), {"torrents"}, true);
+        };
+    }
+
+    auto poll = std::make_shared<poll_t>();
+    poll->server = m_server;
+    poll->store = m_store;
+    poll->connection = connection;
+    poll->since = parse_since(connection);
+    if (poll->since > m_store->version() || poll->since < m_store->horizon()) {
+        // Unknown version (e.g. from before a restart) or too old for a delta.
+        poll->since = 0;
+    }
+
+    return [this, poll](MHD_Connection *connection, const char *,
+                        std::size_t *) {
+        if (!poll->parked && poll->since != 0
+                && poll->since == m_store->version()
+                && current_config()->httpd.longpoll_timeout > 0) {
+            park(poll);
+            return;
+        }
+        // Woken clients may find the delta built for another one.
+        const std::string key =
+                response_cache_t::request_key(connection, "torrents");
+        if (m_cache->lookup(connection, key)) {
+            return;
+        }
+        // Empty deltas are not cached, requests for them have to wait.
+        const response_format_e format = request_format(connection);
+        m_cache->respond(connection, key, serialize(poll->since, format),
+                         to_media_type(format), {"torrents"},
+                         poll->since != m_store->version());
+    };
+}
+
+/**
+ * Suspends the connection until the store changes or the timeout expires.
+ */
+void torrents_api_t::park(const std::shared_ptr<poll_t> &poll)
+{
+    std::weak_ptr<poll_t> weak = poll;
+    poll->parked = true;
+    poll->listener = m_store->add_listener([weak](std::uint64_t) {
+        if (auto poll = weak.lock()) {
+            poll->wake();
+        }
+    });
+    poll->listening = true;
+    m_server->suspend(poll->connection, suspension_e::PARKED);
+
+    m_eventloop->call([weak] {
+        if (auto poll = weak.lock()) {
+            poll->wake();
+        }
+    }, std::chrono::seconds(current_config()->httpd.longpoll_timeout));
+}
+
+/**
+ * Returns the response for clients which know version @p since.
+ */
+buffer_chain_t torrents_api_t::serialize(std::uint64_t since,
+                                         response_format_e format)
+{
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &json) {
+        json.begin_object()
+            .key("version").value(static_cast<unsigned long long>(
+                    m_store->version()))
+            .key("full").value(since == 0)
+            .key("torrents").begin_array();
+        if (since == 0) {
+            for (const auto *entry : m_store->entries()) {
+                write_torrent(json, entry->status);
+            }
+            json.end_array();
+        } else {
+            const auto changes = m_store->changes(since);
+            for (const auto *entry : changes) {
+                if (!entry->removed) {
+                    write_torrent(json, entry->status);
+                }
+            }
+            json.end_array().key("removed").begin_array();
+            for (const auto *entry : changes) {
+                if (entry->removed) {
+                    json.binary(entry->status.infohash.data(),
+                                entry->status.infohash.size());
+                }
+            }
+            json.end_array();
+        }
+        json.end_object();
+    });
+    return chain;
+}
+
+/**
+ * Returns the page of torrents requested by @p query.
+ */
+buffer_chain_t torrents_api_t::serialize(const torrent_query_t &query,
+                                         response_format_e format)
+{
+    const torrent_page_t page = m_index->query(query);
+    buffer_chain_t chain;
+    write_formatted(format, chain, [&](auto &json) {
+        json.begin_object()
+            .key("version").value(static_cast<unsigned long long>(
+                    m_store->version()))
+            .key("total").value(static_cast<unsigned long long>(page.total))
+            .key("offset").value(static_cast<unsigned long long>(
+                    query.offset))
+            .key("torrents").begin_array();
+        for (const auto *entry : page.entries) {
+            write_torrent(json, entry->status);
+        }
+        json.end_array().end_object();
+    });
+    return chain;
+}
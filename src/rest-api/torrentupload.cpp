@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <bencode.hpp>
+#include <bufferchain.hpp>
+#include <errorhandling.hpp>
+#include <logging.hpp>
+#include <multipart.hpp>
+#include <responseformat.hpp>
+#include <torrentupload.hpp>
+
+LOG_MODULE("TorrentUpload")
+
+
+/**
+ * Thrown when the files of a request exceed the limit.
+ */
+class upload_too_large_error : public std::runtime_error
+{
+public:
+    upload_too_large_error()
+        : std::runtime_error("Torrent files are too large") {}
+};
+
+/**
+ * Disk operation recorded by the parser and executed by a job.
+ */
+struct upload_op_t {
+    enum kind_e {
+        OPEN,  //!< Create a temporary file for the next torrent.
+        WRITE, //!< Append data to the temporary file.
+        COMMIT //!< Rename the temporary file to its final name.
+    };
+
+    kind_e kind;
+    std::string data;
+    infohash_t infohash;
+};
+
+/**
+ * State of a single request to `POST /torrents`.
+ *
+ * Members below `ops` are owned by the job while `busy` is set.
+ */
+struct torrent_upload_t::upload_t {
+    ~upload_t() {
+        if (fd >= 0) {
+            close(fd);
+        }
+        for (const std::string &path : temporary) {
+            unlink(path.c_str());
+        }
+    }
+
+    MHD_Connection *connection;
+    std::unique_ptr<multipart_parser_t> parser;
+    //! Scanner of the current part if it is a file.
+    std::unique_ptr<bencode_scanner_t> scanner;
+    //! Bytes of torrent files received so far.
+    std::size_t received = 0;
+    bool started = false;
+    bool busy = false;
+    bool responded = false;
+    //! Status and message of the error response sent after the pending job.
+    unsigned int failure_status = 0;
+    std::string failure;
+
+    //! Operations for the next job.
+    std::vector<upload_op_t> ops;
+
+    int fd = -1;
+    std::string path;
+    //! Temporary files not renamed yet.
+    std::vector<std::string> temporary;
+    //! Infohashes of all committed files.
+    std::vector<infohash_t> added;
+    std::exception_ptr error;
+
+    void run(const std::string &directory,
+             const std::vector<upload_op_t> &ops);
+};
+
+
+
+/**
+ * Registers the route.
+ *
+ * @param eventloop Event loop of @p server.
+ * @param server    Server to register the route at.
+ * @param scheduler Scheduler used to write the files.
+ * @param directory Directory to save torrent files, usually `storage.torrents`.
+ * @param limit     Maximal amount of bytes of all files of a request.
+ */
+torrent_upload_t::torrent_upload_t(eventloop_t *eventloop,
+                                   httpserver_t *server,
+                                   disk_scheduler_t *scheduler,
+                                   const std::string &directory,
+                                   std::size_t limit)
+    : m_eventloop(eventloop)
+    , m_server(server)
+    , m_scheduler(scheduler)
+    , m_directory(directory)
+    , m_limit(limit)
+    , m_self(std::make_shared<torrent_upload_t*>(this))
+{
+    m_server->add_route(MHD_HTTP_METHOD_POST, "torrents",
+                        [this](MHD_Connection *connection) {
+                            return route_upload(connection);
+                        }, route_priority_e::HIGH);
+}
+
+httpserver_t::access_handler_t torrent_upload_t::route_upload(
+        MHD_Connection *connection)
+{
+    auto upload = std::make_shared<upload_t>();
+    upload->connection = connection;
+
+    return [this, upload](MHD_Connection *connection,
+                          const char *upload_data,
+                          std::size_t *upload_data_size) {
+        if (upload->responded) {
+            *upload_data_size = 0;
+            return;
+        }
+        if (upload->busy) {
+            return;
+        }
+        if (upload->error) {
+            std::rethrow_exception(upload->error);
+        }
+        if (upload->failure_status != 0) {
+            *upload_data_size = 0;
+            upload->responded = true;
+            queue_error_response(connection, upload->failure_status,
+                                 upload->failure.c_str());
+            return;
+        }
+
+        if (!upload->started) {
+            upload->started = true;
+            const std::string boundary = multipart_boundary(
+                    MHD_lookup_connection_value(connection, MHD_HEADER_KIND,
+                            MHD_HTTP_HEADER_CONTENT_TYPE));
+            if (boundary.empty()) {
+                upload->responded = true;
+                queue_error_response(connection,
+                                     MHD_HTTP_UNSUPPORTED_MEDIA_TYPE,
+                                     "expected multipart/form-data");
+                return;
+            }
+            upload_t *state = upload.get();
+            upload->parser.reset(new multipart_parser_t(boundary, {
+                [state](const multipart_parser_t::part_t &part) {
+                    if (part.filename.empty())
+                        return;
+                    state->scanner.reset(new bencode_scanner_t);
+                    state->ops.push_back({upload_op_t::OPEN, {}, {}});
+                },
+                [this, state](const char *data, std::size_t len) {
+                    if (!state->scanner)
+                        return;
+                    state->received += len;
+                    if (state->received > m_limit)
+                        throw upload_too_large_error();
+                    state->scanner->feed(data, len);
+                    if (state->ops.empty()
+                            || state->ops.back().kind != upload_op_t::WRITE)
+                        state->ops.push_back({upload_op_t::WRITE, {}, {}});
+                    state->ops.back().data.append(data, len);
+                },
+                [state] {
+                    if (!state->scanner)
+                        return;
+                    infohash_t infohash = state->scanner->infohash();
+                    state->scanner.reset();
+                    state->ops.push_back({upload_op_t::COMMIT, {}, infohash});
+                }
+            }));
+            // The first call comes before any data, not at the end of it.
+            return;
+        }
+
+        try {
+            if (*upload_data_size != 0) {
+                // Consumed even if it is rejected.
+                const std::size_t size = *upload_data_size;
+                *upload_data_size = 0;
+                upload->parser->feed(upload_data, size);
+                if (!upload->ops.empty()) {
+                    flush(upload);
+                }
+                return;
+            }
+            upload->parser->finish();
+        } catch (const upload_too_large_error &e) {
+            fail(upload, MHD_HTTP_REQUEST_ENTITY_TOO_LARGE, e.what());
+            return;
+        } catch (const multipart_error &e) {
+            fail(upload, MHD_HTTP_BAD_REQUEST, e.what());
+            return;
+        } catch (const bencode_error &e) {
+            fail(upload, MHD_HTTP_BAD_REQUEST, e.what());
+            return;
+        }
+
+        upload->responded = true;
+        if (upload->added.empty()) {
+            queue_error_response(connection, MHD_HTTP_BAD_REQUEST,
+                                 "no torrent file");
+            return;
+        }
+        const response_format_e format = request_format(connection);
+        buffer_chain_t chain;
+        write_formatted(format, chain, [&](auto &out) {
+            out.begin_object().key("torrents").begin_array();
+            for (const infohash_t &infohash : upload->added) {
+                out.binary(infohash.data(), infohash.size());
+            }
+            out.end_array().end_object();
+        });
+        LOG_INFO() << "Received " << upload->added.size() << " torrent files";
+        queue_buffer_response(connection, MHD_HTTP_CREATED, std::move(chain),
+                              to_media_type(format));
+    };
+}
+
+/**
+ * Rejects the request with @p status. Files completed before the failure
+ * are committed first, and the operations of the incomplete file are
+ * dropped. The response is sent once the job is done.
+ */
+void torrent_upload_t::fail(const std::shared_ptr<upload_t> &upload,
+                            unsigned int status, const char *message)
+{
+    std::vector<upload_op_t> &ops = upload->ops;
+    auto last_commit = std::find_if(ops.rbegin(), ops.rend(),
+                                    [](const upload_op_t &op) {
+                                        return op.kind == upload_op_t::COMMIT;
+                                    });
+    ops.erase(last_commit.base(), ops.end());
+    if (ops.empty()) {
+        upload->responded = true;
+        queue_error_response(upload->connection, status, message);
+        return;
+    }
+    upload->failure_status = status;
+    upload->failure = message;
+    flush(upload);
+}
+
+/**
+ * Suspends the connection and lets a job execute the recorded operations.
+ * The connection is resumed when the job is done.
+ */
+void torrent_upload_t::flush(const std::shared_ptr<upload_t> &upload)
+{
+    std::weak_ptr<torrent_upload_t*> self = m_self;
+    eventloop_t *eventloop = m_eventloop;
+    const std::string &directory = m_directory;
+    upload->busy = true;
+    m_server->suspend(upload->connection);
+    m_scheduler->submit(io_class_e::INTERACTIVE,
+            [upload, ops = std::move(upload->ops), self, eventloop,
+             directory] {
+        try {
+            upload->run(directory, ops);
+        } catch (...) {
+            upload->error = std::current_exception();
+        }
+        eventloop->call([upload, self] {
+            upload->busy = false;
+            if (auto uploader = self.lock()) {
+                (*uploader)->m_server->resume(upload->connection);
+            }
+        });
+    });
+    upload->ops.clear();
+}
+
+/**
+ * Runs the operations recorded by the parser. Called by a worker thread.
+ */
+void torrent_upload_t::upload_t::run(const std::string &directory,
+                                     const std::vector<upload_op_t> &ops)
+{
+    for (const upload_op_t &op : ops) {
+        switch (op.kind) {
+        case upload_op_t::OPEN: {
+            const std::string name = directory + "/.upload-XXXXXX";
+            temporary.push_back(name);
+            fd = mkostemp(&temporary.back()[0], O_CLOEXEC);
+            if (fd < 0) {
+                temporary.pop_back();
+                OSERROR(mkostemp, "Cannot create temporary torrent file")
+                        << errinfo::filename(name);
+            }
+            path = temporary.back();
+            break;
+        }
+        case upload_op_t::WRITE: {
+            const char *data = op.data.data();
+            std::size_t left = op.data.size();
+            while (left > 0) {
+                ssize_t ret = write(fd, data, left);
+                if (ret < 0 && errno != EINTR) {
+                    OSERROR(write, "Cannot write temporary torrent file")
+                            << errinfo::filename(path);
+                } else if (ret > 0) {
+                    data += ret;
+                    left -= ret;
+                }
+            }
+            break;
+        }
+        case upload_op_t::COMMIT: {
+            // The data has to be on disk before the rename is, or a crash
+            // could leave an empty torrent file.
+            if (fdatasync(fd) < 0) {
+                OSERROR(fdatasync, "Cannot write temporary torrent file")
+                        << errinfo::filename(path);
+            }
+            const int ret = close(fd);
+            fd = -1;
+            if (ret < 0) {
+                OSERROR(close, "Cannot write temporary torrent file")
+                        << errinfo::filename(path);
+            }
+            std::string target = directory + "/" + to_hex(op.infohash)
+                                 + ".torrent";
+            if (rename(path.c_str(), target.c_str()) < 0) {
+                OSERROR(rename, "Cannot rename temporary torrent file")
+                        << errinfo::filename(path);
+            }
+            temporary.pop_back();
+            added.push_back(op.infohash);
+            break;
+        }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sysexits.h>
+
+#include <boost/program_options.hpp>
+
+#include <errorhandling.hpp>
+#include <statusreader.hpp>
+
+namespace po = boost::program_options;
+
+
+static double kib(std::int64_t bytes)
+{
+    return static_cast<double>(bytes) / 1024;
+}
+
+static void print_snapshot(const status_snapshot_t &snapshot)
+{
+    const shm_summary_t &summary = snapshot.summary;
+    const std::int64_t now =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    if (summary.pid == 0) {
+        std::printf("Server has stopped.\n");
+    } else {
+        std::printf("Server %u, updated %.1f s ago\n", summary.pid,
+                    static_cast<double>(now - summary.updated) / 1000);
+    }
+    std::printf("Torrents: %u  Download: %.1f KiB/s  Upload: %.1f KiB/s  "
+                "Peers: %lld\n",
+                summary.total_torrents, kib(summary.download_rate),
+                kib(summary.upload_rate),
+                static_cast<long long>(summary.num_peers));
+    if (snapshot.torrents.empty()) {
+        return;
+    }
+    std::printf("%8s %12s %12s %6s  %s\n",
+                "Progress", "Down KiB/s", "Up KiB/s", "Peers", "Name");
+    for (const shm_torrent_t &torrent : snapshot.torrents) {
+        std::printf("%7.1f%% %12.1f %12.1f %6d  %s\n",
+                    torrent.progress * 100, kib(torrent.download_rate),
+                    kib(torrent.upload_rate), torrent.num_peers,
+                    torrent.name);
+    }
+}
+
+static int main0(int argc, char *argv[])
+{
+    std::string name;
+    unsigned int watch;
+
+    po::options_description desc(
+            "Prints the status a running lan-torrent-server publishes in "
+            "shared memory (httpd.status-shm).\n\nOptions");
+    desc.add_options()
+        ("help,h", "Print this help.")
+        ("name,n", po::value<std::string>(&name)
+                 ->default_value("lan-torrent-server"),
+                 "Name of the shared memory object.")
+        ("watch,w", po::value<unsigned int>(&watch)->default_value(0),
+                 "Print the status every given milliseconds. Zero prints "
+                 "it once.")
+        ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return EX_OK;
+    }
+
+    status_reader_t reader(name);
+    status_snapshot_t snapshot;
+    snapshot.torrents.reserve(shm_max_torrents);
+    while (true) {
+        if (!reader.read(snapshot)) {
+            std::cerr << "Status is being written for too long" << std::endl;
+            return EX_TEMPFAIL;
+        }
+        print_snapshot(snapshot);
+        if (watch == 0) {
+            return EX_OK;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(watch));
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    try {
+        return main0(argc, argv);
+    } catch (const po::error &e) {
+        std::cerr << e.what() << std::endl;
+        return EX_USAGE;
+    } catch (const os_file_error &e) {
+        std::cerr << e.what() << std::endl;
+        return EX_UNAVAILABLE;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EX_SOFTWARE;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef STATUSEXPORT_HPP
+#define STATUSEXPORT_HPP
+
+/**
+ * @file statusexport.hpp
+ * File contains class {@link status_export_t} which publishes the torrent
+ * status in shared memory.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <eventloop.hpp>
+#include <statuslayout.hpp>
+#include <torrentstatus.hpp>
+
+
+/**
+ * Publishes a snapshot of the torrent status store in a POSIX shared memory
+ * object (see {@link shm_status_t}), so local monitoring tools can poll it
+ * without HTTP requests.
+ *
+ * Every `httpd.stats-interval` milliseconds, the sums over all torrents and
+ * the {@link shm_max_torrents} torrents with the highest transfer rates are
+ * written if the store has changed. Otherwise, only the time of the update is
+ * refreshed, so readers can detect a hanging server.
+ *
+ * The object is not removed on destruction, as a new process of the
+ * application may already use it. Its `pid` is reset to zero instead. After a
+ * socket handoff, hand_over() stops the old process before the new one starts
+ * publishing, so the segment never has two writers.
+ */
+class status_export_t : private boost::noncopyable
+{
+public:
+    status_export_t(eventloop_t *eventloop,
+                    const torrent_status_store_t *store,
+                    const std::string &name);
+    ~status_export_t() noexcept;
+
+    void publish();
+    void hand_over() noexcept;
+
+private:
+    void schedule_tick();
+    void tick();
+    void begin_write() noexcept;
+    void end_write() noexcept;
+
+    eventloop_t *m_eventloop;
+    const torrent_status_store_t *m_store;
+    shm_status_t *m_segment = nullptr;
+    //! Version of the store when the segment has been written.
+    std::uint64_t m_version = 0;
+    bool m_written = false;
+    //! Used to ignore scheduled calls after destruction.
+    std::shared_ptr<status_export_t*> m_self;
+};
+
+#endif // STATUSEXPORT_HPP
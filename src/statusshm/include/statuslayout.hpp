@@ -0,0 +1,88 @@
+#ifndef STATUSLAYOUT_HPP
+#define STATUSLAYOUT_HPP
+
+/**
+ * @file statuslayout.hpp
+ * File contains the layout of the shared memory segment written by
+ * {@link status_export_t} and read by {@link status_reader_t}.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+
+//! Maximal amount of torrents in the segment.
+static constexpr std::uint32_t shm_max_torrents = 64;
+//! First bytes of the segment.
+static constexpr std::uint32_t shm_magic = 0x53544c58; // "XLTS"
+//! Version of the layout. Incremented on every incompatible change.
+static constexpr std::uint32_t shm_layout_version = 1;
+
+/**
+ * Status of a single torrent.
+ */
+struct shm_torrent_t {
+    std::uint8_t infohash[20];
+    std::uint8_t state;          //!< Value of {@link torrent_state_e}.
+    std::uint8_t reserved[3];
+    float        progress;       //!< Progress between 0 and 1.
+    std::int32_t download_rate;  //!< Payload download rate in B/s.
+    std::int32_t upload_rate;    //!< Payload upload rate in B/s.
+    std::int32_t num_peers;      //!< Amount of connected peers.
+    std::int32_t num_seeds;      //!< Amount of connected seeds.
+    char         name[96];       //!< Name, truncated and NUL-terminated.
+};
+
+/**
+ * Global part of the status.
+ */
+struct shm_summary_t {
+    std::uint64_t version;        //!< Version of the torrent status store.
+    std::int64_t  updated;        //!< Time of the last update in Unix ms.
+    std::uint32_t pid;            //!< Writing process. Zero if stopped.
+    std::uint32_t total_torrents; //!< Amount of all torrents.
+    std::uint32_t count;          //!< Amount of valid entries in `torrents`.
+    std::uint32_t reserved;
+    std::int64_t  download_rate;  //!< Sum over all torrents in B/s.
+    std::int64_t  upload_rate;    //!< Sum over all torrents in B/s.
+    std::int64_t  num_peers;      //!< Sum over all torrents.
+};
+
+/**
+ * The shared memory segment.
+ *
+ * The header (`magic`, `layout` and `size`) is written once when the segment
+ * is created. All other fields are protected by the seqlock `sequence`: the
+ * writer increments it to an odd value before and to an even value after
+ * every update. A reader copies the data and retries if the sequence was odd
+ * or has changed meanwhile. So readers never block the writer and need no
+ * system calls.
+ */
+struct shm_status_t {
+    std::uint32_t magic;
+    std::uint32_t layout;
+    std::uint32_t size;           //!< `sizeof(shm_status_t)` of the writer.
+    std::uint32_t reserved;
+    std::atomic<std::uint64_t> sequence;
+    shm_summary_t summary;
+    //! The torrents with the highest transfer rates, fastest first.
+    shm_torrent_t torrents[shm_max_torrents];
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "The seqlock requires lock-free 64 bit atomics");
+static_assert(std::is_standard_layout<shm_status_t>::value,
+              "The segment must have a fixed layout");
+
+/**
+ * Returns the name of the POSIX shared memory object for @p name, which
+ * begins with '/'.
+ */
+inline std::string shm_object_name(const std::string &name)
+{
+    return !name.empty() && name.front() == '/' ? name : "/" + name;
+}
+
+#endif // STATUSLAYOUT_HPP
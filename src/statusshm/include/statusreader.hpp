@@ -0,0 +1,48 @@
+#ifndef STATUSREADER_HPP
+#define STATUSREADER_HPP
+
+/**
+ * @file statusreader.hpp
+ * File contains class {@link status_reader_t} which reads the status
+ * published by {@link status_export_t}.
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <statuslayout.hpp>
+
+
+/**
+ * Consistent copy of the shared status.
+ */
+struct status_snapshot_t {
+    shm_summary_t summary;
+    std::vector<shm_torrent_t> torrents;
+};
+
+/**
+ * Maps the shared status of a running server read-only.
+ *
+ * read() copies the status without system calls. It only retries while the
+ * server is writing, which takes a few microseconds. The reader does not
+ * depend on the rest of the application and may be used by any local tool.
+ */
+class status_reader_t : private boost::noncopyable
+{
+public:
+    //! Attempts of read() before it gives up.
+    static constexpr unsigned max_attempts = 1000;
+
+    explicit status_reader_t(const std::string &name);
+    ~status_reader_t() noexcept;
+
+    bool read(status_snapshot_t &snapshot) const;
+
+private:
+    const shm_status_t *m_segment;
+};
+
+#endif // STATUSREADER_HPP
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <configuration.hpp>
+#include <errorhandling.hpp>
+#include <statusexport.hpp>
+
+
+using entry_t = torrent_status_store_t::entry_t;
+
+static long long total_rate(const entry_t *entry) noexcept
+{
+    return static_cast<long long>(entry->status.download_rate)
+            + entry->status.upload_rate;
+}
+
+static void write_torrent(shm_torrent_t &out, const torrent_status_t &status)
+{
+    std::memset(&out, 0, sizeof(out));
+    std::memcpy(out.infohash, status.infohash.data(), sizeof(out.infohash));
+    out.state = static_cast<std::uint8_t>(status.state);
+    out.progress = status.progress;
+    out.download_rate = status.download_rate;
+    out.upload_rate = status.upload_rate;
+    out.num_peers = status.num_peers;
+    out.num_seeds = status.num_seeds;
+    status.name.copy(out.name, sizeof(out.name) - 1);
+}
+
+
+/**
+ * Creates or opens the shared memory object @p name and starts publishing.
+ *
+ * @throws os_file_error if the object cannot be created or mapped.
+ */
+status_export_t::status_export_t(eventloop_t *eventloop,
+                                 const torrent_status_store_t *store,
+                                 const std::string &name)
+    : m_eventloop(eventloop)
+    , m_store(store)
+    , m_self(std::make_shared<status_export_t*>(this))
+{
+    const std::string object = shm_object_name(name);
+    const int fd = shm_open(object.c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+                            0644);
+    if (fd < 0) {
+        THROW(os_file_error("Cannot open shared memory for status"))
+                << errinfo::function("shm_open") << errinfo::errnum(errno)
+                << errinfo::filename(object);
+    }
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, sizeof(shm_status_t)) == 0) {
+        addr = mmap(nullptr, sizeof(shm_status_t), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    }
+    const int errnum = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+        THROW(os_file_error("Cannot map shared memory for status"))
+                << errinfo::function("mmap") << errinfo::errnum(errnum)
+                << errinfo::filename(object);
+    }
+    m_segment = static_cast<shm_status_t*>(addr);
+
+    // The object may be left by a previous process, which might have crashed
+    // while writing or might have used another layout. A process which has
+    // handed over the listening socket does not write anymore.
+    std::uint64_t sequence =
+            m_segment->sequence.load(std::memory_order_relaxed);
+    if (sequence % 2 != 0) {
+        m_segment->sequence.store(++sequence, std::memory_order_relaxed);
+    }
+    begin_write();
+    m_segment->magic = shm_magic;
+    m_segment->layout = shm_layout_version;
+    m_segment->size = sizeof(shm_status_t);
+    std::memset(&m_segment->summary, 0, sizeof(m_segment->summary));
+    std::memset(m_segment->torrents, 0, sizeof(m_segment->torrents));
+    end_write();
+
+    publish();
+    schedule_tick();
+}
+
+status_export_t::~status_export_t() noexcept
+{
+    if (m_segment) {
+        begin_write();
+        m_segment->summary.pid = 0;
+        end_write();
+        munmap(m_segment, sizeof(shm_status_t));
+    }
+}
+
+/**
+ * Stops publishing without writing the segment again. Call it once the
+ * listening socket has been handed over, as the new process writes the
+ * segment from then on.
+ */
+void status_export_t::hand_over() noexcept
+{
+    m_self.reset();
+    if (m_segment) {
+        munmap(m_segment, sizeof(shm_status_t));
+        m_segment = nullptr;
+    }
+}
+
+/**
+ * Writes the current status to the segment.
+ */
+void status_export_t::publish()
+{
+    if (!m_segment) {
+        return;
+    }
+    const bool changed = !m_written || m_store->version() != m_version;
+    std::vector<const entry_t*> entries;
+    std::size_t count = 0;
+    if (changed) {
+        // Sort before writing, so readers do not retry meanwhile.
+        entries = m_store->entries();
+        count = std::min<std::size_t>(entries.size(), shm_max_torrents);
+        std::partial_sort(entries.begin(), entries.begin() + count,
+                          entries.end(),
+                          [](const entry_t *a, const entry_t *b) {
+            const long long rate_a = total_rate(a), rate_b = total_rate(b);
+            return rate_a != rate_b ? rate_a > rate_b
+                    : a->status.infohash < b->status.infohash;
+        });
+    }
+    const std::int64_t now =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+    begin_write();
+    shm_summary_t &summary = m_segment->summary;
+    summary.updated = now;
+    summary.pid = static_cast<std::uint32_t>(getpid());
+    if (changed) {
+        summary.version = m_store->version();
+        summary.total_torrents = static_cast<std::uint32_t>(entries.size());
+        summary.count = static_cast<std::uint32_t>(count);
+        summary.download_rate = 0;
+        summary.upload_rate = 0;
+        summary.num_peers = 0;
+        for (const entry_t *entry : entries) {
+            summary.download_rate += entry->status.download_rate;
+            summary.upload_rate += entry->status.upload_rate;
+            summary.num_peers += entry->status.num_peers;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            write_torrent(m_segment->torrents[i], entries[i]->status);
+        }
+    }
+    end_write();
+
+    m_version = m_store->version();
+    m_written = true;
+}
+
+void status_export_t::schedule_tick()
+{
+    std::weak_ptr<status_export_t*> self = m_self;
+    m_eventloop->call([self] {
+        if (auto status_export = self.lock())
+            (*status_export)->tick();
+    }, std::chrono::milliseconds(current_config()->httpd.stats_interval));
+}
+
+void status_export_t::tick()
+{
+    schedule_tick();
+    publish();
+}
+
+/**
+ * Makes the sequence odd, so readers retry until end_write(). There is only
+ * one writer at a time.
+ */
+void status_export_t::begin_write() noexcept
+{
+    m_segment->sequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void status_export_t::end_write() noexcept
+{
+    m_segment->sequence.fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <errorhandling.hpp>
+#include <statusreader.hpp>
+
+
+constexpr unsigned status_reader_t::max_attempts;
+
+
+/**
+ * Maps the shared memory object @p name.
+ *
+ * @throws os_file_error if the object does not exist, e.g. because the server
+ *         does not run, or has an incompatible layout.
+ */
+status_reader_t::status_reader_t(const std::string &name)
+{
+    const std::string object = shm_object_name(name);
+    const int fd = shm_open(object.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        THROW(os_file_error("Cannot open shared memory of status"))
+                << errinfo::function("shm_open") << errinfo::errnum(errno)
+                << errinfo::filename(object);
+    }
+    struct stat st;
+    void *addr = MAP_FAILED;
+    int errnum = EPROTO;
+    if (fstat(fd, &st) < 0) {
+        errnum = errno;
+    } else if (static_cast<std::size_t>(st.st_size) >= sizeof(shm_status_t)) {
+        addr = mmap(nullptr, sizeof(shm_status_t), PROT_READ, MAP_SHARED, fd,
+                    0);
+        errnum = errno;
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        THROW(os_file_error("Cannot map shared memory of status"))
+                << errinfo::function("mmap") << errinfo::errnum(errnum)
+                << errinfo::filename(object);
+    }
+    m_segment = static_cast<const shm_status_t*>(addr);
+
+    if (m_segment->magic != shm_magic
+            || m_segment->layout != shm_layout_version
+            || m_segment->size != sizeof(shm_status_t)) {
+        munmap(const_cast<shm_status_t*>(m_segment), sizeof(shm_status_t));
+        THROW(os_file_error("Incompatible layout of shared status"))
+                << errinfo::errnum(EPROTO) << errinfo::filename(object);
+    }
+}
+
+status_reader_t::~status_reader_t() noexcept
+{
+    munmap(const_cast<shm_status_t*>(m_segment), sizeof(shm_status_t));
+}
+
+/**
+ * Copies the status into @p snapshot.
+ *
+ * @return `false` if no consistent copy could be taken within
+ *         {@link max_attempts}, e.g. because the server has crashed while
+ *         writing.
+ */
+bool status_reader_t::read(status_snapshot_t &snapshot) const
+{
+    for (unsigned attempt = 0; attempt < max_attempts; ++attempt) {
+        const std::uint64_t sequence =
+                m_segment->sequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0) {
+            // The server is writing.
+            std::this_thread::yield();
+            continue;
+        }
+        snapshot.summary = m_segment->summary;
+        const std::uint32_t count =
+                std::min(snapshot.summary.count, shm_max_torrents);
+        snapshot.torrents.assign(m_segment->torrents,
+                                 m_segment->torrents + count);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_segment->sequence.load(std::memory_order_relaxed) == sequence) {
+            return true;
+        }
+    }
+    return false;
+}
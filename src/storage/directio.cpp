@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <directio.hpp>
+#include <errorhandling.hpp>
+#include <logging.hpp>
+
+LOG_MODULE("DirectIO")
+
+
+static constexpr std::size_t alignment = aligned_buffer_pool_t::alignment;
+
+static std::uint64_t align_down(std::uint64_t value) {
+    return value & ~static_cast<std::uint64_t>(alignment - 1);
+}
+
+static std::uint64_t align_up(std::uint64_t value) {
+    return align_down(value + alignment - 1);
+}
+
+static std::size_t pread_full(int fd, char *buf, std::size_t size,
+                              std::uint64_t offset)
+{
+    // Regular files only return less than requested at the end of the file.
+    // Reading again would use an unaligned offset which fails for O_DIRECT.
+    ssize_t ret;
+    do {
+        ret = pread(fd, buf, size, offset);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        OSERROR(pread, "Cannot read from file");
+    }
+    return ret;
+}
+
+static void pwrite_full(int fd, const char *buf, std::size_t size,
+                        std::uint64_t offset)
+{
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t ret = pwrite(fd, buf + done, size - done, offset + done);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0) {
+            OSERROR(pwrite, "Cannot write to file");
+        }
+        done += ret;
+    }
+}
+
+
+constexpr std::size_t aligned_buffer_pool_t::alignment;
+
+void aligned_buffer_pool_t::deleter_t::operator ()(char *buffer) const noexcept
+{
+    pool->release(buffer);
+}
+
+/**
+ * Creates an empty pool.
+ *
+ * @param buffer_size      Size of every buffer. Rounded up to a multiple of
+ *                         #alignment.
+ * @param max_free_buffers Amount of unused buffers kept for later use. Further
+ *                         buffers are freed when returned to the pool.
+ */
+aligned_buffer_pool_t::aligned_buffer_pool_t(std::size_t buffer_size,
+                                             std::size_t max_free_buffers)
+    : m_buffer_size(std::max(align_up(buffer_size),
+                             static_cast<std::uint64_t>(alignment)))
+    , m_max_free_buffers(max_free_buffers)
+{
+}
+
+aligned_buffer_pool_t::~aligned_buffer_pool_t() noexcept
+{
+    for (char *buffer : m_free_buffers) {
+        std::free(buffer);
+    }
+}
+
+/**
+ * Takes a buffer from the pool or allocates a new one if the pool is empty.
+ * This function is thread-safe.
+ */
+aligned_buffer_pool_t::buffer_t aligned_buffer_pool_t::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (!m_free_buffers.empty()) {
+            char *buffer = m_free_buffers.back();
+            m_free_buffers.pop_back();
+            return buffer_t(buffer, deleter_t{this});
+        }
+    }
+    void *buffer;
+    int ret = posix_memalign(&buffer, alignment, m_buffer_size);
+    if (ret != 0) {
+        throw std::bad_alloc();
+    }
+    return buffer_t(static_cast<char*>(buffer), deleter_t{this});
+}
+
+void aligned_buffer_pool_t::release(char *buffer) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (m_free_buffers.size() < m_max_free_buffers) {
+            m_free_buffers.push_back(buffer);
+            return;
+        }
+    }
+    std::free(buffer);
+}
+
+
+/**
+ * Opens the given file.
+ *
+ * @param path           Path of the file.
+ * @param flags          Flags as used by `open()`.
+ * @param read_os_cache  Whether reads may use the page cache.
+ * @param write_os_cache Whether writes may use the page cache.
+ * @param pool           Pool providing buffers for unaligned access. It must
+ *                       outlive the file.
+ */
+direct_file_t::direct_file_t(const std::string &path, int flags,
+                             bool read_os_cache, bool write_os_cache,
+                             aligned_buffer_pool_t &pool)
+    : m_pool(pool)
+    , m_read_os_cache(read_os_cache)
+    , m_write_os_cache(write_os_cache)
+{
+    m_fd = open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        OSERROR(open, "Cannot open file") << errinfo::filename(path);
+    }
+    if (read_os_cache && write_os_cache) {
+        return;
+    }
+
+    // Open the file a second time with O_DIRECT. Unaligned writes have to read
+    // the surrounding blocks, so write-only files are opened for reading too.
+    int direct_flags = flags & ~(O_CREAT | O_EXCL | O_TRUNC | O_ACCMODE);
+    direct_flags |= O_DIRECT | O_CLOEXEC;
+    direct_flags |= (flags & O_ACCMODE) == O_RDONLY ? O_RDONLY : O_RDWR;
+    m_direct_fd = open(path.c_str(), direct_flags);
+    if (m_direct_fd < 0 && errno == EINVAL) {
+        LOG_DEBUG() << "O_DIRECT not supported for " << path
+                    << ", falling back to posix_fadvise()";
+    } else if (m_direct_fd < 0) {
+        int error = errno;
+        close(m_fd);
+        errno = error;
+        OSERROR(open, "Cannot open file") << errinfo::filename(path);
+    }
+}
+
+direct_file_t::~direct_file_t() noexcept
+{
+    if (m_direct_fd >= 0) {
+        close(m_direct_fd);
+    }
+    close(m_fd);
+}
+
+/**
+ * Reads up to @p size bytes at @p offset.
+ *
+ * @return The amount of bytes read. Less than @p size only at end of file.
+ */
+std::size_t direct_file_t::read(void *buf, std::size_t size,
+                                std::uint64_t offset)
+{
+    if (!m_read_os_cache && m_direct_fd >= 0) {
+        return read_direct(static_cast<char*>(buf), size, offset);
+    }
+
+    std::size_t ret = pread_full(m_fd, static_cast<char*>(buf), size, offset);
+    if (!m_read_os_cache) {
+        posix_fadvise(m_fd, offset, size, POSIX_FADV_DONTNEED);
+    }
+    return ret;
+}
+
+/**
+ * Writes @p size bytes at @p offset. The file grows if necessary.
+ */
+void direct_file_t::write(const void *buf, std::size_t size,
+                          std::uint64_t offset)
+{
+    if (!m_write_os_cache && m_direct_fd >= 0) {
+        write_direct(static_cast<const char*>(buf), size, offset);
+        return;
+    }
+
+    pwrite_full(m_fd, static_cast<const char*>(buf), size, offset);
+    if (!m_write_os_cache) {
+        // Dirty pages are not dropped. Write them back first.
+        OSCHECK(sync_file_range,(m_fd, offset, size,
+                                 SYNC_FILE_RANGE_WAIT_BEFORE
+                                 | SYNC_FILE_RANGE_WRITE
+                                 | SYNC_FILE_RANGE_WAIT_AFTER), == 0);
+        posix_fadvise(m_fd, offset, size, POSIX_FADV_DONTNEED);
+    }
+}
+
+std::size_t direct_file_t::read_direct(char *buf, std::size_t size,
+                                       std::uint64_t offset)
+{
+    aligned_buffer_pool_t::buffer_t buffer = m_pool.acquire();
+    std::size_t done = 0;
+    while (done < size) {
+        std::uint64_t begin = align_down(offset + done);
+        std::size_t head = offset + done - begin;
+        std::size_t len = std::min<std::uint64_t>(
+                m_pool.buffer_size(), align_up(head + size - done));
+
+        std::size_t ret = pread_full(m_direct_fd, buffer.get(), len, begin);
+        if (ret <= head) {
+            break;
+        }
+        std::size_t n = std::min(ret - head, size - done);
+        std::memcpy(buf + done, buffer.get() + head, n);
+        done += n;
+        if (ret < len) {
+            break;
+        }
+    }
+    return done;
+}
+
+void direct_file_t::write_direct(const char *buf, std::size_t size,
+                                 std::uint64_t offset)
+{
+    const std::uint64_t end = offset + size;
+    const bool unaligned = offset % alignment != 0 || end % alignment != 0;
+
+    // Concurrent writes could share a block at their edges.
+    std::unique_lock<std::mutex> lock(m_edge_mtx, std::defer_lock);
+    struct stat st = {};
+    if (unaligned) {
+        lock.lock();
+        OSCHECK(fstat,(m_fd, &st), == 0);
+    }
+
+    aligned_buffer_pool_t::buffer_t buffer = m_pool.acquire();
+    std::size_t done = 0;
+    while (done < size) {
+        std::uint64_t begin = align_down(offset + done);
+        std::size_t head = offset + done - begin;
+        std::size_t n = std::min(m_pool.buffer_size() - head, size - done);
+        std::size_t len = align_up(head + n);
+
+        // Preserve the data surrounding the unaligned edges.
+        if (head != 0) {
+            std::memset(buffer.get(), 0, alignment);
+            pread_full(m_direct_fd, buffer.get(), alignment, begin);
+        }
+        if ((head + n) % alignment != 0) {
+            char *last = buffer.get() + len - alignment;
+            std::memset(last, 0, alignment);
+            pread_full(m_direct_fd, last, alignment, begin + len - alignment);
+        }
+
+        std::memcpy(buffer.get() + head, buf + done, n);
+        pwrite_full(m_direct_fd, buffer.get(), len, begin);
+        done += n;
+    }
+
+    // Writing whole blocks may have extended the file beyond the data and
+    // beyond its previous size.
+    const std::uint64_t size_after =
+            std::max<std::uint64_t>(st.st_size, end);
+    if (end % alignment != 0 && size_after < align_up(end)) {
+        OSCHECK(ftruncate,(m_fd, size_after), == 0);
+    }
+}
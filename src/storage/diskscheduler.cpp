@@ -0,0 +1,180 @@
+#include <cerrno>
+#include <cstring>
+#include <exception>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <diskscheduler.hpp>
+#include <logging.hpp>
+
+LOG_MODULE("DiskScheduler")
+
+
+// Definitions of <linux/ioprio.h> which is not shipped by older kernels.
+static constexpr int ioprio_who_process = 1;
+static constexpr int ioprio_class_shift = 13;
+static constexpr int ioprio_class_be    = 2;
+static constexpr int ioprio_class_idle  = 3;
+
+static constexpr int io_class_weights[] = {8, 4, 1};
+
+constexpr std::size_t disk_scheduler_t::class_count;
+constexpr std::size_t disk_scheduler_t::histogram_size;
+
+
+static int ioprio_value(int io_class, int level)
+{
+    return io_class << ioprio_class_shift | level;
+}
+
+static int ioprio_for(io_class_e io_class, bool low_priority)
+{
+    switch (io_class) {
+    case io_class_e::INTERACTIVE:
+        return ioprio_value(ioprio_class_be, 0);
+    case io_class_e::NORMAL:
+        return ioprio_value(ioprio_class_be, low_priority ? 7 : 4);
+    case io_class_e::BACKGROUND:
+        return ioprio_value(ioprio_class_idle, 0);
+    }
+    return ioprio_value(ioprio_class_be, 4);
+}
+
+
+/**
+ * Starts the worker threads.
+ *
+ * @param threads      Amount of worker threads.
+ * @param low_priority Use the lowest best-effort level for NORMAL jobs. This is
+ *                     usually the value of `torrent.low-disk-priority`.
+ */
+disk_scheduler_t::disk_scheduler_t(std::size_t threads, bool low_priority)
+    : m_low_priority(low_priority)
+{
+    for (std::size_t i = 0; i < class_count; ++i) {
+        m_queues[i].weight = io_class_weights[i];
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this] { worker(); });
+    }
+}
+
+/**
+ * Stops the worker threads. Jobs which have not been started are discarded.
+ */
+disk_scheduler_t::~disk_scheduler_t() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+/**
+ * Adds a job to the queue of the given class. This function is thread-safe.
+ *
+ * Exceptions thrown by @p job are logged and discarded. Results should be
+ * reported by the job itself, e.g. through eventloop_t::call().
+ */
+void disk_scheduler_t::submit(io_class_e io_class, job_t job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_queues[static_cast<std::size_t>(io_class)].entries.push_back(
+                {std::move(job), std::chrono::steady_clock::now()});
+    }
+    m_cond.notify_one();
+}
+
+/**
+ * Returns statistics about the given class. This function is thread-safe.
+ */
+disk_scheduler_t::stats_t disk_scheduler_t::stats(io_class_e io_class) const
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    const queue_t &queue = m_queues[static_cast<std::size_t>(io_class)];
+    stats_t stats = queue.stats;
+    stats.queue_depth = queue.entries.size();
+    return stats;
+}
+
+void disk_scheduler_t::worker() noexcept
+{
+    int current_ioprio = -1;
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cond.wait(lock, [this] {
+            if (m_stop)
+                return true;
+            for (const queue_t &queue : m_queues) {
+                if (!queue.entries.empty())
+                    return true;
+            }
+            return false;
+        });
+        if (m_stop) {
+            return;
+        }
+
+        // Take next job and update statistics.
+        std::size_t index = pick_queue();
+        queue_t &queue = m_queues[index];
+        entry_t entry = std::move(queue.entries.front());
+        queue.entries.pop_front();
+
+        auto wait = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - entry.queued).count();
+        std::size_t bucket = 0;
+        while (bucket + 1 < histogram_size && (1ll << bucket) <= wait) {
+            ++bucket;
+        }
+        ++queue.stats.wait_histogram[bucket];
+        ++queue.stats.started;
+        lock.unlock();
+
+        // Adjust I/O priority of this thread if the class has changed.
+        int ioprio = ioprio_for(static_cast<io_class_e>(index), m_low_priority);
+        if (ioprio != current_ioprio) {
+            if (syscall(SYS_ioprio_set, ioprio_who_process, 0, ioprio) < 0) {
+                LOG_WARN() << "Cannot set I/O priority: " << strerror(errno);
+            }
+            current_ioprio = ioprio;
+        }
+
+        try {
+            entry.job();
+        } catch (const std::exception &e) {
+            LOG_WARN() << "Disk job failed: " << e.what();
+        } catch (...) {
+            LOG_WARN() << "Disk job failed with an unknown exception";
+        }
+        entry.job = nullptr;
+        lock.lock();
+    }
+}
+
+std::size_t disk_scheduler_t::pick_queue()
+{
+    // Smooth weighted round robin over all non-empty queues.
+    int total = 0;
+    std::size_t best = class_count;
+    for (std::size_t i = 0; i < class_count; ++i) {
+        queue_t &queue = m_queues[i];
+        if (queue.entries.empty()) {
+            queue.current = 0;
+            continue;
+        }
+        queue.current += queue.weight;
+        total += queue.weight;
+        if (best == class_count || queue.current > m_queues[best].current) {
+            best = i;
+        }
+    }
+    m_queues[best].current -= total;
+    return best;
+}
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <errorhandling.hpp>
+#include <filemover.hpp>
+#include <logging.hpp>
+
+LOG_MODULE("FileMover")
+
+
+//! Amount of bytes copied at once. Progress is updated after every chunk.
+static constexpr std::size_t copy_chunk_size = 8 << 20;
+
+
+struct file_mover_t::batch_t {
+    std::uint64_t id;
+    std::vector<job_t> jobs;
+    completion_handler_t handler;
+    progress_t progress;
+};
+
+
+/**
+ * Closes the file descriptor when going out of scope.
+ */
+class scoped_fd_t : private boost::noncopyable
+{
+public:
+    explicit scoped_fd_t(int fd = -1) : m_fd(fd) {}
+    ~scoped_fd_t() noexcept {
+        if (m_fd >= 0)
+            close(m_fd);
+    }
+    int get() const { return m_fd; }
+private:
+    int m_fd;
+};
+
+static void make_parent_directories(const std::string &path)
+{
+    for (std::size_t pos = path.find('/', 1); pos != std::string::npos;
+         pos = path.find('/', pos + 1)) {
+        std::string dir = path.substr(0, pos);
+        if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) {
+            OSERROR(mkdir, "Cannot create target directory")
+                    << errinfo::filename(dir);
+        }
+    }
+}
+
+static bool rename_noreplace(const std::string &source,
+                             const std::string &target)
+{
+    int ret = renameat2(AT_FDCWD, source.c_str(), AT_FDCWD, target.c_str(),
+                        RENAME_NOREPLACE);
+    if (ret < 0 && errno == EINVAL) {
+        // The filesystem does not support RENAME_NOREPLACE.
+        if (access(target.c_str(), F_OK) == 0) {
+            errno = EEXIST;
+        } else {
+            ret = rename(source.c_str(), target.c_str());
+        }
+    }
+    if (ret == 0) {
+        return true;
+    } else if (errno == EXDEV) {
+        return false;
+    }
+    OSERROR(renameat2, "Cannot move file") << errinfo::filename(source);
+}
+
+
+/**
+ * Starts the worker thread.
+ *
+ * @param read_os_cache  Whether reading copied files may use the page cache.
+ * @param write_os_cache Whether writing copied files may use the page cache.
+ */
+file_mover_t::file_mover_t(eventloop_t *eventloop, bool read_os_cache,
+                           bool write_os_cache)
+    : m_eventloop(eventloop)
+    , m_read_os_cache(read_os_cache)
+    , m_write_os_cache(write_os_cache)
+    , m_thread([this] { worker(); })
+{
+}
+
+file_mover_t::~file_mover_t() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+/**
+ * Submits a batch of files to move.
+ *
+ * The files are moved in the given order. The batch stops on the first error.
+ * Batches which are still pending when the object is destroyed are discarded
+ * without calling their handler.
+ *
+ * @param jobs    Files to move.
+ * @param handler Handler called within the event loop when the batch is done.
+ *
+ * @return An identifier for the batch as used by progress() and @p handler.
+ */
+std::uint64_t file_mover_t::move(std::vector<job_t> jobs,
+                                 const completion_handler_t &handler)
+{
+    std::uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        id = ++m_batch_id_max;
+        m_batches.push_back({id, std::move(jobs), handler, {}});
+        m_batches.back().progress.files_total = m_batches.back().jobs.size();
+    }
+    m_cond.notify_one();
+    return id;
+}
+
+/**
+ * Returns the progress of all batches which have not been completed yet.
+ *
+ * The amount of bytes is only known after the worker has started the batch. It
+ * only includes files which have to be copied because they cannot be renamed.
+ */
+std::map<std::uint64_t, file_mover_t::progress_t> file_mover_t::progress() const
+{
+    std::map<std::uint64_t, progress_t> result;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (const batch_t &batch : m_batches) {
+        result.emplace(batch.id, batch.progress);
+    }
+    return result;
+}
+
+void file_mover_t::worker() noexcept
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        m_cond.wait(lock, [this] { return m_stop || !m_batches.empty(); });
+        if (m_stop) {
+            return;
+        }
+
+        // Elements of std::deque keep their address when pushing at the back.
+        batch_t &batch = m_batches.front();
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            for (const job_t &job : batch.jobs) {
+                move_file(batch, job);
+                std::lock_guard<std::mutex> progress_lock(m_mtx);
+                ++batch.progress.files_done;
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        std::uint64_t id = batch.id;
+        completion_handler_t handler = std::move(batch.handler);
+        m_batches.pop_front();
+        if (handler) {
+            m_eventloop->call([id, handler, error] { handler(id, error); });
+        }
+    }
+}
+
+void file_mover_t::move_file(batch_t &batch, const job_t &job)
+{
+    make_parent_directories(job.target);
+    if (rename_noreplace(job.source, job.target)) {
+        return;
+    }
+
+    // Source and target are located on different filesystems.
+    direct_file_t source(job.source, O_RDONLY, m_read_os_cache,
+                         m_write_os_cache, m_pool);
+    struct stat st;
+    OSCHECK(fstat,(source.fd(), &st), == 0);
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        batch.progress.bytes_total += st.st_size;
+    }
+
+    // Write to a temporary file first to never leave incomplete targets. A
+    // partial file left by a crash would make every retry fail.
+    const std::string partial = job.target + ".part";
+    if (unlink(partial.c_str()) < 0 && errno != ENOENT) {
+        OSERROR(unlink, "Cannot remove stale partial file")
+                << errinfo::filename(partial);
+    }
+    direct_file_t target(partial, O_WRONLY | O_CREAT | O_EXCL,
+                         m_read_os_cache, m_write_os_cache, m_pool);
+    try {
+        OSCHECK(fchmod,(target.fd(), st.st_mode & 0777), == 0);
+        copy_file(batch, source, target, st.st_size);
+        OSCHECK(fdatasync,(target.fd()), == 0);
+        if (!rename_noreplace(partial, job.target)) {
+            OSERROR(renameat2, "Cannot rename partial file")
+                    << errinfo::filename(partial);
+        }
+    } catch (...) {
+        unlink(partial.c_str());
+        throw;
+    }
+    if (unlink(job.source.c_str()) < 0) {
+        LOG_WARN() << "Cannot remove " << job.source << " after copying it: "
+                   << strerror(errno);
+    }
+}
+
+void file_mover_t::copy_file(batch_t &batch, direct_file_t &source,
+                             direct_file_t &target, std::uint64_t size)
+{
+    const int source_fd = source.fd();
+    const int target_fd = target.fd();
+    // Let the filesystem share the extents if supported (reflink).
+    if (ioctl(target_fd, FICLONE, source_fd) == 0) {
+        add_progress(batch, size);
+        return;
+    }
+    // Copying within the kernel would fill the page cache.
+    if (!m_read_os_cache || !m_write_os_cache) {
+        copy_direct(batch, source, target, size);
+        return;
+    }
+
+    // Copy within the kernel. Fall back to splice() through a pipe if
+    // copy_file_range() is not supported for this pair of filesystems.
+    std::uint64_t done = 0;
+    while (done < size) {
+        ssize_t ret = copy_file_range(source_fd, nullptr, target_fd, nullptr,
+                                      copy_chunk_size, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && done == 0 && (errno == EXDEV || errno == ENOSYS
+                   || errno == EINVAL || errno == EOPNOTSUPP)) {
+            break;
+        } else if (ret < 0) {
+            OSERROR(copy_file_range, "Cannot copy file");
+        } else if (ret == 0) {
+            THROW(os_error("File has been truncated while copying"));
+        }
+        done += ret;
+        add_progress(batch, ret);
+    }
+    if (done == size) {
+        return;
+    }
+
+    int pipe_fds[2];
+    OSCHECK(pipe2,(pipe_fds, O_CLOEXEC), == 0);
+    scoped_fd_t pipe_out(pipe_fds[0]), pipe_in(pipe_fds[1]);
+    while (done < size) {
+        ssize_t ret = splice(source_fd, nullptr, pipe_in.get(), nullptr,
+                             copy_chunk_size, SPLICE_F_MOVE);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0) {
+            OSERROR(splice, "Cannot copy file");
+        } else if (ret == 0) {
+            THROW(os_error("File has been truncated while copying"));
+        }
+        for (ssize_t pending = ret; pending > 0;) {
+            ssize_t written = splice(pipe_out.get(), nullptr, target_fd,
+                                     nullptr, pending, SPLICE_F_MOVE);
+            if (written < 0 && errno != EINTR) {
+                OSERROR(splice, "Cannot copy file");
+            } else if (written > 0) {
+                pending -= written;
+            }
+        }
+        done += ret;
+        add_progress(batch, ret);
+    }
+}
+
+void file_mover_t::copy_direct(batch_t &batch, direct_file_t &source,
+                               direct_file_t &target, std::uint64_t size)
+{
+    aligned_buffer_pool_t::buffer_t buffer = m_pool.acquire();
+    std::uint64_t done = 0;
+    while (done < size) {
+        const std::size_t n = source.read(
+                buffer.get(), std::min<std::uint64_t>(m_pool.buffer_size(),
+                                                      size - done), done);
+        if (n == 0) {
+            THROW(os_error("File has been truncated while copying"));
+        }
+        target.write(buffer.get(), n, done);
+        done += n;
+        add_progress(batch, n);
+    }
+}
+
+void file_mover_t::add_progress(batch_t &batch, std::uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    batch.progress.bytes_done += bytes;
+}
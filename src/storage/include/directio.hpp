@@ -0,0 +1,96 @@
+#ifndef DIRECTIO_HPP
+#define DIRECTIO_HPP
+
+/**
+ * @file directio.hpp
+ * File contains classes to read and write files bypassing the page cache.
+ *
+ * {@link direct_file_t} is used for torrent storage when the options
+ * `torrent.read-os-cache` or `torrent.write-os-cache` are disabled. Files are
+ * accessed with `O_DIRECT` through buffers provided by
+ * {@link aligned_buffer_pool_t}. If the filesystem does not support `O_DIRECT`,
+ * the file is accessed normally and the page cache is dropped afterwards by
+ * `posix_fadvise()`.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+
+/**
+ * Pool of buffers suitable for `O_DIRECT`.
+ *
+ * The address and size of every buffer is a multiple of #alignment.
+ */
+class aligned_buffer_pool_t : private boost::noncopyable
+{
+    struct deleter_t {
+        aligned_buffer_pool_t *pool;
+        void operator ()(char *buffer) const noexcept;
+    };
+public:
+    //! Alignment of buffers, file offsets and transfer sizes.
+    static constexpr std::size_t alignment = 4096;
+
+    //! Buffer which is returned to the pool when destroyed.
+    using buffer_t = std::unique_ptr<char[], deleter_t>;
+
+    aligned_buffer_pool_t(std::size_t buffer_size = 256 << 10,
+                          std::size_t max_free_buffers = 16);
+    ~aligned_buffer_pool_t() noexcept;
+
+    buffer_t acquire();
+    std::size_t buffer_size() const noexcept { return m_buffer_size; }
+
+private:
+    void release(char *buffer) noexcept;
+
+    const std::size_t m_buffer_size;
+    const std::size_t m_max_free_buffers;
+    std::mutex m_mtx;
+    std::vector<char*> m_free_buffers;
+};
+
+/**
+ * File which can be read and written without polluting the page cache.
+ *
+ * Reads and writes may use arbitrary offsets and sizes. Unaligned edges are
+ * handled by reading the surrounding blocks into a buffer of the pool. Writes
+ * with unaligned edges are serialized per file since they have to read, modify
+ * and write the surrounding blocks.
+ */
+class direct_file_t : private boost::noncopyable
+{
+public:
+    direct_file_t(const std::string &path, int flags,
+                  bool read_os_cache, bool write_os_cache,
+                  aligned_buffer_pool_t &pool);
+    ~direct_file_t() noexcept;
+
+    std::size_t read(void *buf, std::size_t size, std::uint64_t offset);
+    void write(const void *buf, std::size_t size, std::uint64_t offset);
+
+    //! Whether `O_DIRECT` is used for reading or writing.
+    bool is_direct() const noexcept { return m_direct_fd >= 0; }
+    //! Descriptor opened without `O_DIRECT`, e.g. for `fstat()`.
+    int fd() const noexcept { return m_fd; }
+
+private:
+    std::size_t read_direct(char *buf, std::size_t size, std::uint64_t offset);
+    void write_direct(const char *buf, std::size_t size, std::uint64_t offset);
+
+    aligned_buffer_pool_t &m_pool;
+    const bool m_read_os_cache;
+    const bool m_write_os_cache;
+    int m_fd = -1;
+    int m_direct_fd = -1;
+    std::mutex m_edge_mtx;
+};
+
+#endif // DIRECTIO_HPP
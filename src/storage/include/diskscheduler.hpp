@@ -0,0 +1,98 @@
+#ifndef DISKSCHEDULER_HPP
+#define DISKSCHEDULER_HPP
+
+/**
+ * @file diskscheduler.hpp
+ * File contains class {@link disk_scheduler_t} which runs disk jobs by class.
+ */
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+
+/**
+ * Classes of disk I/O. Each torrent is assigned to one of them.
+ */
+enum class io_class_e {
+    INTERACTIVE, //!< Torrents which are streamed over HTTP right now.
+    NORMAL,      //!< Torrents which are downloaded or seeded actively.
+    BACKGROUND   //!< Rechecks and seeds nobody is waiting for.
+};
+
+/**
+ * Runs disk jobs on worker threads with one queue per I/O class.
+ *
+ * Queues are served by a smooth weighted round robin. When all queues are
+ * busy, INTERACTIVE gets 8, NORMAL 4 and BACKGROUND 1 of 13 jobs. An idle
+ * class does not consume any share. Before running a job, the worker adjusts
+ * its own I/O priority by `ioprio_set()`: INTERACTIVE runs as best-effort
+ * level 0, NORMAL as best-effort level 4 (level 7 if `torrent.low-disk-priority`
+ * is set) and BACKGROUND as idle.
+ */
+class disk_scheduler_t : private boost::noncopyable
+{
+public:
+    using job_t = std::function<void()>;
+
+    //! Amount of classes in {@link io_class_e}.
+    static constexpr std::size_t class_count = 3;
+    //! Amount of buckets of the wait-time histogram.
+    static constexpr std::size_t histogram_size = 24;
+
+    /**
+     * Statistics of one I/O class.
+     */
+    struct stats_t {
+        //! Amount of jobs waiting in the queue.
+        std::size_t   queue_depth = 0;
+        //! Amount of jobs which have been started.
+        std::uint64_t started     = 0;
+        /**
+         * Histogram of the time jobs have waited in the queue. Bucket `i`
+         * counts waits below `2^i` microseconds which did not fit into the
+         * previous bucket. The last bucket counts all longer waits.
+         */
+        std::array<std::uint64_t, histogram_size> wait_histogram = {};
+    };
+
+    disk_scheduler_t(std::size_t threads, bool low_priority = false);
+    ~disk_scheduler_t() noexcept;
+
+    void submit(io_class_e io_class, job_t job);
+    stats_t stats(io_class_e io_class) const;
+
+private:
+    struct entry_t {
+        job_t job;
+        std::chrono::steady_clock::time_point queued;
+    };
+    struct queue_t {
+        std::deque<entry_t> entries;
+        int weight;
+        int current = 0;
+        stats_t stats;
+    };
+
+    void worker() noexcept;
+    std::size_t pick_queue();
+
+    const bool m_low_priority;
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cond;
+    std::array<queue_t, class_count> m_queues;
+    bool m_stop = false;
+
+    std::vector<std::thread> m_threads;
+};
+
+#endif // DISKSCHEDULER_HPP
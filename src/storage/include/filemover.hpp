@@ -0,0 +1,108 @@
+#ifndef FILEMOVER_HPP
+#define FILEMOVER_HPP
+
+/**
+ * @file filemover.hpp
+ * File contains class {@link file_mover_t} which moves completed downloads.
+ */
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <directio.hpp>
+#include <eventloop.hpp>
+
+
+/**
+ * Moves files from one location to another without blocking the event loop.
+ *
+ * Files are moved by a dedicated worker thread. Every file is renamed if
+ * possible. When source and target are located on different filesystems, the
+ * content is cloned (reflink), copied within the kernel (`copy_file_range()`)
+ * or spliced through a pipe, whichever is supported first. If reading or
+ * writing must not use the page cache (`torrent.read-os-cache`,
+ * `torrent.write-os-cache`), the content is copied through a
+ * {@link direct_file_t} instead of within the kernel. The source file is
+ * removed after the target has been written completely.
+ *
+ * Files are submitted in batches. A batch is processed as a whole and the
+ * completion handler is called once per batch. This keeps the overhead low for
+ * torrents containing many small files.
+ */
+class file_mover_t : private boost::noncopyable
+{
+public:
+    /**
+     * A single file to move.
+     */
+    struct job_t {
+        std::string source; //!< Path of the file to move.
+        std::string target; //!< New path of the file.
+    };
+
+    /**
+     * Progress of a batch which has been submitted by move().
+     */
+    struct progress_t {
+        std::size_t   files_total = 0; //!< Amount of files in the batch.
+        std::size_t   files_done  = 0; //!< Amount of files already moved.
+        std::uint64_t bytes_total = 0; //!< Amount of bytes to copy.
+        std::uint64_t bytes_done  = 0; //!< Amount of bytes already copied.
+    };
+
+    /**
+     * Handler which is called within the event loop when a batch is done.
+     *
+     * @param id    The identifier returned by move().
+     * @param error A null pointer on success or the exception which has
+     *              stopped the batch.
+     */
+    using completion_handler_t = std::function<
+        void(std::uint64_t id, std::exception_ptr error)>;
+
+    explicit file_mover_t(eventloop_t *eventloop, bool read_os_cache = true,
+                          bool write_os_cache = true);
+    ~file_mover_t() noexcept;
+
+    std::uint64_t move(std::vector<job_t> jobs,
+                       const completion_handler_t &handler);
+
+    std::map<std::uint64_t, progress_t> progress() const;
+
+private:
+    struct batch_t;
+
+    void worker() noexcept;
+    void move_file(batch_t &batch, const job_t &job);
+    void copy_file(batch_t &batch, direct_file_t &source,
+                   direct_file_t &target, std::uint64_t size);
+    void copy_direct(batch_t &batch, direct_file_t &source,
+                     direct_file_t &target, std::uint64_t size);
+    void add_progress(batch_t &batch, std::uint64_t bytes);
+
+    eventloop_t *m_eventloop;
+    const bool m_read_os_cache;
+    const bool m_write_os_cache;
+    //! Buffers used if the page cache is bypassed.
+    aligned_buffer_pool_t m_pool;
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cond;
+    std::deque<batch_t> m_batches;
+    std::uint64_t m_batch_id_max = 0;
+    bool m_stop = false;
+
+    std::thread m_thread;
+};
+
+#endif // FILEMOVER_HPP
@@ -0,0 +1,74 @@
+#ifndef READAHEAD_HPP
+#define READAHEAD_HPP
+
+/**
+ * @file readahead.hpp
+ * File contains classes to prefetch files which are read sequentially.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/core/noncopyable.hpp>
+
+
+/**
+ * Upper limit for the amount of data prefetched by all streams together.
+ */
+class readahead_budget_t : private boost::noncopyable
+{
+public:
+    explicit readahead_budget_t(std::uint64_t limit) : m_limit(limit) {}
+
+    bool try_reserve(std::uint64_t bytes) noexcept;
+    void release(std::uint64_t bytes) noexcept;
+
+    std::uint64_t used() const noexcept { return m_used; }
+    std::uint64_t limit() const noexcept { return m_limit; }
+
+private:
+    const std::uint64_t m_limit;
+    std::atomic<std::uint64_t> m_used{0};
+};
+
+/**
+ * Detects sequential reads of a file and prefetches data ahead of them.
+ *
+ * Every read has to be announced by on_read(). As long as the reads are
+ * sequential, the window is doubled each time the reader has consumed half of
+ * the prefetched data, up to the maximal window size. The window only grows as
+ * far as the shared {@link readahead_budget_t} allows. A non-sequential read
+ * resets the window to its minimal size.
+ *
+ * Data is prefetched by `posix_fadvise(POSIX_FADV_WILLNEED)` which starts the
+ * I/O without waiting for it. The page cache then serves the following reads.
+ */
+class readahead_stream_t : private boost::noncopyable
+{
+public:
+    readahead_stream_t(int fd, readahead_budget_t &budget,
+                       std::size_t min_window = 128 << 10,
+                       std::size_t max_window = 16 << 20);
+    ~readahead_stream_t() noexcept;
+
+    void on_read(std::uint64_t offset, std::size_t size);
+
+    //! Current size of the window.
+    std::size_t window() const noexcept { return m_window; }
+    //! Offset up to which data has been prefetched.
+    std::uint64_t prefetched() const noexcept { return m_prefetched; }
+
+private:
+    void resize_window(std::size_t window);
+
+    const int m_fd;
+    readahead_budget_t &m_budget;
+    const std::size_t m_min_window;
+    const std::size_t m_max_window;
+    std::size_t m_window = 0;
+    std::uint64_t m_next = 0;
+    std::uint64_t m_prefetched = 0;
+};
+
+#endif // READAHEAD_HPP
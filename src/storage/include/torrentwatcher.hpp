@@ -0,0 +1,79 @@
+#ifndef TORRENTWATCHER_HPP
+#define TORRENTWATCHER_HPP
+
+/**
+ * @file torrentwatcher.hpp
+ * File contains class {@link torrent_watcher_t} which watches for new torrent
+ * files.
+ */
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <diskscheduler.hpp>
+#include <eventloop.hpp>
+
+
+/**
+ * Watches a directory for torrent files by inotify.
+ *
+ * Files ending with `.torrent` are reported when they have been closed after
+ * writing or moved into the directory. Events are collected until the
+ * directory has been quiet for the debounce interval. Then, all collected
+ * files are read and passed to the handler as one batch by a job of the
+ * {@link disk_scheduler_t}. The directory is never scanned.
+ */
+class torrent_watcher_t : private boost::noncopyable
+{
+public:
+    /**
+     * A torrent file which has been found.
+     */
+    struct file_t {
+        std::string path;    //!< Path of the file.
+        std::string content; //!< Content of the file.
+    };
+
+    /**
+     * Handler called with a batch of new files. It is called by a worker
+     * thread of the disk scheduler, not within the event loop.
+     */
+    using batch_handler_t = std::function<void(std::vector<file_t> files)>;
+
+    torrent_watcher_t(eventloop_t *eventloop, disk_scheduler_t *scheduler,
+                      const std::string &directory,
+                      const batch_handler_t &handler,
+                      std::chrono::milliseconds debounce
+                      = std::chrono::milliseconds(500));
+    ~torrent_watcher_t() noexcept;
+
+private:
+    void fdset_getter(fd_set &rs, fd_set &ws, fd_set &es, int &max,
+                      std::chrono::nanoseconds &timeout);
+    void io_handler(const fd_set &rs, const fd_set &ws, const fd_set &es);
+    void schedule_flush(std::chrono::nanoseconds delay);
+    void flush();
+
+    eventloop_t *m_eventloop;
+    eventloop_t::select_handle_t m_select_handle;
+    disk_scheduler_t *m_scheduler;
+    const std::string m_directory;
+    const batch_handler_t m_handler;
+    const std::chrono::milliseconds m_debounce;
+
+    int m_inotify_fd = -1;
+    std::set<std::string> m_pending;
+    std::chrono::steady_clock::time_point m_first_event;
+    std::chrono::steady_clock::time_point m_last_event;
+    bool m_flush_scheduled = false;
+    //! Used to ignore scheduled calls after destruction.
+    std::shared_ptr<torrent_watcher_t*> m_self;
+};
+
+#endif // TORRENTWATCHER_HPP
@@ -0,0 +1,97 @@
+#include <algorithm>
+
+#include <fcntl.h>
+
+#include <readahead.hpp>
+
+
+/**
+ * Reserves @p bytes if the limit allows it. This function is thread-safe.
+ *
+ * @return Whether the bytes have been reserved.
+ */
+bool readahead_budget_t::try_reserve(std::uint64_t bytes) noexcept
+{
+    std::uint64_t used = m_used.load();
+    do {
+        if (used + bytes > m_limit) {
+            return false;
+        }
+    } while (!m_used.compare_exchange_weak(used, used + bytes));
+    return true;
+}
+
+/**
+ * Returns bytes which have been reserved by try_reserve().
+ */
+void readahead_budget_t::release(std::uint64_t bytes) noexcept
+{
+    m_used -= bytes;
+}
+
+
+/**
+ * Creates a stream for the given file.
+ *
+ * @param fd         File descriptor of the file. It is not closed by the
+ *                   stream.
+ * @param budget     Budget shared by all streams.
+ * @param min_window Size of the window when a sequential read is detected.
+ * @param max_window Maximal size of the window.
+ */
+readahead_stream_t::readahead_stream_t(int fd, readahead_budget_t &budget,
+                                       std::size_t min_window,
+                                       std::size_t max_window)
+    : m_fd(fd)
+    , m_budget(budget)
+    , m_min_window(min_window)
+    , m_max_window(std::max(min_window, max_window))
+{
+}
+
+readahead_stream_t::~readahead_stream_t() noexcept
+{
+    m_budget.release(m_window);
+}
+
+/**
+ * Announces a read of @p size bytes at @p offset.
+ */
+void readahead_stream_t::on_read(std::uint64_t offset, std::size_t size)
+{
+    const std::uint64_t end = offset + size;
+    const bool sequential = offset == m_next || m_next == 0;
+    m_next = end;
+
+    if (!sequential) {
+        // Random access. Wait for the next sequential read.
+        resize_window(0);
+        m_prefetched = end;
+        return;
+    } else if (m_prefetched > end && m_prefetched - end > m_window / 2) {
+        // Enough data ahead. Do not issue small prefetches on every read.
+        return;
+    }
+
+    if (m_window == 0) {
+        resize_window(m_min_window);
+    } else {
+        resize_window(std::min(m_window * 2, m_max_window));
+    }
+
+    std::uint64_t begin = std::max(m_prefetched, end);
+    if (end + m_window > begin) {
+        posix_fadvise(m_fd, begin, end + m_window - begin, POSIX_FADV_WILLNEED);
+        m_prefetched = end + m_window;
+    }
+}
+
+void readahead_stream_t::resize_window(std::size_t window)
+{
+    if (window < m_window) {
+        m_budget.release(m_window - window);
+        m_window = window;
+    } else if (window > m_window && m_budget.try_reserve(window - m_window)) {
+        m_window = window;
+    }
+}
@@ -0,0 +1,171 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <errorhandling.hpp>
+#include <logging.hpp>
+#include <torrentwatcher.hpp>
+
+LOG_MODULE("TorrentWatcher")
+
+
+//! A burst of events delays the batch by at most this factor of the debounce.
+static constexpr int max_delay_factor = 10;
+
+
+static bool has_torrent_extension(const char *name)
+{
+    static const char extension[] = ".torrent";
+    std::size_t len = std::strlen(name);
+    return len >= sizeof(extension)
+        && std::strcmp(name + len - sizeof(extension) + 1, extension) == 0;
+}
+
+static std::vector<torrent_watcher_t::file_t> read_files(
+        const std::vector<std::string> &paths)
+{
+    std::vector<torrent_watcher_t::file_t> files;
+    files.reserve(paths.size());
+    for (const std::string &path : paths) {
+        std::ifstream in(path, std::ios::binary);
+        std::string content{std::istreambuf_iterator<char>(in), {}};
+        if (!in.is_open() || in.bad()) {
+            // The file may have been removed in the meantime.
+            LOG_WARN() << "Cannot read torrent file " << path;
+            continue;
+        }
+        files.push_back({path, std::move(content)});
+    }
+    return files;
+}
+
+
+/**
+ * Starts watching the given directory.
+ *
+ * @param eventloop Event loop used to receive inotify events.
+ * @param scheduler Scheduler used to read the files and call @p handler.
+ * @param directory Directory to watch, usually `storage.torrents`.
+ * @param handler   Handler called with every batch of new files.
+ * @param debounce  Time without events after which the batch is processed.
+ */
+torrent_watcher_t::torrent_watcher_t(eventloop_t *eventloop,
+                                     disk_scheduler_t *scheduler,
+                                     const std::string &directory,
+                                     const batch_handler_t &handler,
+                                     std::chrono::milliseconds debounce)
+    : m_eventloop(eventloop)
+    , m_scheduler(scheduler)
+    , m_directory(directory)
+    , m_handler(handler)
+    , m_debounce(debounce)
+    , m_self(std::make_shared<torrent_watcher_t*>(this))
+{
+    m_inotify_fd = OSCHECK(inotify_init1,(IN_NONBLOCK | IN_CLOEXEC), >= 0);
+    if (inotify_add_watch(m_inotify_fd, directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0) {
+        int error = errno;
+        close(m_inotify_fd);
+        errno = error;
+        OSERROR(inotify_add_watch, "Cannot watch torrent directory")
+                << errinfo::filename(directory);
+    }
+
+    // Register at event loop
+    m_select_handle = m_eventloop->register_handler(
+            [this](auto&... args) {this->io_handler(args...);},
+            [this](auto&... args) {this->fdset_getter(args...);}
+    );
+}
+
+torrent_watcher_t::~torrent_watcher_t() noexcept
+{
+    m_eventloop->unregister_handler(m_select_handle);
+    close(m_inotify_fd);
+}
+
+void torrent_watcher_t::fdset_getter(fd_set &rs, fd_set &ws, fd_set &es,
+                                     int &max,
+                                     std::chrono::nanoseconds &timeout)
+{
+    FD_SET(m_inotify_fd, &rs);
+    max = m_inotify_fd + 1;
+}
+
+void torrent_watcher_t::io_handler(const fd_set &rs, const fd_set &ws,
+                                   const fd_set &es)
+{
+    if (!FD_ISSET(m_inotify_fd, &rs)) {
+        return;
+    }
+
+    alignas(struct inotify_event) char buf[4096];
+    while (true) {
+        ssize_t len = read(m_inotify_fd, buf, sizeof(buf));
+        if (len < 0 && errno == EINTR) {
+            continue;
+        } else if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (len < 0) {
+            OSERROR(read, "Cannot read inotify events");
+        }
+
+        for (char *ptr = buf; ptr < buf + len;) {
+            const auto *event = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                LOG_WARN() << "Inotify queue overflowed, events are lost";
+            } else if (event->len > 0 && has_torrent_extension(event->name)) {
+                auto now = std::chrono::steady_clock::now();
+                if (m_pending.empty()) {
+                    m_first_event = now;
+                }
+                m_last_event = now;
+                m_pending.insert(m_directory + "/" + event->name);
+            }
+        }
+    }
+
+    if (!m_pending.empty() && !m_flush_scheduled) {
+        schedule_flush(m_debounce);
+    }
+}
+
+void torrent_watcher_t::schedule_flush(std::chrono::nanoseconds delay)
+{
+    std::weak_ptr<torrent_watcher_t*> self = m_self;
+    m_eventloop->call([self] {
+        if (auto watcher = self.lock())
+            (*watcher)->flush();
+    }, delay);
+    m_flush_scheduled = true;
+}
+
+void torrent_watcher_t::flush()
+{
+    m_flush_scheduled = false;
+
+    // Wait until the directory has been quiet or the batch has been delayed
+    // for too long.
+    auto now = std::chrono::steady_clock::now();
+    auto deadline = std::min(m_last_event + m_debounce,
+                             m_first_event + max_delay_factor * m_debounce);
+    if (now < deadline) {
+        schedule_flush(deadline - now);
+        return;
+    }
+
+    std::vector<std::string> paths(m_pending.begin(), m_pending.end());
+    m_pending.clear();
+    LOG_INFO() << "Found " << paths.size() << " new torrent file(s)";
+
+    batch_handler_t handler = m_handler;
+    m_scheduler->submit(io_class_e::NORMAL, [paths, handler] {
+        handler(read_files(paths));
+    });
+}
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+
+#include <libtorrent/hasher.hpp>
+
+#include <bencode.hpp>
+
+
+struct bencode_scanner_t::hasher_t {
+    void update(const char *data, std::size_t len) {
+        while (len > 0) {
+            int part = static_cast<int>(std::min<std::size_t>(len, INT_MAX));
+            hasher.update(data, part);
+            data += part;
+            len -= part;
+        }
+    }
+
+    libtorrent::hasher hasher;
+    infohash_t infohash;
+};
+
+
+static bool is_digit(char c) noexcept
+{
+    return c >= '0' && c <= '9';
+}
+
+
+bencode_scanner_t::bencode_scanner_t()
+    : m_hasher(new hasher_t)
+{
+}
+
+bencode_scanner_t::~bencode_scanner_t() noexcept = default;
+
+/**
+ * Scans the next part of the file.
+ *
+ * @throws bencode_error if the data is invalid. The scanner must not be used
+ *         afterwards.
+ */
+void bencode_scanner_t::feed(const char *data, std::size_t len)
+{
+    // Start of the data which still has to be hashed.
+    const char *hash_begin = m_hashing ? data : nullptr;
+
+    std::size_t i = 0;
+    while (i < len) {
+        const char c = data[i];
+        switch (m_token) {
+        case token_e::NONE:
+            if (m_done) {
+                throw bencode_error("Trailing data after torrent file");
+            }
+            if (c == 'e') {
+                if (m_stack.empty()
+                        || (m_stack.back().dict && !m_stack.back().key_next)) {
+                    throw bencode_error("Unexpected end of container");
+                }
+                m_stack.pop_back();
+                if (m_hashing && m_stack.size() < m_info_depth) {
+                    m_hasher->update(hash_begin, data + i + 1 - hash_begin);
+                    const std::string hash =
+                            m_hasher->hasher.final().to_string();
+                    std::copy_n(hash.begin(), m_hasher->infohash.size(),
+                                m_hasher->infohash.begin());
+                    hash_begin = nullptr;
+                    m_hashing = false;
+                    m_hashed = true;
+                }
+                end_value();
+            } else {
+                begin_value(c);
+                if (m_hashing && hash_begin == nullptr) {
+                    hash_begin = data + i;
+                }
+            }
+            ++i;
+            break;
+
+        case token_e::INTEGER:
+            if (c == 'e') {
+                if (m_digits == 0) {
+                    throw bencode_error("Empty integer");
+                }
+                m_token = token_e::NONE;
+                end_value();
+            } else if (c == '-' && m_digits == 0 && !m_negative) {
+                m_negative = true;
+            } else if (is_digit(c) && m_digits < 20 && !m_zero
+                       && !(c == '0' && m_negative && m_digits == 0)) {
+                // Leading zeros and `-0` are not allowed.
+                m_zero = c == '0' && m_digits == 0;
+                ++m_digits;
+            } else {
+                throw bencode_error("Invalid integer");
+            }
+            ++i;
+            break;
+
+        case token_e::LENGTH:
+            if (c == ':') {
+                m_token = token_e::STRING;
+                m_key_len = 0;
+                if (m_length == 0) {
+                    m_token = token_e::NONE;
+                    end_value();
+                }
+            } else if (is_digit(c) && m_digits < 18 && !m_zero) {
+                m_length = m_length * 10 + (c - '0');
+                ++m_digits;
+            } else {
+                throw bencode_error("Invalid string length");
+            }
+            ++i;
+            break;
+
+        case token_e::STRING: {
+            std::size_t n = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(m_length, len - i));
+            if (m_top_key && m_key_len < sizeof(m_key)) {
+                std::size_t copy = std::min(n, sizeof(m_key) - m_key_len);
+                std::memcpy(m_key + m_key_len, data + i, copy);
+            }
+            m_key_len += n;
+            m_length -= n;
+            i += n;
+            if (m_length == 0) {
+                m_token = token_e::NONE;
+                end_value();
+            }
+            break;
+        }
+        }
+    }
+
+    if (hash_begin != nullptr) {
+        m_hasher->update(hash_begin, data + len - hash_begin);
+    }
+}
+
+/**
+ * Returns the SHA1 hash of the info dictionary.
+ *
+ * @throws bencode_error if the file is incomplete or has no info dictionary.
+ */
+infohash_t bencode_scanner_t::infohash() const
+{
+    if (!m_done) {
+        throw bencode_error("Torrent file is incomplete");
+    }
+    if (!m_hashed) {
+        throw bencode_error("Torrent file has no info dictionary");
+    }
+    return m_hasher->infohash;
+}
+
+void bencode_scanner_t::begin_value(char c)
+{
+    const bool key = !m_stack.empty() && m_stack.back().dict
+                     && m_stack.back().key_next;
+    if (key && !is_digit(c)) {
+        throw bencode_error("Dictionary key is not a string");
+    }
+    m_top_key = key && m_stack.size() == 1;
+    if (m_stack.empty() && c != 'd') {
+        throw bencode_error("Torrent file is not a dictionary");
+    }
+    if (m_info_next && !key) {
+        m_info_next = false;
+        if (c != 'd') {
+            throw bencode_error("Info is not a dictionary");
+        }
+        m_hashing = true;
+        m_info_depth = m_stack.size() + 1;
+    }
+
+    if (c == 'i') {
+        m_token = token_e::INTEGER;
+        m_digits = 0;
+        m_negative = false;
+        m_zero = false;
+    } else if (is_digit(c)) {
+        m_token = token_e::LENGTH;
+        m_length = c - '0';
+        m_digits = 1;
+        m_zero = c == '0';
+    } else if (c == 'l' || c == 'd') {
+        if (m_stack.size() >= max_depth) {
+            throw bencode_error("Nesting is too deep");
+        }
+        m_stack.push_back({c == 'd', true});
+    } else {
+        throw bencode_error("Invalid token");
+    }
+}
+
+/**
+ * Called after a value or a dictionary key has been completed.
+ */
+void bencode_scanner_t::end_value()
+{
+    if (m_stack.empty()) {
+        m_done = true;
+        return;
+    }
+    container_t &top = m_stack.back();
+    if (!top.dict) {
+        return;
+    }
+    if (top.key_next && m_stack.size() == 1) {
+        m_info_next = m_key_len == sizeof(m_key)
+                      && std::memcmp(m_key, "info", sizeof(m_key)) == 0;
+        if (m_info_next && m_hashed) {
+            throw bencode_error("Duplicate info dictionary");
+        }
+    }
+    top.key_next = !top.key_next;
+}
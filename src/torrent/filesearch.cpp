@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <filesearch.hpp>
+
+
+static char fold(char c) noexcept
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static std::string lowercase(std::string text)
+{
+    // Only ASCII is folded, multi-byte characters are compared as they are.
+    std::transform(text.begin(), text.end(), text.begin(), fold);
+    return text;
+}
+
+/**
+ * Returns whether @p text contains the lowercase @p term, ignoring case.
+ */
+static bool contains_folded(const std::string &text, const std::string &term)
+{
+    return std::search(text.begin(), text.end(), term.begin(), term.end(),
+                       [](char a, char b) { return fold(a) == b; })
+           != text.end();
+}
+
+static std::uint32_t trigram(const char *text) noexcept
+{
+    return std::uint32_t(static_cast<unsigned char>(text[0])) << 16
+         | std::uint32_t(static_cast<unsigned char>(text[1])) << 8
+         | std::uint32_t(static_cast<unsigned char>(text[2]));
+}
+
+/**
+ * Splits @p text at any of @p separators, skipping empty parts.
+ */
+static std::vector<std::string> split(const std::string &text,
+                                      const char *separators)
+{
+    std::vector<std::string> parts;
+    std::size_t begin = text.find_first_not_of(separators);
+    while (begin != std::string::npos) {
+        std::size_t end = text.find_first_of(separators, begin);
+        parts.push_back(text.substr(begin, end - begin));
+        begin = text.find_first_not_of(separators, end);
+    }
+    return parts;
+}
+
+static std::vector<std::string> query_terms(const std::string &query)
+{
+    return split(lowercase(query), " \t\r\n\f\v/");
+}
+
+
+void file_search_index_t::postings_t::push(std::uint32_t id)
+{
+    if (m_count != 0 && id == m_last) {
+        return;
+    }
+    std::uint32_t delta = id - m_last;
+    while (delta >= 0x80) {
+        m_bytes.push_back(static_cast<std::uint8_t>(delta | 0x80));
+        delta >>= 7;
+    }
+    m_bytes.push_back(static_cast<std::uint8_t>(delta));
+    m_last = id;
+    ++m_count;
+}
+
+std::vector<std::uint32_t> file_search_index_t::postings_t::decode() const
+{
+    std::vector<std::uint32_t> ids;
+    ids.reserve(m_count);
+    std::uint32_t id = 0;
+    std::uint32_t delta = 0;
+    int shift = 0;
+    for (std::uint8_t byte : m_bytes) {
+        delta |= std::uint32_t(byte & 0x7f) << shift;
+        if (byte & 0x80) {
+            shift += 7;
+            continue;
+        }
+        id += delta;
+        ids.push_back(id);
+        delta = 0;
+        shift = 0;
+    }
+    return ids;
+}
+
+
+/**
+ * Indexes the files of a torrent. Replaces the files if the torrent is
+ * already indexed.
+ *
+ * @param paths Paths of all files in the order of the torrent.
+ */
+void file_search_index_t::add(const infohash_t &infohash,
+                              const std::vector<std::string> &paths)
+{
+    remove(infohash);
+
+    torrent_t torrent;
+    torrent.slot = static_cast<std::uint32_t>(m_slots.size());
+    torrent.first = static_cast<std::uint32_t>(m_files.size());
+    torrent.count = static_cast<std::uint32_t>(paths.size());
+    m_slots.push_back(infohash);
+
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        const auto id = static_cast<std::uint32_t>(m_files.size());
+        file_t file;
+        file.torrent = torrent.slot;
+        file.index = static_cast<std::uint32_t>(i);
+        file.path = static_cast<std::uint32_t>(m_paths.size());
+        file.dead = false;
+        for (const std::string &name : split(paths[i], "/")) {
+            const std::uint32_t component = intern(name);
+            m_components[component].files.push(id);
+            ++m_components[component].refs;
+            m_paths.push_back(component);
+        }
+        file.depth = static_cast<std::uint32_t>(m_paths.size()) - file.path;
+        m_files.push_back(file);
+    }
+    m_torrents.emplace(infohash, torrent);
+}
+
+/**
+ * Removes the files of a torrent. Does nothing if the torrent is unknown.
+ */
+void file_search_index_t::remove(const infohash_t &infohash)
+{
+    auto it = m_torrents.find(infohash);
+    if (it == m_torrents.end()) {
+        return;
+    }
+    const torrent_t &torrent = it->second;
+    for (std::uint32_t id = torrent.first;
+         id < torrent.first + torrent.count; ++id) {
+        file_t &file = m_files[id];
+        file.dead = true;
+        for (std::uint32_t i = 0; i < file.depth; ++i) {
+            --m_components[m_paths[file.path + i]].refs;
+        }
+    }
+    m_dead += torrent.count;
+    m_torrents.erase(it);
+
+    if (m_dead > m_files.size() / 2) {
+        compact();
+    }
+}
+
+/**
+ * Returns whether @p query contains a term which is long enough.
+ */
+bool file_search_index_t::searchable(const std::string &query)
+{
+    for (const std::string &term : query_terms(query)) {
+        if (term.size() >= min_term_length)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Returns the files matching @p query, ordered by torrent and file index
+ * within the torrent. Only the long terms are looked up, so the costs depend
+ * on the amount of candidates rather than on the amount of files.
+ *
+ * @param limit Maximal amount of files to return.
+ */
+file_search_result_t file_search_index_t::search(const std::string &query,
+                                                 std::size_t limit) const
+{
+    file_search_result_t result;
+    std::vector<std::string> terms = query_terms(query);
+    auto short_begin = std::stable_partition(
+            terms.begin(), terms.end(), [](const std::string &term) {
+                return term.size() >= min_term_length;
+            });
+    if (short_begin == terms.begin()) {
+        return result;
+    }
+
+    // Start with the term matching the fewest files, the others only filter.
+    std::vector<std::uint32_t> best;
+    std::size_t best_files = 0;
+    for (auto it = terms.begin(); it != short_begin; ++it) {
+        std::vector<std::uint32_t> components = term_components(*it);
+        std::size_t files = 0;
+        for (std::uint32_t id : components) {
+            files += m_components[id].files.size();
+        }
+        if (it == terms.begin() || files < best_files) {
+            best = std::move(components);
+            best_files = files;
+            std::iter_swap(terms.begin(), it);
+        }
+    }
+
+    std::vector<std::uint32_t> candidates;
+    candidates.reserve(best_files);
+    for (std::uint32_t id : best) {
+        const std::vector<std::uint32_t> ids = m_components[id].files.decode();
+        candidates.insert(candidates.end(), ids.begin(), ids.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+
+    for (std::uint32_t id : candidates) {
+        const file_t &file = m_files[id];
+        if (file.dead) {
+            continue;
+        }
+        bool matches = std::all_of(std::next(terms.begin()), terms.end(),
+                                   [&](const std::string &term) {
+                                       return contains(file, term);
+                                   });
+        if (!matches) {
+            continue;
+        }
+        if (result.files.size() < limit) {
+            result.files.push_back({m_slots[file.torrent],
+                                    static_cast<int>(file.index),
+                                    path(file)});
+        }
+        ++result.total;
+    }
+    return result;
+}
+
+std::uint32_t file_search_index_t::intern(const std::string &name)
+{
+    auto it = m_component_ids.find(name);
+    if (it != m_component_ids.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<std::uint32_t>(m_components.size());
+    m_components.emplace_back();
+    m_components.back().name = name;
+    m_component_ids.emplace(name, id);
+
+    const std::string lower = lowercase(name);
+    std::vector<std::uint32_t> keys;
+    for (std::size_t i = 0; i + 3 <= lower.size(); ++i) {
+        keys.push_back(trigram(lower.data() + i));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    for (std::uint32_t key : keys) {
+        m_trigrams[key].push(id);
+    }
+    return id;
+}
+
+/**
+ * Returns the ids of all used components containing @p term. Only the
+ * shortest list of its trigrams is decoded, the candidates are verified
+ * directly.
+ */
+std::vector<std::uint32_t> file_search_index_t::term_components(
+        const std::string &term) const
+{
+    const postings_t *shortest = nullptr;
+    for (std::size_t i = 0; i + 3 <= term.size(); ++i) {
+        auto it = m_trigrams.find(trigram(term.data() + i));
+        if (it == m_trigrams.end()) {
+            return {};
+        }
+        if (shortest == nullptr || it->second.size() < shortest->size()) {
+            shortest = &it->second;
+        }
+    }
+
+    std::vector<std::uint32_t> components = shortest->decode();
+    auto end = std::remove_if(components.begin(), components.end(),
+                              [&](std::uint32_t id) {
+                                  const component_t &c = m_components[id];
+                                  return c.refs == 0
+                                      || !contains_folded(c.name, term);
+                              });
+    components.erase(end, components.end());
+    return components;
+}
+
+std::string file_search_index_t::path(const file_t &file) const
+{
+    std::string result;
+    for (std::uint32_t i = 0; i < file.depth; ++i) {
+        if (i != 0)
+            result += '/';
+        result += m_components[m_paths[file.path + i]].name;
+    }
+    return result;
+}
+
+bool file_search_index_t::contains(const file_t &file,
+                                   const std::string &term) const
+{
+    for (std::uint32_t i = 0; i < file.depth; ++i) {
+        if (contains_folded(m_components[m_paths[file.path + i]].name, term))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Rebuilds the index from the living files, which drops dead files and
+ * unused components.
+ */
+void file_search_index_t::compact()
+{
+    std::vector<std::pair<infohash_t, std::vector<std::string>>> torrents;
+    torrents.reserve(m_torrents.size());
+    for (const auto &entry : m_torrents) {
+        const torrent_t &torrent = entry.second;
+        std::vector<std::string> paths;
+        paths.reserve(torrent.count);
+        for (std::uint32_t id = torrent.first;
+             id < torrent.first + torrent.count; ++id) {
+            paths.push_back(path(m_files[id]));
+        }
+        torrents.emplace_back(entry.first, std::move(paths));
+    }
+
+    m_components.clear();
+    m_component_ids.clear();
+    m_trigrams.clear();
+    m_files.clear();
+    m_paths.clear();
+    m_dead = 0;
+    m_torrents.clear();
+    m_slots.clear();
+
+    for (const auto &torrent : torrents) {
+        add(torrent.first, torrent.second);
+    }
+}
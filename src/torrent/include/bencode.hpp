@@ -0,0 +1,107 @@
+#ifndef BENCODE_HPP
+#define BENCODE_HPP
+
+/**
+ * @file bencode.hpp
+ * File contains class {@link bencode_scanner_t} which validates torrent files
+ * and computes their infohash while they are received.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <torrentstatus.hpp>
+
+
+/**
+ * Thrown by {@link bencode_scanner_t} if the data is not a valid torrent file.
+ */
+class bencode_error : public std::runtime_error
+{
+public:
+    explicit bencode_error(const char *what) : std::runtime_error(what) {}
+};
+
+/**
+ * Incremental parser for bencoded torrent files.
+ *
+ * Data can be passed in chunks of any size. The scanner checks the syntax,
+ * expects a dictionary at top level and hashes the value of its key `info`
+ * while scanning. Nothing but the nesting of containers and the current token
+ * is kept in memory, so the memory usage does not depend on the size of the
+ * file.
+ *
+ * ```{.cpp}
+ * bencode_scanner_t scanner;
+ * while (read(fd, buf, sizeof(buf)) > 0)
+ *     scanner.feed(buf, len);
+ * infohash_t infohash = scanner.infohash();
+ * ```
+ */
+class bencode_scanner_t : private boost::noncopyable
+{
+public:
+    //! Maximal nesting of lists and dictionaries.
+    static constexpr std::size_t max_depth = 64;
+
+    bencode_scanner_t();
+    ~bencode_scanner_t() noexcept;
+
+    void feed(const char *data, std::size_t len);
+
+    /**
+     * Returns whether the top-level dictionary has been completed.
+     */
+    bool done() const noexcept { return m_done; }
+
+    infohash_t infohash() const;
+
+private:
+    struct hasher_t;
+
+    enum class token_e {
+        NONE,    //!< Between two tokens.
+        INTEGER, //!< Within `i...e`.
+        LENGTH,  //!< Within the length prefix of a string.
+        STRING   //!< Within the bytes of a string.
+    };
+
+    //! An open list or dictionary.
+    struct container_t {
+        bool dict;      //!< Whether it is a dictionary.
+        bool key_next;  //!< Whether a dictionary expects a key next.
+    };
+
+    void begin_value(char c);
+    void end_value();
+
+    std::unique_ptr<hasher_t> m_hasher;
+    std::vector<container_t> m_stack;
+    token_e m_token = token_e::NONE;
+    //! Whether the current token is a key of the top-level dictionary.
+    bool m_top_key = false;
+    //! Amount of digits of the current integer or length.
+    std::size_t m_digits = 0;
+    //! Whether the first digit is a zero, which must not be followed by more.
+    bool m_zero = false;
+    bool m_negative = false;
+    //! Length of the current string or remaining bytes while reading it.
+    std::uint64_t m_length = 0;
+    //! Prefix of the current top-level key, used to recognize `info`.
+    char m_key[4];
+    std::size_t m_key_len = 0;
+    //! Whether the next value of the top-level dictionary is the info dict.
+    bool m_info_next = false;
+    //! Depth of the stack at which the info dictionary has been opened.
+    std::size_t m_info_depth = 0;
+    bool m_hashing = false;
+    bool m_hashed = false;
+    bool m_done = false;
+};
+
+#endif // BENCODE_HPP
@@ -0,0 +1,145 @@
+#ifndef FILESEARCH_HPP
+#define FILESEARCH_HPP
+
+/**
+ * @file filesearch.hpp
+ * File contains class {@link file_search_index_t} which finds files of all
+ * torrents by parts of their paths.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <torrentstatus.hpp>
+
+namespace libtorrent {
+    class file_storage;
+}
+
+
+/**
+ * Returns the paths of all files of @p files, separated by `/`.
+ */
+std::vector<std::string> file_paths(const libtorrent::file_storage &files);
+
+
+/**
+ * A file found by {@link file_search_index_t::search()}.
+ */
+struct file_match_t {
+    infohash_t  infohash; //!< Torrent containing the file.
+    int         file;     //!< Index of the file within the torrent.
+    std::string path;     //!< Path of the file within the torrent.
+};
+
+/**
+ * Result of {@link file_search_index_t::search()}.
+ */
+struct file_search_result_t {
+    std::size_t               total = 0; //!< Amount of matching files.
+    std::vector<file_match_t> files;     //!< First matching files.
+};
+
+/**
+ * Trigram index over the file paths of all torrents.
+ *
+ * Paths are split into components, which are interned, so a directory shared
+ * by thousands of files is stored and indexed once. Every trigram of a
+ * lowercased component points to the components containing it, and every
+ * component points to the files using it. Both lists are sorted by id and
+ * stored as varint-coded deltas.
+ *
+ * Ids only grow, so adding a torrent appends to the lists. Removed files are
+ * only marked; the index is rebuilt when more than half of the files are
+ * dead.
+ *
+ * A query is split into terms at whitespace and `/`. A file matches if every
+ * term is contained case-insensitively in one component of its path. At least
+ * one term must be min_term_length characters long, shorter terms are only
+ * used to filter the candidates.
+ *
+ * The index is not thread-safe. It is used within the event loop.
+ */
+class file_search_index_t : private boost::noncopyable
+{
+public:
+    //! Minimal length of the longest term of a query.
+    static constexpr std::size_t min_term_length = 3;
+
+    file_search_index_t() = default;
+
+    void add(const infohash_t &infohash,
+             const std::vector<std::string> &paths);
+    void remove(const infohash_t &infohash);
+
+    static bool searchable(const std::string &query);
+    file_search_result_t search(const std::string &query,
+                                std::size_t limit) const;
+
+    //! Amount of indexed files.
+    std::size_t size() const noexcept { return m_files.size() - m_dead; }
+
+private:
+    /**
+     * Sorted list of ids, stored as varint-coded deltas.
+     */
+    class postings_t {
+    public:
+        void push(std::uint32_t id);
+        std::vector<std::uint32_t> decode() const;
+        std::size_t size() const noexcept { return m_count; }
+
+    private:
+        std::vector<std::uint8_t> m_bytes;
+        std::uint32_t m_last = 0;
+        std::uint32_t m_count = 0;
+    };
+
+    struct component_t {
+        std::string name;
+        postings_t  files;  //!< Files using the component.
+        std::size_t refs = 0; //!< Amount of living files using it.
+    };
+
+    struct file_t {
+        std::uint32_t torrent; //!< Slot of the torrent.
+        std::uint32_t index;   //!< Index within the torrent.
+        std::uint32_t path;    //!< Offset of the components in #m_paths.
+        std::uint32_t depth;   //!< Amount of components.
+        bool          dead;
+    };
+
+    struct torrent_t {
+        std::uint32_t slot;
+        std::uint32_t first; //!< Id of the first file.
+        std::uint32_t count; //!< Amount of files.
+    };
+
+    std::uint32_t intern(const std::string &name);
+    std::vector<std::uint32_t> term_components(const std::string &term) const;
+    std::string path(const file_t &file) const;
+    bool contains(const file_t &file, const std::string &term) const;
+    void compact();
+
+    std::vector<component_t> m_components;
+    std::unordered_map<std::string, std::uint32_t> m_component_ids;
+    //! Components of all trigrams, keyed by the lowercased trigram.
+    std::unordered_map<std::uint32_t, postings_t> m_trigrams;
+
+    std::vector<file_t> m_files;
+    //! Component ids of all paths, referenced by file_t::path.
+    std::vector<std::uint32_t> m_paths;
+    std::size_t m_dead = 0;
+
+    std::map<infohash_t, torrent_t> m_torrents;
+    //! Infohashes by slot.
+    std::vector<infohash_t> m_slots;
+};
+
+#endif // FILESEARCH_HPP
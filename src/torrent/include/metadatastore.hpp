@@ -0,0 +1,84 @@
+#ifndef METADATASTORE_HPP
+#define METADATASTORE_HPP
+
+/**
+ * @file metadatastore.hpp
+ * File contains class {@link metadata_store_t} which keeps the metadata of all
+ * torrents seen before, so magnet links can be added without fetching it from
+ * peers again.
+ */
+
+#include <cstddef>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <torrentstatus.hpp>
+
+namespace libtorrent {
+    struct add_torrent_params;
+    class torrent_info;
+}
+
+
+/**
+ * Content-addressed store of info dictionaries.
+ *
+ * Every info dictionary is kept in a file named after its infohash, e.g.
+ * `<directory>/b41b...66ad.info`. Files are written to a temporary file,
+ * synced and renamed, so a crash never leaves a partial entry behind. As the
+ * content determines the name, an entry never changes once written and
+ * concurrent writers of the same torrent write identical data.
+ *
+ * Entries are verified by their hash when loaded. Corrupt entries are removed
+ * and reported as missing.
+ *
+ * All functions block on disk I/O. They should be called by jobs of the
+ * {@link disk_scheduler_t}, not within the event loop. The store may be used
+ * by several threads at once.
+ *
+ * The application does not create a store yet. It is meant to use the
+ * directory `metadata` inside `storage.torrents` once a libtorrent session
+ * exists.
+ */
+class metadata_store_t : private boost::noncopyable
+{
+public:
+    explicit metadata_store_t(const std::string &directory);
+
+    bool contains(const infohash_t &infohash) const;
+    std::string load(const infohash_t &infohash) const;
+    std::string load_torrent(const infohash_t &infohash) const;
+    infohash_t save(const char *info, std::size_t len);
+
+    /**
+     * Returns the directory of the store.
+     */
+    const std::string &directory() const noexcept { return m_directory; }
+
+private:
+    std::string path(const infohash_t &infohash) const;
+
+    const std::string m_directory;
+};
+
+/**
+ * Sets the metadata of @p params from @p store if it has no metadata yet and
+ * the store knows its infohash, e.g. for a magnet link of a torrent which has
+ * been added before. Call it right before adding the torrent.
+ *
+ * @return Whether the metadata has been set.
+ */
+bool apply_cached_metadata(const metadata_store_t &store,
+                           libtorrent::add_torrent_params &params);
+
+/**
+ * Saves the info dictionary of @p info in @p store. Call it for torrents
+ * added with metadata and when `metadata_received_alert` is posted.
+ *
+ * @return The infohash of the torrent.
+ */
+infohash_t save_metadata(metadata_store_t &store,
+                         const libtorrent::torrent_info &info);
+
+#endif // METADATASTORE_HPP
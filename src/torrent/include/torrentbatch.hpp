@@ -0,0 +1,91 @@
+#ifndef TORRENTBATCH_HPP
+#define TORRENTBATCH_HPP
+
+/**
+ * @file torrentbatch.hpp
+ * File contains types and functions to apply many operations on torrents at
+ * once.
+ */
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include <torrentstatus.hpp>
+
+namespace libtorrent {
+    struct session_handle;
+}
+
+
+/**
+ * Actions of a {@link batch_op_t}.
+ */
+enum class batch_action_e {
+    PAUSE,        //!< Pause the torrent.
+    RESUME,       //!< Resume the torrent.
+    REMOVE,       //!< Remove the torrent but keep its files.
+    REMOVE_DATA,  //!< Remove the torrent and delete its files.
+    FILE_PRIORITY //!< Set the priority of a single file.
+};
+
+/**
+ * A single operation of a batch.
+ */
+struct batch_op_t {
+    batch_action_e action;
+    infohash_t     infohash;
+    int            file = 0;     //!< Index of the file for FILE_PRIORITY.
+    int            priority = 0; //!< Priority (0 to 7) for FILE_PRIORITY.
+};
+
+/**
+ * Results of a single operation.
+ */
+enum class batch_result_e {
+    OK,              //!< The operation has been applied.
+    UNKNOWN_TORRENT, //!< There is no torrent with the infohash.
+    INVALID_FILE,    //!< The torrent has no file with the index.
+    FAILED,          //!< libtorrent has rejected the operation.
+    SUPERSEDED       //!< Not applied, the batch removes the torrent.
+};
+
+/**
+ * Returns the name of @p result as used by the REST API.
+ */
+const char *to_string(batch_result_e result) noexcept;
+
+/**
+ * Operations of a batch merged per torrent.
+ *
+ * Later operations supersede earlier ones: the last of PAUSE and RESUME wins,
+ * the last priority of every file wins and a removal makes all other
+ * operations obsolete.
+ */
+struct torrent_batch_t {
+    infohash_t infohash;
+    //! Indices of all operations of the batch concerning this torrent.
+    std::vector<std::size_t> ops;
+    bool pause  = false; //!< Whether the torrent is paused.
+    bool resume = false; //!< Whether the torrent is resumed.
+    bool remove = false; //!< Whether the torrent is removed.
+    bool remove_data = false; //!< Whether the files are deleted as well.
+    //! New priorities by file index.
+    std::map<int, int> file_priorities;
+};
+
+std::vector<torrent_batch_t> group_batch(const std::vector<batch_op_t> &ops);
+
+/**
+ * Applies @p ops to the torrents of @p session.
+ *
+ * The operations are grouped by group_batch(), so every torrent is looked up
+ * once and gets at most one call per kind of change. Setting priorities of
+ * hundreds of files results in a single call of `prioritize_files()`.
+ *
+ * @return The result of every operation in the order of @p ops.
+ */
+std::vector<batch_result_e> apply_batch(libtorrent::session_handle &session,
+                                        const std::vector<batch_op_t> &ops);
+
+#endif // TORRENTBATCH_HPP
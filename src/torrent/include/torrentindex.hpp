@@ -0,0 +1,88 @@
+#ifndef TORRENTINDEX_HPP
+#define TORRENTINDEX_HPP
+
+/**
+ * @file torrentindex.hpp
+ * File contains class {@link torrent_index_t} which keeps the torrents of a
+ * {@link torrent_status_store_t} sorted by various keys.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <torrentstatus.hpp>
+
+
+/**
+ * Keys torrents can be sorted by.
+ */
+enum class torrent_sort_e {
+    NAME,     //!< Name of the torrent.
+    SIZE,     //!< Bytes of wanted files.
+    PROGRESS, //!< Progress between 0 and 1.
+    ADDED,    //!< Time the torrent has been added.
+    RATIO     //!< Ratio of uploaded to downloaded payload.
+};
+
+/**
+ * Query for a page of torrents.
+ */
+struct torrent_query_t {
+    bool            filter_state = false; //!< Whether to filter by state.
+    torrent_state_e state = torrent_state_e::DOWNLOADING;
+    torrent_sort_e  sort = torrent_sort_e::NAME;
+    bool            descending = false;
+    std::size_t     offset = 0;
+    std::size_t     limit = 50;
+};
+
+/**
+ * Result of a {@link torrent_query_t}.
+ */
+struct torrent_page_t {
+    //! Amount of torrents matching the filter.
+    std::size_t total = 0;
+    //! Torrents of the page, pointers are valid until the store is modified.
+    std::vector<const torrent_status_store_t::entry_t*> entries;
+};
+
+/**
+ * Secondary indexes over the torrents of a {@link torrent_status_store_t}.
+ *
+ * For every sort key, the index keeps an order statistic tree over all
+ * torrents and one over the torrents grouped by state. The trees are updated
+ * incrementally with the changes of the store, and only if a key has
+ * changed, so rate updates cost a single lookup. A page is found by rank, so
+ * a query costs O(log n + limit) regardless of the offset.
+ *
+ * Must be destroyed before the store.
+ */
+class torrent_index_t : private boost::noncopyable
+{
+public:
+    explicit torrent_index_t(torrent_status_store_t *store);
+    ~torrent_index_t() noexcept;
+
+    torrent_page_t query(const torrent_query_t &query) const;
+
+    //! Amount of indexed torrents.
+    std::size_t size() const noexcept;
+
+private:
+    struct items_t;
+
+    void update(std::uint64_t version);
+    void rebuild();
+
+    torrent_status_store_t *m_store;
+    torrent_status_store_t::listener_handle_t m_listener;
+    //! Version of the store the index is up to date with.
+    std::uint64_t m_version = 0;
+    std::unique_ptr<items_t> m_items;
+};
+
+#endif // TORRENTINDEX_HPP
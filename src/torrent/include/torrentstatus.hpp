@@ -0,0 +1,151 @@
+#ifndef TORRENTSTATUS_HPP
+#define TORRENTSTATUS_HPP
+
+/**
+ * @file torrentstatus.hpp
+ * File contains class {@link torrent_status_store_t} which keeps the latest
+ * status of every torrent together with a version number.
+ */
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+namespace libtorrent {
+    struct torrent_status;
+}
+
+
+//! SHA1 hash of the info dictionary which identifies a torrent.
+using infohash_t = std::array<std::uint8_t, 20>;
+
+/**
+ * Returns @p infohash as lowercase hexadecimal text, e.g. for file names.
+ */
+std::string to_hex(const infohash_t &infohash);
+
+/**
+ * States of a torrent. The values match `libtorrent::torrent_status::state_t`.
+ */
+enum class torrent_state_e {
+    CHECKING_FILES       = 1,
+    DOWNLOADING_METADATA = 2,
+    DOWNLOADING          = 3,
+    FINISHED             = 4,
+    SEEDING              = 5,
+    ALLOCATING           = 6,
+    CHECKING_RESUME_DATA = 7
+};
+
+/**
+ * Returns the name of @p state as used by the REST API.
+ */
+const char *to_string(torrent_state_e state) noexcept;
+
+/**
+ * Status of a torrent as reported to clients.
+ */
+struct torrent_status_t {
+    infohash_t      infohash;         //!< Infohash of the torrent.
+    std::string     name;             //!< Name of the torrent.
+    torrent_state_e state = torrent_state_e::CHECKING_RESUME_DATA;
+    float           progress = 0;     //!< Progress between 0 and 1.
+    int             download_rate = 0; //!< Payload download rate in B/s.
+    int             upload_rate = 0;  //!< Payload upload rate in B/s.
+    int             num_peers = 0;    //!< Amount of connected peers.
+    int             num_seeds = 0;    //!< Amount of connected seeds.
+    std::int64_t    total_done = 0;   //!< Bytes of wanted files received.
+    std::int64_t    total_wanted = 0; //!< Bytes of wanted files.
+    std::int64_t    added_time = 0;   //!< Time of adding as Unix time.
+    float           ratio = 0;        //!< Uploaded per downloaded payload.
+
+    bool operator ==(const torrent_status_t &other) const noexcept;
+    bool operator !=(const torrent_status_t &other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+/**
+ * Converts a status as reported by `libtorrent::state_update_alert`.
+ */
+torrent_status_t make_torrent_status(const libtorrent::torrent_status &status);
+
+/**
+ * Latest status of all torrents with a version counter.
+ *
+ * Every change of a torrent increments the global version and assigns the new
+ * version to the torrent. Entries are indexed by version, so collecting the
+ * changes since a version a client has seen costs time proportional to the
+ * amount of changes, not to the amount of torrents.
+ *
+ * Removed torrents are kept as tombstones, so clients can learn about the
+ * removal. Only the latest `max_tombstones` tombstones are kept. Deltas
+ * starting before horizon() are not available any more and clients have to
+ * fetch the full list.
+ *
+ * The store is not thread-safe. It is used within the event loop.
+ */
+class torrent_status_store_t : private boost::noncopyable
+{
+public:
+    /**
+     * Entry of the store.
+     */
+    struct entry_t {
+        torrent_status_t status;  //!< Last known status.
+        std::uint64_t    version; //!< Version of the last change.
+        bool             removed; //!< Whether the entry is a tombstone.
+    };
+
+    /**
+     * Listener called after a batch of updates has changed anything.
+     *
+     * @param version The new version of the store.
+     */
+    using listener_t = std::function<void(std::uint64_t version)>;
+    using listener_handle_t = std::uint64_t;
+
+    explicit torrent_status_store_t(std::size_t max_tombstones = 1024);
+
+    void update(const std::vector<torrent_status_t> &statuses);
+    void remove(const infohash_t &infohash);
+
+    //! Version of the latest change. Zero if nothing has been stored yet.
+    std::uint64_t version() const noexcept { return m_version; }
+    //! Oldest version deltas can be computed for.
+    std::uint64_t horizon() const noexcept { return m_horizon; }
+
+    std::vector<const entry_t*> changes(std::uint64_t since) const;
+    std::vector<const entry_t*> entries() const;
+    const entry_t *find(const infohash_t &infohash) const;
+
+    listener_handle_t add_listener(const listener_t &listener);
+    void remove_listener(listener_handle_t handle) noexcept;
+
+private:
+    bool apply(const torrent_status_t &status);
+    void set_version(entry_t &entry);
+    void prune_tombstones();
+    void notify();
+
+    const std::size_t m_max_tombstones;
+
+    std::uint64_t m_version = 0;
+    std::uint64_t m_horizon = 0;
+    std::map<infohash_t, entry_t> m_entries;
+    //! Index of all entries by version. Points into #m_entries.
+    std::map<std::uint64_t, entry_t*> m_by_version;
+    //! Versions of all tombstones.
+    std::set<std::uint64_t> m_tombstones;
+
+    listener_handle_t m_listener_max = 0;
+    std::map<listener_handle_t, listener_t> m_listeners;
+};
+
+#endif // TORRENTSTATUS_HPP
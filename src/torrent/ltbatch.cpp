@@ -0,0 +1,89 @@
+#include <exception>
+
+#include <libtorrent/session_handle.hpp>
+#include <libtorrent/sha1_hash.hpp>
+#include <libtorrent/torrent_handle.hpp>
+
+#include <torrentbatch.hpp>
+
+
+static void apply_torrent(libtorrent::session_handle &session,
+                          const torrent_batch_t &batch,
+                          const std::vector<batch_op_t> &ops,
+                          std::vector<batch_result_e> &results)
+{
+    libtorrent::torrent_handle handle = session.find_torrent(
+            libtorrent::sha1_hash(
+                    reinterpret_cast<const char*>(batch.infohash.data())));
+    if (!handle.is_valid()) {
+        for (std::size_t i : batch.ops)
+            results[i] = batch_result_e::UNKNOWN_TORRENT;
+        return;
+    }
+
+    if (batch.remove) {
+        // Other changes of the torrent would be lost anyway.
+        for (std::size_t i : batch.ops) {
+            if (ops[i].action != batch_action_e::REMOVE
+                    && ops[i].action != batch_action_e::REMOVE_DATA) {
+                results[i] = batch_result_e::SUPERSEDED;
+            }
+        }
+        if (batch.remove_data) {
+            session.remove_torrent(handle,
+                                   libtorrent::session_handle::delete_files);
+        } else {
+            session.remove_torrent(handle);
+        }
+        return;
+    }
+
+    if (!batch.file_priorities.empty()) {
+        auto priorities = handle.file_priorities();
+        using priority_t = decltype(priorities)::value_type;
+        bool changed = false;
+        for (const auto &entry : batch.file_priorities) {
+            if (entry.first < 0
+                    || static_cast<std::size_t>(entry.first)
+                       >= priorities.size()) {
+                continue;
+            }
+            priority_t priority = priority_t(entry.second);
+            changed |= !(priorities[entry.first] == priority);
+            priorities[entry.first] = priority;
+        }
+        for (std::size_t i : batch.ops) {
+            const batch_op_t &op = ops[i];
+            if (op.action == batch_action_e::FILE_PRIORITY
+                    && (op.file < 0 || static_cast<std::size_t>(op.file)
+                                       >= priorities.size())) {
+                results[i] = batch_result_e::INVALID_FILE;
+            }
+        }
+        if (changed) {
+            handle.prioritize_files(priorities);
+        }
+    }
+
+    if (batch.pause) {
+        handle.pause();
+    } else if (batch.resume) {
+        handle.resume();
+    }
+}
+
+std::vector<batch_result_e> apply_batch(libtorrent::session_handle &session,
+                                        const std::vector<batch_op_t> &ops)
+{
+    std::vector<batch_result_e> results(ops.size(), batch_result_e::OK);
+    for (const torrent_batch_t &batch : group_batch(ops)) {
+        try {
+            apply_torrent(session, batch, ops, results);
+        } catch (const std::exception &) {
+            // The torrent may have been removed in the meantime.
+            for (std::size_t i : batch.ops)
+                results[i] = batch_result_e::FAILED;
+        }
+    }
+    return results;
+}
@@ -0,0 +1,26 @@
+#include <algorithm>
+#include <utility>
+
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/version.hpp>
+
+#include <filesearch.hpp>
+
+
+std::vector<std::string> file_paths(const libtorrent::file_storage &files)
+{
+#if LIBTORRENT_VERSION_NUM >= 10200
+    using file_index_t = libtorrent::file_index_t;
+#else
+    using file_index_t = int;
+#endif
+    std::vector<std::string> paths;
+    paths.reserve(static_cast<std::size_t>(files.num_files()));
+    for (int i = 0; i < files.num_files(); ++i) {
+        std::string path = files.file_path(file_index_t(i));
+        // Windows builds of libtorrent use backslashes.
+        std::replace(path.begin(), path.end(), '\\', '/');
+        paths.push_back(std::move(path));
+    }
+    return paths;
+}
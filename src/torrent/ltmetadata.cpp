@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <string>
+
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/error_code.hpp>
+#include <libtorrent/sha1_hash.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/version.hpp>
+
+#include <metadatastore.hpp>
+
+
+bool apply_cached_metadata(const metadata_store_t &store,
+                           libtorrent::add_torrent_params &params)
+{
+    if (params.ti) {
+        return false;
+    }
+#if LIBTORRENT_VERSION_NUM >= 20000
+    const libtorrent::sha1_hash &hash = params.info_hashes.v1;
+#else
+    const libtorrent::sha1_hash &hash = params.info_hash;
+#endif
+    infohash_t infohash;
+    std::copy_n(hash.data(), infohash.size(), infohash.begin());
+
+    const std::string torrent = store.load_torrent(infohash);
+    if (torrent.empty()) {
+        return false;
+    }
+    libtorrent::error_code ec;
+    // libtorrent 1.1 uses boost::shared_ptr, later versions std::shared_ptr.
+    decltype(params.ti) info(new libtorrent::torrent_info(
+            torrent.data(), static_cast<int>(torrent.size()), ec));
+    if (ec) {
+        return false;
+    }
+    params.ti = info;
+    return true;
+}
+
+infohash_t save_metadata(metadata_store_t &store,
+                         const libtorrent::torrent_info &info)
+{
+#if LIBTORRENT_VERSION_NUM >= 20000
+    const auto section = info.info_section();
+    return store.save(section.data(), static_cast<std::size_t>(section.size()));
+#else
+    return store.save(info.metadata().get(),
+                      static_cast<std::size_t>(info.metadata_size()));
+#endif
+}
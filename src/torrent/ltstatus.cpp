@@ -0,0 +1,30 @@
+#include <algorithm>
+#include <string>
+
+#include <libtorrent/torrent_status.hpp>
+
+#include <torrentstatus.hpp>
+
+
+torrent_status_t make_torrent_status(const libtorrent::torrent_status &status)
+{
+    torrent_status_t result;
+    const std::string hash = status.info_hash.to_string();
+    std::copy_n(hash.begin(), std::min(hash.size(), result.infohash.size()),
+                result.infohash.begin());
+    result.name          = status.name;
+    result.state         = static_cast<torrent_state_e>(status.state);
+    result.progress      = status.progress;
+    result.download_rate = status.download_payload_rate;
+    result.upload_rate   = status.upload_payload_rate;
+    result.num_peers     = status.num_peers;
+    result.num_seeds     = status.num_seeds;
+    result.total_done    = status.total_wanted_done;
+    result.total_wanted  = status.total_wanted;
+    result.added_time    = status.added_time;
+    result.ratio         = status.all_time_download > 0
+            ? static_cast<float>(status.all_time_upload)
+              / static_cast<float>(status.all_time_download)
+            : 0;
+    return result;
+}
@@ -0,0 +1,191 @@
+#include <cerrno>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bencode.hpp>
+#include <errorhandling.hpp>
+#include <metadatastore.hpp>
+
+
+//! Prefix and suffix which turn an info dictionary into a torrent file.
+static const char torrent_prefix[] = "d4:info";
+static const char torrent_suffix[] = "e";
+
+
+/**
+ * Returns the infohash of the info dictionary @p info.
+ *
+ * @throws bencode_error if @p info is not a valid dictionary.
+ */
+static infohash_t hash_info(const char *info, std::size_t len)
+{
+    bencode_scanner_t scanner;
+    scanner.feed(torrent_prefix, sizeof(torrent_prefix) - 1);
+    scanner.feed(info, len);
+    scanner.feed(torrent_suffix, sizeof(torrent_suffix) - 1);
+    return scanner.infohash();
+}
+
+static void write_all(int fd, const char *data, std::size_t len,
+                      const std::string &path)
+{
+    while (len > 0) {
+        ssize_t ret = write(fd, data, len);
+        if (ret < 0 && errno != EINTR) {
+            const int errnum = errno;
+            close(fd);
+            unlink(path.c_str());
+            errno = errnum;
+            OSERROR(write, "Cannot write metadata") << errinfo::filename(path);
+        } else if (ret > 0) {
+            data += ret;
+            len -= ret;
+        }
+    }
+}
+
+
+/**
+ * Opens the store in @p directory. The directory is created if it does not
+ * exist, but its parent has to.
+ *
+ * @throws os_error if the directory cannot be created.
+ */
+metadata_store_t::metadata_store_t(const std::string &directory)
+    : m_directory(directory)
+{
+    if (mkdir(m_directory.c_str(), 0755) < 0 && errno != EEXIST) {
+        OSERROR(mkdir, "Cannot create metadata directory")
+                << errinfo::filename(m_directory);
+    }
+}
+
+/**
+ * Returns whether the store has an entry for @p infohash. The entry is not
+ * verified.
+ */
+bool metadata_store_t::contains(const infohash_t &infohash) const
+{
+    return access(path(infohash).c_str(), F_OK) == 0;
+}
+
+/**
+ * Returns the info dictionary of @p infohash.
+ *
+ * @return The bencoded dictionary. Empty if the store has no valid entry.
+ * @throws os_error if the entry cannot be read.
+ */
+std::string metadata_store_t::load(const infohash_t &infohash) const
+{
+    const std::string file = path(infohash);
+    const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return std::string();
+        }
+        OSERROR(open, "Cannot open metadata") << errinfo::filename(file);
+    }
+    std::string info;
+    char buf[16 << 10];
+    while (true) {
+        ssize_t ret = read(fd, buf, sizeof(buf));
+        if (ret < 0 && errno != EINTR) {
+            const int errnum = errno;
+            close(fd);
+            errno = errnum;
+            OSERROR(read, "Cannot read metadata") << errinfo::filename(file);
+        } else if (ret == 0) {
+            break;
+        } else if (ret > 0) {
+            info.append(buf, ret);
+        }
+    }
+    close(fd);
+
+    // Drop entries damaged e.g. by a crash of the system.
+    bool valid = false;
+    try {
+        valid = hash_info(info.data(), info.size()) == infohash;
+    } catch (const bencode_error &) {
+    }
+    if (!valid) {
+        unlink(file.c_str());
+        return std::string();
+    }
+    return info;
+}
+
+/**
+ * Returns a torrent file which consists of the info dictionary of @p infohash
+ * only. It can be passed to `libtorrent::torrent_info`.
+ *
+ * @return The torrent file. Empty if the store has no valid entry.
+ * @throws os_error if the entry cannot be read.
+ */
+std::string metadata_store_t::load_torrent(const infohash_t &infohash) const
+{
+    const std::string info = load(infohash);
+    if (info.empty()) {
+        return std::string();
+    }
+    return torrent_prefix + info + torrent_suffix;
+}
+
+/**
+ * Saves the bencoded info dictionary @p info unless the store has it already.
+ *
+ * @return The infohash of @p info.
+ * @throws bencode_error if @p info is not a valid dictionary.
+ * @throws os_error if the entry cannot be written.
+ */
+infohash_t metadata_store_t::save(const char *info, std::size_t len)
+{
+    const infohash_t infohash = hash_info(info, len);
+    const std::string file = path(infohash);
+    if (access(file.c_str(), F_OK) == 0) {
+        return infohash;
+    }
+
+    std::string temporary = file + ".XXXXXX";
+    const int fd = mkostemp(&temporary[0], O_CLOEXEC);
+    if (fd < 0) {
+        OSERROR(mkostemp, "Cannot create temporary metadata file")
+                << errinfo::filename(temporary);
+    }
+    write_all(fd, info, len, temporary);
+    // The data has to be on disk before the rename is, or a crash could
+    // leave an empty entry.
+    if (fdatasync(fd) < 0) {
+        const int errnum = errno;
+        close(fd);
+        unlink(temporary.c_str());
+        errno = errnum;
+        OSERROR(fdatasync, "Cannot write metadata")
+                << errinfo::filename(temporary);
+    }
+    close(fd);
+    if (rename(temporary.c_str(), file.c_str()) < 0) {
+        const int errnum = errno;
+        unlink(temporary.c_str());
+        errno = errnum;
+        OSERROR(rename, "Cannot rename temporary metadata file")
+                << errinfo::filename(temporary);
+    }
+    // Persist the rename. If this fails, the entry is only lost on a crash
+    // and saved again next time, so it is not worth an error.
+    const int dir_fd = open(m_directory.c_str(),
+                            O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return infohash;
+}
+
+std::string metadata_store_t::path(const infohash_t &infohash) const
+{
+    return m_directory + "/" + to_hex(infohash) + ".info";
+}
@@ -0,0 +1,56 @@
+#include <map>
+
+#include <torrentbatch.hpp>
+
+
+const char *to_string(batch_result_e result) noexcept
+{
+    switch (result) {
+    case batch_result_e::OK:              return "ok";
+    case batch_result_e::UNKNOWN_TORRENT: return "unknown_torrent";
+    case batch_result_e::INVALID_FILE:    return "invalid_file";
+    case batch_result_e::FAILED:          return "failed";
+    case batch_result_e::SUPERSEDED:      return "superseded";
+    }
+    return "unknown";
+}
+
+/**
+ * Merges @p ops per torrent. Torrents are ordered by their first operation.
+ */
+std::vector<torrent_batch_t> group_batch(const std::vector<batch_op_t> &ops)
+{
+    std::vector<torrent_batch_t> batches;
+    std::map<infohash_t, std::size_t> index;
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        const batch_op_t &op = ops[i];
+        auto result = index.emplace(op.infohash, batches.size());
+        if (result.second) {
+            batches.emplace_back();
+            batches.back().infohash = op.infohash;
+        }
+        torrent_batch_t &batch = batches[result.first->second];
+        batch.ops.push_back(i);
+
+        switch (op.action) {
+        case batch_action_e::PAUSE:
+            batch.pause = true;
+            batch.resume = false;
+            break;
+        case batch_action_e::RESUME:
+            batch.pause = false;
+            batch.resume = true;
+            break;
+        case batch_action_e::REMOVE_DATA:
+            batch.remove_data = true;
+            // fall through
+        case batch_action_e::REMOVE:
+            batch.remove = true;
+            break;
+        case batch_action_e::FILE_PRIORITY:
+            batch.file_priorities[op.file] = op.priority;
+            break;
+        }
+    }
+    return batches;
+}
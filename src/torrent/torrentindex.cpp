@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <string>
+
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/tuple/tuple.hpp>
+
+#include <torrentindex.hpp>
+
+namespace mi = boost::multi_index;
+
+
+namespace {
+
+/**
+ * Sort keys of a torrent.
+ */
+struct item_t {
+    infohash_t      infohash;
+    torrent_state_e state;
+    std::string     name;
+    std::int64_t    size;
+    float           progress;
+    std::int64_t    added;
+    float           ratio;
+
+    explicit item_t(const torrent_status_t &status)
+        : infohash(status.infohash), state(status.state), name(status.name)
+        , size(status.total_wanted), progress(status.progress)
+        , added(status.added_time), ratio(status.ratio) {}
+
+    bool operator ==(const item_t &other) const noexcept {
+        return state == other.state && name == other.name
+            && size == other.size && progress == other.progress
+            && added == other.added && ratio == other.ratio;
+    }
+};
+
+using infohash_key = mi::member<item_t, infohash_t, &item_t::infohash>;
+using state_key    = mi::member<item_t, torrent_state_e, &item_t::state>;
+
+/**
+ * Indexes by @p key_t, with and without the state as first key. The infohash
+ * makes all keys unique, so the order is deterministic.
+ */
+template<typename key_t>
+using sorted_by = mi::ranked_unique<
+    mi::composite_key<item_t, key_t, infohash_key>>;
+template<typename key_t>
+using sorted_by_state = mi::ranked_unique<
+    mi::composite_key<item_t, state_key, key_t, infohash_key>>;
+
+using name_key     = mi::member<item_t, std::string, &item_t::name>;
+using size_key     = mi::member<item_t, std::int64_t, &item_t::size>;
+using progress_key = mi::member<item_t, float, &item_t::progress>;
+using added_key    = mi::member<item_t, std::int64_t, &item_t::added>;
+using ratio_key    = mi::member<item_t, float, &item_t::ratio>;
+
+/**
+ * Index 0 looks up items by infohash. Index `1 + sort` sorts by the key,
+ * index `6 + sort` sorts by state and key.
+ */
+using container_t = mi::multi_index_container<item_t, mi::indexed_by<
+    mi::ordered_unique<infohash_key>,
+    sorted_by<name_key>,
+    sorted_by<size_key>,
+    sorted_by<progress_key>,
+    sorted_by<added_key>,
+    sorted_by<ratio_key>,
+    sorted_by_state<name_key>,
+    sorted_by_state<size_key>,
+    sorted_by_state<progress_key>,
+    sorted_by_state<added_key>,
+    sorted_by_state<ratio_key>
+>>;
+
+/**
+ * Collects the page of @p query out of the items with ranks from @p begin to
+ * @p end (exclusive) in @p index.
+ */
+template<typename index_t>
+torrent_page_t collect(const index_t &index, std::size_t begin,
+                       std::size_t end, const torrent_query_t &query,
+                       const torrent_status_store_t &store)
+{
+    torrent_page_t page;
+    page.total = end - begin;
+    if (query.offset >= page.total) {
+        return page;
+    }
+    std::size_t count = std::min(query.limit, page.total - query.offset);
+    page.entries.reserve(count);
+
+    auto it = index.nth(query.descending ? end - 1 - query.offset
+                                         : begin + query.offset);
+    for (std::size_t i = 0; i < count; ++i) {
+        page.entries.push_back(store.find(it->infohash));
+        if (query.descending) {
+            --it;
+        } else {
+            ++it;
+        }
+    }
+    return page;
+}
+
+template<std::size_t sort>
+torrent_page_t query_by(const container_t &items,
+                        const torrent_query_t &query,
+                        const torrent_status_store_t &store)
+{
+    if (!query.filter_state) {
+        const auto &index = items.get<1 + sort>();
+        return collect(index, 0, index.size(), query, store);
+    }
+    const auto &index = items.get<6 + sort>();
+    const auto key = boost::make_tuple(query.state);
+    return collect(index, index.rank(index.lower_bound(key)),
+                   index.rank(index.upper_bound(key)), query, store);
+}
+
+} // namespace
+
+
+struct torrent_index_t::items_t {
+    container_t items;
+};
+
+
+/**
+ * Indexes all torrents of @p store and follows its changes.
+ */
+torrent_index_t::torrent_index_t(torrent_status_store_t *store)
+    : m_store(store)
+    , m_items(new items_t)
+{
+    rebuild();
+    m_listener = m_store->add_listener([this](std::uint64_t version) {
+        update(version);
+    });
+}
+
+torrent_index_t::~torrent_index_t() noexcept
+{
+    m_store->remove_listener(m_listener);
+}
+
+/**
+ * Returns a page of torrents. Costs O(log n + `query.limit`).
+ */
+torrent_page_t torrent_index_t::query(const torrent_query_t &query) const
+{
+    const container_t &items = m_items->items;
+    switch (query.sort) {
+    case torrent_sort_e::NAME:     return query_by<0>(items, query, *m_store);
+    case torrent_sort_e::SIZE:     return query_by<1>(items, query, *m_store);
+    case torrent_sort_e::PROGRESS: return query_by<2>(items, query, *m_store);
+    case torrent_sort_e::ADDED:    return query_by<3>(items, query, *m_store);
+    case torrent_sort_e::RATIO:    return query_by<4>(items, query, *m_store);
+    }
+    return {};
+}
+
+std::size_t torrent_index_t::size() const noexcept
+{
+    return m_items->items.size();
+}
+
+/**
+ * Applies the changes of the store since the last call.
+ */
+void torrent_index_t::update(std::uint64_t version)
+{
+    if (m_version < m_store->horizon()) {
+        // Tombstones have been pruned before we have seen them.
+        rebuild();
+        return;
+    }
+    auto &by_hash = m_items->items.get<0>();
+    for (const auto *entry : m_store->changes(m_version)) {
+        auto it = by_hash.find(entry->status.infohash);
+        if (entry->removed) {
+            if (it != by_hash.end()) {
+                by_hash.erase(it);
+            }
+            continue;
+        }
+        item_t item(entry->status);
+        if (it == by_hash.end()) {
+            by_hash.insert(std::move(item));
+        } else if (!(*it == item)) {
+            // Only changed keys move the item within the trees.
+            by_hash.replace(it, std::move(item));
+        }
+    }
+    m_version = version;
+}
+
+void torrent_index_t::rebuild()
+{
+    m_items->items.clear();
+    for (const auto *entry : m_store->entries()) {
+        m_items->items.emplace(entry->status);
+    }
+    m_version = m_store->version();
+}
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cstddef>
+
+#include <torrentstatus.hpp>
+
+
+std::string to_hex(const infohash_t &infohash)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    std::string result(2 * infohash.size(), '0');
+    for (std::size_t i = 0; i < infohash.size(); ++i) {
+        result[2 * i]     = hex_digits[infohash[i] >> 4];
+        result[2 * i + 1] = hex_digits[infohash[i] & 0x0F];
+    }
+    return result;
+}
+
+const char *to_string(torrent_state_e state) noexcept
+{
+    switch (state) {
+    case torrent_state_e::CHECKING_FILES:       return "checking_files";
+    case torrent_state_e::DOWNLOADING_METADATA: return "downloading_metadata";
+    case torrent_state_e::DOWNLOADING:          return "downloading";
+    case torrent_state_e::FINISHED:             return "finished";
+    case torrent_state_e::SEEDING:              return "seeding";
+    case torrent_state_e::ALLOCATING:           return "allocating";
+    case torrent_state_e::CHECKING_RESUME_DATA: return "checking_resume_data";
+    }
+    return "unknown";
+}
+
+bool torrent_status_t::operator ==(const torrent_status_t &other) const noexcept
+{
+    return infohash == other.infohash
+            && name == other.name
+            && state == other.state
+            && progress == other.progress
+            && download_rate == other.download_rate
+            && upload_rate == other.upload_rate
+            && num_peers == other.num_peers
+            && num_seeds == other.num_seeds
+            && total_done == other.total_done
+            && total_wanted == other.total_wanted
+            && added_time == other.added_time
+            && ratio == other.ratio;
+}
+
+
+/**
+ * @param max_tombstones Amount of removed torrents which are remembered.
+ */
+torrent_status_store_t::torrent_status_store_t(std::size_t max_tombstones)
+    : m_max_tombstones(max_tombstones)
+{}
+
+/**
+ * Stores a batch of statuses, usually the content of one
+ * `state_update_alert`. Statuses equal to the stored ones are ignored.
+ * Listeners are called once if anything has changed.
+ */
+void torrent_status_store_t::update(
+        const std::vector<torrent_status_t> &statuses)
+{
+    bool changed = false;
+    for (const torrent_status_t &status : statuses) {
+        changed |= apply(status);
+    }
+    if (changed) {
+        prune_tombstones();
+        notify();
+    }
+}
+
+/**
+ * Marks a torrent as removed. Does nothing if the torrent is unknown.
+ */
+void torrent_status_store_t::remove(const infohash_t &infohash)
+{
+    auto it = m_entries.find(infohash);
+    if (it == m_entries.end() || it->second.removed) {
+        return;
+    }
+    it->second.removed = true;
+    set_version(it->second);
+    m_tombstones.insert(it->second.version);
+    prune_tombstones();
+    notify();
+}
+
+/**
+ * Returns all entries which have changed after version @p since, ordered by
+ * version. The result is only complete if @p since is not older than
+ * horizon(). Pointers are valid until the store is modified.
+ */
+std::vector<const torrent_status_store_t::entry_t*>
+torrent_status_store_t::changes(std::uint64_t since) const
+{
+    std::vector<const entry_t*> result;
+    for (auto it = m_by_version.upper_bound(since); it != m_by_version.end();
+            ++it) {
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+/**
+ * Returns all torrents which have not been removed, ordered by infohash.
+ * Pointers are valid until the store is modified.
+ */
+std::vector<const torrent_status_store_t::entry_t*>
+torrent_status_store_t::entries() const
+{
+    std::vector<const entry_t*> result;
+    result.reserve(m_entries.size() - m_tombstones.size());
+    for (const auto &entry : m_entries) {
+        if (!entry.second.removed) {
+            result.push_back(&entry.second);
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the torrent with @p infohash or `nullptr` if it is unknown or has
+ * been removed. The pointer is valid until the store is modified.
+ */
+const torrent_status_store_t::entry_t *
+torrent_status_store_t::find(const infohash_t &infohash) const
+{
+    auto it = m_entries.find(infohash);
+    if (it == m_entries.end() || it->second.removed) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+/**
+ * Registers a listener which is called after every change of the store.
+ * Listeners may remove themselves or other listeners when being called.
+ */
+torrent_status_store_t::listener_handle_t
+torrent_status_store_t::add_listener(const listener_t &listener)
+{
+    listener_handle_t handle = ++m_listener_max;
+    m_listeners.emplace(handle, listener);
+    return handle;
+}
+
+void torrent_status_store_t::remove_listener(listener_handle_t handle) noexcept
+{
+    m_listeners.erase(handle);
+}
+
+/**
+ * Stores a single status.
+ *
+ * @return Whether the store has been changed.
+ */
+bool torrent_status_store_t::apply(const torrent_status_t &status)
+{
+    auto result = m_entries.emplace(status.infohash,
+                                    entry_t{status, 0, false});
+    entry_t &entry = result.first->second;
+    if (!result.second) {
+        if (entry.removed) {
+            // Torrent has been added again.
+            m_tombstones.erase(entry.version);
+            entry.removed = false;
+        } else if (entry.status == status) {
+            return false;
+        }
+        entry.status = status;
+    }
+    set_version(entry);
+    return true;
+}
+
+void torrent_status_store_t::set_version(entry_t &entry)
+{
+    if (entry.version != 0) {
+        m_by_version.erase(entry.version);
+    }
+    entry.version = ++m_version;
+    m_by_version.emplace(entry.version, &entry);
+}
+
+void torrent_status_store_t::prune_tombstones()
+{
+    while (m_tombstones.size() > m_max_tombstones) {
+        std::uint64_t version = *m_tombstones.begin();
+        m_tombstones.erase(m_tombstones.begin());
+
+        // Clients which have not seen the removal yet need the full list.
+        auto it = m_by_version.find(version);
+        const infohash_t infohash = it->second->status.infohash;
+        m_by_version.erase(it);
+        m_entries.erase(infohash);
+        m_horizon = std::max(m_horizon, version);
+    }
+}
+
+void torrent_status_store_t::notify()
+{
+    // Listeners may be removed while iterating.
+    std::vector<listener_handle_t> handles;
+    handles.reserve(m_listeners.size());
+    for (const auto &listener : m_listeners) {
+        handles.push_back(listener.first);
+    }
+    for (listener_handle_t handle : handles) {
+        auto it = m_listeners.find(handle);
+        if (it != m_listeners.end()) {
+            // Copy, the listener may remove itself.
+            listener_t listener = it->second;
+            listener(m_version);
+        }
+    }
+}
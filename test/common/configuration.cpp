@@ -1,6 +1,11 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
 #include <vector>
 
 #include <sysexits.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
@@ -84,6 +89,20 @@ TEST(ConfigurationDeathTest, ConfigurationFileInvalidFormat) {
 }
 
 
+TEST(ConfigurationDeathTest, NumberOutOfRange) {
+    for (const char *arg : {"--httpd.worker-threads=0",
+                            "--httpd.worker-queue=-1",
+                            "--httpd.cache-size=-1",
+                            "--httpd.upload-limit=0",
+                            "--httpd.stats-interval=0",
+                            "--httpd.longpoll-timeout=-5"}) {
+        std::vector<const char*> argv = {"", arg};
+        EXPECT_EXIT({
+                load_configuration(argv.size(), argv.data());
+        }, ::testing::ExitedWithCode(EX_CONFIG), "has to be between") << arg;
+    }
+}
+
 TEST(ConfigurationTest, NoArguments) {
     std::vector<const char*> argv = {""};
     load_configuration(argv.size(), argv.data());
@@ -109,6 +128,23 @@ TEST(ConfigurationTest, NoArguments) {
 
     EXPECT_EQ(  "/", config.httpd.prefix);
     EXPECT_EQ( 8080, config.httpd.port);
+    EXPECT_EQ(  256, config.httpd.readahead_budget);
+    EXPECT_EQ(   30, config.httpd.longpoll_timeout);
+    EXPECT_EQ( 1000, config.httpd.stats_interval);
+    EXPECT_EQ(   64, config.httpd.cache_size);
+    EXPECT_EQ(    4, config.httpd.worker_threads);
+    EXPECT_EQ(   64, config.httpd.worker_queue);
+    EXPECT_EQ(   16, config.httpd.upload_limit);
+    EXPECT_EQ(  250, config.httpd.max_loop_lag);
+    EXPECT_EQ( 1024, config.httpd.max_suspended);
+    EXPECT_EQ(    0, config.httpd.rate_limit);
+    EXPECT_EQ(    0, config.httpd.client_rate_limit);
+    EXPECT_EQ(    0, config.httpd.download_rate_limit);
+    EXPECT_EQ(   "", config.httpd.status_shm);
+    EXPECT_EQ(   "", config.httpd.trace_file);
+    EXPECT_EQ(   "", config.httpd.handoff_socket);
+    EXPECT_EQ(   "", config.httpd.unix_socket);
+    EXPECT_EQ("0660", config.httpd.unix_socket_mode);
 }
 
 TEST(ConfigurationTest, HttpdPrefixEnsureSlash) {
@@ -132,6 +168,15 @@ TEST(ConfigurationTest, HttpdPrefixDontAddRedundantSlash) {
     EXPECT_EQ("/prefix/", config.httpd.prefix);
 }
 
+TEST(ConfigurationTest, HttpdUnixSocketMode) {
+    std::vector<const char*> argv = {"", "--httpd.unix-socket=/run/lts.sock",
+                                     "--httpd.unix-socket-mode=600"};
+    load_configuration(argv.size(), argv.data());
+
+    EXPECT_EQ("/run/lts.sock", config.httpd.unix_socket);
+    EXPECT_EQ("600", config.httpd.unix_socket_mode);
+}
+
 TEST(ConfigurationTest, StorageTmpdirDefaultsToDownloads) {
     std::vector<const char*> argv = {"", "--storage.downloads=some-dir"};
     load_configuration(argv.size(), argv.data());
@@ -154,3 +199,88 @@ TEST(ConfigurationTest, UseIniFile) {
 
     EXPECT_EQ(1234, config.httpd.port);
 }
+
+
+class ConfigurationReloadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/xlts-configuration-XXXXXX";
+        int fd = mkstemp(tmpl);
+        ASSERT_LE(0, fd);
+        close(fd);
+        path = tmpl;
+    }
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    void write(const char *content) {
+        std::ofstream(path) << content;
+    }
+
+    std::string path;
+    std::vector<std::string> pending;
+};
+
+TEST_F(ConfigurationReloadTest, PublishesNewSnapshot) {
+    write("[httpd]\ncache-size=32\n");
+    std::vector<const char*> argv = {"", "--inifile", path.c_str()};
+    load_configuration(argv.size(), argv.data());
+    const auto before = current_config();
+    EXPECT_EQ(32, before->httpd.cache_size);
+
+    write("[httpd]\ncache-size=48\nlongpoll-timeout=5\n");
+    const auto after = reload_configuration(pending);
+    EXPECT_EQ(after, current_config());
+    EXPECT_EQ(48, after->httpd.cache_size);
+    EXPECT_EQ( 5, after->httpd.longpoll_timeout);
+
+    // Snapshots and the startup configuration never change.
+    EXPECT_EQ(32, before->httpd.cache_size);
+    EXPECT_EQ(32, config.httpd.cache_size);
+}
+
+TEST_F(ConfigurationReloadTest, CommandLineTakesPrecedence) {
+    write("[httpd]\nstats-interval=100\n");
+    std::vector<const char*> argv = {"", "--inifile", path.c_str(),
+                                     "--httpd.stats-interval=500"};
+    load_configuration(argv.size(), argv.data());
+
+    write("[httpd]\nstats-interval=200\n");
+    EXPECT_EQ(500, reload_configuration(pending)->httpd.stats_interval);
+}
+
+TEST_F(ConfigurationReloadTest, KeepsStaticSettings) {
+    write("[httpd]\nport=1000\nprefix=a\n");
+    std::vector<const char*> argv = {"", "--inifile", path.c_str()};
+    load_configuration(argv.size(), argv.data());
+
+    write("[httpd]\nport=2000\nprefix=b\nupload-limit=1\n");
+    const auto after = reload_configuration(pending);
+    EXPECT_EQ(1000, after->httpd.port);
+    EXPECT_EQ("/a/", after->httpd.prefix);
+    EXPECT_EQ(1, after->httpd.upload_limit);
+    EXPECT_EQ(std::vector<std::string>({"httpd.port", "httpd.prefix"}),
+              pending);
+}
+
+TEST_F(ConfigurationReloadTest, RejectsInvalidFile) {
+    write("[httpd]\ncache-size=32\n");
+    std::vector<const char*> argv = {"", "--inifile", path.c_str()};
+    load_configuration(argv.size(), argv.data());
+    const auto before = current_config();
+
+    write("[httpd]\ncache-size=many\n");
+    EXPECT_THROW(reload_configuration(pending), configuration_error);
+    write("[httpd]\nunix-socket-mode=rw\n");
+    EXPECT_THROW(reload_configuration(pending), configuration_error);
+    write("[httpd]\nstats-interval=0\n");
+    EXPECT_THROW(reload_configuration(pending), configuration_error);
+    write("[httpd]\ncache-size=-1\n");
+    EXPECT_THROW(reload_configuration(pending), configuration_error);
+    write("[httpd]\nno-such-option=1\n");
+    EXPECT_THROW(reload_configuration(pending), configuration_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(reload_configuration(pending), configuration_error);
+    EXPECT_EQ(before, current_config());
+}
@@ -69,6 +69,14 @@ TEST(ErrorHandlingTest, OSErrorMacroHasMessage) {
     }
 }
 
+TEST(ErrorHandlingTest, OSFileErrorHasMessage) {
+    try {
+        THROW(os_file_error("42 /\\"));
+    } catch (const os_error &e) {
+        EXPECT_STREQ("42 /\\", e.what());
+    }
+}
+
 TEST(ErrorHandlingTest, OSErrorMacroSetsApiFunction) {
     try {
         OSERROR(read, "");
@@ -0,0 +1,203 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <eventloop.hpp>
+#include <sockethandoff.hpp>
+
+
+class SocketHandoffTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = "/tmp/xlts-handoff-" + std::to_string(getpid());
+    }
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    static int listen_tcp() {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        listen(fd, 4);
+        return fd;
+    }
+    static int port_of(int fd) {
+        sockaddr_in address = {};
+        socklen_t size = sizeof(address);
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size);
+        return ntohs(address.sin_port);
+    }
+
+    std::string path;
+};
+
+
+TEST_F(SocketHandoffTest, NoProcessListening) {
+    EXPECT_EQ(-1, socket_handoff_t::receive_listen_socket(path));
+}
+
+TEST_F(SocketHandoffTest, PassesListeningSocket) {
+    const int listen_fd = listen_tcp();
+    const int port = port_of(listen_fd);
+
+    eventloop_t eventloop;
+    int released = 0;
+    socket_handoff_t handoff(&eventloop, path, [&] { return listen_fd; },
+                             [&] { ++released; });
+    EXPECT_FALSE(handoff.done());
+
+    int received = -1;
+    std::thread receiver([&] {
+        received = socket_handoff_t::receive_listen_socket(path);
+    });
+    eventloop.exec([&] { return handoff.done(); });
+    receiver.join();
+
+    EXPECT_EQ(1, released);
+    ASSERT_LE(0, received);
+    EXPECT_NE(listen_fd, received);
+    EXPECT_EQ(port, port_of(received));
+
+    // The received socket accepts connections of the same port.
+    const int client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    ASSERT_EQ(0, connect(client, reinterpret_cast<sockaddr*>(&address),
+                         sizeof(address)));
+    const int accepted = accept(received, nullptr, nullptr);
+    EXPECT_LE(0, accepted);
+
+    close(accepted);
+    close(client);
+    close(received);
+    close(listen_fd);
+}
+
+TEST_F(SocketHandoffTest, OnlyOneProcessTakesOver) {
+    const int listen_fd = listen_tcp();
+    eventloop_t eventloop;
+    socket_handoff_t handoff(&eventloop, path, [&] { return listen_fd; },
+                             [] {});
+
+    std::thread receiver([&] {
+        close(socket_handoff_t::receive_listen_socket(path));
+    });
+    eventloop.exec([&] { return handoff.done(); });
+    receiver.join();
+
+    // The path is left for the new process.
+    EXPECT_EQ(-1, socket_handoff_t::receive_listen_socket(path));
+    close(listen_fd);
+}
+
+TEST_F(SocketHandoffTest, ReplacesStaleSocket) {
+    eventloop_t eventloop;
+    {
+        socket_handoff_t handoff(&eventloop, path, [] { return -1; },
+                                 [] {});
+    }
+    EXPECT_NE(0, access(path.c_str(), F_OK));
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    ASSERT_EQ(0, bind(fd, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address)));
+    close(fd);
+    EXPECT_NO_THROW(socket_handoff_t(&eventloop, path, [] { return -1; },
+                                     [] {}));
+}
+
+TEST_F(SocketHandoffTest, KeepsSocketIfNewProcessQuits) {
+    const int listen_fd = listen_tcp();
+    eventloop_t eventloop;
+    int released = 0;
+    socket_handoff_t handoff(&eventloop, path, [&] { return listen_fd; },
+                             [&] { ++released; });
+
+    // A process which quits without confirming the receipt.
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    ASSERT_EQ(0, connect(fd, reinterpret_cast<sockaddr*>(&address),
+                         sizeof(address)));
+    close(fd);
+    bool timeout = false;
+    eventloop.call([&] { timeout = true; eventloop.notify(); },
+                   std::chrono::milliseconds(200));
+    eventloop.exec([&] { return timeout; });
+
+    EXPECT_EQ(0, released);
+    EXPECT_FALSE(handoff.done());
+
+    // The next process still takes over.
+    int received = -1;
+    std::thread receiver([&] {
+        received = socket_handoff_t::receive_listen_socket(path);
+    });
+    eventloop.exec([&] { return handoff.done(); });
+    receiver.join();
+    EXPECT_EQ(1, released);
+    EXPECT_EQ(port_of(listen_fd), port_of(received));
+    close(received);
+    close(listen_fd);
+}
+
+TEST_F(SocketHandoffTest, ServesWhileWaitingForConfirmation) {
+    const int listen_fd = listen_tcp();
+    eventloop_t eventloop;
+    int released = 0;
+    socket_handoff_t handoff(&eventloop, path, [&] { return listen_fd; },
+                             [&] { ++released; });
+
+    // A process which hangs without confirming the receipt.
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    ASSERT_EQ(0, connect(fd, reinterpret_cast<sockaddr*>(&address),
+                         sizeof(address)));
+
+    // Other events are still handled while waiting.
+    const auto start = std::chrono::steady_clock::now();
+    bool called = false;
+    eventloop.call([&] { called = true; eventloop.notify(); },
+                   std::chrono::milliseconds(100));
+    eventloop.exec([&] { return called; });
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              socket_handoff_t::ack_timeout);
+    EXPECT_FALSE(handoff.done());
+
+    // The next process takes over after the timeout.
+    bool timeout = false;
+    eventloop.call([&] { timeout = true; eventloop.notify(); },
+                   socket_handoff_t::ack_timeout);
+    eventloop.exec([&] { return timeout; });
+    EXPECT_EQ(0, released);
+    int received = -1;
+    std::thread receiver([&] {
+        received = socket_handoff_t::receive_listen_socket(path);
+    });
+    eventloop.exec([&] { return handoff.done(); });
+    receiver.join();
+    EXPECT_EQ(1, released);
+    EXPECT_EQ(port_of(listen_fd), port_of(received));
+    close(received);
+    close(fd);
+    close(listen_fd);
+}
@@ -0,0 +1,85 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <workerpool.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+// Blocks jobs until it is opened.
+class gate_t {
+public:
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [this] { return open; });
+    }
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            open = true;
+        }
+        cond.notify_all();
+    }
+private:
+    std::mutex mtx;
+    std::condition_variable cond;
+    bool open = false;
+};
+
+static void wait_until(const std::function<bool()> &condition)
+{
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (!condition() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+
+TEST(WorkerPoolTest, RunsJobs) {
+    worker_pool_t pool(2, 16);
+    std::atomic<int> done{0};
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(pool.try_submit([&] { ++done; }));
+    }
+    wait_until([&] { return done == 10; });
+    EXPECT_EQ(10, done);
+    wait_until([&] { return pool.stats().completed == 10; });
+    EXPECT_EQ(10u, pool.stats().completed);
+}
+
+TEST(WorkerPoolTest, RejectsJobsWhenQueueIsFull) {
+    gate_t gate;
+    worker_pool_t pool(1, 2);
+    ASSERT_TRUE(pool.try_submit([&] { gate.wait(); }));
+    wait_until([&] { return pool.stats().running == 1; });
+
+    EXPECT_TRUE(pool.try_submit([] {}));
+    EXPECT_TRUE(pool.try_submit([] {}));
+    EXPECT_FALSE(pool.try_submit([] {}));
+
+    worker_pool_t::stats_t stats = pool.stats();
+    EXPECT_EQ(2u, stats.queue_length);
+    EXPECT_EQ(1u, stats.running);
+    EXPECT_EQ(1u, stats.rejected);
+
+    gate.release();
+    wait_until([&] { return pool.stats().completed == 3; });
+    EXPECT_TRUE(pool.try_submit([] {}));
+}
+
+TEST(WorkerPoolTest, SurvivesFailingJobs) {
+    worker_pool_t pool(1, 4);
+    std::atomic<bool> done{false};
+    EXPECT_TRUE(pool.try_submit([] { throw std::runtime_error("failed"); }));
+    // Not derived from std::exception.
+    EXPECT_TRUE(pool.try_submit([] { throw 42; }));
+    EXPECT_TRUE(pool.try_submit([&] { done = true; }));
+    wait_until([&] { return done.load(); });
+    EXPECT_TRUE(done);
+}
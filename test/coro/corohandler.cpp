@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <corohandler.hpp>
+#include <httptest.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+static MHD_Response *text_response(const std::string &text)
+{
+    return MHD_create_response_from_buffer(
+            text.size(), const_cast<char*>(text.data()),
+            MHD_RESPMEM_MUST_COPY);
+}
+
+
+class CoroHandlerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+};
+
+
+TEST_F(CoroHandlerTest, ReceivesUploadInChunks) {
+    std::vector<std::string> chunks;
+    server->add_route("POST", "upload", coro_route(server.get(),
+            [&](std::shared_ptr<coro_request_t> request) -> coro_task_t {
+        std::string data;
+        while (true) {
+            std::string_view chunk = co_await request->next_chunk();
+            if (chunk.empty())
+                break;
+            chunks.emplace_back(chunk);
+            data += chunk;
+            // The connection is suspended meanwhile.
+            co_await sleep_for(&eventloop, 5ms);
+        }
+        request->respond(MHD_HTTP_OK, text_response(data));
+    }));
+
+    http_reply_t reply = http_exchange(eventloop, port,
+            "POST /upload HTTP/1.0", {"first,", "second,", "third"});
+    EXPECT_EQ(MHD_HTTP_OK, reply.status);
+    EXPECT_EQ("first,second,third", reply.body);
+    EXPECT_LE(2u, chunks.size());
+    EXPECT_EQ(0u, server->active_requests());
+}
+
+TEST_F(CoroHandlerTest, RespondsAfterSuspending) {
+    server->add_route("GET", "slow", coro_route(server.get(),
+            [&](std::shared_ptr<coro_request_t> request) -> coro_task_t {
+        co_await sleep_for(&eventloop, 20ms);
+        request->respond(MHD_HTTP_ACCEPTED, text_response("done"));
+    }));
+
+    const auto start = std::chrono::steady_clock::now();
+    http_reply_t reply = http_exchange(eventloop, port,
+                                       "GET /slow HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_ACCEPTED, reply.status);
+    EXPECT_EQ("done", reply.body);
+    EXPECT_LE(20ms, std::chrono::steady_clock::now() - start);
+}
+
+TEST_F(CoroHandlerTest, RespondsWithoutSuspending) {
+    server->add_route("GET", "fast", coro_route(server.get(),
+            [](std::shared_ptr<coro_request_t> request) -> coro_task_t {
+        request->respond(MHD_HTTP_OK, text_response("fast"));
+        co_return;
+    }));
+
+    http_reply_t reply = http_exchange(eventloop, port,
+                                       "GET /fast HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_OK, reply.status);
+    EXPECT_EQ("fast", reply.body);
+}
+
+TEST_F(CoroHandlerTest, FailsIfCoroutineDoesNotRespond) {
+    server->add_route("GET", "silent", coro_route(server.get(),
+            [&](std::shared_ptr<coro_request_t>) -> coro_task_t {
+        co_await sleep_for(&eventloop, 5ms);
+    }));
+
+    http_reply_t reply = http_exchange(eventloop, port,
+                                       "GET /silent HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_INTERNAL_SERVER_ERROR, reply.status);
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <coroutine.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+TEST(CoroutineTest, ReusesFrames) {
+    void *frame = allocate_frame(100);
+    deallocate_frame(frame, 100);
+    void *other = allocate_frame(120);
+    EXPECT_EQ(frame, other);
+    deallocate_frame(other, 120);
+
+    void *large = allocate_frame(1 << 16);
+    deallocate_frame(large, 1 << 16);
+}
+
+TEST(CoroutineTest, ResumesAfterTimer) {
+    eventloop_t eventloop;
+    bool done = false;
+    auto start = std::chrono::steady_clock::now();
+    [&]() -> coro_task_t {
+        co_await sleep_for(&eventloop, 10ms);
+        done = true;
+        eventloop.notify();
+    }();
+    EXPECT_FALSE(done);
+    eventloop.exec([&] { return done; });
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 10ms);
+}
+
+TEST(CoroutineTest, ReturnsResultOfWorker) {
+    eventloop_t eventloop;
+    worker_pool_t pool(1, 4);
+    std::thread::id loop_thread = std::this_thread::get_id();
+    std::thread::id worker_thread, resumed_thread;
+    std::string result, error;
+    bool done = false;
+    [&]() -> coro_task_t {
+        result = co_await run_on(&pool, &eventloop, [&] {
+            worker_thread = std::this_thread::get_id();
+            return std::string("result");
+        });
+        resumed_thread = std::this_thread::get_id();
+        try {
+            co_await run_on(&pool, &eventloop, [] {
+                throw std::runtime_error("failed");
+            });
+        } catch (const std::runtime_error &e) {
+            error = e.what();
+        }
+        done = true;
+        eventloop.notify();
+    }();
+    eventloop.exec([&] { return done; });
+
+    EXPECT_EQ("result", result);
+    EXPECT_EQ("failed", error);
+    EXPECT_NE(loop_thread, worker_thread);
+    EXPECT_EQ(loop_thread, resumed_thread);
+}
+
+TEST(CoroutineTest, ThrowsIfPoolIsFull) {
+    eventloop_t eventloop;
+    worker_pool_t pool(0, 0);
+    bool rejected = false;
+    [&]() -> coro_task_t {
+        try {
+            co_await run_on(&pool, &eventloop, [] {});
+        } catch (const pool_full_error &) {
+            rejected = true;
+        }
+    }();
+    EXPECT_TRUE(rejected);
+}
+
+TEST(CoroutineTest, WaitsForStoreChange) {
+    torrent_status_store_t store;
+    std::uint64_t version = 0;
+    [&]() -> coro_task_t {
+        version = co_await next_change(&store);
+    }();
+    EXPECT_EQ(0u, version);
+
+    torrent_status_t status;
+    status.infohash.fill(1);
+    store.update({status});
+    EXPECT_EQ(store.version(), version);
+
+    // The awaitable has unregistered itself.
+    status.download_rate = 1;
+    store.update({status});
+    EXPECT_NE(store.version(), version);
+}
@@ -0,0 +1,214 @@
+#ifndef HTTPTEST_HPP
+#define HTTPTEST_HPP
+
+/**
+ * @file httptest.hpp
+ * File contains helpers for tests which send requests to an
+ * {@link httpserver_t} over the loopback interface.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <eventloop.hpp>
+
+
+/**
+ * Reply received by http_exchange().
+ */
+struct http_reply_t {
+    unsigned int status = 0;
+    //! Status line and headers, separated by CRLF.
+    std::string head;
+    std::string body;
+
+    /**
+     * Returns the value of the first header @p name or an empty string. The
+     * name is compared case-sensitively.
+     */
+    std::string header(const std::string &name) const {
+        const std::string key = "\r\n" + name + ": ";
+        const std::size_t begin = head.find(key);
+        if (begin == std::string::npos) {
+            return std::string();
+        }
+        const std::size_t value = begin + key.size();
+        return head.substr(value, head.find("\r\n", value) - value);
+    }
+};
+
+/**
+ * Returns a listening socket on an ephemeral port of 127.0.0.1. Pass it to
+ * the constructor of {@link httpserver_t}.
+ *
+ * @param[out] port Receives the port.
+ * @return The socket or -1 on errors.
+ */
+inline int http_listen_loopback(std::uint16_t &port)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(addr);
+    if (fd < 0
+            || bind(fd, reinterpret_cast<sockaddr*>(&addr), size) < 0
+            || listen(fd, 16) < 0
+            || getsockname(fd, reinterpret_cast<sockaddr*>(&addr),
+                           &size) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * Sends a request from another thread and runs @p eventloop until the reply
+ * has been received. The request uses HTTP/1.0, so the server closes the
+ * connection after the reply and sends the body without chunked encoding.
+ *
+ * @param head    Request line and headers without the final empty line, e.g.
+ *                `"GET /torrents HTTP/1.0\r\nAccept: application/cbor"`.
+ * @param body    Parts of the body. They are sent one by one with a short
+ *                pause in between, so the server receives several chunks.
+ *                `Content-Length` is added if there are any.
+ * @return The reply. Its status is zero if the connection failed.
+ */
+inline http_reply_t http_exchange(eventloop_t &eventloop, std::uint16_t port,
+                                  const std::string &head,
+                                  const std::vector<std::string> &body = {})
+{
+    http_reply_t reply;
+    bool done = false;
+    std::thread client([&] {
+        std::string request = head + "\r\n";
+        std::size_t length = 0;
+        for (const std::string &part : body) {
+            length += part.size();
+        }
+        if (!body.empty()) {
+            request += "Content-Length: " + std::to_string(length) + "\r\n";
+        }
+        request += "\r\n";
+
+        const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        std::string raw;
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                    sizeof(addr)) == 0) {
+            send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+            for (const std::string &part : body) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                send(fd, part.data(), part.size(), MSG_NOSIGNAL);
+            }
+            char buf[4096];
+            ssize_t ret;
+            while ((ret = recv(fd, buf, sizeof(buf), 0)) != 0) {
+                if (ret > 0) {
+                    raw.append(buf, ret);
+                } else if (errno != EINTR) {
+                    break;
+                }
+            }
+        }
+        close(fd);
+
+        const std::size_t end = raw.find("\r\n\r\n");
+        if (raw.compare(0, 5, "HTTP/") == 0 && end != std::string::npos) {
+            reply.status = static_cast<unsigned int>(
+                    std::strtoul(raw.c_str() + raw.find(' '), nullptr, 10));
+            reply.head = raw.substr(0, end);
+            reply.body = raw.substr(end + 4);
+        }
+        // The loop checks the condition again only after notify().
+        eventloop.call([&] { done = true; eventloop.notify(); });
+    });
+    eventloop.exec([&] { return done; });
+    client.join();
+    return reply;
+}
+
+/**
+ * Client of a response which does not end by itself, e.g. a stream of
+ * Server-Sent Events. The constructor sends the request, the test runs the
+ * event loop and collects the received data by read().
+ */
+class http_stream_client_t
+{
+public:
+    /**
+     * @param head Request line and headers, see http_exchange().
+     */
+    http_stream_client_t(std::uint16_t port, const std::string &head) {
+        m_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        // Connecting does not need the server, the listen queue accepts.
+        if (connect(m_fd, reinterpret_cast<sockaddr*>(&addr),
+                    sizeof(addr)) == 0) {
+            const std::string request = head + "\r\n\r\n";
+            send(m_fd, request.data(), request.size(), MSG_NOSIGNAL);
+        }
+    }
+    ~http_stream_client_t() {
+        close();
+    }
+    http_stream_client_t(const http_stream_client_t &) = delete;
+    http_stream_client_t &operator=(const http_stream_client_t &) = delete;
+
+    /**
+     * Returns the data received since the last call without waiting. The
+     * first call also returns the status line and headers.
+     */
+    std::string read() {
+        std::string data;
+        char buf[4096];
+        ssize_t ret;
+        while (m_fd >= 0
+                && (ret = recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT)) != 0) {
+            if (ret > 0) {
+                data.append(buf, ret);
+            } else if (errno != EINTR) {
+                return data;
+            }
+        }
+        m_eof = m_fd >= 0;
+        return data;
+    }
+
+    //! Whether read() has seen the end of the response.
+    bool eof() const noexcept { return m_eof; }
+
+    //! Closes the connection.
+    void close() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+private:
+    int m_fd;
+    bool m_eof = false;
+};
+
+#endif // HTTPTEST_HPP
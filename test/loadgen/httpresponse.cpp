@@ -0,0 +1,78 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <httpresponse.hpp>
+
+
+static std::size_t feed(http_response_parser_t &parser, const std::string &data)
+{
+    return parser.feed(data.data(), data.size());
+}
+
+
+TEST(HttpResponseParserTest, ParsesContentLength) {
+    const std::string response = "HTTP/1.1 200 OK\r\n"
+                                 "Content-Length: 5\r\n"
+                                 "\r\n"
+                                 "hello"
+                                 "HTTP/1.1 404 Not Found\r\n";
+    http_response_parser_t parser;
+    EXPECT_EQ(response.find("HTTP/1.1 404"), feed(parser, response));
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(200, parser.status());
+    EXPECT_EQ(5u, parser.body_size());
+    EXPECT_TRUE(parser.keep_alive());
+}
+
+TEST(HttpResponseParserTest, ParsesChunksByteByByte) {
+    const std::string response = "HTTP/1.1 200 OK\r\n"
+                                 "transfer-encoding: Chunked\r\n"
+                                 "\r\n"
+                                 "3\r\nabc\r\n"
+                                 "a;ext=1\r\n0123456789\r\n"
+                                 "0\r\n"
+                                 "\r\n";
+    http_response_parser_t parser;
+    for (char c : response) {
+        ASSERT_FALSE(parser.done());
+        EXPECT_EQ(1u, parser.feed(&c, 1));
+    }
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(13u, parser.body_size());
+}
+
+TEST(HttpResponseParserTest, HandlesResponsesWithoutBody) {
+    http_response_parser_t parser(true);
+    feed(parser, "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n");
+    EXPECT_TRUE(parser.done());
+
+    parser.reset(false);
+    feed(parser, "HTTP/1.1 100 Continue\r\n\r\n"
+                 "HTTP/1.1 304 Not Modified\r\n\r\n");
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(304, parser.status());
+}
+
+TEST(HttpResponseParserTest, ReadsUntilClose) {
+    http_response_parser_t parser;
+    feed(parser, "HTTP/1.0 200 OK\r\n\r\nbody");
+    EXPECT_FALSE(parser.done());
+    EXPECT_FALSE(parser.keep_alive());
+    parser.close();
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(4u, parser.body_size());
+}
+
+TEST(HttpResponseParserTest, RejectsMalformedResponses) {
+    http_response_parser_t parser;
+    EXPECT_THROW(feed(parser, "HTTX/1.1 200 OK\r\n"), http_parse_error);
+
+    parser.reset(false);
+    feed(parser, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc");
+    EXPECT_THROW(parser.close(), http_parse_error);
+
+    parser.reset(false);
+    EXPECT_THROW(feed(parser, "HTTP/1.1 200 OK\r\nContent-Length: x\r\n"),
+                 http_parse_error);
+}
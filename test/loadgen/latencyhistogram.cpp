@@ -0,0 +1,55 @@
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include <latencyhistogram.hpp>
+
+using std::chrono::nanoseconds;
+
+
+TEST(LatencyHistogramTest, CountsSmallValuesExactly) {
+    latency_histogram_t histogram;
+    for (int i = 1; i <= 100; ++i) {
+        histogram.record(nanoseconds(i));
+    }
+    EXPECT_EQ(100u, histogram.count());
+    EXPECT_EQ(nanoseconds(50), histogram.percentile(50));
+    EXPECT_EQ(nanoseconds(99), histogram.percentile(99));
+    EXPECT_EQ(nanoseconds(100), histogram.percentile(100));
+    EXPECT_EQ(nanoseconds(100), histogram.max());
+}
+
+TEST(LatencyHistogramTest, BoundsRelativeError) {
+    for (std::int64_t value = 1000; value < 10000000000; value *= 3) {
+        latency_histogram_t single;
+        single.record(nanoseconds(value));
+        single.record(nanoseconds(value * 2));
+        const double reported = single.percentile(50).count();
+        EXPECT_GE(reported, value);
+        EXPECT_LE(reported, value * 1.016);
+    }
+}
+
+TEST(LatencyHistogramTest, ReportsTail) {
+    latency_histogram_t histogram;
+    for (int i = 0; i < 999; ++i) {
+        histogram.record(std::chrono::milliseconds(1));
+    }
+    histogram.record(std::chrono::seconds(2));
+
+    EXPECT_NEAR(1e6, histogram.percentile(99.9).count(), 1e6 * 0.016);
+    EXPECT_EQ(std::chrono::seconds(2), histogram.percentile(99.99));
+    EXPECT_EQ(std::chrono::seconds(2), histogram.max());
+}
+
+TEST(LatencyHistogramTest, Merges) {
+    latency_histogram_t a, b;
+    a.record(nanoseconds(10));
+    b.record(nanoseconds(20));
+    b.record(nanoseconds(-5));
+    a.merge(b);
+    EXPECT_EQ(3u, a.count());
+    EXPECT_EQ(nanoseconds(0), a.percentile(0));
+    EXPECT_EQ(nanoseconds(20), a.max());
+    EXPECT_EQ(nanoseconds(0), latency_histogram_t().percentile(50));
+}
@@ -0,0 +1,130 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <loadgenerator.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+/**
+ * Minimal HTTP server answering every request with a short response, after
+ * an optional delay of the first response.
+ */
+class StubServer {
+public:
+    explicit StubServer(std::chrono::milliseconds first_delay = 0ms)
+        : first_delay(first_delay) {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address));
+        socklen_t size = sizeof(address);
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &size);
+        port = std::to_string(ntohs(address.sin_port));
+        listen(listen_fd, 16);
+        acceptor = std::thread([this] { accept_loop(); });
+    }
+    ~StubServer() {
+        shutdown(listen_fd, SHUT_RDWR);
+        close(listen_fd);
+        acceptor.join();
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    std::string port;
+    std::atomic<int> requests{0};
+
+private:
+    void accept_loop() {
+        int fd;
+        while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0) {
+            threads.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+    void serve(int fd) {
+        static const std::string response =
+                "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+        std::string in;
+        char buffer[1024];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+            in.append(buffer, n);
+            std::size_t end;
+            while ((end = in.find("\r\n\r\n")) != std::string::npos) {
+                in.erase(0, end + 4);
+                if (requests++ == 0)
+                    std::this_thread::sleep_for(first_delay);
+                write(fd, response.data(), response.size());
+            }
+        }
+        close(fd);
+    }
+
+    const std::chrono::milliseconds first_delay;
+    int listen_fd;
+    std::thread acceptor;
+    std::vector<std::thread> threads;
+};
+
+static request_mix_t make_mix()
+{
+    load_request_t request;
+    request.target = "/torrents";
+    request_mix_t mix;
+    mix.add(1, request);
+    return mix;
+}
+
+
+TEST(LoadGeneratorTest, SendsRequestsAtRate) {
+    StubServer server;
+    load_generator_t::options_t options;
+    options.port = server.port;
+    options.connections = 2;
+    load_generator_t generator(options);
+
+    const load_report_t report =
+            generator.run(synthetic_source(make_mix(), 200, 200ms));
+    EXPECT_EQ(40u, report.completed);
+    EXPECT_EQ(0u, report.errors);
+    EXPECT_EQ(40u, report.statuses.at(200));
+    EXPECT_EQ(80u, report.bytes);
+    EXPECT_EQ(40u, report.latency.count());
+    EXPECT_GE(report.elapsed, 195ms);
+    EXPECT_EQ(40, server.requests);
+}
+
+TEST(LoadGeneratorTest, ChargesStallsToWaitingRequests) {
+    StubServer server(100ms);
+    load_generator_t::options_t options;
+    options.port = server.port;
+    options.connections = 1;
+    load_generator_t generator(options);
+
+    // 50 requests are due while the first response is delayed.
+    const load_report_t report =
+            generator.run(synthetic_source(make_mix(), 1000, 50ms));
+    EXPECT_EQ(50u, report.completed);
+    EXPECT_GE(report.latency.percentile(50), 50ms);
+    EXPECT_LT(report.service_time.percentile(50), 50ms);
+}
+
+TEST(LoadGeneratorTest, FailsWithoutServer) {
+    load_generator_t::options_t options;
+    options.port = "1"; // Nothing is expected to listen there.
+    load_generator_t generator(options);
+    EXPECT_ANY_THROW(generator.run(synthetic_source(make_mix(), 1, 1s)));
+}
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <admission.hpp>
+#include <eventloop.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+class AdmissionControlTest : public ::testing::Test {
+protected:
+    // Runs the event loop for the given duration.
+    void run_for(std::chrono::milliseconds duration) {
+        bool done = false;
+        eventloop.call([&] { done = true; }, duration);
+        eventloop.exec([&] { return done; });
+    }
+
+    // Blocks the event loop, as an expensive request would do.
+    void block_loop(std::chrono::milliseconds duration) {
+        eventloop.call([duration] { std::this_thread::sleep_for(duration); },
+                       1ms);
+    }
+
+    static admission_control_t::limits_t limits(
+            std::chrono::milliseconds max_lag, std::size_t max_suspended) {
+        admission_control_t::limits_t limits;
+        limits.max_lag = max_lag;
+        limits.max_suspended = max_suspended;
+        return limits;
+    }
+
+    eventloop_t eventloop;
+};
+
+
+TEST_F(AdmissionControlTest, AdmitsIdleServer) {
+    admission_control_t admission(&eventloop, limits(100ms, 10));
+    run_for(200ms);
+    EXPECT_LT(admission.lag(), 100ms);
+    EXPECT_TRUE(admission.admit(route_priority_e::NORMAL, 0));
+    EXPECT_FALSE(admission.overloaded());
+    EXPECT_EQ(0u, admission.stats().rejected);
+}
+
+TEST_F(AdmissionControlTest, RejectsNormalRequestsWhileLagging) {
+    admission_control_t admission(&eventloop, limits(100ms, 0));
+    block_loop(admission_control_t::probe_interval + 300ms);
+    run_for(admission_control_t::probe_interval * 2);
+
+    EXPECT_GE(admission.lag(), 200ms);
+    EXPECT_FALSE(admission.admit(route_priority_e::NORMAL, 0));
+    EXPECT_TRUE(admission.admit(route_priority_e::HIGH, 0));
+    EXPECT_TRUE(admission.overloaded());
+    EXPECT_EQ(1u, admission.stats().rejected);
+    EXPECT_EQ(1u, admission.stats().overloads);
+
+    // The lag decays when the loop is idle again.
+    run_for(1s);
+    EXPECT_LT(admission.lag(), 100ms);
+    EXPECT_TRUE(admission.admit(route_priority_e::NORMAL, 0));
+    EXPECT_FALSE(admission.overloaded());
+}
+
+TEST_F(AdmissionControlTest, RejectsNormalRequestsWithManySuspended) {
+    admission_control_t admission(&eventloop, limits(0ms, 2));
+    EXPECT_TRUE(admission.admit(route_priority_e::NORMAL, 2));
+    EXPECT_FALSE(admission.admit(route_priority_e::NORMAL, 3));
+    EXPECT_TRUE(admission.admit(route_priority_e::HIGH, 3));
+}
+
+TEST_F(AdmissionControlTest, ZeroDisablesLimits) {
+    admission_control_t admission(&eventloop, limits(0ms, 0));
+    block_loop(admission_control_t::probe_interval + 200ms);
+    run_for(admission_control_t::probe_interval * 2);
+    EXPECT_TRUE(admission.admit(route_priority_e::NORMAL, 100000));
+
+    admission.set_limits(limits(50ms, 0));
+    EXPECT_FALSE(admission.admit(route_priority_e::NORMAL, 0));
+}
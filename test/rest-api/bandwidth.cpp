@@ -0,0 +1,167 @@
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bandwidth.hpp>
+#include <eventloop.hpp>
+
+using namespace std::literals::chrono_literals;
+
+//! 1000 KiB/s, which is 100 KiB per 100 ms.
+static constexpr std::uint64_t rate = 1000 << 10;
+
+
+TEST(TokenBucketTest, StartsWithBurst) {
+    const auto now = std::chrono::steady_clock::now();
+    token_bucket_t bucket(rate, now);
+    EXPECT_EQ(rate / 4, bucket.available(now));
+
+    token_bucket_t small(1000, now);
+    EXPECT_EQ(token_bucket_t::min_burst, small.available(now));
+}
+
+TEST(TokenBucketTest, RefillsWithRate) {
+    const auto now = std::chrono::steady_clock::now();
+    token_bucket_t bucket(rate, now);
+    bucket.consume(rate / 4);
+    EXPECT_EQ(0u, bucket.available(now));
+    EXPECT_EQ(100ms, std::chrono::duration_cast<std::chrono::milliseconds>(
+                  bucket.time_until(rate / 10) + 500us));
+
+    EXPECT_NEAR(rate / 10, bucket.available(now + 100ms), 1);
+    // Never more than the burst.
+    EXPECT_EQ(rate / 4, bucket.available(now + 10s));
+}
+
+TEST(TokenBucketTest, PaysBackDebt) {
+    const auto now = std::chrono::steady_clock::now();
+    token_bucket_t bucket(rate, now);
+    bucket.consume(rate / 2);
+    EXPECT_EQ(0u, bucket.available(now + 100ms));
+    EXPECT_NEAR(rate / 8, bucket.available(now + 375ms), 1);
+}
+
+TEST(TokenBucketTest, ZeroIsUnlimited) {
+    const auto now = std::chrono::steady_clock::now();
+    token_bucket_t bucket(0, now);
+    bucket.consume(1ull << 40);
+    EXPECT_EQ(std::numeric_limits<std::uint64_t>::max(),
+              bucket.available(now));
+    EXPECT_EQ(0ns, bucket.time_until(1ull << 40));
+
+    // Limiting starts with a small burst.
+    bucket.set_rate(rate, now);
+    EXPECT_EQ(token_bucket_t::min_burst, bucket.available(now));
+}
+
+
+class BandwidthSchedulerTest : public ::testing::Test {
+protected:
+    // Runs the event loop for the given duration.
+    void run_for(std::chrono::milliseconds duration) {
+        bool done = false;
+        eventloop.call([&] { done = true; eventloop.notify(); }, duration);
+        eventloop.exec([&] { return done; });
+    }
+
+    static bandwidth_scheduler_t::limits_t limits(std::uint64_t global,
+                                                  std::uint64_t client,
+                                                  std::uint64_t download) {
+        bandwidth_scheduler_t::limits_t limits;
+        limits.global = global;
+        limits.client = client;
+        limits.download = download;
+        return limits;
+    }
+
+    // Opens a flow which records its pauses.
+    std::unique_ptr<bandwidth_flow_t> open(bandwidth_scheduler_t &scheduler,
+                                           const std::string &client,
+                                           std::vector<bool> &pauses) {
+        return scheduler.open(client, [&pauses](bool pause) {
+            pauses.push_back(pause);
+        });
+    }
+
+    eventloop_t eventloop;
+};
+
+
+TEST_F(BandwidthSchedulerTest, UnlimitedGrantsEverything) {
+    bandwidth_scheduler_t scheduler(&eventloop, limits(0, 0, 0));
+    std::vector<bool> pauses;
+    auto flow = open(scheduler, "10.0.0.1", pauses);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(1u << 20, flow->grant(1 << 20));
+    }
+    EXPECT_TRUE(pauses.empty());
+    EXPECT_EQ(100u << 20, scheduler.stats().sent);
+    EXPECT_EQ(1u, scheduler.stats().downloads);
+    EXPECT_EQ(1u, scheduler.stats().clients);
+}
+
+TEST_F(BandwidthSchedulerTest, PausesAndContinuesFlow) {
+    bandwidth_scheduler_t scheduler(&eventloop, limits(0, 0, rate));
+    std::vector<bool> pauses;
+    auto flow = open(scheduler, "10.0.0.1", pauses);
+    EXPECT_EQ(rate / 4, flow->grant(1 << 20));
+    EXPECT_EQ(0u, flow->grant(64 << 10));
+    EXPECT_EQ(std::vector<bool>{true}, pauses);
+    EXPECT_EQ(1u, scheduler.stats().paused);
+
+    // Continued when min_grant bytes are available, after about 16 ms.
+    run_for(50ms);
+    EXPECT_EQ((std::vector<bool>{true, false}), pauses);
+    EXPECT_GE(flow->grant(64 << 10), bandwidth_scheduler_t::min_grant);
+}
+
+TEST_F(BandwidthSchedulerTest, ClientSharesBucket) {
+    bandwidth_scheduler_t scheduler(&eventloop, limits(0, rate, 0));
+    std::vector<bool> pauses1, pauses2, pauses3;
+    auto flow1 = open(scheduler, "10.0.0.1", pauses1);
+    auto flow2 = open(scheduler, "10.0.0.1", pauses2);
+    auto flow3 = open(scheduler, "10.0.0.2", pauses3);
+    EXPECT_EQ(2u, scheduler.stats().clients);
+
+    EXPECT_EQ(rate / 4, flow1->grant(1 << 20));
+    EXPECT_EQ(0u, flow2->grant(1 << 20));
+    // Another client is not affected.
+    EXPECT_EQ(rate / 4, flow3->grant(1 << 20));
+    EXPECT_TRUE(pauses1.empty());
+    EXPECT_EQ(std::vector<bool>{true}, pauses2);
+    EXPECT_TRUE(pauses3.empty());
+
+    flow1.reset();
+    flow2.reset();
+    EXPECT_EQ(1u, scheduler.stats().clients);
+    EXPECT_EQ(1u, scheduler.stats().downloads);
+    // The timer of the closed flow is ignored.
+    run_for(50ms);
+    EXPECT_EQ(std::vector<bool>{true}, pauses2);
+}
+
+TEST_F(BandwidthSchedulerTest, ChargeSharesGlobalBudget) {
+    bandwidth_scheduler_t scheduler(&eventloop, limits(rate, 0, 0));
+    std::vector<bool> pauses;
+    auto flow = open(scheduler, "10.0.0.1", pauses);
+    scheduler.charge(rate / 4);
+    EXPECT_EQ(0u, flow->grant(64 << 10));
+    EXPECT_EQ(std::vector<bool>{true}, pauses);
+}
+
+TEST_F(BandwidthSchedulerTest, SetLimitsContinuesPausedFlows) {
+    bandwidth_scheduler_t scheduler(&eventloop, limits(rate, 0, 0));
+    std::vector<bool> pauses;
+    auto flow = open(scheduler, "10.0.0.1", pauses);
+    EXPECT_EQ(rate / 4, flow->grant(1 << 20));
+    EXPECT_EQ(0u, flow->grant(1 << 20));
+
+    scheduler.set_limits(limits(0, 0, 0));
+    EXPECT_EQ((std::vector<bool>{true, false}), pauses);
+    EXPECT_EQ(0u, scheduler.limits().global);
+    EXPECT_EQ(1u << 20, flow->grant(1 << 20));
+}
@@ -0,0 +1,43 @@
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <bandwidthapi.hpp>
+
+
+static bandwidth_scheduler_t::limits_t current_limits()
+{
+    bandwidth_scheduler_t::limits_t limits;
+    limits.global = 1000;
+    limits.client = 200;
+    limits.download = 30;
+    return limits;
+}
+
+
+TEST(BandwidthApiTest, ParsesLimits) {
+    auto limits = parse_bandwidth_limits(
+            "{\"global\": 0, \"client\": 1048576, \"download\": 65536}",
+            current_limits());
+    EXPECT_EQ(0u, limits.global);
+    EXPECT_EQ(1048576u, limits.client);
+    EXPECT_EQ(65536u, limits.download);
+}
+
+TEST(BandwidthApiTest, KeepsMissingLimits) {
+    auto limits = parse_bandwidth_limits("{\"client\": 400}",
+                                         current_limits());
+    EXPECT_EQ(1000u, limits.global);
+    EXPECT_EQ(400u, limits.client);
+    EXPECT_EQ(30u, limits.download);
+}
+
+TEST(BandwidthApiTest, RejectsInvalidLimits) {
+    EXPECT_THROW(parse_bandwidth_limits("{\"global\": -1}", current_limits()),
+                 std::runtime_error);
+    EXPECT_THROW(parse_bandwidth_limits("{\"global\": \"fast\"}",
+                                        current_limits()),
+                 std::runtime_error);
+    EXPECT_THROW(parse_bandwidth_limits("[1, 2", current_limits()),
+                 std::runtime_error);
+}
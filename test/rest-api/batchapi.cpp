@@ -0,0 +1,60 @@
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <batchapi.hpp>
+
+
+static const std::string hash1(40, 'a');
+static const std::string hash2 = "0123456789ABCDEF0123456789abcdef01234567";
+
+
+TEST(BatchApiTest, ParsesOperations) {
+    auto ops = parse_batch("{\"operations\": ["
+        "{\"op\": \"pause\", \"torrent\": \"" + hash1 + "\"},"
+        "{\"op\": \"resume\", \"torrent\": \"" + hash2 + "\"},"
+        "{\"op\": \"remove\", \"torrent\": \"" + hash1 + "\"},"
+        "{\"op\": \"remove\", \"torrent\": \"" + hash1 + "\", \"data\": true},"
+        "{\"op\": \"file-priority\", \"torrent\": \"" + hash2 + "\","
+            " \"file\": 12, \"priority\": 7}"
+    "]}");
+    ASSERT_EQ(5u, ops.size());
+    for (const auto &op : ops) {
+        ASSERT_TRUE(op);
+    }
+    EXPECT_EQ(batch_action_e::PAUSE, ops[0]->action);
+    EXPECT_EQ(0xAA, ops[0]->infohash[0]);
+    EXPECT_EQ(batch_action_e::RESUME, ops[1]->action);
+    EXPECT_EQ(0x01, ops[1]->infohash[0]);
+    EXPECT_EQ(0xEF, ops[1]->infohash[7]);
+    EXPECT_EQ(batch_action_e::REMOVE, ops[2]->action);
+    EXPECT_EQ(batch_action_e::REMOVE_DATA, ops[3]->action);
+    EXPECT_EQ(batch_action_e::FILE_PRIORITY, ops[4]->action);
+    EXPECT_EQ(12, ops[4]->file);
+    EXPECT_EQ(7, ops[4]->priority);
+}
+
+TEST(BatchApiTest, MarksInvalidOperations) {
+    auto ops = parse_batch("{\"operations\": ["
+        "{\"op\": \"explode\", \"torrent\": \"" + hash1 + "\"},"
+        "{\"op\": \"pause\", \"torrent\": \"abc\"},"
+        "{\"op\": \"pause\"},"
+        "{\"op\": \"file-priority\", \"torrent\": \"" + hash1 + "\"},"
+        "{\"op\": \"file-priority\", \"torrent\": \"" + hash1 + "\","
+            " \"file\": \"x\", \"priority\": 1},"
+        "{\"op\": \"file-priority\", \"torrent\": \"" + hash1 + "\","
+            " \"file\": 1, \"priority\": 8},"
+        "{\"op\": \"pause\", \"torrent\": \"" + hash1 + "\"}"
+    "]}");
+    ASSERT_EQ(7u, ops.size());
+    for (std::size_t i = 0; i < 6; ++i) {
+        EXPECT_FALSE(ops[i]) << i;
+    }
+    EXPECT_TRUE(ops[6]);
+}
+
+TEST(BatchApiTest, RejectsMalformedBody) {
+    EXPECT_THROW(parse_batch("{\"operations\": ["), std::runtime_error);
+    EXPECT_THROW(parse_batch("{\"ops\": []}"), std::runtime_error);
+}
@@ -0,0 +1,111 @@
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <cborwriter.hpp>
+#include <jsonwriter.hpp>
+
+
+/**
+ * Returns @p data as lowercase hexadecimal string.
+ */
+static std::string hex(const std::string &data) {
+    static const char digits[] = "0123456789abcdef";
+    std::string result;
+    for (unsigned char c : data) {
+        result += digits[c >> 4];
+        result += digits[c & 0x0F];
+    }
+    return result;
+}
+
+template<typename writer_t>
+static void write_record(writer_t &out) {
+    const std::string infohash(20, '\xab');
+    out.begin_object()
+        .key("infohash").binary(infohash.data(), infohash.size())
+        .key("name").value("debian.iso")
+        .key("state").value("seeding")
+        .key("progress").value(1.0)
+        .key("download_rate").value(0)
+        .key("upload_rate").value(123456)
+        .key("peers").value(12)
+        .key("seeds").value(3)
+        .key("total_done").value(4000000000ll)
+        .key("total_wanted").value(4000000000ll)
+        .key("added").value(1700000000ll)
+        .key("ratio").value(0.5)
+        .end_object();
+}
+
+
+TEST(CborWriterTest, WritesNestedStructures) {
+    buffer_chain_t out;
+    cbor_writer_t cbor(out);
+    cbor.begin_object()
+        .key("a").value(1)
+        .key("b").begin_array().value(true).value(false).null().end_array()
+        .end_object();
+    EXPECT_EQ("bf" "6161" "01" "6162" "9f" "f5" "f4" "f6" "ff" "ff",
+              hex(out.str()));
+}
+
+TEST(CborWriterTest, WritesKnownKeysAsIndex) {
+    buffer_chain_t out;
+    cbor_writer_t cbor(out);
+    cbor.begin_object()
+        .key("infohash").null()
+        .key("msg").null()
+        .key("info").null()
+        .end_object();
+    EXPECT_EQ("bf" "00f6" "12f6" "64696e666ff6" "ff", hex(out.str()));
+    EXPECT_STREQ("infohash", cbor_key_names[0]);
+    EXPECT_STREQ("msg", cbor_key_names[18]);
+}
+
+TEST(CborWriterTest, WritesIntegersInShortestForm) {
+    // Examples of RFC 8949, appendix A.
+    buffer_chain_t out;
+    cbor_writer_t cbor(out);
+    cbor.value(0).value(23).value(24).value(255).value(256).value(65535)
+        .value(65536).value(4294967296ull)
+        .value(std::numeric_limits<std::uint64_t>::max());
+    EXPECT_EQ("00" "17" "1818" "18ff" "190100" "19ffff" "1a00010000"
+              "1b0000000100000000" "1bffffffffffffffff", hex(out.str()));
+}
+
+TEST(CborWriterTest, WritesNegativeIntegers) {
+    buffer_chain_t out;
+    cbor_writer_t cbor(out);
+    cbor.value(-1).value(-24).value(-25).value(-1000)
+        .value(std::numeric_limits<std::int64_t>::min());
+    EXPECT_EQ("20" "37" "3818" "3903e7" "3b7fffffffffffffff",
+              hex(out.str()));
+}
+
+TEST(CborWriterTest, WritesStringsAndBinary) {
+    buffer_chain_t out;
+    cbor_writer_t cbor(out);
+    cbor.value("").value("IETF").value(std::string(24, 'x'))
+        .binary("\x01\x02\x03\x04", 4);
+    EXPECT_EQ("60" "6449455446" "7818" + hex(std::string(24, 'x'))
+              + "4401020304", hex(out.str()));
+}
+
+TEST(CborWriterTest, WritesDoubles) {
+    buffer_chain_t out;
+    cbor_writer_t cbor(out);
+    cbor.value(1.5).value(0.1).value(std::nan("")).value(HUGE_VAL);
+    EXPECT_EQ("fa3fc00000" "fb3fb999999999999a" "f6" "f6", hex(out.str()));
+}
+
+TEST(CborWriterTest, IsSmallerThanJson) {
+    buffer_chain_t json_out, cbor_out;
+    json_writer_t json(json_out);
+    cbor_writer_t cbor(cbor_out);
+    write_record(json);
+    write_record(cbor);
+    EXPECT_LT(cbor_out.str().size(), json_out.str().size() / 2);
+}
@@ -0,0 +1,65 @@
+#include <string>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <compression.hpp>
+
+
+static std::string gunzip(const std::string &data)
+{
+    z_stream stream = {};
+    EXPECT_EQ(Z_OK, inflateInit2(&stream, 15 + 16));
+    std::string result(1 << 20, '\0');
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in  = data.size();
+    stream.next_out  = reinterpret_cast<Bytef*>(&result[0]);
+    stream.avail_out = result.size();
+    EXPECT_EQ(Z_STREAM_END, inflate(&stream, Z_FINISH));
+    result.resize(stream.total_out);
+    inflateEnd(&stream);
+    return result;
+}
+
+
+TEST(CompressionTest, GzipRoundTrip) {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data += "{\"name\":\"torrent-" + std::to_string(i) + "\"},";
+    }
+    std::string compressed = compress(data, content_coding_e::GZIP);
+    ASSERT_FALSE(compressed.empty());
+    EXPECT_LT(compressed.size(), data.size() / 4);
+    EXPECT_EQ(data, gunzip(compressed));
+}
+
+TEST(CompressionTest, IdentityKeepsData) {
+    EXPECT_EQ("abc", compress("abc", content_coding_e::IDENTITY));
+}
+
+#ifdef XLTS_USE_BROTLI
+TEST(CompressionTest, BrotliCompresses) {
+    std::string data(10000, 'x');
+    std::string compressed = compress(data, content_coding_e::BROTLI);
+    ASSERT_FALSE(compressed.empty());
+    EXPECT_LT(compressed.size(), 100u);
+}
+#endif
+
+TEST(CompressionTest, AcceptsListedCodings) {
+    EXPECT_TRUE(accepts_coding("gzip, deflate, br", content_coding_e::GZIP));
+    EXPECT_TRUE(accepts_coding("gzip, deflate, br", content_coding_e::BROTLI));
+    EXPECT_TRUE(accepts_coding("GZIP", content_coding_e::GZIP));
+    EXPECT_FALSE(accepts_coding("deflate", content_coding_e::GZIP));
+    EXPECT_FALSE(accepts_coding(nullptr, content_coding_e::GZIP));
+    EXPECT_TRUE(accepts_coding(nullptr, content_coding_e::IDENTITY));
+}
+
+TEST(CompressionTest, HonorsQualityValues) {
+    EXPECT_FALSE(accepts_coding("gzip;q=0, br", content_coding_e::GZIP));
+    EXPECT_TRUE(accepts_coding("gzip;q=0.5", content_coding_e::GZIP));
+    EXPECT_TRUE(accepts_coding("*", content_coding_e::BROTLI));
+    EXPECT_FALSE(accepts_coding("*;q=0", content_coding_e::BROTLI));
+    EXPECT_FALSE(accepts_coding("gzip;q=0, *", content_coding_e::GZIP));
+    EXPECT_TRUE(accepts_coding("*;q=0, gzip", content_coding_e::GZIP));
+}
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <diskapi.hpp>
+#include <httptest.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+class DiskApiTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+    }
+
+    // Requests `GET /disk` and parses the body.
+    boost::property_tree::ptree get_disk() {
+        http_reply_t reply = http_exchange(eventloop, port,
+                                           "GET /disk HTTP/1.0");
+        EXPECT_EQ(MHD_HTTP_OK, reply.status);
+        EXPECT_EQ("application/json", reply.header("Content-type"));
+        boost::property_tree::ptree tree;
+        std::istringstream in(reply.body);
+        boost::property_tree::read_json(in, tree);
+        return tree;
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+};
+
+
+TEST_F(DiskApiTest, ShowsQueueDepths) {
+    // Without worker threads, all jobs stay queued.
+    disk_scheduler_t scheduler(0);
+    disk_api_t disk_api(server.get(), &scheduler);
+    scheduler.submit(io_class_e::NORMAL, [] {});
+    scheduler.submit(io_class_e::NORMAL, [] {});
+    scheduler.submit(io_class_e::BACKGROUND, [] {});
+
+    boost::property_tree::ptree tree = get_disk();
+    EXPECT_EQ(0, tree.get<int>("interactive.queue_depth"));
+    EXPECT_EQ(2, tree.get<int>("normal.queue_depth"));
+    EXPECT_EQ(1, tree.get<int>("background.queue_depth"));
+    EXPECT_EQ(0, tree.get<int>("normal.started"));
+    EXPECT_EQ(disk_scheduler_t::histogram_size,
+              tree.get_child("normal.wait_histogram").size());
+}
+
+TEST_F(DiskApiTest, ShowsStartedJobs) {
+    disk_scheduler_t scheduler(1);
+    disk_api_t disk_api(server.get(), &scheduler);
+    std::atomic<int> done{0};
+    for (int i = 0; i < 3; ++i) {
+        scheduler.submit(io_class_e::INTERACTIVE, [&] { ++done; });
+    }
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (done < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    boost::property_tree::ptree tree = get_disk();
+    EXPECT_EQ(3, tree.get<int>("interactive.started"));
+    EXPECT_EQ(0, tree.get<int>("interactive.queue_depth"));
+    int waits = 0;
+    for (const auto &bucket : tree.get_child("interactive.wait_histogram")) {
+        waits += bucket.second.get_value<int>();
+    }
+    EXPECT_EQ(3, waits);
+}
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <eventstream.hpp>
+#include <httptest.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+class EventStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+        stream.reset(new event_stream_t(server.get()));
+        server->add_route("GET", "events", [this](MHD_Connection *c) {
+            return stream->subscribe(c);
+        });
+    }
+    void TearDown() override {
+        stream.reset();
+        server.reset();
+    }
+
+    // Runs the event loop for the given duration.
+    void run_for(std::chrono::milliseconds duration) {
+        bool done = false;
+        eventloop.call([&] { done = true; eventloop.notify(); }, duration);
+        eventloop.exec([&] { return done; });
+    }
+
+    // Returns the received data without status line and headers.
+    static std::string read_events(http_stream_client_t &client) {
+        const std::string data = client.read();
+        const std::size_t end = data.find("\r\n\r\n");
+        return end == std::string::npos ? data : data.substr(end + 4);
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+    std::unique_ptr<event_stream_t> stream;
+};
+
+
+TEST_F(EventStreamTest, SendsEventToAllSubscribers) {
+    http_stream_client_t first(port, "GET /events HTTP/1.0");
+    http_stream_client_t second(port, "GET /events HTTP/1.0");
+    run_for(20ms);
+    EXPECT_EQ(2u, stream->subscribers());
+    EXPECT_EQ("", read_events(first));
+    EXPECT_EQ("", read_events(second));
+
+    stream->publish("{\"a\":1}");
+    run_for(20ms);
+    EXPECT_EQ("id: 1\ndata: {\"a\":1}\n\n", first.read());
+    EXPECT_EQ("id: 1\ndata: {\"a\":1}\n\n", second.read());
+}
+
+TEST_F(EventStreamTest, ResumesSuspendedSubscribers) {
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(20ms);
+    read_events(client);
+    // The subscriber is suspended in between and woken up by every event.
+    for (int i = 1; i <= 3; ++i) {
+        stream->publish(std::to_string(i));
+        run_for(20ms);
+        EXPECT_EQ("id: " + std::to_string(i) + "\ndata: "
+                  + std::to_string(i) + "\n\n", client.read());
+        run_for(10ms);
+        EXPECT_EQ("", client.read());
+    }
+    EXPECT_EQ(1u, server->active_requests());
+}
+
+TEST_F(EventStreamTest, SkipsEventsForSlowSubscribers) {
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(20ms);
+    read_events(client);
+
+    // Events published before the subscriber could send them are dropped.
+    stream->publish("first");
+    stream->publish("second");
+    stream->publish("third");
+    run_for(20ms);
+    EXPECT_EQ("id: 3\ndata: third\n\n", client.read());
+}
+
+TEST_F(EventStreamTest, SendsLatestEventToNewSubscribers) {
+    stream->publish("old");
+    stream->publish("latest");
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(20ms);
+    EXPECT_EQ("id: 2\ndata: latest\n\n", read_events(client));
+}
+
+TEST_F(EventStreamTest, DropsDisconnectedSubscribers) {
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(20ms);
+    EXPECT_EQ(1u, stream->subscribers());
+
+    // The server notices at the latest when sending fails.
+    client.close();
+    for (int i = 0; i < 2; ++i) {
+        stream->publish("event");
+        run_for(20ms);
+    }
+    EXPECT_EQ(0u, stream->subscribers());
+    EXPECT_EQ(0u, server->active_requests());
+}
+
+TEST_F(EventStreamTest, EndsResponsesOnDestruction) {
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(20ms);
+    stream.reset();
+    run_for(20ms);
+    client.read();
+    EXPECT_TRUE(client.eof());
+}
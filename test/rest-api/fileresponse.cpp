@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <errorhandling.hpp>
+#include <fileresponse.hpp>
+#include <httpd.hpp>
+#include <httptest.hpp>
+
+
+class FileResponseTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        char tmpl[] = "/tmp/xlts-fileresponse-XXXXXX";
+        const int fd = mkstemp(tmpl);
+        ASSERT_LE(0, fd);
+        close(fd);
+        path = tmpl;
+        // Larger than a block, so the file is sent in several chunks.
+        for (int i = 0; content.size() < 200000; ++i) {
+            content += std::to_string(i) + ',';
+        }
+        std::ofstream(path) << content;
+
+        const int listen_fd = http_listen_loopback(port);
+        ASSERT_LE(0, listen_fd);
+        server.reset(new httpserver_t(&eventloop, listen_fd));
+    }
+    void TearDown() override {
+        server.reset();
+        unlink(path.c_str());
+    }
+
+    // Adds route `GET /file` which sends @p size bytes from @p offset.
+    void add_file_route(std::uint64_t offset, std::uint64_t size) {
+        server->add_route("GET", "file", [=](MHD_Connection *) {
+            return [=](MHD_Connection *connection, const char *,
+                       std::size_t *) {
+                file_fd = OSCHECK(open,(path.c_str(), O_RDONLY | O_CLOEXEC),
+                                  >= 0);
+                MHD_Response *r = create_file_response(file_fd, offset,
+                                                       size);
+                OSCHECK(MHD_queue_response,(connection, MHD_HTTP_OK, r),
+                        == MHD_YES);
+                MHD_destroy_response(r);
+            };
+        });
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+    std::string path;
+    std::string content;
+    int file_fd = -1;
+};
+
+
+TEST_F(FileResponseTest, SendsWholeFile) {
+    add_file_route(0, content.size());
+    http_reply_t reply = http_exchange(eventloop, port, "GET /file HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_OK, reply.status);
+    EXPECT_EQ(std::to_string(content.size()),
+              reply.header("Content-Length"));
+    EXPECT_TRUE(reply.body == content);
+}
+
+TEST_F(FileResponseTest, SendsRange) {
+    add_file_route(1000, 70000);
+    http_reply_t reply = http_exchange(eventloop, port, "GET /file HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_OK, reply.status);
+    EXPECT_TRUE(reply.body == content.substr(1000, 70000));
+}
+
+TEST_F(FileResponseTest, ClosesFile) {
+    add_file_route(0, 10);
+    http_exchange(eventloop, port, "GET /file HTTP/1.0");
+    ASSERT_LE(0, file_fd);
+    EXPECT_EQ(-1, fcntl(file_fd, F_GETFD));
+}
+
+TEST_F(FileResponseTest, AbortsAtEndOfFile) {
+    add_file_route(content.size() - 10, 1000);
+    http_reply_t reply = http_exchange(eventloop, port, "GET /file HTTP/1.0");
+    // The response is cut when the file ends early.
+    EXPECT_EQ(content.substr(content.size() - 10), reply.body);
+}
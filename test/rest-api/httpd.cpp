@@ -0,0 +1,213 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <gtest/gtest.h>
+
+#include <admission.hpp>
+#include <configuration.hpp>
+#include <httpd.hpp>
+#include <httptest.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+using work_result_t = std::pair<unsigned int, MHD_Response*>;
+
+
+static MHD_Response *text_response(const std::string &text)
+{
+    return MHD_create_response_from_buffer(
+            text.size(), const_cast<char*>(text.data()),
+            MHD_RESPMEM_MUST_COPY);
+}
+
+
+class HttpServerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+    }
+
+    // Adds route `GET /<path>` which runs @p work on a worker thread.
+    void add_offload_route(const std::string &path,
+                           const httpserver_t::blocking_work_t &work) {
+        server->add_route("GET", path, [this, work](MHD_Connection *) {
+            return server->offload(work);
+        });
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+};
+
+
+TEST_F(HttpServerTest, RespondsWithOffloadedWork) {
+    add_offload_route("work", [] {
+        return std::make_pair(MHD_HTTP_OK, text_response("done"));
+    });
+    http_reply_t reply = http_exchange(eventloop, port, "GET /work HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_OK, reply.status);
+    EXPECT_EQ("done", reply.body);
+    EXPECT_EQ(0u, server->active_requests());
+}
+
+TEST_F(HttpServerTest, FailsIfOffloadedWorkThrows) {
+    add_offload_route("error", []() -> work_result_t {
+        throw std::runtime_error("failed");
+    });
+    // Not derived from std::exception.
+    add_offload_route("unknown", []() -> work_result_t {
+        throw 42;
+    });
+    EXPECT_EQ(MHD_HTTP_INTERNAL_SERVER_ERROR,
+              http_exchange(eventloop, port, "GET /error HTTP/1.0").status);
+    EXPECT_EQ(MHD_HTTP_INTERNAL_SERVER_ERROR,
+              http_exchange(eventloop, port, "GET /unknown HTTP/1.0").status);
+    EXPECT_EQ(0u, server->active_requests());
+}
+
+TEST_F(HttpServerTest, FailsIfRouteThrows) {
+    server->add_route("GET", "route", [](MHD_Connection *)
+            -> httpserver_t::access_handler_t {
+        throw 42;
+    });
+    server->add_route("GET", "handler", [](MHD_Connection *) {
+        return [](MHD_Connection *, const char *, std::size_t *) {
+            throw std::runtime_error("failed");
+        };
+    });
+    EXPECT_EQ(MHD_HTTP_INTERNAL_SERVER_ERROR,
+              http_exchange(eventloop, port, "GET /route HTTP/1.0").status);
+    EXPECT_EQ(MHD_HTTP_INTERNAL_SERVER_ERROR,
+              http_exchange(eventloop, port, "GET /handler HTTP/1.0").status);
+    EXPECT_EQ(MHD_HTTP_NOT_FOUND,
+              http_exchange(eventloop, port, "GET /missing HTTP/1.0").status);
+}
+
+TEST_F(HttpServerTest, SendsErrorsInRequestedFormat) {
+    http_reply_t reply = http_exchange(eventloop, port,
+                                       "GET /missing HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_NOT_FOUND, reply.status);
+    EXPECT_EQ("application/json", reply.header("Content-type"));
+    EXPECT_EQ("{\"msg\":\"not found\"}", reply.body);
+
+    reply = http_exchange(eventloop, port,
+                          "GET /missing HTTP/1.0\r\n"
+                          "Accept: application/cbor");
+    EXPECT_EQ(MHD_HTTP_NOT_FOUND, reply.status);
+    EXPECT_EQ("application/cbor", reply.header("Content-type"));
+    // Map with key 18 ("msg") and text "not found".
+    EXPECT_EQ(std::string("\xbf\x12\x69" "not found" "\xff"), reply.body);
+}
+
+TEST_F(HttpServerTest, ShowsAdmissionStats) {
+    EXPECT_EQ(MHD_HTTP_NOT_FOUND,
+              http_exchange(eventloop, port,
+                            "GET /admission HTTP/1.0").status);
+
+    admission_control_t::limits_t limits;
+    limits.max_lag = 50ms;
+    limits.max_suspended = 10;
+    admission_control_t admission(&eventloop, limits);
+    server->set_admission_control(&admission);
+    server->add_route("GET", "work", [](MHD_Connection *) {
+        return [](MHD_Connection *connection, const char *, std::size_t *) {
+            MHD_Response *r = text_response("done");
+            MHD_queue_response(connection, MHD_HTTP_OK, r);
+            MHD_destroy_response(r);
+        };
+    });
+    // Block the loop, so the next probe is late.
+    eventloop.call([] { std::this_thread::sleep_for(200ms); }, 1ms);
+    bool done = false;
+    eventloop.call([&] { done = true; eventloop.notify(); }, 20ms);
+    eventloop.exec([&] { return done; });
+    EXPECT_EQ(MHD_HTTP_SERVICE_UNAVAILABLE,
+              http_exchange(eventloop, port, "GET /work HTTP/1.0").status);
+
+    // The route is served while the server is overloaded.
+    http_reply_t reply = http_exchange(eventloop, port,
+                                       "GET /admission HTTP/1.0");
+    EXPECT_EQ(MHD_HTTP_OK, reply.status);
+    EXPECT_EQ("application/json", reply.header("Content-type"));
+    boost::property_tree::ptree tree;
+    std::istringstream in(reply.body);
+    boost::property_tree::read_json(in, tree);
+    EXPECT_TRUE(tree.get<bool>("overloaded"));
+    EXPECT_LT(50.0, tree.get<double>("lag_ms"));
+    EXPECT_EQ(50, tree.get<int>("max_lag_ms"));
+    EXPECT_EQ(0, tree.get<int>("suspended"));
+    EXPECT_EQ(10, tree.get<int>("max_suspended"));
+    EXPECT_EQ(0, tree.get<int>("parked"));
+    EXPECT_EQ(0, tree.get<int>("throttled"));
+    EXPECT_EQ(1, tree.get<int>("rejected"));
+    EXPECT_EQ(1, tree.get<int>("overloads"));
+    server->set_admission_control(nullptr);
+}
+
+TEST_F(HttpServerTest, CountsOnlyWorkTowardsOverload) {
+    admission_control_t::limits_t limits;
+    limits.max_suspended = 1;
+    admission_control_t admission(&eventloop, limits);
+    server->set_admission_control(&admission);
+    // Suspends every connection for good, for the given reason.
+    for (suspension_e reason : {suspension_e::WORK, suspension_e::PARKED}) {
+        const std::string path =
+                reason == suspension_e::WORK ? "work" : "parked";
+        server->add_route("GET", path, [this, reason](MHD_Connection *) {
+            return [this, reason](MHD_Connection *connection, const char *,
+                                  std::size_t *) {
+                server->suspend(connection, reason);
+            };
+        });
+    }
+    server->add_route("GET", "status", [](MHD_Connection *) {
+        return [](MHD_Connection *connection, const char *, std::size_t *) {
+            MHD_Response *r = text_response("ok");
+            MHD_queue_response(connection, MHD_HTTP_OK, r);
+            MHD_destroy_response(r);
+        };
+    });
+    auto run_for = [this](std::chrono::milliseconds duration) {
+        bool done = false;
+        eventloop.call([&] { done = true; eventloop.notify(); }, duration);
+        eventloop.exec([&] { return done; });
+    };
+
+    // Idle long-polls and subscribers do not cause an overload.
+    http_stream_client_t first(port, "GET /parked HTTP/1.0");
+    http_stream_client_t second(port, "GET /parked HTTP/1.0");
+    run_for(20ms);
+    EXPECT_EQ(MHD_HTTP_OK,
+              http_exchange(eventloop, port, "GET /status HTTP/1.0").status);
+    http_reply_t reply = http_exchange(eventloop, port,
+                                       "GET /admission HTTP/1.0");
+    boost::property_tree::ptree tree;
+    std::istringstream in(reply.body);
+    boost::property_tree::read_json(in, tree);
+    EXPECT_EQ(2, tree.get<int>("parked"));
+    EXPECT_EQ(0, tree.get<int>("suspended"));
+
+    // Work in progress does.
+    http_stream_client_t third(port, "GET /work HTTP/1.0");
+    http_stream_client_t fourth(port, "GET /work HTTP/1.0");
+    run_for(20ms);
+    EXPECT_EQ(MHD_HTTP_SERVICE_UNAVAILABLE,
+              http_exchange(eventloop, port, "GET /status HTTP/1.0").status);
+    server->set_admission_control(nullptr);
+}
@@ -0,0 +1,105 @@
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <jsonwriter.hpp>
+
+
+static std::string format(double value, int decimals = 6) {
+    char buf[32];
+    return std::string(buf, format_double(value, decimals, buf));
+}
+
+
+TEST(JsonWriterTest, WritesNestedStructures) {
+    buffer_chain_t out;
+    json_writer_t json(out);
+    json.begin_object()
+        .key("a").value(1)
+        .key("b").begin_array().value(true).value(false).null().end_array()
+        .key("c").begin_object().end_object()
+        .key("d").begin_array().begin_object().key("e").value("f")
+                                .end_object().end_array()
+        .end_object();
+    EXPECT_EQ("{\"a\":1,\"b\":[true,false,null],\"c\":{},"
+              "\"d\":[{\"e\":\"f\"}]}", out.str());
+}
+
+TEST(JsonWriterTest, WritesIntegers) {
+    buffer_chain_t out;
+    json_writer_t json(out);
+    json.begin_array()
+        .value(0).value(-1).value(99).value(100).value(123456789)
+        .value(std::numeric_limits<std::int64_t>::min())
+        .value(std::numeric_limits<std::uint64_t>::max())
+        .end_array();
+    EXPECT_EQ("[0,-1,99,100,123456789,-9223372036854775808,"
+              "18446744073709551615]", out.str());
+}
+
+TEST(JsonWriterTest, EscapesStrings) {
+    buffer_chain_t out;
+    json_writer_t json(out);
+    json.value(std::string("a\"b\\c\nd\x01" "e\tf/\xc3\xa4", 14));
+    EXPECT_EQ("\"a\\\"b\\\\c\\nd\\u0001e\\tf/\xc3\xa4\"", out.str());
+}
+
+TEST(JsonWriterTest, EscapesLongStrings) {
+    // Long enough to be checked in blocks of 16 characters.
+    std::string str(100, 'x');
+    str[37] = '"';
+    str[38] = '\x1f';
+    buffer_chain_t out;
+    json_writer_t json(out);
+    json.value(str);
+    EXPECT_EQ("\"" + std::string(37, 'x') + "\\\"\\u001f"
+              + std::string(61, 'x') + "\"", out.str());
+}
+
+TEST(JsonWriterTest, WritesBinaryAsHex) {
+    buffer_chain_t out;
+    json_writer_t json(out);
+    json.binary("\x00\x7f\xff", 3);
+    EXPECT_EQ("\"007fff\"", out.str());
+}
+
+TEST(JsonWriterTest, FormatsDoubles) {
+    EXPECT_EQ("0", format(0.0));
+    EXPECT_EQ("0.5", format(0.5));
+    EXPECT_EQ("-1.25", format(-1.25));
+    EXPECT_EQ("0.333333", format(1.0 / 3));
+    EXPECT_EQ("1", format(0.9999999));
+    EXPECT_EQ("0", format(-0.0000001));
+    EXPECT_EQ("0.01", format(0.0123, 2));
+    EXPECT_EQ("1e+20", format(1e20));
+    EXPECT_EQ("null", format(std::nan("")));
+    EXPECT_EQ("null", format(HUGE_VAL));
+}
+
+TEST(BufferChainTest, SpansMultipleChunks) {
+    std::string data(3 * buffer_chain_t::chunk_size + 17, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 13);
+    }
+    buffer_chain_t chain;
+    chain.append(data.data(), 5);
+    chain.append(data.data() + 5, data.size() - 5);
+    EXPECT_EQ(data.size(), chain.size());
+    EXPECT_EQ(data, chain.str());
+}
+
+TEST(BufferChainTest, ReadsSequentially) {
+    std::string data(buffer_chain_t::chunk_size + 100, 'y');
+    data.back() = 'z';
+    buffer_chain_t chain;
+    chain.append(data.data(), data.size());
+
+    std::string result;
+    char buf[1000];
+    while (std::size_t n = chain.read(buf, sizeof(buf))) {
+        result.append(buf, n);
+    }
+    EXPECT_EQ(data, result);
+}
@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <httptest.hpp>
+#include <moverapi.hpp>
+
+
+class MoverApiTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        char tmpl[] = "/tmp/xlts-moverapi-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        dir = tmpl;
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+        mover_api.reset(new mover_api_t(server.get(), &mover));
+    }
+    void TearDown() override {
+        mover_api.reset();
+        server.reset();
+        std::system(("rm -rf '" + dir + "'").c_str());
+    }
+
+    // Requests `GET /moves` and parses the body.
+    boost::property_tree::ptree get_moves() {
+        http_reply_t reply = http_exchange(eventloop, port,
+                                           "GET /moves HTTP/1.0");
+        EXPECT_EQ(MHD_HTTP_OK, reply.status);
+        EXPECT_EQ("application/json", reply.header("Content-type"));
+        boost::property_tree::ptree tree;
+        std::istringstream in(reply.body);
+        boost::property_tree::read_json(in, tree);
+        return tree;
+    }
+
+    eventloop_t eventloop;
+    file_mover_t mover{&eventloop};
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+    std::unique_ptr<mover_api_t> mover_api;
+    std::string dir;
+};
+
+
+TEST_F(MoverApiTest, ShowsNoBatchesWhenIdle) {
+    EXPECT_TRUE(get_moves().get_child("batches").empty());
+}
+
+TEST_F(MoverApiTest, ShowsBatchInProgress) {
+    // Copying a FIFO from another filesystem blocks the worker until the
+    // FIFO is opened for writing.
+    char tmpl[] = "/dev/shm/xlts-moverapi-XXXXXX";
+    ASSERT_NE(nullptr, mktemp(tmpl));
+    if (mkfifo(tmpl, 0600) < 0) {
+        return;
+    }
+    struct stat source_st, dir_st;
+    ASSERT_EQ(0, stat(tmpl, &source_st));
+    ASSERT_EQ(0, stat(dir.c_str(), &dir_st));
+    if (source_st.st_dev == dir_st.st_dev) {
+        unlink(tmpl);
+        return;
+    }
+
+    bool done = false;
+    const std::uint64_t id = mover.move(
+            {{tmpl, dir + "/a"}, {dir + "/missing", dir + "/b"}},
+            [&](std::uint64_t, std::exception_ptr) {
+                done = true;
+                eventloop.notify();
+            });
+
+    boost::property_tree::ptree tree = get_moves();
+    ASSERT_EQ(1u, tree.get_child("batches").size());
+    const boost::property_tree::ptree &batch =
+            tree.get_child("batches").front().second;
+    EXPECT_EQ(id, batch.get<std::uint64_t>("id"));
+    EXPECT_EQ(2, batch.get<int>("files_total"));
+    EXPECT_EQ(0, batch.get<int>("files_done"));
+    EXPECT_EQ(0, batch.get<int>("bytes_done"));
+
+    // Lets the worker finish the batch, which also removes the FIFO.
+    close(open(tmpl, O_WRONLY));
+    eventloop.exec([&] { return done; });
+    EXPECT_TRUE(get_moves().get_child("batches").empty());
+}
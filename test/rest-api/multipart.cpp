@@ -0,0 +1,105 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <multipart.hpp>
+
+
+static const std::string body =
+        "preamble\r\n"
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"field\"\r\n"
+        "\r\n"
+        "value\r\n"
+        "--XyZ  \r\n"
+        "content-disposition: form-data; name=\"torrent\"; "
+            "filename=\"a \\\"b\\\"; c.torrent\"\r\n"
+        "Content-Type: application/x-bittorrent\r\n"
+        "\r\n"
+        "d4:info\r\n--XyAde\r\r\n--X\r\n"
+        "--XyZ--\r\n"
+        "epilogue";
+
+/**
+ * Collects all parts passed to the handlers.
+ */
+struct collector_t {
+    multipart_parser_t::handlers_t handlers() {
+        return {
+            [this](const multipart_parser_t::part_t &part) {
+                parts.push_back(part);
+                contents.emplace_back();
+            },
+            [this](const char *data, std::size_t len) {
+                contents.back().append(data, len);
+            },
+            [this] { ++ended; }
+        };
+    }
+
+    std::vector<multipart_parser_t::part_t> parts;
+    std::vector<std::string> contents;
+    int ended = 0;
+};
+
+
+TEST(MultipartTest, ParsesBoundary) {
+    EXPECT_EQ("XyZ", multipart_boundary("multipart/form-data; boundary=XyZ"));
+    EXPECT_EQ("a b", multipart_boundary(
+            "Multipart/Form-Data; charset=utf-8; Boundary=\"a b\""));
+    EXPECT_EQ("", multipart_boundary("multipart/form-data"));
+    EXPECT_EQ("", multipart_boundary("text/plain; boundary=XyZ"));
+    EXPECT_EQ("", multipart_boundary(nullptr));
+}
+
+TEST(MultipartTest, ParsesPartsInAnyChunking) {
+    for (std::size_t size : {1, 2, 5, 13, 4096}) {
+        collector_t collector;
+        multipart_parser_t parser("XyZ", collector.handlers());
+        for (std::size_t i = 0; i < body.size(); i += size) {
+            std::string chunk = body.substr(i, size);
+            parser.feed(chunk.data(), chunk.size());
+        }
+        EXPECT_NO_THROW(parser.finish());
+
+        ASSERT_EQ(2u, collector.parts.size());
+        EXPECT_EQ(2, collector.ended);
+        EXPECT_EQ("field", collector.parts[0].name);
+        EXPECT_EQ("", collector.parts[0].filename);
+        EXPECT_EQ("value", collector.contents[0]);
+        EXPECT_EQ("torrent", collector.parts[1].name);
+        EXPECT_EQ("a \"b\"; c.torrent", collector.parts[1].filename);
+        EXPECT_EQ("application/x-bittorrent", collector.parts[1].content_type);
+        EXPECT_EQ("d4:info\r\n--XyAde\r\r\n--X", collector.contents[1]);
+    }
+}
+
+TEST(MultipartTest, AcceptsPartsWithoutHeaders) {
+    collector_t collector;
+    multipart_parser_t parser("b", collector.handlers());
+    const std::string data = "--b\r\n\r\nabc\r\n--b--";
+    parser.feed(data.data(), data.size());
+    EXPECT_NO_THROW(parser.finish());
+    ASSERT_EQ(1u, collector.contents.size());
+    EXPECT_EQ("abc", collector.contents[0]);
+}
+
+TEST(MultipartTest, RejectsIncompleteBody) {
+    multipart_parser_t parser("XyZ", {});
+    parser.feed(body.data(), body.size() - 20);
+    EXPECT_THROW(parser.finish(), multipart_error);
+}
+
+TEST(MultipartTest, RejectsMalformedBody) {
+    multipart_parser_t parser("b", {});
+    const std::string data = "--bx";
+    EXPECT_THROW(parser.feed(data.data(), data.size()), multipart_error);
+}
+
+TEST(MultipartTest, LimitsHeaderSize) {
+    multipart_parser_t parser("b", {});
+    const std::string data = "--b\r\nX-Long: "
+            + std::string(multipart_parser_t::max_header_size, 'x');
+    EXPECT_THROW(parser.feed(data.data(), data.size()), multipart_error);
+}
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <httpd.hpp>
+#include <httptest.hpp>
+#include <requesttrace.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+class RequestTraceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/xlts-requesttrace-XXXXXX";
+        int fd = mkstemp(tmpl);
+        ASSERT_LE(0, fd);
+        close(fd);
+        path = tmpl;
+    }
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    static trace_record_t make_record(long us, const char *method,
+                                      const char *target,
+                                      const char *range = "") {
+        trace_record_t record;
+        record.time = std::chrono::microseconds(us);
+        record.method = method;
+        record.target = target;
+        record.range = range;
+        return record;
+    }
+
+    // Returns the size of the trace file.
+    long file_size() const {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fclose(file);
+        return size;
+    }
+
+    std::string path;
+};
+
+
+TEST_F(RequestTraceTest, ReadsWrittenRecords) {
+    {
+        trace_writer_t writer(path);
+        writer.write(make_record(0, "GET", "/torrents?since=4"));
+        writer.write(make_record(1500, "HEAD", "/files/a.iso",
+                                 "bytes=0-1023"));
+        writer.write(make_record(100000000, "PROPFIND", "/"));
+    }
+
+    trace_reader_t reader(path);
+    trace_record_t record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(0, record.time.count());
+    EXPECT_EQ("GET", record.method);
+    EXPECT_EQ("/torrents?since=4", record.target);
+    EXPECT_EQ("", record.range);
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(1500, record.time.count());
+    EXPECT_EQ("HEAD", record.method);
+    EXPECT_EQ("bytes=0-1023", record.range);
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(100000000, record.time.count());
+    EXPECT_EQ("PROPFIND", record.method);
+    EXPECT_EQ("/", record.target);
+
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST_F(RequestTraceTest, IsCompact) {
+    {
+        trace_writer_t writer(path);
+        writer.write(make_record(250, "GET", "/torrents"));
+    }
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(nullptr, file);
+    std::fseek(file, 0, SEEK_END);
+    // Magic, time (2), method (1), target (1 + 9), range (1)
+    EXPECT_EQ(8 + 2 + 1 + 10 + 1, std::ftell(file));
+    std::fclose(file);
+}
+
+TEST_F(RequestTraceTest, RejectsMalformedFiles) {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    std::fputs("NOTATRACE", file);
+    std::fclose(file);
+    EXPECT_THROW(trace_reader_t reader(path), trace_error);
+
+    file = std::fopen(path.c_str(), "wb");
+    std::fputs("XLTSTRC1\x05\x00\x10/tor", file);
+    std::fclose(file);
+    trace_reader_t reader(path);
+    trace_record_t record;
+    EXPECT_THROW(reader.next(record), trace_error);
+}
+
+TEST_F(RequestTraceTest, RecordsEncodedTargets) {
+    std::vector<const char*> argv = {""};
+    load_configuration(argv.size(), argv.data());
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    const int fd = http_listen_loopback(port);
+    ASSERT_LE(0, fd);
+    {
+        trace_writer_t writer(path);
+        httpserver_t server(&eventloop, fd);
+        server.set_request_trace(&writer);
+        http_exchange(eventloop, port,
+                      "GET /files/a%20b/c%3Fd%25?q=x%26y HTTP/1.0\r\n"
+                      "Range: bytes=0-9");
+    }
+
+    trace_reader_t reader(path);
+    trace_record_t record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ("GET", record.method);
+    EXPECT_EQ("/files/a%20b/c%3Fd%25?q=x%26y", record.target);
+    EXPECT_EQ("bytes=0-9", record.range);
+}
+
+TEST_F(RequestTraceTest, FlushesPeriodically) {
+    eventloop_t eventloop;
+    trace_writer_t writer(path, &eventloop);
+    writer.write(make_record(0, "GET", "/torrents"));
+    EXPECT_EQ(0, file_size());
+
+    bool done = false;
+    eventloop.call([&] { done = true; eventloop.notify(); },
+                   trace_writer_t::flush_interval + 100ms);
+    eventloop.exec([&] { return done; });
+    EXPECT_EQ(8 + 1 + 1 + 10 + 1, file_size());
+}
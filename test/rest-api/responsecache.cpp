@@ -0,0 +1,138 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <httptest.hpp>
+#include <responsecache.hpp>
+
+
+class ResponseCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+        cache.reset(new response_cache_t(server.get(), 1 << 20));
+        // Each route responds with its path, tagged by the first letter.
+        for (const std::string path : {"alpha", "apple", "beta", "gamma"}) {
+            server->add_route("GET", path, [this, path](MHD_Connection *) {
+                return [this, path](MHD_Connection *connection, const char *,
+                                    std::size_t *) {
+                    ++built;
+                    buffer_chain_t body;
+                    body.append(path.data(), path.size());
+                    cache->respond(connection,
+                                   response_cache_t::request_key(
+                                           connection, path.c_str()),
+                                   std::move(body), "text/plain",
+                                   {path.substr(0, 1)});
+                };
+            });
+        }
+    }
+    void TearDown() override {
+        cache.reset();
+        server.reset();
+    }
+
+    http_reply_t get(const std::string &path,
+                     const std::string &headers = std::string()) {
+        return http_exchange(eventloop, port,
+                             "GET " + path + " HTTP/1.0" + headers);
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+    std::unique_ptr<response_cache_t> cache;
+    unsigned int built = 0;
+};
+
+
+TEST_F(ResponseCacheTest, ServesRepeatedRequests) {
+    EXPECT_EQ("alpha", get("/alpha").body);
+    http_reply_t reply = get("/alpha");
+    EXPECT_EQ(MHD_HTTP_OK, reply.status);
+    EXPECT_EQ("alpha", reply.body);
+    EXPECT_EQ(1u, built);
+    EXPECT_EQ(1u, cache->stats().hits);
+    EXPECT_EQ(1u, cache->stats().misses);
+    EXPECT_EQ(1u, cache->stats().entries);
+}
+
+TEST_F(ResponseCacheTest, EvictsLeastRecentlyUsed) {
+    get("/alpha");
+    const std::size_t entry = cache->stats().memory;
+    cache->set_budget(entry * 2 + entry / 2);
+    get("/beta");
+    get("/alpha");
+    get("/gamma");
+    // Beta has been used least recently.
+    EXPECT_EQ(2u, cache->stats().entries);
+    EXPECT_EQ(1u, cache->stats().evictions);
+    EXPECT_GE(entry * 2 + entry / 2, cache->stats().memory);
+
+    built = 0;
+    get("/alpha");
+    get("/gamma");
+    EXPECT_EQ(0u, built);
+    get("/beta");
+    EXPECT_EQ(1u, built);
+
+    cache->set_budget(0);
+    EXPECT_EQ(0u, cache->stats().entries);
+    EXPECT_EQ(0u, cache->stats().memory);
+}
+
+TEST_F(ResponseCacheTest, InvalidatesByTag) {
+    get("/alpha");
+    get("/apple");
+    get("/beta");
+    EXPECT_EQ(3u, cache->stats().entries);
+
+    cache->invalidate("a");
+    EXPECT_EQ(1u, cache->stats().entries);
+    EXPECT_EQ(2u, cache->stats().invalidations);
+    cache->invalidate("a");
+    EXPECT_EQ(2u, cache->stats().invalidations);
+
+    built = 0;
+    get("/alpha");
+    get("/beta");
+    EXPECT_EQ(1u, built);
+}
+
+TEST_F(ResponseCacheTest, RespondsNotModified) {
+    const std::string etag = get("/alpha").header("ETag");
+    ASSERT_FALSE(etag.empty());
+
+    http_reply_t reply = get("/alpha", "\r\nIf-None-Match: " + etag);
+    EXPECT_EQ(MHD_HTTP_NOT_MODIFIED, reply.status);
+    EXPECT_EQ("", reply.body);
+    EXPECT_EQ(etag, reply.header("ETag"));
+    reply = get("/alpha", "\r\nIf-None-Match: \"other\", W/" + etag);
+    EXPECT_EQ(MHD_HTTP_NOT_MODIFIED, reply.status);
+    reply = get("/alpha", "\r\nIf-None-Match: *");
+    EXPECT_EQ(MHD_HTTP_NOT_MODIFIED, reply.status);
+    EXPECT_EQ(3u, cache->stats().not_modified);
+}
+
+TEST_F(ResponseCacheTest, RespondsIfETagDiffers) {
+    const std::string etag = get("/alpha").header("ETag");
+    const std::string hash = etag.substr(1, etag.size() - 2);
+    for (const std::string &tag : {std::string("\"*\""),
+                                   "\"" + hash + "*\"",
+                                   "\"x" + hash + "\"", hash}) {
+        http_reply_t reply = get("/alpha", "\r\nIf-None-Match: " + tag);
+        EXPECT_EQ(MHD_HTTP_OK, reply.status) << tag;
+        EXPECT_EQ("alpha", reply.body) << tag;
+    }
+    EXPECT_EQ(0u, cache->stats().not_modified);
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <responseformat.hpp>
+
+
+TEST(ResponseFormatTest, DefaultsToJson) {
+    EXPECT_EQ(response_format_e::JSON, negotiate_format(nullptr));
+    EXPECT_EQ(response_format_e::JSON, negotiate_format(""));
+    EXPECT_EQ(response_format_e::JSON, negotiate_format("*/*"));
+    EXPECT_EQ(response_format_e::JSON,
+              negotiate_format("text/html,application/xhtml+xml,*/*;q=0.8"));
+}
+
+TEST(ResponseFormatTest, AcceptsCbor) {
+    EXPECT_EQ(response_format_e::CBOR, negotiate_format("application/cbor"));
+    EXPECT_EQ(response_format_e::CBOR,
+              negotiate_format("Application/CBOR, */*;q=0.1"));
+    EXPECT_EQ(response_format_e::CBOR,
+              negotiate_format("application/json;q=0.5, application/cbor"));
+}
+
+TEST(ResponseFormatTest, RespectsQuality) {
+    EXPECT_EQ(response_format_e::JSON,
+              negotiate_format("application/cbor;q=0"));
+    EXPECT_EQ(response_format_e::JSON,
+              negotiate_format("application/cbor;q=0.5, application/json"));
+}
+
+TEST(ResponseFormatTest, WritesWithMatchingWriter) {
+    buffer_chain_t json, cbor;
+    auto write = [](auto &out) { out.begin_array().value(1).end_array(); };
+    write_formatted(response_format_e::JSON, json, write);
+    write_formatted(response_format_e::CBOR, cbor, write);
+    EXPECT_EQ("[1]", json.str());
+    EXPECT_EQ(std::string("\x9f\x01\xff"), cbor.str());
+    EXPECT_STREQ("application/cbor", to_media_type(response_format_e::CBOR));
+}
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <httptest.hpp>
+#include <statsstream.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+static torrent_status_t make_status(int id, int download_rate)
+{
+    torrent_status_t status;
+    status.infohash.fill(static_cast<std::uint8_t>(id));
+    status.download_rate = download_rate;
+    status.num_peers = 1;
+    return status;
+}
+
+static std::size_t count(const std::string &text, const std::string &word)
+{
+    std::size_t result = 0;
+    for (std::size_t pos = text.find(word); pos != std::string::npos;
+            pos = text.find(word, pos + word.size())) {
+        ++result;
+    }
+    return result;
+}
+
+
+class StatsStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {"", "--httpd.stats-interval=10"};
+        load_configuration(argv.size(), argv.data());
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+        store.update({make_status(1, 100), make_status(2, 200)});
+    }
+
+    // Runs the event loop for the given duration.
+    void run_for(std::chrono::milliseconds duration) {
+        bool done = false;
+        eventloop.call([&] { done = true; eventloop.notify(); }, duration);
+        eventloop.exec([&] { return done; });
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+    // Keeps a single tombstone, so removals are pruned quickly.
+    torrent_status_store_t store{1};
+};
+
+
+TEST_F(StatsStreamTest, SendsAllTorrentsToNewSubscribers) {
+    stats_stream_t stats(&eventloop, server.get(), &store);
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(50ms);
+    const std::string data = client.read();
+    EXPECT_EQ(1u, count(data, "data: "));
+    EXPECT_EQ(2u, count(data, "\"infohash\""));
+    EXPECT_EQ(1u, count(data, "\"download_rate\":300"));
+}
+
+TEST_F(StatsStreamTest, SendsChangesToAllSubscribers) {
+    stats_stream_t stats(&eventloop, server.get(), &store);
+    http_stream_client_t first(port, "GET /events HTTP/1.0");
+    http_stream_client_t second(port, "GET /events HTTP/1.0");
+    run_for(50ms);
+    first.read();
+    second.read();
+
+    store.update({make_status(2, 500)});
+    run_for(50ms);
+    const std::string data = first.read();
+    EXPECT_EQ(data, second.read());
+    // Only the changed torrent is listed.
+    EXPECT_EQ(1u, count(data, "data: "));
+    EXPECT_EQ(1u, count(data, "\"infohash\":\"0202"));
+    EXPECT_EQ(1u, count(data, "\"download_rate\":600"));
+    EXPECT_EQ(0u, count(data, "\"infohash\":\"0101"));
+}
+
+TEST_F(StatsStreamTest, CoalescesChangesOfOneTick) {
+    stats_stream_t stats(&eventloop, server.get(), &store);
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(50ms);
+    client.read();
+
+    store.update({make_status(1, 110)});
+    store.update({make_status(2, 220)});
+    run_for(50ms);
+    const std::string data = client.read();
+    EXPECT_EQ(1u, count(data, "data: "));
+    EXPECT_EQ(2u, count(data, "\"infohash\""));
+
+    // Nothing is sent while nothing changes.
+    run_for(50ms);
+    EXPECT_EQ("", client.read());
+}
+
+TEST_F(StatsStreamTest, SendsRemovedTorrents) {
+    stats_stream_t stats(&eventloop, server.get(), &store);
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(50ms);
+    client.read();
+
+    store.remove(make_status(2, 0).infohash);
+    run_for(50ms);
+    const std::string data = client.read();
+    EXPECT_EQ(1u, count(data, "\"full\":false"));
+    EXPECT_EQ(1u, count(data, "\"torrents\":[]"));
+    EXPECT_EQ(1u, count(data, "\"removed\":[\"0202"));
+}
+
+TEST_F(StatsStreamTest, SendsAllTorrentsIfRemovalsArePruned) {
+    stats_stream_t stats(&eventloop, server.get(), &store);
+    http_stream_client_t client(port, "GET /events HTTP/1.0");
+    run_for(50ms);
+    client.read();
+
+    // The first removal is pruned before it is published.
+    store.update({make_status(3, 300)});
+    store.remove(make_status(1, 0).infohash);
+    store.remove(make_status(2, 0).infohash);
+    run_for(50ms);
+    const std::string data = client.read();
+    EXPECT_EQ(1u, count(data, "data: "));
+    EXPECT_EQ(1u, count(data, "\"full\":true"));
+    EXPECT_EQ(1u, count(data, "\"infohash\":\"0303"));
+    EXPECT_EQ(0u, count(data, "\"removed\""));
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <diskscheduler.hpp>
+#include <httptest.hpp>
+#include <torrentupload.hpp>
+
+
+static const std::string first_torrent =
+        "d4:infod4:name8:test.txt6:lengthi42e12:piece lengthi16384e"
+        "6:pieces20:aaaaaaaaaaaaaaaaaaaaee";
+static const std::string first_hash =
+        "b41b508e8ddc7ed10cf885ff4386a11816de66ad";
+static const std::string second_torrent =
+        "d4:infod4:name9:other.txt6:lengthi7e12:piece lengthi16384e"
+        "6:pieces20:bbbbbbbbbbbbbbbbbbbbee";
+static const std::string second_hash =
+        "61ed670bb9a8f9a5fc4bace8d04f952fa7a673dd";
+
+static const std::string request_head =
+        "POST /torrents HTTP/1.0\r\n"
+        "Content-Type: multipart/form-data; boundary=xyz";
+
+// Returns a part of a multipart body with file @p content.
+static std::string file_part(const std::string &name,
+                             const std::string &content)
+{
+    return "--xyz\r\nContent-Disposition: form-data; name=\"file\"; "
+           "filename=\"" + name + "\"\r\n\r\n" + content + "\r\n";
+}
+
+static const std::string end_of_body = "--xyz--\r\n";
+
+
+class TorrentUploadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {""};
+        load_configuration(argv.size(), argv.data());
+        char tmpl[] = "/tmp/xlts-torrentupload-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        dir = tmpl;
+        const int fd = http_listen_loopback(port);
+        ASSERT_LE(0, fd);
+        server.reset(new httpserver_t(&eventloop, fd));
+        upload.reset(new torrent_upload_t(&eventloop, server.get(),
+                                          &scheduler, dir, 1 << 20));
+    }
+    void TearDown() override {
+        upload.reset();
+        server.reset();
+        std::system(("rm -rf '" + dir + "'").c_str());
+    }
+
+    // Returns the names of all files in the directory, sorted.
+    std::vector<std::string> files() const {
+        std::vector<std::string> result;
+        DIR *d = opendir(dir.c_str());
+        while (dirent *entry = readdir(d)) {
+            const std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                result.push_back(name);
+            }
+        }
+        closedir(d);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // Returns the infohashes listed by a successful response.
+    static std::vector<std::string> added(const http_reply_t &reply) {
+        boost::property_tree::ptree tree;
+        std::istringstream in(reply.body);
+        boost::property_tree::read_json(in, tree);
+        std::vector<std::string> result;
+        for (const auto &hash : tree.get_child("torrents")) {
+            result.push_back(hash.second.get_value<std::string>());
+        }
+        return result;
+    }
+
+    eventloop_t eventloop;
+    std::uint16_t port = 0;
+    std::unique_ptr<httpserver_t> server;
+    std::unique_ptr<torrent_upload_t> upload;
+    std::string dir;
+    // Destroyed first, so no job outlives the members used by it.
+    disk_scheduler_t scheduler{1};
+};
+
+
+TEST_F(TorrentUploadTest, AddsTorrentFiles) {
+    // The second file is split across chunks.
+    http_reply_t reply = http_exchange(eventloop, port, request_head, {
+            file_part("a.torrent", first_torrent)
+            + file_part("b.torrent", second_torrent).substr(0, 80),
+            file_part("b.torrent", second_torrent).substr(80)
+            + end_of_body});
+    EXPECT_EQ(MHD_HTTP_CREATED, reply.status);
+    EXPECT_EQ(std::vector<std::string>({first_hash, second_hash}),
+              added(reply));
+    EXPECT_EQ(std::vector<std::string>({second_hash + ".torrent",
+                                        first_hash + ".torrent"}), files());
+}
+
+TEST_F(TorrentUploadTest, KeepsFilesCompletedBeforeError) {
+    // Both files arrive in the same chunk, the second one is incomplete.
+    http_reply_t reply = http_exchange(eventloop, port, request_head, {
+            file_part("a.torrent", first_torrent)
+            + file_part("b.torrent", second_torrent.substr(0, 30))
+            + end_of_body});
+    EXPECT_EQ(MHD_HTTP_BAD_REQUEST, reply.status);
+    EXPECT_EQ(std::vector<std::string>({first_hash + ".torrent"}), files());
+}
+
+TEST_F(TorrentUploadTest, RejectsInvalidFiles) {
+    http_reply_t reply = http_exchange(eventloop, port, request_head, {
+            file_part("a.torrent", "d4:infoi03ee") + end_of_body});
+    EXPECT_EQ(MHD_HTTP_BAD_REQUEST, reply.status);
+    EXPECT_TRUE(files().empty());
+}
+
+TEST_F(TorrentUploadTest, RejectsTooLargeFiles) {
+    upload->set_limit(first_torrent.size() - 1);
+    http_reply_t reply = http_exchange(eventloop, port, request_head, {
+            file_part("a.torrent", first_torrent) + end_of_body});
+    EXPECT_EQ(MHD_HTTP_REQUEST_ENTITY_TOO_LARGE, reply.status);
+    EXPECT_TRUE(files().empty());
+}
+
+TEST_F(TorrentUploadTest, RejectsOtherContentTypes) {
+    http_reply_t reply = http_exchange(
+            eventloop, port,
+            "POST /torrents HTTP/1.0\r\nContent-Type: application/json",
+            {"{}"});
+    EXPECT_EQ(MHD_HTTP_UNSUPPORTED_MEDIA_TYPE, reply.status);
+}
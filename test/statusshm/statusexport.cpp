@@ -0,0 +1,150 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <eventloop.hpp>
+#include <statusexport.hpp>
+#include <statusreader.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+static torrent_status_t make_status(int id, int download_rate,
+                                    int upload_rate = 0)
+{
+    torrent_status_t status;
+    status.infohash.fill(static_cast<std::uint8_t>(id));
+    status.name = "torrent-" + std::to_string(id);
+    status.progress = 0.5f;
+    status.download_rate = download_rate;
+    status.upload_rate = upload_rate;
+    status.num_peers = 2;
+    return status;
+}
+
+
+class StatusExportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {"", "--httpd.stats-interval=20"};
+        load_configuration(argv.size(), argv.data());
+        name = "xlts-status-" + std::to_string(getpid());
+    }
+    void TearDown() override {
+        shm_unlink(shm_object_name(name).c_str());
+    }
+
+    // Runs the event loop for the given duration.
+    void run_for(std::chrono::milliseconds duration) {
+        bool done = false;
+        eventloop.call([&] { done = true; eventloop.notify(); }, duration);
+        eventloop.exec([&] { return done; });
+    }
+
+    std::string name;
+    eventloop_t eventloop;
+    torrent_status_store_t store;
+};
+
+
+TEST_F(StatusExportTest, PublishesFastestTorrents) {
+    std::vector<torrent_status_t> statuses;
+    for (int id = 0; id < 100; ++id) {
+        statuses.push_back(make_status(id, id * 10, id % 2));
+    }
+    store.update(statuses);
+    status_export_t status_export(&eventloop, &store, name);
+
+    status_reader_t reader(name);
+    status_snapshot_t snapshot;
+    ASSERT_TRUE(reader.read(snapshot));
+    EXPECT_EQ(store.version(), snapshot.summary.version);
+    EXPECT_EQ(static_cast<std::uint32_t>(getpid()), snapshot.summary.pid);
+    EXPECT_EQ(100u, snapshot.summary.total_torrents);
+    EXPECT_EQ(49500, snapshot.summary.download_rate);
+    EXPECT_EQ(50, snapshot.summary.upload_rate);
+    EXPECT_EQ(200, snapshot.summary.num_peers);
+
+    ASSERT_EQ(shm_max_torrents, snapshot.torrents.size());
+    for (std::size_t i = 0; i < snapshot.torrents.size(); ++i) {
+        const shm_torrent_t &torrent = snapshot.torrents[i];
+        const int id = 99 - static_cast<int>(i);
+        EXPECT_EQ(id, torrent.infohash[0]);
+        EXPECT_EQ(id * 10, torrent.download_rate);
+        EXPECT_EQ(0.5f, torrent.progress);
+        EXPECT_STREQ(("torrent-" + std::to_string(id)).c_str(),
+                     torrent.name);
+    }
+}
+
+TEST_F(StatusExportTest, TruncatesLongNames) {
+    torrent_status_t status = make_status(1, 0);
+    status.name = std::string(200, 'x');
+    store.update({status});
+    status_export_t status_export(&eventloop, &store, name);
+
+    status_snapshot_t snapshot;
+    ASSERT_TRUE(status_reader_t(name).read(snapshot));
+    ASSERT_EQ(1u, snapshot.torrents.size());
+    EXPECT_EQ(sizeof(shm_torrent_t::name) - 1,
+              std::strlen(snapshot.torrents[0].name));
+}
+
+TEST_F(StatusExportTest, UpdatesEveryInterval) {
+    status_export_t status_export(&eventloop, &store, name);
+    status_reader_t reader(name);
+    status_snapshot_t snapshot;
+    ASSERT_TRUE(reader.read(snapshot));
+    EXPECT_EQ(0u, snapshot.summary.total_torrents);
+    const std::int64_t updated = snapshot.summary.updated;
+
+    store.update({make_status(1, 100), make_status(2, 200)});
+    run_for(60ms);
+    ASSERT_TRUE(reader.read(snapshot));
+    EXPECT_EQ(store.version(), snapshot.summary.version);
+    EXPECT_EQ(2u, snapshot.summary.total_torrents);
+    EXPECT_EQ(300, snapshot.summary.download_rate);
+    EXPECT_GT(snapshot.summary.updated, updated);
+}
+
+TEST_F(StatusExportTest, MarksStatusAsStopped) {
+    std::unique_ptr<status_export_t> status_export(
+            new status_export_t(&eventloop, &store, name));
+    status_reader_t reader(name);
+    status_export.reset();
+
+    status_snapshot_t snapshot;
+    ASSERT_TRUE(reader.read(snapshot));
+    EXPECT_EQ(0u, snapshot.summary.pid);
+
+    // A new process takes over the object.
+    status_export.reset(new status_export_t(&eventloop, &store, name));
+    ASSERT_TRUE(reader.read(snapshot));
+    EXPECT_EQ(static_cast<std::uint32_t>(getpid()), snapshot.summary.pid);
+}
+
+TEST_F(StatusExportTest, StopsWritingAfterHandOver) {
+    std::unique_ptr<status_export_t> old_export(
+            new status_export_t(&eventloop, &store, name));
+    old_export->hand_over();
+    status_export_t new_export(&eventloop, &store, name);
+    store.update({make_status(1, 100)});
+    new_export.publish();
+
+    // Neither scheduled updates nor the destruction touch the segment.
+    old_export->publish();
+    run_for(60ms);
+    old_export.reset();
+    status_snapshot_t snapshot;
+    ASSERT_TRUE(status_reader_t(name).read(snapshot));
+    EXPECT_EQ(static_cast<std::uint32_t>(getpid()), snapshot.summary.pid);
+    EXPECT_EQ(store.version(), snapshot.summary.version);
+}
@@ -0,0 +1,97 @@
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <configuration.hpp>
+#include <errorhandling.hpp>
+#include <eventloop.hpp>
+#include <statusexport.hpp>
+#include <statusreader.hpp>
+
+
+class StatusReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<const char*> argv = {"", "--httpd.stats-interval=20"};
+        load_configuration(argv.size(), argv.data());
+        name = "xlts-reader-" + std::to_string(getpid());
+    }
+    void TearDown() override {
+        shm_unlink(shm_object_name(name).c_str());
+    }
+
+    std::string name;
+};
+
+
+TEST_F(StatusReaderTest, ThrowsIfMissing) {
+    EXPECT_THROW(status_reader_t reader(name), os_file_error);
+}
+
+TEST_F(StatusReaderTest, ThrowsOnIncompatibleLayout) {
+    const int fd = shm_open(shm_object_name(name).c_str(),
+                            O_RDWR | O_CREAT, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, ftruncate(fd, sizeof(shm_status_t)));
+    close(fd);
+    // All zero, so the magic does not match.
+    EXPECT_THROW(status_reader_t reader(name), os_file_error);
+
+    shm_unlink(shm_object_name(name).c_str());
+    const int small = shm_open(shm_object_name(name).c_str(),
+                               O_RDWR | O_CREAT, 0600);
+    ASSERT_GE(small, 0);
+    ASSERT_EQ(0, ftruncate(small, 64));
+    close(small);
+    EXPECT_THROW(status_reader_t reader(name), os_file_error);
+}
+
+TEST_F(StatusReaderTest, ReadsConsistentSnapshotsWhileWriting) {
+    eventloop_t eventloop;
+    torrent_status_store_t store;
+    status_export_t status_export(&eventloop, &store, name);
+    status_reader_t reader(name);
+
+    // Every update sets all rates to the same value.
+    std::atomic<bool> stop(false);
+    std::thread writer([&] {
+        std::vector<torrent_status_t> statuses(shm_max_torrents);
+        for (int rate = 1; !stop; ++rate) {
+            for (std::size_t i = 0; i < statuses.size(); ++i) {
+                statuses[i].infohash.fill(static_cast<std::uint8_t>(i));
+                statuses[i].download_rate = rate;
+            }
+            store.update(statuses);
+            status_export.publish();
+        }
+    });
+
+    // Read until many different versions have been seen.
+    status_snapshot_t snapshot;
+    std::uint64_t version = 0;
+    for (int versions = 0; versions < 100; ) {
+        ASSERT_TRUE(reader.read(snapshot));
+        if (snapshot.summary.version != version) {
+            version = snapshot.summary.version;
+            ++versions;
+        }
+        for (const shm_torrent_t &torrent : snapshot.torrents) {
+            ASSERT_EQ(snapshot.torrents[0].download_rate,
+                      torrent.download_rate);
+        }
+        ASSERT_EQ(snapshot.summary.count * std::int64_t(
+                      snapshot.torrents.empty()
+                      ? 0 : snapshot.torrents[0].download_rate),
+                  snapshot.summary.download_rate);
+    }
+    stop = true;
+    writer.join();
+}
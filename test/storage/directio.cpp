@@ -0,0 +1,115 @@
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <fcntl.h>
+
+#include <gtest/gtest.h>
+
+#include <directio.hpp>
+
+
+class DirectIOTest : public ::testing::TestWithParam<bool> {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/xlts-directio-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        dir = tmpl;
+        path = dir + "/file";
+    }
+    void TearDown() override {
+        std::system(("rm -rf '" + dir + "'").c_str());
+    }
+
+    std::string read_file() {
+        std::ifstream in(path);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    }
+
+    static std::string pattern(std::size_t size, char seed) {
+        std::string str(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            str[i] = static_cast<char>(seed + i * 7);
+        }
+        return str;
+    }
+
+    aligned_buffer_pool_t pool{8192, 2};
+    std::string dir;
+    std::string path;
+};
+
+
+TEST(AlignedBufferPoolTest, BuffersAreAligned) {
+    aligned_buffer_pool_t pool(1000, 1);
+    auto buffer = pool.acquire();
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(buffer.get())
+                  % aligned_buffer_pool_t::alignment);
+    EXPECT_EQ(aligned_buffer_pool_t::alignment, pool.buffer_size());
+}
+
+TEST(AlignedBufferPoolTest, ReusesReleasedBuffers) {
+    aligned_buffer_pool_t pool(4096, 1);
+    char *first = pool.acquire().get();
+    EXPECT_EQ(first, pool.acquire().get());
+}
+
+TEST_P(DirectIOTest, WritesUnalignedRanges) {
+    const bool os_cache = GetParam();
+    const std::string data = pattern(20000, 'a');
+    {
+        direct_file_t file(path, O_RDWR | O_CREAT, os_cache, os_cache, pool);
+        file.write(data.data() + 5000, 15000, 5000);
+        file.write(data.data(), 5000, 0);
+    }
+    EXPECT_EQ(data, read_file());
+}
+
+TEST_P(DirectIOTest, KeepsDataAroundUnalignedWrite) {
+    const bool os_cache = GetParam();
+    std::string data = pattern(12288, 'x');
+    std::ofstream(path) << data;
+    {
+        direct_file_t file(path, O_RDWR, os_cache, os_cache, pool);
+        file.write("hello", 5, 4094);
+    }
+    data.replace(4094, 5, "hello");
+    EXPECT_EQ(data, read_file());
+}
+
+TEST_P(DirectIOTest, KeepsSizeOfUnalignedFile) {
+    const bool os_cache = GetParam();
+    std::string data = pattern(4000, 'x');
+    std::ofstream(path) << data;
+    {
+        direct_file_t file(path, O_RDWR, os_cache, os_cache, pool);
+        file.write("abc", 3, 0);
+    }
+    data.replace(0, 3, "abc");
+    EXPECT_EQ(data, read_file());
+}
+
+TEST_P(DirectIOTest, ReadsUnalignedRanges) {
+    const bool os_cache = GetParam();
+    const std::string data = pattern(30000, '0');
+    std::ofstream(path) << data;
+
+    direct_file_t file(path, O_RDONLY, os_cache, os_cache, pool);
+    std::string buf(20000, '\0');
+    ASSERT_EQ(20000u, file.read(&buf[0], buf.size(), 3));
+    EXPECT_EQ(data.substr(3, 20000), buf);
+}
+
+TEST_P(DirectIOTest, ReadStopsAtEndOfFile) {
+    const bool os_cache = GetParam();
+    const std::string data = pattern(5000, '0');
+    std::ofstream(path) << data;
+
+    direct_file_t file(path, O_RDONLY, os_cache, os_cache, pool);
+    std::string buf(8000, '\0');
+    ASSERT_EQ(1000u, file.read(&buf[0], buf.size(), 4000));
+    EXPECT_EQ(data.substr(4000), buf.substr(0, 1000));
+    EXPECT_EQ(0u, file.read(&buf[0], buf.size(), 6000));
+}
+
+INSTANTIATE_TEST_SUITE_P(OsCache, DirectIOTest, ::testing::Bool());
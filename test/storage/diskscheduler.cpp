@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <diskscheduler.hpp>
+
+
+class DiskSchedulerTest : public ::testing::Test {
+protected:
+    // Occupies the only worker until release() is called.
+    void block() {
+        scheduler.submit(io_class_e::NORMAL, [this] {
+            std::unique_lock<std::mutex> lock(mtx);
+            cond.wait(lock, [this] { return released; });
+        });
+        // Wait until the worker has taken the blocking job.
+        while (scheduler.stats(io_class_e::NORMAL).queue_depth != 0) {
+            std::this_thread::yield();
+        }
+    }
+    void release() {
+        std::lock_guard<std::mutex> lock(mtx);
+        released = true;
+        cond.notify_all();
+    }
+    // Waits until @p count jobs have been recorded and returns their order.
+    std::vector<io_class_e> wait_for(std::size_t count) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [&] { return order.size() >= count; });
+        return order;
+    }
+    void record(io_class_e io_class) {
+        scheduler.submit(io_class, [this, io_class] {
+            std::lock_guard<std::mutex> lock(mtx);
+            order.push_back(io_class);
+            cond.notify_all();
+        });
+    }
+
+    std::mutex mtx;
+    std::condition_variable cond;
+    bool released = false;
+    std::vector<io_class_e> order;
+    disk_scheduler_t scheduler{1};
+};
+
+
+TEST_F(DiskSchedulerTest, SharesWorkerByWeight) {
+    block();
+    for (int i = 0; i < 20; ++i) {
+        record(io_class_e::BACKGROUND);
+        record(io_class_e::NORMAL);
+        record(io_class_e::INTERACTIVE);
+    }
+    release();
+    std::vector<io_class_e> recorded = wait_for(13);
+
+    std::vector<io_class_e> first(recorded.begin(), recorded.begin() + 13);
+    EXPECT_EQ(8, std::count(first.begin(), first.end(),
+                            io_class_e::INTERACTIVE));
+    EXPECT_EQ(4, std::count(first.begin(), first.end(), io_class_e::NORMAL));
+    EXPECT_EQ(1, std::count(first.begin(), first.end(),
+                            io_class_e::BACKGROUND));
+    EXPECT_EQ(io_class_e::INTERACTIVE, first.front());
+}
+
+TEST_F(DiskSchedulerTest, IdleClassesDoNotDelayOthers) {
+    block();
+    for (int i = 0; i < 5; ++i) {
+        record(io_class_e::BACKGROUND);
+    }
+    release();
+    EXPECT_EQ(5u, wait_for(5).size());
+}
+
+TEST_F(DiskSchedulerTest, ReportsQueueDepthAndWaitTimes) {
+    block();
+    record(io_class_e::BACKGROUND);
+    record(io_class_e::BACKGROUND);
+    EXPECT_EQ(2u, scheduler.stats(io_class_e::BACKGROUND).queue_depth);
+
+    release();
+    wait_for(2);
+    disk_scheduler_t::stats_t stats = scheduler.stats(io_class_e::BACKGROUND);
+    EXPECT_EQ(0u, stats.queue_depth);
+    EXPECT_EQ(2u, stats.started);
+    EXPECT_EQ(2u, std::accumulate(stats.wait_histogram.begin(),
+                                  stats.wait_histogram.end(), 0ull));
+}
+
+TEST_F(DiskSchedulerTest, SurvivesThrowingJobs) {
+    scheduler.submit(io_class_e::NORMAL, [] {
+        throw std::runtime_error("job failed");
+    });
+    // Not derived from std::exception.
+    scheduler.submit(io_class_e::NORMAL, [] { throw 42; });
+    record(io_class_e::NORMAL);
+    EXPECT_EQ(1u, wait_for(1).size());
+}
@@ -0,0 +1,136 @@
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <eventloop.hpp>
+#include <filemover.hpp>
+
+
+class FileMoverTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/xlts-filemover-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        dir = tmpl;
+    }
+    void TearDown() override {
+        std::system(("rm -rf '" + dir + "'").c_str());
+    }
+
+    void write_file(const std::string &path, const std::string &content) {
+        std::ofstream(path) << content;
+    }
+    std::string read_file(const std::string &path) {
+        std::ifstream in(path);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    }
+
+    // Runs the given batch and returns the error reported by the mover.
+    std::exception_ptr run(std::vector<file_mover_t::job_t> jobs,
+                           bool os_cache = true) {
+        eventloop_t eventloop;
+        file_mover_t mover(&eventloop, os_cache, os_cache);
+        bool done = false;
+        std::exception_ptr result;
+        mover.move(std::move(jobs), [&](std::uint64_t, std::exception_ptr e) {
+            result = e;
+            done = true;
+            eventloop.notify();
+        });
+        eventloop.exec([&] { return done; });
+        return result;
+    }
+
+    // Creates a file on another filesystem than the directory, so it has to
+    // be copied. Returns an empty string if there is none.
+    std::string foreign_file() {
+        char tmpl[] = "/dev/shm/xlts-filemover-XXXXXX";
+        const int fd = mkstemp(tmpl);
+        if (fd < 0) {
+            return std::string();
+        }
+        close(fd);
+        struct stat source_st, dir_st;
+        if (stat(tmpl, &source_st) < 0 || stat(dir.c_str(), &dir_st) < 0
+                || source_st.st_dev == dir_st.st_dev) {
+            unlink(tmpl);
+            return std::string();
+        }
+        return tmpl;
+    }
+
+    std::string dir;
+};
+
+
+TEST_F(FileMoverTest, MovesBatchOfFiles) {
+    write_file(dir + "/a", "content a");
+    write_file(dir + "/b", "content b");
+
+    EXPECT_EQ(nullptr, run({{dir + "/a", dir + "/out/a"},
+                            {dir + "/b", dir + "/out/sub/b"}}));
+
+    EXPECT_EQ("content a", read_file(dir + "/out/a"));
+    EXPECT_EQ("content b", read_file(dir + "/out/sub/b"));
+    EXPECT_NE(0, access((dir + "/a").c_str(), F_OK));
+    EXPECT_NE(0, access((dir + "/b").c_str(), F_OK));
+}
+
+TEST_F(FileMoverTest, DoesNotReplaceExistingTarget) {
+    write_file(dir + "/a", "new");
+    write_file(dir + "/b", "old");
+
+    EXPECT_NE(nullptr, run({{dir + "/a", dir + "/b"}}));
+
+    EXPECT_EQ("new", read_file(dir + "/a"));
+    EXPECT_EQ("old", read_file(dir + "/b"));
+}
+
+TEST_F(FileMoverTest, ReportsMissingSource) {
+    EXPECT_NE(nullptr, run({{dir + "/missing", dir + "/target"}}));
+}
+
+TEST_F(FileMoverTest, ReplacesStalePartialFile) {
+    const std::string source = foreign_file();
+    if (source.empty()) {
+        GTEST_SKIP();
+    }
+    write_file(source, "content");
+    // Left by a crash while copying.
+    write_file(dir + "/target.part", "stale");
+
+    EXPECT_EQ(nullptr, run({{source, dir + "/target"}}));
+
+    EXPECT_EQ("content", read_file(dir + "/target"));
+    EXPECT_NE(0, access((dir + "/target.part").c_str(), F_OK));
+    EXPECT_NE(0, access(source.c_str(), F_OK));
+}
+
+TEST_F(FileMoverTest, HasNoProgressWhenIdle) {
+    eventloop_t eventloop;
+    file_mover_t mover(&eventloop);
+    EXPECT_TRUE(mover.progress().empty());
+}
+
+TEST_F(FileMoverTest, CopiesWithoutPageCache) {
+    const std::string source = foreign_file();
+    if (source.empty()) {
+        GTEST_SKIP();
+    }
+    // Not a multiple of the block size.
+    std::string content;
+    for (int i = 0; content.size() < 300000; ++i) {
+        content += std::to_string(i) + ',';
+    }
+    write_file(source, content);
+
+    EXPECT_EQ(nullptr, run({{source, dir + "/target"}}, false));
+
+    EXPECT_TRUE(content == read_file(dir + "/target"));
+    EXPECT_NE(0, access(source.c_str(), F_OK));
+}
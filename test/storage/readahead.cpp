@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <readahead.hpp>
+
+
+TEST(ReadaheadBudgetTest, ReservesUpToLimit) {
+    readahead_budget_t budget(100);
+    EXPECT_TRUE(budget.try_reserve(60));
+    EXPECT_FALSE(budget.try_reserve(41));
+    EXPECT_TRUE(budget.try_reserve(40));
+    budget.release(100);
+    EXPECT_EQ(0u, budget.used());
+}
+
+TEST(ReadaheadStreamTest, PrefetchesOnSequentialReads) {
+    readahead_budget_t budget(1 << 20);
+    readahead_stream_t stream(-1, budget, 1000, 8000);
+
+    stream.on_read(0, 100);
+    EXPECT_EQ(1000u, stream.window());
+    EXPECT_EQ(1100u, stream.prefetched());
+}
+
+TEST(ReadaheadStreamTest, GrowsWindowWhenHalfConsumed) {
+    readahead_budget_t budget(1 << 20);
+    readahead_stream_t stream(-1, budget, 1000, 4000);
+
+    stream.on_read(0, 100);
+    stream.on_read(100, 100);
+    EXPECT_EQ(1000u, stream.window()); // More than half is still ahead.
+    stream.on_read(200, 500);
+    EXPECT_EQ(2000u, stream.window());
+    EXPECT_EQ(2700u, stream.prefetched());
+    stream.on_read(700, 1500);
+    stream.on_read(2200, 1500);
+    EXPECT_EQ(4000u, stream.window());
+    EXPECT_EQ(4000u, budget.used());
+}
+
+TEST(ReadaheadStreamTest, ResetsWindowOnRandomAccess) {
+    readahead_budget_t budget(1 << 20);
+    readahead_stream_t stream(-1, budget, 1000, 4000);
+
+    stream.on_read(0, 100);
+    stream.on_read(5000, 100);
+    EXPECT_EQ(0u, stream.window());
+    EXPECT_EQ(0u, budget.used());
+    stream.on_read(5100, 100);
+    EXPECT_EQ(1000u, stream.window());
+}
+
+TEST(ReadaheadStreamTest, RespectsBudget) {
+    readahead_budget_t budget(1500);
+    readahead_stream_t first(-1, budget, 1000, 4000);
+    readahead_stream_t second(-1, budget, 1000, 4000);
+
+    first.on_read(0, 100);
+    second.on_read(0, 100);
+    EXPECT_EQ(1000u, first.window());
+    EXPECT_EQ(0u, second.window());
+}
+
+TEST(ReadaheadStreamTest, ReleasesBudgetWhenDestroyed) {
+    readahead_budget_t budget(1 << 20);
+    {
+        readahead_stream_t stream(-1, budget);
+        stream.on_read(0, 100);
+        EXPECT_NE(0u, budget.used());
+    }
+    EXPECT_EQ(0u, budget.used());
+}
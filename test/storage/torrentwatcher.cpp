@@ -0,0 +1,99 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <diskscheduler.hpp>
+#include <errorhandling.hpp>
+#include <eventloop.hpp>
+#include <torrentwatcher.hpp>
+
+using namespace std::literals::chrono_literals;
+
+
+class TorrentWatcherTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/xlts-torrentwatcher-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        dir = tmpl;
+    }
+    void TearDown() override {
+        std::system(("rm -rf '" + dir + "'").c_str());
+    }
+
+    void write_file(const std::string &name, const std::string &content) {
+        std::ofstream(dir + "/" + name) << content;
+    }
+
+    // Runs the event loop until a batch has been received or time is up.
+    void run(std::chrono::milliseconds limit = 2s) {
+        bool timeout = false;
+        eventloop.call([&] { timeout = true; eventloop.notify(); }, limit);
+        eventloop.exec([&] { return timeout || batches > 0; });
+    }
+    torrent_watcher_t::batch_handler_t handler() {
+        return [this](std::vector<torrent_watcher_t::file_t> files) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                received.insert(received.end(), files.begin(), files.end());
+            }
+            ++batches;
+            eventloop.notify();
+        };
+    }
+
+    std::string dir;
+    eventloop_t eventloop;
+    std::mutex mtx;
+    std::vector<torrent_watcher_t::file_t> received;
+    std::atomic<int> batches{0};
+    // Declared last, so its jobs have stopped before the members they use
+    // are destroyed.
+    disk_scheduler_t scheduler{1};
+};
+
+
+TEST_F(TorrentWatcherTest, ReportsBurstAsOneBatch) {
+    torrent_watcher_t watcher(&eventloop, &scheduler, dir, handler(), 50ms);
+    write_file("a.torrent", "first");
+    write_file("b.torrent", "second");
+    run();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    EXPECT_EQ(1, batches);
+    ASSERT_EQ(2u, received.size());
+    EXPECT_EQ(dir + "/a.torrent", received[0].path);
+    EXPECT_EQ("first", received[0].content);
+    EXPECT_EQ(dir + "/b.torrent", received[1].path);
+    EXPECT_EQ("second", received[1].content);
+}
+
+TEST_F(TorrentWatcherTest, ReportsMovedFiles) {
+    write_file("c.part", "moved");
+    torrent_watcher_t watcher(&eventloop, &scheduler, dir, handler(), 10ms);
+    std::rename((dir + "/c.part").c_str(), (dir + "/c.torrent").c_str());
+    run();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    ASSERT_EQ(1u, received.size());
+    EXPECT_EQ("moved", received[0].content);
+}
+
+TEST_F(TorrentWatcherTest, IgnoresOtherFiles) {
+    torrent_watcher_t watcher(&eventloop, &scheduler, dir, handler(), 10ms);
+    write_file("notes.txt", "ignored");
+    run(200ms);
+
+    EXPECT_EQ(0, batches);
+}
+
+TEST_F(TorrentWatcherTest, FailsOnMissingDirectory) {
+    EXPECT_THROW(torrent_watcher_t(&eventloop, &scheduler, dir + "/missing",
+                                   handler()), os_error);
+}
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <bencode.hpp>
+
+
+static const std::string info =
+        "d4:name8:test.txt6:lengthi42e12:piece lengthi16384e"
+        "6:pieces20:aaaaaaaaaaaaaaaaaaaae";
+static const std::string torrent =
+        "d8:announce15:http://tracker/13:creation datei-1e4:info" + info
+        + "4:listli1e2:abd1:xleeee";
+
+static std::string hex(const infohash_t &hash)
+{
+    std::string result;
+    char buf[3];
+    for (std::uint8_t byte : hash) {
+        std::snprintf(buf, sizeof(buf), "%02x", byte);
+        result += buf;
+    }
+    return result;
+}
+
+static void feed(bencode_scanner_t &scanner, const std::string &data)
+{
+    scanner.feed(data.data(), data.size());
+}
+
+
+TEST(BencodeScannerTest, HashesInfoDictionary) {
+    bencode_scanner_t scanner;
+    feed(scanner, torrent);
+    EXPECT_TRUE(scanner.done());
+    EXPECT_EQ("b41b508e8ddc7ed10cf885ff4386a11816de66ad",
+              hex(scanner.infohash()));
+}
+
+TEST(BencodeScannerTest, AcceptsAnyChunking) {
+    for (std::size_t size : {1, 2, 3, 7, 64}) {
+        bencode_scanner_t scanner;
+        for (std::size_t i = 0; i < torrent.size(); i += size) {
+            feed(scanner, torrent.substr(i, size));
+        }
+        EXPECT_TRUE(scanner.done());
+        EXPECT_EQ("b41b508e8ddc7ed10cf885ff4386a11816de66ad",
+                  hex(scanner.infohash()));
+    }
+}
+
+TEST(BencodeScannerTest, IgnoresNestedInfoKeys) {
+    bencode_scanner_t scanner;
+    feed(scanner, "d1:xd4:infod1:ai1eee4:info" + info + "e");
+    EXPECT_EQ("b41b508e8ddc7ed10cf885ff4386a11816de66ad",
+              hex(scanner.infohash()));
+}
+
+TEST(BencodeScannerTest, RejectsIncompleteFiles) {
+    bencode_scanner_t scanner;
+    feed(scanner, torrent.substr(0, torrent.size() - 1));
+    EXPECT_FALSE(scanner.done());
+    EXPECT_THROW(scanner.infohash(), bencode_error);
+}
+
+TEST(BencodeScannerTest, RejectsMissingInfo) {
+    bencode_scanner_t scanner;
+    feed(scanner, "d4:name3:abce");
+    EXPECT_TRUE(scanner.done());
+    EXPECT_THROW(scanner.infohash(), bencode_error);
+}
+
+TEST(BencodeScannerTest, RejectsInvalidData) {
+    for (const char *data : {"l4:infoe", "di1ei2ee", "d4:infoi1ee", "d1:ae",
+                             "d1:xi1-ee", "d1:x3a:abce", "de1:x",
+                             "d4:info" "de" "4:info" "dee", "d1:xi03ee",
+                             "d1:xi-0ee", "d1:xi-ee", "d04:spami1ee"}) {
+        bencode_scanner_t scanner;
+        EXPECT_THROW(feed(scanner, data), bencode_error) << data;
+    }
+}
+
+TEST(BencodeScannerTest, AcceptsZeros) {
+    bencode_scanner_t scanner;
+    feed(scanner, "d1:xi0e1:y0:e");
+    EXPECT_TRUE(scanner.done());
+}
+
+TEST(BencodeScannerTest, LimitsNesting) {
+    bencode_scanner_t scanner;
+    EXPECT_THROW(feed(scanner, "d1:x" + std::string(100, 'l')),
+                 bencode_error);
+}
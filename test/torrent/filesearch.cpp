@@ -0,0 +1,118 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <filesearch.hpp>
+
+
+static infohash_t make_infohash(std::uint8_t id)
+{
+    infohash_t infohash;
+    infohash.fill(id);
+    return infohash;
+}
+
+static std::vector<std::string> paths(const file_search_result_t &result)
+{
+    std::vector<std::string> paths;
+    for (const auto &file : result.files) {
+        paths.push_back(file.path);
+    }
+    return paths;
+}
+
+
+class FileSearchIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        index.add(make_infohash(1), {
+            "Holiday Photos/Beach/IMG_0001.jpg",
+            "Holiday Photos/Beach/IMG_0002.jpg",
+            "Holiday Photos/Mountains/IMG_0003.jpg"
+        });
+        index.add(make_infohash(2), {
+            "Music/Album/01 - Beach Song.mp3",
+            "Music/Album/02 - Other Song.mp3"
+        });
+    }
+
+    file_search_index_t index;
+};
+
+
+TEST_F(FileSearchIndexTest, FindsFilesByComponent) {
+    EXPECT_EQ(5u, index.size());
+
+    file_search_result_t result = index.search("beach", 10);
+    EXPECT_EQ(3u, result.total);
+    EXPECT_EQ((std::vector<std::string>{
+                "Holiday Photos/Beach/IMG_0001.jpg",
+                "Holiday Photos/Beach/IMG_0002.jpg",
+                "Music/Album/01 - Beach Song.mp3"}),
+              paths(result));
+    EXPECT_EQ(make_infohash(2), result.files[2].infohash);
+    EXPECT_EQ(0, result.files[2].file);
+
+    result = index.search("IMG_0003", 10);
+    ASSERT_EQ(1u, result.total);
+    EXPECT_EQ(make_infohash(1), result.files[0].infohash);
+    EXPECT_EQ(2, result.files[0].file);
+}
+
+TEST_F(FileSearchIndexTest, RequiresAllTerms) {
+    file_search_result_t result = index.search("beach mp3", 10);
+    EXPECT_EQ((std::vector<std::string>{"Music/Album/01 - Beach Song.mp3"}),
+              paths(result));
+
+    // Short terms only filter.
+    result = index.search("song 02", 10);
+    EXPECT_EQ((std::vector<std::string>{"Music/Album/02 - Other Song.mp3"}),
+              paths(result));
+
+    EXPECT_EQ(0u, index.search("beach xyz", 10).total);
+    EXPECT_EQ(0u, index.search("beach/mountains", 10).total);
+}
+
+TEST_F(FileSearchIndexTest, RejectsShortQueries) {
+    EXPECT_FALSE(file_search_index_t::searchable(""));
+    EXPECT_FALSE(file_search_index_t::searchable("ab / cd"));
+    EXPECT_TRUE(file_search_index_t::searchable("ab cde"));
+    EXPECT_EQ(0u, index.search("ab", 10).total);
+}
+
+TEST_F(FileSearchIndexTest, LimitsFiles) {
+    file_search_result_t result = index.search("img", 2);
+    EXPECT_EQ(3u, result.total);
+    EXPECT_EQ(2u, result.files.size());
+}
+
+TEST_F(FileSearchIndexTest, RemovesAndReplacesTorrents) {
+    index.remove(make_infohash(2));
+    EXPECT_EQ(3u, index.size());
+    EXPECT_EQ(0u, index.search("song", 10).total);
+    EXPECT_EQ(2u, index.search("beach", 10).total);
+
+    index.add(make_infohash(1), {"New/Beach House.txt"});
+    EXPECT_EQ(1u, index.size());
+    EXPECT_EQ((std::vector<std::string>{"New/Beach House.txt"}),
+              paths(index.search("BEACH", 10)));
+    EXPECT_EQ(0u, index.search("img", 10).total);
+
+    index.remove(make_infohash(3));
+    EXPECT_EQ(1u, index.size());
+}
+
+TEST_F(FileSearchIndexTest, CodesLargeIds) {
+    std::vector<std::string> many;
+    for (int i = 0; i < 1000; ++i) {
+        many.push_back("many/file-" + std::to_string(i));
+    }
+    index.add(make_infohash(3), many);
+    index.add(make_infohash(4), {"many/last"});
+
+    file_search_result_t result = index.search("many", 2000);
+    EXPECT_EQ(1001u, result.total);
+    EXPECT_EQ("many/last", result.files.back().path);
+    EXPECT_EQ(1u, index.search("file-999", 10).total);
+}
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <bencode.hpp>
+#include <metadatastore.hpp>
+
+
+static const std::string info =
+        "d4:name8:test.txt6:lengthi42e12:piece lengthi16384e"
+        "6:pieces20:aaaaaaaaaaaaaaaaaaaae";
+static const std::string info_file =
+        "b41b508e8ddc7ed10cf885ff4386a11816de66ad.info";
+
+static std::string hex(const infohash_t &hash)
+{
+    std::string result;
+    char buf[3];
+    for (std::uint8_t byte : hash) {
+        std::snprintf(buf, sizeof(buf), "%02x", byte);
+        result += buf;
+    }
+    return result;
+}
+
+
+class MetadataStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/xlts-metadatastore-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        dir = tmpl;
+    }
+    void TearDown() override {
+        std::system(("rm -rf '" + dir + "'").c_str());
+    }
+
+    std::string read_file(const std::string &path) {
+        std::ostringstream out;
+        out << std::ifstream(path).rdbuf();
+        return out.str();
+    }
+
+    std::string dir;
+};
+
+
+TEST_F(MetadataStoreTest, SavesByInfohash) {
+    metadata_store_t store(dir + "/metadata");
+    const infohash_t infohash = store.save(info.data(), info.size());
+    EXPECT_EQ("b41b508e8ddc7ed10cf885ff4386a11816de66ad", hex(infohash));
+    EXPECT_EQ(info, read_file(dir + "/metadata/" + info_file));
+    EXPECT_TRUE(store.contains(infohash));
+}
+
+TEST_F(MetadataStoreTest, LoadsAfterReopening) {
+    infohash_t infohash;
+    {
+        metadata_store_t store(dir);
+        infohash = store.save(info.data(), info.size());
+    }
+    metadata_store_t store(dir);
+    EXPECT_EQ(info, store.load(infohash));
+    EXPECT_EQ("d4:info" + info + "e", store.load_torrent(infohash));
+
+    // The torrent file has the same infohash.
+    bencode_scanner_t scanner;
+    const std::string torrent = store.load_torrent(infohash);
+    scanner.feed(torrent.data(), torrent.size());
+    EXPECT_EQ(infohash, scanner.infohash());
+}
+
+TEST_F(MetadataStoreTest, ReportsUnknownInfohash) {
+    metadata_store_t store(dir);
+    infohash_t infohash = {};
+    EXPECT_FALSE(store.contains(infohash));
+    EXPECT_EQ("", store.load(infohash));
+    EXPECT_EQ("", store.load_torrent(infohash));
+}
+
+TEST_F(MetadataStoreTest, DropsCorruptEntries) {
+    metadata_store_t store(dir);
+    const infohash_t infohash = store.save(info.data(), info.size());
+    std::ofstream(dir + "/" + info_file) << info.substr(0, 20);
+
+    EXPECT_EQ("", store.load(infohash));
+    EXPECT_FALSE(store.contains(infohash));
+    // It can be saved again.
+    store.save(info.data(), info.size());
+    EXPECT_EQ(info, store.load(infohash));
+}
+
+TEST_F(MetadataStoreTest, RejectsInvalidInfo) {
+    metadata_store_t store(dir);
+    const std::string invalid = "l1:ae";
+    EXPECT_THROW(store.save(invalid.data(), invalid.size()), bencode_error);
+    EXPECT_THROW(store.save(info.data(), info.size() - 1), bencode_error);
+}
@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <torrentbatch.hpp>
+
+
+static batch_op_t make_op(batch_action_e action, std::uint8_t id,
+                          int file = 0, int priority = 0)
+{
+    batch_op_t op;
+    op.action = action;
+    op.infohash.fill(id);
+    op.file = file;
+    op.priority = priority;
+    return op;
+}
+
+
+TEST(TorrentBatchTest, GroupsByTorrentInOrder) {
+    auto batches = group_batch({
+        make_op(batch_action_e::PAUSE, 2),
+        make_op(batch_action_e::PAUSE, 1),
+        make_op(batch_action_e::RESUME, 2),
+    });
+    ASSERT_EQ(2u, batches.size());
+    EXPECT_EQ(2, batches[0].infohash[0]);
+    EXPECT_EQ((std::vector<std::size_t>{0, 2}), batches[0].ops);
+    EXPECT_FALSE(batches[0].pause);
+    EXPECT_TRUE(batches[0].resume);
+    EXPECT_EQ(1, batches[1].infohash[0]);
+    EXPECT_TRUE(batches[1].pause);
+    EXPECT_FALSE(batches[1].resume);
+}
+
+TEST(TorrentBatchTest, MergesFilePriorities) {
+    std::vector<batch_op_t> ops;
+    for (int file = 0; file < 300; ++file) {
+        ops.push_back(make_op(batch_action_e::FILE_PRIORITY, 1, file, 1));
+    }
+    ops.push_back(make_op(batch_action_e::FILE_PRIORITY, 1, 7, 0));
+    auto batches = group_batch(ops);
+    ASSERT_EQ(1u, batches.size());
+    EXPECT_EQ(301u, batches[0].ops.size());
+    EXPECT_EQ(300u, batches[0].file_priorities.size());
+    EXPECT_EQ(0, batches[0].file_priorities[7]);
+    EXPECT_EQ(1, batches[0].file_priorities[8]);
+}
+
+TEST(TorrentBatchTest, RemembersRemoval) {
+    auto batches = group_batch({
+        make_op(batch_action_e::REMOVE_DATA, 1),
+        make_op(batch_action_e::PAUSE, 1),
+        make_op(batch_action_e::REMOVE, 2),
+    });
+    ASSERT_EQ(2u, batches.size());
+    EXPECT_TRUE(batches[0].remove);
+    EXPECT_TRUE(batches[0].remove_data);
+    EXPECT_TRUE(batches[1].remove);
+    EXPECT_FALSE(batches[1].remove_data);
+}
+
+TEST(TorrentBatchTest, NamesResults) {
+    EXPECT_STREQ("ok", to_string(batch_result_e::OK));
+    EXPECT_STREQ("failed", to_string(batch_result_e::FAILED));
+    EXPECT_STREQ("superseded", to_string(batch_result_e::SUPERSEDED));
+}
@@ -0,0 +1,121 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <torrentindex.hpp>
+
+
+static torrent_status_t make_status(std::uint8_t id, torrent_state_e state,
+                                    std::int64_t size)
+{
+    torrent_status_t status;
+    status.infohash.fill(id);
+    status.name = "torrent-" + std::to_string(id);
+    status.state = state;
+    status.total_wanted = size;
+    return status;
+}
+
+static std::vector<std::uint8_t> ids(const torrent_page_t &page)
+{
+    std::vector<std::uint8_t> result;
+    for (const auto *entry : page.entries) {
+        result.push_back(entry->status.infohash[0]);
+    }
+    return result;
+}
+
+
+class TorrentIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Sizes are reversed to the names.
+        for (std::uint8_t id = 1; id <= 9; ++id) {
+            statuses.push_back(make_status(id, id % 2
+                    ? torrent_state_e::SEEDING : torrent_state_e::DOWNLOADING,
+                    100 - id));
+        }
+        store.update(statuses);
+    }
+
+    torrent_status_store_t store;
+    std::vector<torrent_status_t> statuses;
+};
+
+
+TEST_F(TorrentIndexTest, IndexesExistingTorrents) {
+    torrent_index_t index(&store);
+    EXPECT_EQ(9u, index.size());
+
+    torrent_query_t query;
+    torrent_page_t page = index.query(query);
+    EXPECT_EQ(9u, page.total);
+    EXPECT_EQ((std::vector<std::uint8_t>{1, 2, 3, 4, 5, 6, 7, 8, 9}),
+              ids(page));
+}
+
+TEST_F(TorrentIndexTest, ReturnsPages) {
+    torrent_index_t index(&store);
+    torrent_query_t query;
+    query.sort = torrent_sort_e::SIZE;
+    query.offset = 2;
+    query.limit = 3;
+    EXPECT_EQ((std::vector<std::uint8_t>{7, 6, 5}), ids(index.query(query)));
+
+    query.descending = true;
+    EXPECT_EQ((std::vector<std::uint8_t>{3, 4, 5}), ids(index.query(query)));
+
+    query.offset = 8;
+    EXPECT_EQ((std::vector<std::uint8_t>{9}), ids(index.query(query)));
+    query.offset = 9;
+    EXPECT_TRUE(index.query(query).entries.empty());
+    EXPECT_EQ(9u, index.query(query).total);
+}
+
+TEST_F(TorrentIndexTest, FiltersByState) {
+    torrent_index_t index(&store);
+    torrent_query_t query;
+    query.filter_state = true;
+    query.state = torrent_state_e::DOWNLOADING;
+    query.sort = torrent_sort_e::SIZE;
+    torrent_page_t page = index.query(query);
+    EXPECT_EQ(4u, page.total);
+    EXPECT_EQ((std::vector<std::uint8_t>{8, 6, 4, 2}), ids(page));
+
+    query.descending = true;
+    query.offset = 1;
+    query.limit = 2;
+    EXPECT_EQ((std::vector<std::uint8_t>{4, 6}), ids(index.query(query)));
+
+    query.state = torrent_state_e::CHECKING_FILES;
+    EXPECT_EQ(0u, index.query(query).total);
+}
+
+TEST_F(TorrentIndexTest, FollowsChanges) {
+    torrent_index_t index(&store);
+    statuses[0].state = torrent_state_e::DOWNLOADING;
+    statuses[0].total_wanted = 1;
+    statuses[1].download_rate = 1000;
+    store.update(statuses);
+    store.remove(statuses[3].infohash);
+    store.update({make_status(10, torrent_state_e::DOWNLOADING, 50)});
+
+    torrent_query_t query;
+    query.filter_state = true;
+    query.state = torrent_state_e::DOWNLOADING;
+    query.sort = torrent_sort_e::SIZE;
+    EXPECT_EQ((std::vector<std::uint8_t>{1, 10, 8, 6, 2}),
+              ids(index.query(query)));
+    EXPECT_EQ(9u, index.size());
+}
+
+TEST_F(TorrentIndexTest, RebuildsAfterPrunedTombstones) {
+    torrent_status_store_t small(0);
+    small.update(statuses);
+    torrent_index_t index(&small);
+    small.remove(statuses[0].infohash);
+    EXPECT_EQ(8u, index.size());
+    EXPECT_EQ(8u, index.query(torrent_query_t()).total);
+}
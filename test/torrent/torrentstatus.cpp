@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <torrentstatus.hpp>
+
+
+static torrent_status_t make_status(std::uint8_t id, int rate = 0)
+{
+    torrent_status_t status;
+    status.infohash.fill(id);
+    status.name = "torrent-" + std::to_string(id);
+    status.download_rate = rate;
+    return status;
+}
+
+static std::vector<std::uint8_t> ids(
+        const std::vector<const torrent_status_store_t::entry_t*> &entries)
+{
+    std::vector<std::uint8_t> result;
+    for (const auto *entry : entries) {
+        result.push_back(entry->status.infohash[0]);
+    }
+    return result;
+}
+
+
+TEST(TorrentStatusStoreTest, AssignsVersionPerChange) {
+    torrent_status_store_t store;
+    EXPECT_EQ(0u, store.version());
+
+    store.update({make_status(1), make_status(2), make_status(3)});
+    EXPECT_EQ(3u, store.version());
+    EXPECT_EQ((std::vector<std::uint8_t>{1, 2, 3}), ids(store.entries()));
+    EXPECT_EQ((std::vector<std::uint8_t>{1, 2, 3}), ids(store.changes(0)));
+}
+
+TEST(TorrentStatusStoreTest, ReturnsOnlyChangedEntries) {
+    torrent_status_store_t store;
+    store.update({make_status(1), make_status(2), make_status(3)});
+    const std::uint64_t seen = store.version();
+
+    store.update({make_status(1), make_status(2, 100), make_status(3)});
+    EXPECT_EQ(seen + 1, store.version());
+    EXPECT_EQ((std::vector<std::uint8_t>{2}), ids(store.changes(seen)));
+
+    store.update({make_status(1, 5)});
+    EXPECT_EQ((std::vector<std::uint8_t>{2, 1}), ids(store.changes(seen)));
+    EXPECT_TRUE(store.changes(store.version()).empty());
+}
+
+TEST(TorrentStatusStoreTest, NotifiesOncePerChangingBatch) {
+    torrent_status_store_t store;
+    std::vector<std::uint64_t> versions;
+    auto handle = store.add_listener([&](std::uint64_t version) {
+        versions.push_back(version);
+    });
+
+    store.update({make_status(1), make_status(2)});
+    store.update({make_status(1), make_status(2)});
+    store.update({make_status(1, 7)});
+    EXPECT_EQ((std::vector<std::uint64_t>{2, 3}), versions);
+
+    store.remove_listener(handle);
+    store.update({make_status(1, 8)});
+    EXPECT_EQ(2u, versions.size());
+}
+
+TEST(TorrentStatusStoreTest, ListenerCanRemoveItself) {
+    torrent_status_store_t store;
+    int calls = 0;
+    torrent_status_store_t::listener_handle_t handle;
+    handle = store.add_listener([&](std::uint64_t) {
+        ++calls;
+        store.remove_listener(handle);
+    });
+
+    store.update({make_status(1)});
+    store.update({make_status(2)});
+    EXPECT_EQ(1, calls);
+}
+
+TEST(TorrentStatusStoreTest, ReportsRemovedTorrents) {
+    torrent_status_store_t store;
+    store.update({make_status(1), make_status(2)});
+    const std::uint64_t seen = store.version();
+
+    store.remove(make_status(1).infohash);
+    auto changes = store.changes(seen);
+    ASSERT_EQ(1u, changes.size());
+    EXPECT_TRUE(changes[0]->removed);
+    EXPECT_EQ((std::vector<std::uint8_t>{2}), ids(store.entries()));
+
+    // Adding it again revives the entry.
+    store.update({make_status(1)});
+    changes = store.changes(seen);
+    ASSERT_EQ(1u, changes.size());
+    EXPECT_FALSE(changes[0]->removed);
+    EXPECT_EQ((std::vector<std::uint8_t>{1, 2}), ids(store.entries()));
+}
+
+TEST(TorrentStatusStoreTest, PrunesOldTombstones) {
+    torrent_status_store_t store(2);
+    store.update({make_status(1), make_status(2), make_status(3)});
+    store.remove(make_status(1).infohash);
+    store.remove(make_status(2).infohash);
+    EXPECT_EQ(0u, store.horizon());
+
+    store.remove(make_status(3).infohash);
+    EXPECT_EQ(4u, store.horizon());
+    EXPECT_EQ(2u, store.changes(store.horizon() - 1).size());
+    EXPECT_TRUE(store.entries().empty());
+}
+
+TEST(InfohashTest, FormatsAsLowercaseHex) {
+    infohash_t infohash;
+    infohash.fill(0xab);
+    infohash[0] = 0x01;
+    std::string expected = "01";
+    for (int i = 1; i < 20; ++i) {
+        expected += "ab";
+    }
+    EXPECT_EQ(expected, to_hex(infohash));
+}